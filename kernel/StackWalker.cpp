@@ -44,3 +44,32 @@ StackWalker::Frame* StackWalker::walk_stack(const kstd::Arc<Thread>& thread, uin
 	return nullptr;
 #endif
 }
+
+size_t StackWalker::walk_stack_safe(PageDirectory& page_directory, StackWalker::Frame* start_frame, uintptr_t* addr_buf, size_t addr_bufsz) {
+#if defined(__i386__)
+	ASSERT(page_directory.is_mapped());
+	const bool kernel = (uintptr_t) start_frame >= HIGHER_HALF;
+	auto& directory = kernel ? MM.kernel_page_directory : page_directory;
+	auto* cur_frame = start_frame;
+	size_t count = 0;
+	while (cur_frame && count < addr_bufsz) {
+		auto frame_addr = (uintptr_t) cur_frame;
+		if (((frame_addr >= HIGHER_HALF) != kernel) || frame_addr % sizeof(uintptr_t))
+			break;
+		// A frame might straddle two pages
+		if (!directory.try_is_mapped(frame_addr, false) || !directory.try_is_mapped(frame_addr + sizeof(Frame) - 1, false))
+			break;
+		if (!cur_frame->ret_addr)
+			break;
+		addr_buf[count++] = cur_frame->ret_addr;
+		// Stacks grow down, so each frame should be above the last. Otherwise, we could be walking in circles.
+		if ((uintptr_t) cur_frame->next_frame <= frame_addr)
+			break;
+		cur_frame = cur_frame->next_frame;
+	}
+	return count;
+#elif defined(__aarch64__)
+	// TODO: aarch64
+	return 0;
+#endif
+}
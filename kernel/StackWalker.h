@@ -13,4 +13,16 @@ namespace StackWalker {
 	};
 
 	Frame* walk_stack(const kstd::Arc<Thread>& thread, uintptr_t* addr_buf, size_t ptr_bufsz, StackWalker::Frame* start_frame);
+
+	/**
+	 * Walks a stack in the currently loaded address space without faulting or taking any locks, so that it can be
+	 * used in an interrupt. The walk stops at the first frame that isn't mapped, or once it leaves the half of the
+	 * address space (kernel or user) it started in.
+	 * @param page_directory The currently loaded page directory.
+	 * @param start_frame The frame to start walking at.
+	 * @param addr_buf The buffer to write the return addresses to.
+	 * @param addr_bufsz The maximum number of return addresses to write.
+	 * @return The number of return addresses written.
+	 */
+	size_t walk_stack_safe(PageDirectory& page_directory, Frame* start_frame, uintptr_t* addr_buf, size_t addr_bufsz);
 };
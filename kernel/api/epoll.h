@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include "types.h"
+
+// These match the POLL* flags.
+#define EPOLLIN 0x01
+#define EPOLLPRI 0x02
+#define EPOLLOUT 0x04
+#define EPOLLERR 0x08
+#define EPOLLHUP 0x10
+
+// Only report the file when it becomes ready, instead of for as long as it stays ready.
+#define EPOLLET (1u << 31)
+// Stop watching the file once it's been reported, until it's re-armed with EPOLL_CTL_MOD.
+#define EPOLLONESHOT (1u << 30)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC 0x1
+
+__DECL_BEGIN
+
+typedef union epoll_data {
+	void* ptr;
+	int fd;
+	uint32_t u32;
+	uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+	uint32_t events;
+	epoll_data_t data; // Given back as-is when the file is reported.
+};
+
+struct epoll_ctl_args {
+	int epfd;
+	int op;
+	int fd;
+	struct epoll_event* event; // Ignored for EPOLL_CTL_DEL.
+};
+
+struct epoll_wait_args {
+	int epfd;
+	struct epoll_event* events;
+	int max_events;
+	int timeout; // In milliseconds, or -1 to wait forever.
+};
+
+__DECL_END
@@ -3,12 +3,30 @@
 
 #pragma once
 #include "types.h"
+#include "time.h"
 
+// Waits until the futex is greater than zero or is woken.
 #define FUTEX_WAIT    1
+// Registers the futex to a file descriptor that is readable when the futex is greater than zero.
 #define FUTEX_REGFD   2
+// Waits while the futex's value is futex_args.value, until woken or futex_args.timeout passes. arg is a futex_args*.
+#define FUTEX_WAIT_VALUE 3
+// Wakes up to arg threads waiting on the futex, and returns the number of threads woken.
+#define FUTEX_WAKE    4
+// If the futex's value is futex_args.value, wakes up to futex_args.count threads waiting on the futex and moves up to
+// futex_args.requeue_count of the rest to wait on futex_args.futex2 instead. arg is a futex_args*.
+#define FUTEX_REQUEUE 5
 
 __DECL_BEGIN
 
 typedef int futex_t;
 
-__DECL_END
\ No newline at end of file
+struct futex_args {
+	int value;
+	int count;
+	int requeue_count;
+	futex_t* futex2;
+	const struct timespec* timeout; // Relative, or NULL to wait forever
+};
+
+__DECL_END
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include "types.h"
+
+// Profile every process instead of a single one.
+#define PROFILE_ALL_PROCESSES (-1)
+
+// The most frames of each stack that are recorded in a sample.
+#define PROFILE_MAX_KERNEL_FRAMES 32
+#define PROFILE_MAX_USER_FRAMES 64
+
+#define PROFILE_RECORD_SAMPLE 1
+// Fills the rest of the buffer when a record doesn't fit before the end, so records never wrap around.
+#define PROFILE_RECORD_PADDING 2
+
+__DECL_BEGIN
+
+struct profile_args {
+	pid_t pid; // The process to profile, or PROFILE_ALL_PROCESSES.
+	unsigned int frequency; // Samples per second. Limited by the frequency of the system timer.
+	size_t buffer_size; // The size of the ring buffer. Rounded up to a power of two number of pages.
+};
+
+/**
+ * The profiler's buffer is mapped with mmap(MAP_SHARED) on the file descriptor returned by profile(). It starts with
+ * this header on its own page, which is followed by a ring buffer of records.
+ *
+ * The kernel appends records at head and the reader consumes them up to head, then sets tail to tell the kernel the
+ * space can be reused. Both only ever increase, and the position of a record in the ring is its offset modulo
+ * data_size. When there's no room for a sample, it's dropped and counted in lost.
+ */
+struct profile_buffer {
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t lost;
+	uint32_t data_offset;
+	uint32_t data_size;
+	uint32_t frequency; // The frequency the profiler actually samples at.
+};
+
+struct profile_record {
+	uint16_t size; // The size of the record in bytes, including the frames.
+	uint16_t type;
+	pid_t pid;
+	tid_t tid;
+	uint16_t num_kernel_frames;
+	uint16_t num_user_frames;
+	uintptr_t frames[]; // The kernel frames followed by the user frames, each from the innermost outwards.
+};
+
+__DECL_END
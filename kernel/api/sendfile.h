@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include "types.h"
+
+// Accepted for compatibility, but they don't change anything.
+#define SPLICE_F_MOVE 0x1
+#define SPLICE_F_MORE 0x4
+#define SPLICE_F_GIFT 0x8
+
+// Not supported; splice() fails with EINVAL if it's given.
+#define SPLICE_F_NONBLOCK 0x2
+
+__DECL_BEGIN
+
+struct sendfile_args {
+	int out_fd;
+	int in_fd;
+	off_t* offset; // If not null, read from here instead of in_fd's offset, and update it instead.
+	size_t count;
+};
+
+struct splice_args {
+	int fd_in;
+	off_t* off_in; // If not null, read from here instead of fd_in's offset, and update it instead.
+	int fd_out;
+	off_t* off_out; // If not null, write here instead of at fd_out's offset, and update it instead.
+	size_t len;
+	unsigned int flags;
+};
+
+__DECL_END
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include "types.h"
+
+#define PROC_SNAPSHOT_PATH "/proc/snapshot"
+#define PROC_SNAPSHOT_VERSION 1
+#define PROC_SNAPSHOT_NAME_MAX 64
+
+__DECL_BEGIN
+
+/**
+ * /proc/snapshot describes every process at once. A single read() at offset zero fills the buffer with this header,
+ * followed by as many proc_snapshot_records as fit. If num_records is less than num_processes, the buffer was too
+ * small and the read should be retried from the start with a bigger one. Reads at any other offset return nothing.
+ */
+struct proc_snapshot_header {
+	uint32_t version;
+	uint32_t record_size; // The size of each record. Records may grow in later versions, so step through them by this.
+	uint32_t num_processes; // The number of processes that existed when the snapshot was taken.
+	uint32_t num_records; // The number of records that follow.
+	uint64_t uptime; // The system uptime when the snapshot was taken, in milliseconds.
+};
+
+struct proc_snapshot_record {
+	pid_t pid;
+	pid_t ppid;
+	uid_t uid;
+	gid_t gid;
+	uint32_t state; // The same as "state" in /proc/<pid>/status.
+	uint32_t num_threads;
+	uint64_t cpu_time; // The time spent running on the CPU, in milliseconds.
+	uint64_t pmem;
+	uint64_t vmem;
+	uint64_t shmem;
+	char name[PROC_SNAPSHOT_NAME_MAX]; // Null-terminated, and truncated if it doesn't fit.
+};
+
+__DECL_END
@@ -27,6 +27,12 @@ __DECL_BEGIN
 #define SO_BINDTODEVICE       1
 #define SO_BROADCAST          2
 #define SO_ERROR              3
+#define SO_RCVBUF             4 // How many bytes can be waiting to be received
+#define SO_SNDBUF             5 // How many bytes can be sent but not yet acknowledged
+
+// send / recv flags
+#define MSG_DONTWAIT   0x40    // Don't block, even if the socket isn't non-blocking
+#define MSG_WAITFORONE 0x10000 // recvmmsg: only block for the first message
 
 // shutdown
 #define SHUT_RD   0x1
@@ -60,6 +66,12 @@ struct msghdr {
 	int            msg_flags;
 };
 
+// For recvmmsg / sendmmsg.
+struct mmsghdr {
+	struct msghdr msg_hdr;
+	unsigned int  msg_len; // Set to the number of bytes received or sent.
+};
+
 struct sockaddr_storage {
 	sa_family_t ss_family;
 	struct sockaddr_un __un;
@@ -42,7 +42,8 @@ struct TCPSegment {
 	[[nodiscard]] const uint8_t* payload() const { return ((const uint8_t*) this) + (data_offset() * sizeof(uint32_t)); }
 	[[nodiscard]] uint8_t* payload() { return ((uint8_t*) this) + (data_offset() * sizeof(uint32_t)); }
 
-	inline BigEndian<uint16_t> calculate_checksum(const IPv4Address& src, const IPv4Address& dest, size_t payload_size) {
+	/** The sum of the pseudo-header, which is what goes in the checksum field if the adapter calculates the rest. **/
+	inline uint16_t pseudo_header_checksum(const IPv4Address& src, const IPv4Address& dest, size_t payload_size) {
 		union PseudoHeader {
 			struct __attribute__((packed)) {
 				IPv4Address src;
@@ -66,18 +67,21 @@ struct TCPSegment {
 		};
 
 		uint32_t sum = 0;
-
-		// Checksum of pseudo header
 		auto* ptr = (uint16_t*) pheader.raw;
 		for (size_t i = 0; i < sizeof(pheader) / sizeof(uint16_t); i++) {
 			sum += as_big_endian(ptr[i]);
 			if (sum > 0xffff)
 				sum = (sum >> 16) + (sum & 0xffff);
 		}
+		return sum;
+	}
+
+	inline BigEndian<uint16_t> calculate_checksum(const IPv4Address& src, const IPv4Address& dest, size_t payload_size) {
+		uint32_t sum = pseudo_header_checksum(src, dest, payload_size);
 
 		// Checksum of segment header
 		const void* selfptr = this; // Necessary to suppress alignment errors
-		ptr = (uint16_t*) selfptr;
+		auto* ptr = (uint16_t*) selfptr;
 		for (size_t i = 0; i < (data_offset() * sizeof(uint32_t)) / sizeof(uint16_t); i++) {
 			sum += as_big_endian(ptr[i]);
 			if (sum > 0xffff)
@@ -75,6 +75,10 @@ bool PageDirectory::is_mapped(size_t vaddr, bool write) {
 	return pte->entries[MMU::pte_page_index(vpage)].valid;
 }
 
+bool PageDirectory::try_is_mapped(size_t vaddr, bool write) {
+	return is_mapped(vaddr, write);
+}
+
 bool PageDirectory::is_mapped() {
 	return true;
 }
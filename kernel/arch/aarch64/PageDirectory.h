@@ -77,6 +77,14 @@ public:
 	 */
 	bool is_mapped(VirtualAddress vaddr, bool write);
 
+	/**
+	 * Checks if a given virtual address is mapped without taking any locks, so it can be used in an interrupt.
+	 * @param vaddr The virtual address to check.
+	 * @param permission Whether to check for write permission.
+	 * @return Whether or not the given virtual address is mapped.
+	 */
+	bool try_is_mapped(VirtualAddress vaddr, bool write);
+
 	/**
 	 * Gets whether or not this PageDirectory is currently mapped.
 	 * @return Whether or not the PageDirectory is currently mapped.
@@ -150,6 +150,16 @@ void PageDirectory::dealloc_page_table(size_t tables_index) {
 
 bool PageDirectory::is_mapped(size_t vaddr, bool write) {
 	LOCK(m_lock);
+	return check_mapped(vaddr, write);
+}
+
+bool PageDirectory::try_is_mapped(size_t vaddr, bool write) {
+	if(m_lock.locked())
+		return false;
+	return check_mapped(vaddr, write);
+}
+
+bool PageDirectory::check_mapped(size_t vaddr, bool write) {
 	if(vaddr < HIGHER_HALF) { //Program space
 		size_t page = vaddr / PAGE_SIZE;
 		size_t directory_index = (page / 1024) % 1024;
@@ -109,6 +109,15 @@ public:
 	 */
 	bool is_mapped(VirtualAddress vaddr, bool write);
 
+	/**
+	 * Checks if a given virtual address is mapped without taking the lock, so it can be used in an interrupt. If the
+	 * page directory is locked, it might be in the middle of being changed, so this returns false.
+	 * @param vaddr The virtual address to check.
+	 * @param permission Whether to check for write permission.
+	 * @return Whether or not the given virtual address is mapped.
+	 */
+	bool try_is_mapped(VirtualAddress vaddr, bool write);
+
 	/**
 	 * Gets whether or not this PageDirectory is currently mapped.
 	 * @return Whether or not the PageDirectory is currently mapped.
@@ -117,6 +126,8 @@ public:
 
 private:
 	friend class MemoryManager;
+	bool check_mapped(VirtualAddress vaddr, bool write);
+
 	/**
 	 * Maps a virtual page to a physical page.
 	 * @param vpage The index of the virtual page to map.
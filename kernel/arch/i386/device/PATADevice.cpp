@@ -347,68 +347,8 @@ size_t PATADevice::block_size() {
     return 512;
 }
 
-ssize_t PATADevice::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-    size_t first_block       = offset / block_size();
-    size_t first_block_start = offset % block_size();
-    size_t bytes_left        = count;
-    size_t blk               = first_block;
-    ssize_t nread            = 0;
-
-    uint8_t block_buf[block_size()];
-    while(bytes_left) {
-        if(blk > _max_addressable_block) break;
-
-        Result res = read_block(blk, block_buf);
-        if(res.is_error()) return res.code();
-
-        if(blk == first_block) {
-            size_t avail   = block_size() - first_block_start;
-            size_t to_copy = min(bytes_left, avail);
-            buffer.write(block_buf + first_block_start, to_copy);
-            nread     += to_copy;
-            bytes_left -= to_copy;
-        } else {
-            size_t to_copy = min(bytes_left, block_size());
-            buffer.write(block_buf, count - bytes_left, to_copy);
-            nread     += to_copy;
-            bytes_left -= to_copy;
-        }
-        blk++;
-    }
-    return nread;
-}
-
-ssize_t PATADevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-    size_t first_block       = offset / block_size();
-    size_t last_block        = (offset + count - 1) / block_size();
-    size_t first_block_start = offset % block_size();
-    size_t bytes_left        = count;
-    size_t blk               = first_block;
-
-    if(last_block > _max_addressable_block)
-        return -ENOSPC;
-
-    uint8_t block_buf[block_size()];
-    while(bytes_left) {
-        Result res = read_block(blk, block_buf);
-        if(res.is_error()) return res.code();
-
-        if(blk == first_block) {
-            size_t avail   = block_size() - first_block_start;
-            size_t to_copy = min(bytes_left, avail);
-            buffer.read(block_buf + first_block_start, to_copy);
-            bytes_left -= to_copy;
-        } else {
-            size_t to_copy = min(bytes_left, block_size());
-            buffer.read(block_buf, count - bytes_left, to_copy);
-            bytes_left -= to_copy;
-        }
-
-        res = write_block(blk, block_buf);
-        if(res.is_error()) return res.code();
-        blk++;
-    }
-    return count;
+uint64_t PATADevice::max_addressable_block() {
+    return _max_addressable_block;
 }
 
 void PATADevice::handle_irq(IRQRegisters* regs) {
@@ -53,9 +53,8 @@ public:
     Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) override;
     size_t block_size() override;
 
-    //File
-    ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
-    ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+    //DiskDevice
+    uint64_t max_addressable_block() override;
 
     //IRQHandler
     void handle_irq(IRQRegisters* regs) override;
@@ -21,6 +21,7 @@
 #include <kernel/memory/MemoryManager.h>
 #include "DiskDevice.h"
 #include "kernel/kstd/KLog.h"
+#include "kernel/filesystem/FileDescriptor.h"
 
 size_t DiskDevice::s_used_cache_memory = 0;
 kstd::vector<DiskDevice*> DiskDevice::s_disk_devices;
@@ -46,7 +47,7 @@ Result DiskDevice::read_blocks(uint32_t start_block, uint32_t count, uint8_t* bu
 	for(size_t i = 0; i < count; i++) {
 		size_t block = start_block + i;
 		if(!cache_region || !cache_region->has_block(block))
-			cache_region = get_cache_region(block);
+			cache_region = get_cache_region(block, count - i);
 		LOCK(cache_region->lock);
 		cache_region->last_used = Time::now();
 		memcpy(buffer + i * block_size(), cache_region->block_data(block), block_size());
@@ -82,6 +83,90 @@ Result DiskDevice::write_blocks(uint32_t start_block, uint32_t count, const uint
 	return Result::Success;
 }
 
+ssize_t DiskDevice::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	size_t first_block       = offset / block_size();
+	size_t first_block_start = offset % block_size();
+	size_t bytes_left        = count;
+	size_t blk               = first_block;
+	ssize_t nread            = 0;
+
+	uint8_t block_buf[block_size()];
+	while(bytes_left) {
+		if(blk > max_addressable_block()) break;
+
+		Result res = read_block(blk, block_buf);
+		if(res.is_error()) return res.code();
+
+		if(blk == first_block) {
+			size_t avail   = block_size() - first_block_start;
+			size_t to_copy = min(bytes_left, avail);
+			buffer.write(block_buf + first_block_start, to_copy);
+			nread     += to_copy;
+			bytes_left -= to_copy;
+		} else {
+			size_t to_copy = min(bytes_left, block_size());
+			buffer.write(block_buf, count - bytes_left, to_copy);
+			nread     += to_copy;
+			bytes_left -= to_copy;
+		}
+		blk++;
+	}
+	return nread;
+}
+
+ssize_t DiskDevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	size_t first_block       = offset / block_size();
+	size_t last_block        = (offset + count - 1) / block_size();
+	size_t first_block_start = offset % block_size();
+	size_t bytes_left        = count;
+	size_t blk               = first_block;
+
+	if(last_block > max_addressable_block())
+		return -ENOSPC;
+
+	uint8_t block_buf[block_size()];
+	while(bytes_left) {
+		Result res = read_block(blk, block_buf);
+		if(res.is_error()) return res.code();
+
+		if(blk == first_block) {
+			size_t avail   = block_size() - first_block_start;
+			size_t to_copy = min(bytes_left, avail);
+			buffer.read(block_buf + first_block_start, to_copy);
+			bytes_left -= to_copy;
+		} else {
+			size_t to_copy = min(bytes_left, block_size());
+			buffer.read(block_buf, count - bytes_left, to_copy);
+			bytes_left -= to_copy;
+		}
+
+		res = write_block(blk, block_buf);
+		if(res.is_error()) return res.code();
+		blk++;
+	}
+	return count;
+}
+
+Result DiskDevice::flush_writes() {
+	return Result(SUCCESS);
+}
+
+Result DiskDevice::discard_uncached_blocks(uint32_t block, uint32_t count) {
+	return Result(ENOTSUP);
+}
+
+Result DiskDevice::read_uncached_ranges(const BlockRange* ranges, size_t count) {
+	for(size_t i = 0; i < count; i++)
+		TRYRES(read_uncached_blocks(ranges[i].block, ranges[i].count, ranges[i].buffer));
+	return Result(SUCCESS);
+}
+
+Result DiskDevice::write_uncached_ranges(const BlockRange* ranges, size_t count) {
+	for(size_t i = 0; i < count; i++)
+		TRYRES(write_uncached_blocks(ranges[i].block, ranges[i].count, ranges[i].buffer));
+	return Result(SUCCESS);
+}
+
 size_t DiskDevice::used_cache_memory() {
 	return s_used_cache_memory;
 }
@@ -90,29 +175,46 @@ size_t DiskDevice::free_pages(size_t num_pages) {
 	size_t num_freed = 0;
 	LOCK(s_disk_devices_lock);
 
+	// Regions that are locked are being loaded, written back, or used, so they're never evicted. This checks for any
+	// holder, since try_acquire would succeed if we're being called by the thread holding one (e.g. while it allocates).
+	auto is_unlocked = [](const kstd::Arc<BlockCacheRegion>& region) {
+		return !region->lock.locked();
+	};
+
 	while(num_freed < num_pages) {
 		DiskDevice* lru_device = nullptr;
+		size_t lru_start = 0;
 		Time lru_time = Time::distant_future();
-		kstd::Arc<BlockCacheRegion> lru_region;
 
 		// Find the device with the least recently used cache region
 		for(size_t i = 0; i < s_disk_devices.size(); i++) {
 			auto device = s_disk_devices[i];
 			LOCK_N(device->_cache_lock, device_lock);
-			if(device->_cache_regions.empty())
+			auto device_lru = device->_cache_regions.lru_matching(is_unlocked);
+			if(!device_lru.second)
 				continue;
-			auto device_lru = device->_cache_regions.lru_unsafe();
-			auto time = device_lru.second->last_used;
+			auto time = (*device_lru.second)->last_used;
 			if(time < lru_time) {
 				lru_time = time;
 				lru_device = device;
-				lru_region = device_lru.second;
+				lru_start = device_lru.first;
 			}
 		}
 
-		if(!lru_region)
+		if(!lru_device)
 			break;
 
+		// Lock it and take it out of the cache, so nobody can start using it. If someone got to it first, look again.
+		kstd::Arc<BlockCacheRegion> lru_region;
+		{
+			LOCK_N(lru_device->_cache_lock, device_lock);
+			auto* region = lru_device->_cache_regions.peek_unsafe(lru_start);
+			if(!region || (*region)->lock.locked() || !(*region)->lock.try_acquire())
+				continue;
+			lru_region = *region;
+			lru_device->_cache_regions.erase(lru_start);
+		}
+
 		// Flush it if necessary
 		if(lru_region->dirty)
 			lru_device->write_uncached_blocks(lru_region->start_block, lru_region->num_blocks(), (uint8_t*) lru_region->region->start());
@@ -120,8 +222,8 @@ size_t DiskDevice::free_pages(size_t num_pages) {
 		// Free it
 		num_freed += lru_region->region->size() / PAGE_SIZE;
 		s_used_cache_memory -= lru_region->region->size();
+		lru_region->lock.release();
 		lru_region.reset();
-		lru_device->_cache_regions.prune(1);
 	}
 
 	if(num_freed != num_pages)
@@ -130,32 +232,50 @@ size_t DiskDevice::free_pages(size_t num_pages) {
 	return num_freed;
 }
 
-kstd::Arc<DiskDevice::BlockCacheRegion> DiskDevice::get_cache_region(size_t block) {
+kstd::Arc<DiskDevice::BlockCacheRegion> DiskDevice::get_cache_region(size_t block, size_t num_blocks) {
 	_cache_lock.acquire();
 
 	//See if we already have the block
-	auto reg_opt = _cache_regions.get(block_cache_region_start(block));
+	auto start = block_cache_region_start(block);
+	auto reg_opt = _cache_regions.get(start);
 	if(reg_opt) {
 		_cache_lock.release();
 		return reg_opt.value();
 	}
 
-	//Create a new cache region
-	auto reg = kstd::Arc<BlockCacheRegion>::make(block_cache_region_start(block), block_size());
-	s_used_cache_memory += PAGE_SIZE;
-	reg->lock.acquire();
-	_cache_regions.insert(block_cache_region_start(block), reg);
-
-	//Read the blocks into it
-	read_uncached_blocks(reg->start_block, blocks_per_cache_region(), (uint8_t*) reg->region->start());
+	//We'll read in the regions for the rest of the blocks the caller wants too, and if the region before this one is
+	//cached, it looks like we're reading sequentially, so read a few more after that
+	auto per_region = blocks_per_cache_region();
+	size_t num_regions = (block - start + num_blocks + per_region - 1) / per_region;
+	if(start >= per_region && _cache_regions.peek(start - per_region))
+		num_regions += readahead_regions;
+	num_regions = min(num_regions, max_batch_regions);
+
+	//Create the regions, stopping at the first one that's already cached or past the end of the disk. Each is locked
+	//until it's filled, so anyone who finds it in the meantime waits for it
+	kstd::Arc<BlockCacheRegion> regions[max_batch_regions];
+	BlockRange ranges[max_batch_regions];
+	size_t num_loading = 0;
+	for(size_t i = 0; i < num_regions; i++) {
+		auto region_start = start + i * per_region;
+		if(i && (region_start + per_region > max_addressable_block() || _cache_regions.peek(region_start)))
+			break;
+		auto reg = kstd::Arc<BlockCacheRegion>::make(region_start, block_size());
+		s_used_cache_memory += PAGE_SIZE;
+		reg->lock.acquire();
+		_cache_regions.insert(region_start, reg);
+		ranges[num_loading] = {(uint32_t) region_start, (uint32_t) per_region, (uint8_t*) reg->region->start()};
+		regions[num_loading++] = reg;
+	}
 
-	//TODO: Figure out how to read the block after releasing the cache lock so that other blocks can be used in the meantime
-	//(We cannot do this currently as that would result in acquiring / releasing locks in the wrong order)
-	reg->lock.release();
+	//Read the blocks in without holding the cache lock, so other regions can be used (and loaded) in the meantime
 	_cache_lock.release();
+	read_uncached_ranges(ranges, num_loading);
+	for(size_t i = 0; i < num_loading; i++)
+		regions[i]->lock.release();
 
 	//Return the requested region
-	return reg;
+	return regions[0];
 }
 
 void DiskDevice::cache_writeback_task_entry() {
@@ -167,28 +287,44 @@ void DiskDevice::cache_writeback_task_entry() {
 
 		KLog::dbg_if<writeback_debug>("DiskDevice", "Writing back caches...");
 		for (auto device : s_disk_devices) {
+			bool wrote = false;
 			while (true) {
-				size_t region_loc;
-				{
-					LOCK(device->_dirty_regions_lock);
-					if (device->_dirty_regions.empty())
-						break;
-					region_loc = device->_dirty_regions.pop_front();
-				}
-				kstd::Arc<BlockCacheRegion> region;
-				{
-					LOCK(device->_cache_lock);
-					auto region_opt = device->_cache_regions.get(region_loc);
-					if (!region_opt) {
-						KLog::warn("DiskDevice", "Was going to write back cache region, but couldn't find it!");
-						return;
+				//Write back a batch of dirty regions at once, so the disk can work on several of them at a time
+				kstd::Arc<BlockCacheRegion> regions[max_batch_regions];
+				BlockRange ranges[max_batch_regions];
+				size_t num_regions = 0;
+				while (num_regions < max_batch_regions) {
+					size_t region_loc;
+					{
+						LOCK(device->_dirty_regions_lock);
+						if (device->_dirty_regions.empty())
+							break;
+						region_loc = device->_dirty_regions.pop_front();
+					}
+					kstd::Arc<BlockCacheRegion> region;
+					{
+						LOCK(device->_cache_lock);
+						auto region_opt = device->_cache_regions.peek(region_loc);
+						if (!region_opt)
+							continue; // It was written back when it was freed
+						region = region_opt.value();
 					}
-					region = region_opt.value();
+					region->lock.acquire();
+					ranges[num_regions] = {(uint32_t) region->start_block, (uint32_t) region->num_blocks(), (uint8_t*) region->region->start()};
+					regions[num_regions++] = region;
+				}
+				if (!num_regions)
+					break;
+
+				device->write_uncached_ranges(ranges, num_regions);
+				for (size_t i = 0; i < num_regions; i++) {
+					regions[i]->dirty = false;
+					regions[i]->lock.release();
 				}
-				LOCK(region->lock);
-				device->write_uncached_blocks(region->start_block, region->num_blocks(), (uint8_t*) region->region->start());
-				region->dirty = false;
+				wrote = true;
 			}
+			if (wrote)
+				device->flush_writes();
 		}
 		KLog::dbg_if<writeback_debug>("DiskDevice", "Done writing caches!");
 	}
@@ -35,6 +35,28 @@ public:
 	virtual Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t *buffer) = 0;
 	virtual Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t *buffer) = 0;
 
+	/** A run of blocks to read or write with read_uncached_ranges() or write_uncached_ranges(). **/
+	struct BlockRange {
+		uint32_t block;
+		uint32_t count;
+		uint8_t* buffer;
+	};
+	/**
+	 * Reads or writes several runs of blocks. Disks that can have several requests in flight should override these to
+	 * submit all of them before waiting; by default, they're done one after another.
+	 */
+	virtual Result read_uncached_ranges(const BlockRange* ranges, size_t count);
+	virtual Result write_uncached_ranges(const BlockRange* ranges, size_t count);
+	/** Makes sure that everything written so far has made it to the disk, for disks that cache writes. **/
+	virtual Result flush_writes();
+	/** Tells the disk that it can forget the contents of some blocks. Not all disks support this. **/
+	virtual Result discard_uncached_blocks(uint32_t block, uint32_t count);
+	virtual uint64_t max_addressable_block() = 0;
+
+	//File
+	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+
 	static size_t used_cache_memory();
 	/** Tries to free a number of pages from the cache. Returns the number of pages that could be freed. **/
 	static size_t free_pages(size_t num_pages);
@@ -56,7 +78,7 @@ private:
 		size_t start_block;
 		Time last_used = Time::now();
 		bool dirty = false;
-		Mutex lock {"BlockCacheRegion"};
+		Mutex lock {"BlockCacheRegion"}; ///< Held while the region is being read in, so nobody uses it before it's filled.
 	};
 
 	// Static
@@ -67,7 +89,10 @@ private:
 
 	kstd::LRUCache<size_t, kstd::Arc<BlockCacheRegion>> _cache_regions;
 	kstd::queue<size_t> _dirty_regions; // We really need a set type.
-	kstd::Arc<BlockCacheRegion> get_cache_region(size_t block);
+	static constexpr size_t max_batch_regions = 16; ///< The most cache regions that are read or written back at once.
+	static constexpr size_t readahead_regions = 8; ///< How many regions to read ahead when reading sequentially.
+
+	kstd::Arc<BlockCacheRegion> get_cache_region(size_t block, size_t num_blocks = 1);
 	inline size_t blocks_per_cache_region() { return PAGE_SIZE / block_size(); }
 	inline size_t block_cache_region_start(size_t block) { return block - (block % blocks_per_cache_region()); }
 	Mutex _cache_lock {"DiskDeviceCache"};
@@ -61,6 +61,10 @@ ssize_t KeyboardDevice::write(FileDescriptor &fd, size_t offset, SafePointer<uin
 	return 0;
 }
 
+bool KeyboardDevice::notifies_readiness() {
+	return true;
+}
+
 bool KeyboardDevice::can_read(const FileDescriptor& fd) {
 	return !_event_buffer.empty();
 }
@@ -136,4 +140,5 @@ void KeyboardDevice::set_key_state(uint8_t scancode, bool pressed) {
 	if(_event_buffer.size() == _event_buffer.capacity())
 		_event_buffer.pop_front();
 	_event_buffer.push_back(event);
+	notify_readiness();
 }
@@ -49,6 +49,7 @@ public:
 	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	bool can_read(const FileDescriptor& fd) override;
 	bool can_write(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 
 	//IRQHandler
 	void set_handler(KeyboardHandler* handler);
@@ -122,9 +122,14 @@ void MouseDevice::handle_vmware_bytes() {
 		if(event_buffer.size() == event_buffer.capacity())
 			event_buffer.pop_front();
 		event_buffer.push_back(VMWare::inst().read_mouse_event());
+		notify_readiness();
 	}
 }
 
+bool MouseDevice::notifies_readiness() {
+	return true;
+}
+
 bool MouseDevice::can_read(const FileDescriptor& fd) {
 	return !event_buffer.empty();
 }
@@ -158,4 +163,5 @@ void MouseDevice::handle_packet() {
 	if(event_buffer.size() == event_buffer.capacity())
 		event_buffer.pop_front();
 	event_buffer.push_back({x, y, z, (uint8_t) (packet_data[0] & 0x7u), false});
+	notify_readiness();
 }
\ No newline at end of file
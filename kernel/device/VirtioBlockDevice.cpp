@@ -0,0 +1,265 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "VirtioBlockDevice.h"
+#include "../kstd/KLog.h"
+#include "../kstd/cstring.h"
+#include "../memory/MemoryManager.h"
+#include "../tasking/TaskManager.h"
+
+// https://docs.oasis-open.org/virtio/virtio/v1.1/virtio-v1.1.html (5.2, Block Device)
+
+#define VIRTIO_BLK_F_RO      5  // Device is read-only
+#define VIRTIO_BLK_F_FLUSH   9  // Device has a write cache that can be flushed
+#define VIRTIO_BLK_F_DISCARD 13 // Device supports discarding sectors
+
+#define VIRTIO_BLK_T_IN      0
+#define VIRTIO_BLK_T_OUT     1
+#define VIRTIO_BLK_T_FLUSH   4
+#define VIRTIO_BLK_T_DISCARD 11
+
+#define VIRTIO_BLK_S_OK     0
+#define VIRTIO_BLK_S_IOERR  1
+#define VIRTIO_BLK_S_UNSUPP 2
+
+#define CONFIG_CAPACITY            0
+#define CONFIG_MAX_DISCARD_SECTORS 36
+
+#define VIRTIO_BLOCK_MAJOR 254
+
+#define VIRTIO_BLK_DBG false
+
+VirtioBlockDevice* VirtioBlockDevice::find() {
+	PCI::Address addr = {0, 0, 0};
+	PCI::enumerate_devices([](PCI::Address addr, PCI::ID id, uint16_t type, void* data) {
+		if (id.vendor == VIRTIO_VENDOR && id.device == VIRTIO_DEV_BLOCK)
+			*((PCI::Address*) data) = addr;
+	}, &addr);
+	if (addr.is_zero())
+		return nullptr;
+
+	auto* device = new VirtioBlockDevice(addr);
+	if (!device->init()) {
+		delete device;
+		return nullptr;
+	}
+	return device;
+}
+
+VirtioBlockDevice::VirtioBlockDevice(PCI::Address addr):
+	VirtioDevice(addr), DiskDevice(VIRTIO_BLOCK_MAJOR, 0) {}
+
+bool VirtioBlockDevice::init() {
+	negotiate_features((1u << VIRTIO_BLK_F_RO) | (1u << VIRTIO_BLK_F_FLUSH) | (1u << VIRTIO_BLK_F_DISCARD) |
+					   (1u << VIRTIO_RING_F_EVENT_IDX));
+	m_capacity = config_read64(CONFIG_CAPACITY);
+
+	m_queue = setup_queue(0);
+	if (!m_queue) {
+		KLog::warn("VirtioBlock", "Disk is missing its request queue!");
+		fail();
+		return false;
+	}
+
+	// Each request takes at most three descriptors, so make sure they can all be in the queue at once
+	m_num_slots = min(max_slots, (size_t) m_queue->size() / 3);
+	m_request_region = MM.alloc_dma_region(sizeof(RequestData) * m_num_slots);
+	m_bounce_region = MM.alloc_dma_region(max_request_sectors * sector_size * m_num_slots);
+
+	finish_init();
+	KLog::dbg_if<VIRTIO_BLK_DBG>("VirtioBlock", "Found disk with {} sectors{}", m_capacity, has_feature(VIRTIO_BLK_F_RO) ? " (read-only)" : "");
+	return true;
+}
+
+Result VirtioBlockDevice::read_uncached_blocks(uint32_t block, uint32_t count, uint8_t* buffer) {
+	BlockRange range = {block, count, buffer};
+	return do_io(VIRTIO_BLK_T_IN, &range, 1);
+}
+
+Result VirtioBlockDevice::write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t* buffer) {
+	BlockRange range = {block, count, (uint8_t*) buffer};
+	return write_uncached_ranges(&range, 1);
+}
+
+Result VirtioBlockDevice::read_uncached_ranges(const BlockRange* ranges, size_t count) {
+	return do_io(VIRTIO_BLK_T_IN, ranges, count);
+}
+
+Result VirtioBlockDevice::write_uncached_ranges(const BlockRange* ranges, size_t count) {
+	if (has_feature(VIRTIO_BLK_F_RO))
+		return Result(EROFS);
+	return do_io(VIRTIO_BLK_T_OUT, ranges, count);
+}
+
+Result VirtioBlockDevice::flush_writes() {
+	if (!has_feature(VIRTIO_BLK_F_FLUSH))
+		return Result(SUCCESS); // There's no write cache
+	auto slot = acquire_slot(true);
+	submit(slot, VIRTIO_BLK_T_FLUSH, 0, 0);
+	auto res = wait(slot);
+	release_slot(slot);
+	return res;
+}
+
+Result VirtioBlockDevice::discard_uncached_blocks(uint32_t block, uint32_t count) {
+	if (!has_feature(VIRTIO_BLK_F_DISCARD))
+		return Result(ENOTSUP);
+	if (block + (uint64_t) count > m_capacity)
+		return Result(EINVAL);
+
+	uint32_t max_sectors = config_read32(CONFIG_MAX_DISCARD_SECTORS);
+	if (!max_sectors)
+		max_sectors = count;
+	while (count) {
+		auto num_sectors = min(count, max_sectors);
+		auto slot = acquire_slot(true);
+		submit(slot, VIRTIO_BLK_T_DISCARD, block, num_sectors);
+		auto res = wait(slot);
+		release_slot(slot);
+		if (res.is_error())
+			return res;
+		block += num_sectors;
+		count -= num_sectors;
+	}
+	return Result(SUCCESS);
+}
+
+uint64_t VirtioBlockDevice::max_addressable_block() {
+	return m_capacity;
+}
+
+size_t VirtioBlockDevice::block_size() {
+	return sector_size;
+}
+
+void VirtioBlockDevice::handle_queue_irq() {
+	do {
+		uint32_t length;
+		while (auto* slot = (Slot*) m_queue->pop_used(length))
+			slot->blocker.set_ready(true);
+	} while (m_queue->enable_interrupts());
+	TaskManager::yield_if_idle();
+}
+
+int VirtioBlockDevice::acquire_slot(bool wait) {
+	while (true) {
+		{
+			LOCK(m_slot_lock);
+			for (size_t i = 0; i < m_num_slots; i++) {
+				if (!m_slots[i].in_use) {
+					m_slots[i].in_use = true;
+					return (int) i;
+				}
+			}
+			if (!wait)
+				return -1;
+			m_slot_blocker.set_ready(false);
+		}
+		TaskManager::current_thread()->block(m_slot_blocker);
+	}
+}
+
+void VirtioBlockDevice::release_slot(int slot) {
+	LOCK(m_slot_lock);
+	m_slots[slot].in_use = false;
+	m_slot_blocker.set_ready(true);
+}
+
+void VirtioBlockDevice::submit(int slot, uint32_t type, uint64_t sector, uint32_t count) {
+	auto* data = (RequestData*) (m_request_region->start() + sizeof(RequestData) * slot);
+	auto data_paddr = m_request_region->object()->physical_page(0).paddr() + sizeof(RequestData) * slot;
+	data->header = {type, 0, sector};
+	data->status = 0xFF;
+
+	VirtQueue::Buffer buffers[3];
+	size_t num_buffers = 0;
+	buffers[num_buffers++] = {data_paddr + __builtin_offsetof(RequestData, header), sizeof(RequestHeader), false};
+	if (type == VIRTIO_BLK_T_IN || type == VIRTIO_BLK_T_OUT) {
+		auto bounce_paddr = m_bounce_region->object()->physical_page(0).paddr() + max_request_sectors * sector_size * slot;
+		buffers[num_buffers++] = {bounce_paddr, (uint32_t) (count * sector_size), type == VIRTIO_BLK_T_IN};
+	} else if (type == VIRTIO_BLK_T_DISCARD) {
+		data->discard = {sector, count, 0};
+		buffers[num_buffers++] = {data_paddr + __builtin_offsetof(RequestData, discard), sizeof(DiscardSegment), false};
+	}
+	buffers[num_buffers++] = {data_paddr + __builtin_offsetof(RequestData, status), sizeof(uint8_t), true};
+
+	m_slots[slot].blocker.set_ready(false);
+	TaskManager::IRQSafeCritical crit;
+	bool added = m_queue->add(buffers, num_buffers, &m_slots[slot]);
+	ASSERT(added); // There are few enough slots that there's always room
+	m_queue->kick();
+}
+
+Result VirtioBlockDevice::wait(int slot) {
+	TaskManager::current_thread()->block(m_slots[slot].blocker);
+	auto status = ((RequestData*) (m_request_region->start() + sizeof(RequestData) * slot))->status;
+	switch (status) {
+	case VIRTIO_BLK_S_OK:
+		return Result(SUCCESS);
+	case VIRTIO_BLK_S_UNSUPP:
+		return Result(ENOTSUP);
+	default:
+		return Result(EIO);
+	}
+}
+
+Result VirtioBlockDevice::do_io(uint32_t type, const BlockRange* ranges, size_t num_ranges) {
+	for (size_t i = 0; i < num_ranges; i++) {
+		if (ranges[i].block + (uint64_t) ranges[i].count > m_capacity)
+			return Result(EINVAL);
+	}
+
+	struct Pending {
+		int slot;
+		uint8_t* buffer;
+		uint32_t count;
+	};
+	Pending pending[max_slots];
+	size_t oldest = 0;
+	size_t num_pending = 0;
+	Result result = Result(SUCCESS);
+
+	auto finish_oldest = [&] {
+		auto& req = pending[oldest];
+		oldest = (oldest + 1) % max_slots;
+		num_pending--;
+		auto res = wait(req.slot);
+		if (res.is_error())
+			result = res;
+		else if (type == VIRTIO_BLK_T_IN)
+			memcpy(req.buffer, (void*) (m_bounce_region->start() + max_request_sectors * sector_size * req.slot), req.count * sector_size);
+		release_slot(req.slot);
+	};
+
+	// Keep as many requests in flight as we can get slots for, and only wait for the oldest one when we run out
+	for (size_t i = 0; i < num_ranges; i++) {
+		uint32_t block = ranges[i].block;
+		uint32_t count = ranges[i].count;
+		uint8_t* buffer = ranges[i].buffer;
+		while (count) {
+			int slot = acquire_slot(false);
+			if (slot < 0) {
+				if (num_pending) {
+					finish_oldest();
+					continue;
+				}
+				slot = acquire_slot(true);
+			}
+
+			auto num_sectors = min(count, (uint32_t) max_request_sectors);
+			if (type == VIRTIO_BLK_T_OUT)
+				memcpy((void*) (m_bounce_region->start() + max_request_sectors * sector_size * slot), buffer, num_sectors * sector_size);
+			submit(slot, type, block, num_sectors);
+			pending[(oldest + num_pending) % max_slots] = {slot, buffer, num_sectors};
+			num_pending++;
+
+			block += num_sectors;
+			buffer += num_sectors * sector_size;
+			count -= num_sectors;
+		}
+	}
+
+	while (num_pending)
+		finish_oldest();
+	return result;
+}
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "DiskDevice.h"
+#include "../pci/VirtioDevice.h"
+#include "../tasking/BooleanBlocker.h"
+#include "../tasking/Mutex.h"
+
+/**
+ * A driver for virtio block devices. Unlike PATADevice, requests don't have to be made one at a time: big reads and
+ * writes (and batches of them, like the disk cache's readahead and writeback) are split into several requests which
+ * are all in flight at once, and other threads can submit requests while they are. Requests are completed from the
+ * interrupt handler.
+ */
+class VirtioBlockDevice: public VirtioDevice, public DiskDevice {
+public:
+	static VirtioBlockDevice* find();
+
+	// DiskDevice
+	Result read_uncached_blocks(uint32_t block, uint32_t count, uint8_t* buffer) override;
+	Result write_uncached_blocks(uint32_t block, uint32_t count, const uint8_t* buffer) override;
+	Result read_uncached_ranges(const BlockRange* ranges, size_t count) override;
+	Result write_uncached_ranges(const BlockRange* ranges, size_t count) override;
+	Result flush_writes() override;
+	Result discard_uncached_blocks(uint32_t block, uint32_t count) override;
+	uint64_t max_addressable_block() override;
+	size_t block_size() override;
+
+protected:
+	// VirtioDevice
+	void handle_queue_irq() override;
+
+private:
+	explicit VirtioBlockDevice(PCI::Address addr);
+
+	struct RequestHeader {
+		uint32_t type;
+		uint32_t reserved;
+		uint64_t sector;
+	};
+
+	struct DiscardSegment {
+		uint64_t sector;
+		uint32_t num_sectors;
+		uint32_t flags;
+	};
+
+	/** The parts of a request that the device reads or writes, which live in DMA memory. **/
+	struct RequestData {
+		RequestHeader header;
+		DiscardSegment discard;
+		uint8_t status;
+	};
+
+	struct Slot {
+		UninterruptibleBooleanBlocker blocker;
+		bool in_use = false;
+	};
+
+	bool init();
+	int acquire_slot(bool wait);
+	void release_slot(int slot);
+	void submit(int slot, uint32_t type, uint64_t sector, uint32_t count);
+	Result wait(int slot);
+	Result do_io(uint32_t type, const BlockRange* ranges, size_t num_ranges);
+
+	static constexpr size_t max_slots = 32;
+	static constexpr size_t max_request_sectors = 128;
+	static constexpr size_t sector_size = 512;
+
+	VirtQueue* m_queue = nullptr;
+	uint64_t m_capacity = 0;
+	size_t m_num_slots = 0;
+	Slot m_slots[max_slots];
+	kstd::Arc<VMRegion> m_request_region;
+	kstd::Arc<VMRegion> m_bounce_region;
+	Mutex m_slot_lock {"VirtioBlockDevice::Slots"};
+	UninterruptibleBooleanBlocker m_slot_blocker; ///< Ready when a slot might be free.
+};
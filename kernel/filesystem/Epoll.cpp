@@ -0,0 +1,306 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "Epoll.h"
+#include "FileDescriptor.h"
+#include "../tasking/TaskManager.h"
+#include "../tasking/Thread.h"
+#include <kernel/arch/Processor.h>
+
+// Files may notify from an IRQ handler, so watch lists are only touched with interrupts disabled.
+using WatchListLock = TaskManager::IRQSafeCritical;
+
+static uint32_t ready_events(FileDescriptor& fd, uint32_t events) {
+	uint32_t revents = 0;
+	auto file = fd.file();
+	if((events & EPOLLIN) && file->can_read(fd))
+		revents |= EPOLLIN;
+	if((events & EPOLLOUT) && file->can_write(fd))
+		revents |= EPOLLOUT;
+	return revents;
+}
+
+Epoll::Epoll() = default;
+
+Epoll::~Epoll() {
+	for(auto& pair : m_watches) {
+		detach(pair.second);
+		delete pair.second;
+	}
+}
+
+Result Epoll::add(int fd_num, const kstd::Arc<FileDescriptor>& fd, const epoll_event& event) {
+	auto file = fd->file();
+	if(file.get() == this)
+		return Result(EINVAL);
+
+	LOCK(m_lock);
+	auto node = m_watches.find_node(fd_num);
+	if(node) {
+		// The fd number may have been closed and reused since it was added
+		auto* old_watch = node->data.second;
+		if(old_watch->fd.lock().get() == fd.get())
+			return Result(EEXIST);
+		detach(old_watch);
+		m_watches.erase(fd_num);
+		delete old_watch;
+	}
+
+	auto* watch = new EpollWatch();
+	watch->epoll = this;
+	watch->file = file.get();
+	watch->fd = fd;
+	watch->fd_num = fd_num;
+	watch->event = event;
+	m_watches.insert({fd_num, watch});
+
+	{
+		WatchListLock lock;
+		watch->m_file_next = file->m_watchers;
+		if(file->m_watchers)
+			file->m_watchers->m_file_prev = watch;
+		file->m_watchers = watch;
+	}
+
+	// Check whether it's already ready the next time we wait
+	queue(watch);
+	return Result(SUCCESS);
+}
+
+Result Epoll::modify(int fd_num, const kstd::Arc<FileDescriptor>& fd, const epoll_event& event) {
+	LOCK(m_lock);
+	auto* watch = find_watch(fd_num, fd);
+	if(!watch)
+		return Result(ENOENT);
+	{
+		WatchListLock lock;
+		watch->event = event;
+		watch->disarmed = false;
+	}
+	queue(watch);
+	return Result(SUCCESS);
+}
+
+Result Epoll::remove(int fd_num, const kstd::Arc<FileDescriptor>& fd) {
+	LOCK(m_lock);
+	auto* watch = find_watch(fd_num, fd);
+	if(!watch)
+		return Result(ENOENT);
+	detach(watch);
+	m_watches.erase(fd_num);
+	delete watch;
+	return Result(SUCCESS);
+}
+
+int Epoll::wait(SafePointer<epoll_event> events, int max_events, int timeout) {
+	WaitBlocker blocker(*this, timeout);
+	while(true) {
+		int count = 0;
+		{
+			LOCK(m_lock);
+
+			auto report = [&](EpollWatch* watch, uint32_t revents) {
+				// Whatever doesn't fit is reported next time
+				if(count >= max_events) {
+					if(watch->file->notifies_readiness())
+						queue(watch);
+					return;
+				}
+				events.set(count++, {revents, watch->event.data});
+				if(watch->event.events & EPOLLONESHOT)
+					watch->disarmed = true;
+				else if(!(watch->event.events & EPOLLET) && watch->file->notifies_readiness())
+					queue(watch);
+			};
+
+			// Go through everything that's ready up to now. Anything that's queued while we do, including the watches we
+			// queue again, goes after it.
+			EpollWatch* last;
+			{
+				WatchListLock lock;
+				last = m_ready_tail;
+			}
+			while(last) {
+				EpollWatch* watch;
+				{
+					WatchListLock lock;
+					watch = m_ready_head;
+					m_ready_head = watch->m_ready_next;
+					if(!m_ready_head)
+						m_ready_tail = nullptr;
+					watch->queued = false;
+					watch->m_ready_next = nullptr;
+				}
+
+				bool is_last = watch == last;
+				auto fd = watch->fd.lock();
+				if(!fd || !watch->file) {
+					// The file was closed, so it can't be watched anymore
+					detach(watch);
+					m_watches.erase(watch->fd_num);
+					delete watch;
+				} else if(watch->file->notifies_readiness()) {
+					auto revents = ready_events(*fd, watch->event.events);
+					if(revents)
+						report(watch, revents);
+				}
+				if(is_last)
+					break;
+			}
+
+			// Files that don't notify have to be checked every time
+			blocker.polled.resize(0);
+			for(auto& pair : m_watches) {
+				auto* polled = pair.second;
+				if(!polled->file || polled->file->notifies_readiness() || polled->disarmed)
+					continue;
+				auto fd = polled->fd.lock();
+				if(!fd)
+					continue;
+				auto revents = ready_events(*fd, polled->event.events);
+				if(revents)
+					report(polled, revents);
+				else
+					blocker.polled.push_back({fd, polled->event.events});
+			}
+		}
+
+		if(count || !timeout || blocker.timed_out())
+			return count;
+
+		{
+			WatchListLock lock;
+			blocker.thread = TaskManager::current_thread().get();
+			blocker.next = m_waiters;
+			m_waiters = &blocker;
+		}
+		TaskManager::current_thread()->block(blocker);
+		{
+			WatchListLock lock;
+			for(auto* waiter = &m_waiters; *waiter; waiter = &(*waiter)->next) {
+				if(*waiter == &blocker) {
+					*waiter = blocker.next;
+					break;
+				}
+			}
+		}
+		if(blocker.was_interrupted())
+			return -EINTR;
+	}
+}
+
+void Epoll::notify(File& file) {
+	WatchListLock lock;
+	for(auto* watch = file.m_watchers; watch; watch = watch->m_file_next)
+		watch->epoll->queue(watch);
+}
+
+void Epoll::file_destroyed(File& file) {
+	WatchListLock lock;
+	auto* watch = file.m_watchers;
+	while(watch) {
+		auto* next = watch->m_file_next;
+		watch->file = nullptr;
+		watch->m_file_prev = nullptr;
+		watch->m_file_next = nullptr;
+		watch = next;
+	}
+	file.m_watchers = nullptr;
+}
+
+bool Epoll::can_read(const FileDescriptor& fd) {
+	return m_ready_head;
+}
+
+bool Epoll::notifies_readiness() {
+	return true;
+}
+
+bool Epoll::is_epoll() {
+	return true;
+}
+
+EpollWatch* Epoll::find_watch(int fd_num, const kstd::Arc<FileDescriptor>& fd) {
+	auto node = m_watches.find_node(fd_num);
+	if(!node || node->data.second->fd.lock().get() != fd.get())
+		return nullptr;
+	return node->data.second;
+}
+
+void Epoll::queue(EpollWatch* watch) {
+	WatchListLock lock;
+	if(watch->queued || watch->disarmed)
+		return;
+	watch->queued = true;
+	watch->m_ready_next = nullptr;
+	if(m_ready_tail)
+		m_ready_tail->m_ready_next = watch;
+	else
+		m_ready_head = watch;
+	m_ready_tail = watch;
+
+	// Waiters woken in an IRQ handler are picked up by the scheduler instead
+	if(!Processor::in_interrupt()) {
+		for(auto* waiter = m_waiters; waiter; waiter = waiter->next)
+			waiter->thread->unblock();
+	}
+
+	// We may be watched by another epoll
+	notify_readiness();
+}
+
+void Epoll::unqueue(EpollWatch* watch) {
+	WatchListLock lock;
+	if(!watch->queued)
+		return;
+	EpollWatch* prev = nullptr;
+	for(auto* cur = m_ready_head; cur; prev = cur, cur = cur->m_ready_next) {
+		if(cur != watch)
+			continue;
+		if(prev)
+			prev->m_ready_next = cur->m_ready_next;
+		else
+			m_ready_head = cur->m_ready_next;
+		if(m_ready_tail == cur)
+			m_ready_tail = prev;
+		break;
+	}
+	watch->queued = false;
+	watch->m_ready_next = nullptr;
+}
+
+void Epoll::detach(EpollWatch* watch) {
+	WatchListLock lock;
+	unqueue(watch);
+	if(!watch->file)
+		return;
+	if(watch->m_file_prev)
+		watch->m_file_prev->m_file_next = watch->m_file_next;
+	else
+		watch->file->m_watchers = watch->m_file_next;
+	if(watch->m_file_next)
+		watch->m_file_next->m_file_prev = watch->m_file_prev;
+	watch->m_file_prev = nullptr;
+	watch->m_file_next = nullptr;
+	watch->file = nullptr;
+}
+
+Epoll::WaitBlocker::WaitBlocker(Epoll& epoll, int timeout):
+	m_epoll(epoll),
+	m_end_time(Time::now() + Time(timeout / 1000, (timeout % 1000) * 1000)),
+	m_has_timeout(timeout >= 0)
+{}
+
+bool Epoll::WaitBlocker::is_ready() {
+	if(m_epoll.m_ready_head)
+		return true;
+	for(auto& polled : polled) {
+		if(ready_events(*polled.fd, polled.events))
+			return true;
+	}
+	return timed_out();
+}
+
+bool Epoll::WaitBlocker::timed_out() {
+	return m_has_timeout && Time::now() >= m_end_time;
+}
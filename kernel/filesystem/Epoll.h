@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "File.h"
+#include "../api/epoll.h"
+#include "../kstd/map.hpp"
+#include "../kstd/vector.hpp"
+#include "../tasking/Blocker.h"
+#include "../tasking/Mutex.h"
+#include "../time/Time.h"
+
+class Epoll;
+class Thread;
+
+/** A file being watched by an Epoll. **/
+class EpollWatch {
+public:
+	Epoll* epoll;
+	File* file; ///< Null once the file has been destroyed.
+	kstd::Weak<FileDescriptor> fd;
+	int fd_num;
+	epoll_event event;
+	bool queued = false; ///< Whether it's in the epoll's ready list.
+	bool disarmed = false; ///< Whether it's a oneshot watch that's already been reported.
+
+private:
+	friend class Epoll;
+	EpollWatch* m_file_prev = nullptr;
+	EpollWatch* m_file_next = nullptr;
+	EpollWatch* m_ready_next = nullptr;
+};
+
+/**
+ * Watches a set of files and reports which of them are ready to read or write, like epoll on Linux.
+ *
+ * Most files call notify_readiness() when their state changes, which puts their watches on the ready list of each
+ * epoll watching them. wait() only has to look at what's on the ready list, so it doesn't matter how many files are
+ * being watched. Level-triggered watches are put back on the list after being reported until they're no longer ready,
+ * and edge-triggered ones aren't reported again until they're notified again. Files that don't notify (see
+ * File::notifies_readiness()) are checked on every wait() instead, and so are reported whenever they're ready even if
+ * they're edge-triggered.
+ */
+class Epoll: public File {
+public:
+	Epoll();
+	~Epoll() override;
+
+	Result add(int fd_num, const kstd::Arc<FileDescriptor>& fd, const epoll_event& event);
+	Result modify(int fd_num, const kstd::Arc<FileDescriptor>& fd, const epoll_event& event);
+	Result remove(int fd_num, const kstd::Arc<FileDescriptor>& fd);
+
+	/**
+	 * Waits for watched files to be ready.
+	 * @param events The buffer to write the ready events to.
+	 * @param max_events The most events to write.
+	 * @param timeout How long to wait for, in milliseconds. Negative waits forever, and zero doesn't wait at all.
+	 * @return The number of events written, or -EINTR.
+	 */
+	int wait(SafePointer<epoll_event> events, int max_events, int timeout);
+
+	/** Queues every watch of a file. Called by File::notify_readiness(). **/
+	static void notify(File& file);
+	/** Detaches every watch from a file that's being destroyed. **/
+	static void file_destroyed(File& file);
+
+	// File
+	bool can_read(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
+	bool is_epoll() override;
+
+private:
+	struct PolledFD {
+		kstd::Arc<FileDescriptor> fd;
+		uint32_t events;
+	};
+
+	class WaitBlocker: public Blocker {
+	public:
+		WaitBlocker(Epoll& epoll, int timeout);
+		bool is_ready() override;
+		bool timed_out();
+
+		Thread* thread = nullptr;
+		WaitBlocker* next = nullptr;
+		kstd::vector<PolledFD> polled; ///< The files that don't notify, which are checked every time.
+
+	private:
+		Epoll& m_epoll;
+		Time m_end_time;
+		bool m_has_timeout;
+	};
+
+	EpollWatch* find_watch(int fd_num, const kstd::Arc<FileDescriptor>& fd);
+	void queue(EpollWatch* watch);
+	void unqueue(EpollWatch* watch);
+	void detach(EpollWatch* watch);
+
+	Mutex m_lock {"Epoll"};
+	kstd::map<int, EpollWatch*> m_watches;
+	// The ready list is touched with interrupts disabled, since files may notify from an IRQ handler.
+	EpollWatch* m_ready_head = nullptr;
+	EpollWatch* m_ready_tail = nullptr;
+	WaitBlocker* m_waiters = nullptr;
+};
@@ -18,14 +18,16 @@
 */
 
 #include "File.h"
+#include "Epoll.h"
 #include <kernel/kstd/unix_types.h>
+#include <kernel/memory/VMObject.h>
 
 File::File() {
 
 }
 
 File::~File() {
-
+	Epoll::file_destroyed(*this);
 }
 
 bool File::is_inode() {
@@ -56,6 +58,10 @@ bool File::is_socket() {
 	return false;
 }
 
+bool File::is_epoll() {
+	return false;
+}
+
 ssize_t File::read(FileDescriptor &fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
 	return 0;
 }
@@ -89,3 +95,15 @@ bool File::can_write(const FileDescriptor& fd) {
 	return true;
 }
 
+kstd::Arc<VMObject> File::vm_object() {
+	return {};
+}
+
+bool File::notifies_readiness() {
+	return false;
+}
+
+void File::notify_readiness() {
+	if(m_watchers)
+		Epoll::notify(*this);
+}
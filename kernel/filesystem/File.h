@@ -25,6 +25,8 @@
 
 class FileDescriptor;
 class DirectoryEntry;
+class VMObject;
+class EpollWatch;
 class File {
 public:
 	virtual ~File();
@@ -38,13 +40,25 @@ public:
 	virtual bool is_pty();
 	virtual bool is_fifo();
 	virtual bool is_socket();
+	virtual bool is_epoll();
 	virtual int ioctl(unsigned request, SafePointer<void*> argp);
 	virtual void open(FileDescriptor& fd, int options);
 	virtual void close(FileDescriptor& fd);
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	/** The memory to map when a file that isn't an inode is mmap()ed, or nullptr if it can't be. **/
+	virtual kstd::Arc<VMObject> vm_object();
+	/** Whether the file calls notify_readiness() whenever it may have become ready. If not, Epoll has to poll it. **/
+	virtual bool notifies_readiness();
+	/** Tells anything watching the file with Epoll that it may have become ready to read or write. **/
+	void notify_readiness();
+
 protected:
 	File();
+
+private:
+	friend class Epoll;
+	EpollWatch* m_watchers = nullptr;
 };
 
 
@@ -136,8 +136,8 @@ Result FileBasedFilesystem::truncate_block(size_t block, size_t new_size) {
 }
 
 ResultRet<kstd::Arc<Inode>> FileBasedFilesystem::get_cached_inode(ino_t id) {
-	LOCK(m_inode_cache_lock);
-	auto inode = m_inode_cache.get(id);
+	LOCK_READ(m_inode_cache_lock);
+	auto inode = m_inode_cache.peek(id);
 	if(inode)
 		return inode.value();
 	return Result(-ENOENT);
@@ -158,16 +158,20 @@ Inode* FileBasedFilesystem::get_inode_rawptr(ino_t id) {
 }
 
 ResultRet<kstd::Arc<Inode>> FileBasedFilesystem::get_inode(ino_t id) {
-	LOCK(m_inode_cache_lock);
 	auto inode_perhaps = get_cached_inode(id);
-	if(inode_perhaps.is_error()) {
-		Inode* in = get_inode_rawptr(id);
-		if(in) {
-			auto ins = kstd::Arc<Inode>(in);
-			add_cached_inode(ins);
-			return ins;
-		} else return Result(-ENOENT);
-	} else {
+	if(!inode_perhaps.is_error())
 		return inode_perhaps.value();
-	}
+
+	// Check again with the lock held for writing, since another thread may have loaded the inode in the meantime
+	LOCK(m_inode_cache_lock);
+	auto loaded_inode = get_cached_inode(id);
+	if(!loaded_inode.is_error())
+		return loaded_inode.value();
+
+	Inode* in = get_inode_rawptr(id);
+	if(!in)
+		return Result(-ENOENT);
+	auto ins = kstd::Arc<Inode>(in);
+	add_cached_inode(ins);
+	return ins;
 }
@@ -23,6 +23,7 @@
 #include "../kstd/LRUCache.h"
 #include <kernel/time/Time.h>
 #include <kernel/tasking/Mutex.h>
+#include <kernel/tasking/RWLock.h>
 #include <kernel/kstd/vector.hpp>
 
 class FileBasedFilesystem: public Filesystem {
@@ -61,7 +62,7 @@ protected:
 
 private:
 	kstd::LRUCache<ino_t, kstd::Arc<Inode>> m_inode_cache;
-	Mutex m_inode_cache_lock {"InodeCache"};
+	RWLock m_inode_cache_lock {"InodeCache"};
 };
 
 
@@ -78,15 +78,18 @@ bool Inode::can_write(const FileDescriptor& fd) {
 	return true;
 }
 
+bool Inode::notifies_readiness() {
+	return false;
+}
+
 kstd::Arc<InodeVMObject> Inode::shared_vm_object(kstd::string name) {
 	LOCK(m_vmobject_lock);
 
-	kstd::Arc<InodeVMObject> ret;
-	if(!m_shared_vm_object) {
+	// The last object may have been freed since it was made
+	auto ret = m_shared_vm_object.lock();
+	if(!ret) {
 		ret = InodeVMObject::make_for_inode(name, self(), InodeVMObject::Type::Shared);
 		m_shared_vm_object = ret;
-	} else {
-		ret = m_shared_vm_object.lock();
 	}
 
 	return ret;
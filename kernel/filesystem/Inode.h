@@ -60,6 +60,8 @@ public :
 	virtual void close(FileDescriptor& fd) = 0;
 	virtual bool can_read(const FileDescriptor& fd);
 	virtual bool can_write(const FileDescriptor& fd);
+	/** Whether the inode calls File::notify_readiness() on the files it's opened with. See File::notifies_readiness(). **/
+	virtual bool notifies_readiness();
 
 	virtual InodeMetadata metadata();
 
@@ -79,3 +79,7 @@ bool InodeFile::can_write(const FileDescriptor& fd) {
 	return _inode->can_write(fd);
 }
 
+bool InodeFile::notifies_readiness() {
+	return _inode->notifies_readiness();
+}
+
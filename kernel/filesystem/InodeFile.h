@@ -35,6 +35,7 @@ public:
 	void close(FileDescriptor& fd) override;
 	virtual bool can_read(const FileDescriptor& fd) override;
 	virtual bool can_write(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 
 private:
 	kstd::Arc<Inode> _inode;
@@ -22,7 +22,9 @@
 #include <kernel/tasking/TaskManager.h>
 #include <kernel/filesystem/FileDescriptor.h>
 
-Pipe::Pipe(): _queue(PIPE_SIZE) {}
+Pipe::Pipe() {
+	_write_blocker.set_ready(true);
+}
 
 Pipe::~Pipe() = default;
 
@@ -36,49 +38,79 @@ void Pipe::add_writer() {
 
 void Pipe::remove_reader() {
 	_readers--;
+	if(!_readers)
+		_write_blocker.set_ready(true);
 }
 
 void Pipe::remove_writer() {
 	_writers--;
 	if(!_writers) {
 		_blocker.set_ready(true);
+		notify_readiness();
 	}
 }
 
 ssize_t Pipe::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	if(!_writers && _queue.empty()) return 0;
+	if(!_writers && _buffer.empty()) return 0;
 	if(!_blocker.is_ready())
 		TaskManager::current_thread()->block(_blocker);
 	if(_blocker.was_interrupted())
 		return -EINTR;
 	LOCK(_lock);
-	if(count > _queue.size())
-		count = _queue.size();
-	for(size_t i = 0; i < count; i++)
-		buffer.set(i, _queue.pop_front());
-	if(_queue.empty() && _writers)
+	count = _buffer.pop(count, [&](const uint8_t* span, size_t offset, size_t length) {
+		buffer.write(span, offset, length);
+	});
+	if(_buffer.empty() && _writers)
 		_blocker.set_ready(false);
+	if(count) {
+		_write_blocker.set_ready(true);
+		notify_readiness();
+	}
 	return count;
 }
 
 ssize_t Pipe::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	//TODO: Block writes bigger than available space
 	if(_readers == 0) {
 		TaskManager::current_process()->kill(SIGPIPE);
 		return -EPIPE;
 	}
+	if(!count)
+		return 0;
 
-	LOCK(_lock);
-
+	// Writes that fit in the pipe go in all at once, so they aren't interleaved with other writers'. Bigger ones go in
+	// piece by piece as the reader makes space. Either way, we only return early if we can't block or get interrupted.
+	size_t needed_space = count <= PIPE_SIZE ? count : 1;
 	size_t nwrote = 0;
-	bool flag = true;
-	while(nwrote < count && flag) {
-		flag = _queue.push_back(buffer.get(nwrote));
-		nwrote++;
-	}
+	_lock.acquire();
+	while(nwrote < count) {
+		while(_buffer.space() < min(needed_space, count - nwrote) && _readers) {
+			if(fd.nonblock()) {
+				_lock.release();
+				return nwrote ? nwrote : -EAGAIN;
+			}
+			_write_blocker.set_ready(false);
+			_lock.release();
+			TaskManager::current_thread()->block(_write_blocker);
+			if(_write_blocker.was_interrupted())
+				return nwrote ? nwrote : -EINTR;
+			_lock.acquire();
+		}
+
+		if(!_readers) {
+			_lock.release();
+			TaskManager::current_process()->kill(SIGPIPE);
+			return nwrote ? nwrote : -EPIPE;
+		}
+
+		size_t nchunk = _buffer.push(count - nwrote, [&](uint8_t* span, size_t offset, size_t length) {
+			buffer.read(span, nwrote + offset, length);
+		});
+		nwrote += nchunk;
 
-	if(nwrote)
 		_blocker.set_ready(true);
+		notify_readiness();
+	}
+	_lock.release();
 
 	return nwrote;
 }
@@ -88,5 +120,14 @@ bool Pipe::is_fifo() {
 }
 
 bool Pipe::can_read(const FileDescriptor& fd) {
-	return !_queue.empty() && !fd.is_fifo_writer();
+	// Once every writer is gone, reading returns EOF without blocking
+	return (!_buffer.empty() || !_writers) && !fd.is_fifo_writer();
+}
+
+bool Pipe::can_write(const FileDescriptor& fd) {
+	return _buffer.space() || !_readers;
+}
+
+bool Pipe::notifies_readiness() {
+	return true;
 }
@@ -21,8 +21,8 @@
 
 #include <kernel/memory/MemoryManager.h>
 #include <kernel/filesystem/File.h>
-#include <kernel/kstd/circular_queue.hpp>
 #include <kernel/tasking/Mutex.h>
+#include <kernel/kstd/ByteRing.h>
 
 #define PIPE_SIZE PAGE_SIZE
 
@@ -42,12 +42,15 @@ public:
 	ssize_t write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	bool is_fifo() override;
 	bool can_read(const FileDescriptor& fd) override;
+	bool can_write(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 
 private:
-	kstd::circular_queue<uint8_t> _queue;
+	kstd::ByteRing _buffer {PIPE_SIZE};
 	size_t _readers = 0;
 	size_t _writers = 0;
 	BooleanBlocker _blocker;
+	BooleanBlocker _write_blocker; ///< Ready when there's space to write, or nobody's left to read.
 	Mutex _lock {"Pipe"};
 };
 
@@ -141,6 +141,16 @@ ssize_t Ext2Inode::read(size_t start, size_t length, SafePointer<uint8_t> buffer
 	while(bytes_left) {
 		uint32_t blk = get_block_pointer(block_index);
 		if(!blk) break; // Sparse / unallocated block — treat as zeros
+
+		// Whole blocks going to kernel memory (like sendfile's buffer) can be read straight from the disk cache
+		size_t buf_offset = length - bytes_left;
+		if(!buffer.is_user() && (block_index != first_block || !first_block_start) && bytes_left >= ext2fs().block_size()) {
+			ext2fs().read_block(blk, buffer.raw() + buf_offset);
+			bytes_left -= ext2fs().block_size();
+			block_index++;
+			continue;
+		}
+
 		ext2fs().read_block(blk, block_buf);
 
 		if(block_index == first_block) {
@@ -28,16 +28,17 @@ ProcFS::ProcFS() {
 	entries.push_back(ProcFSEntry(RootUptime, 0));
 	entries.push_back(ProcFSEntry(RootCpuInfo, 0));
 	entries.push_back(ProcFSEntry(RootLockInfo, 0));
+	entries.push_back(ProcFSEntry(RootSnapshot, 0));
 
 	root_inode = kstd::make_shared<ProcFSInode>(*this, entries[0]);
 }
 
 ino_t ProcFS::id_for_entry(pid_t pid, ProcFSInodeType type) {
-	return (type & 0xFu) | ((unsigned)pid << 8u);
+	return (type & 0xFFu) | ((unsigned)pid << 8u);
 }
 
 ProcFSInodeType ProcFS::type_for_id(ino_t id) {
-	return static_cast<ProcFSInodeType>(id & 0xFu);
+	return static_cast<ProcFSInodeType>(id & 0xFFu);
 }
 
 pid_t ProcFS::pid_for_id(ino_t id) {
@@ -56,6 +57,7 @@ void ProcFS::proc_add(Process* proc) {
 	entries.push_back(ProcFSEntry(ProcStatus,    pid));
 	entries.push_back(ProcFSEntry(ProcStacks,    pid));
 	entries.push_back(ProcFSEntry(ProcVMSpace,   pid));
+	entries.push_back(ProcFSEntry(ProcThreads,   pid));
 }
 
 void ProcFS::proc_remove(Process* proc) {
@@ -8,6 +8,38 @@
 #include <kernel/KernelMapper.h>
 #include <kernel/time/TimeManager.h>
 #include <kernel/device/DiskDevice.h>
+#include <kernel/api/snapshot.h>
+
+// Appends "\n<name> = <value>" to str, which is how most fields in procfs files are written.
+static void append_field(kstd::string& str, const char* name, long long value) {
+	char numbuf[21];
+	str += "\n";
+	str += name;
+	str += " = ";
+	lltoa(value, numbuf, 10);
+	str += numbuf;
+}
+
+// Appends the fields shared by the stats of processes in status and threads in threads, with times in microseconds.
+static void append_stats(kstd::string& str, const ThreadStats& stats) {
+	append_field(str, "user_time", TimeManager::cycles_to_us(stats.user_cycles));
+	append_field(str, "kernel_time", TimeManager::cycles_to_us(stats.kernel_cycles));
+	append_field(str, "irq_time", TimeManager::cycles_to_us(stats.irq_cycles));
+	append_field(str, "wait_time", TimeManager::cycles_to_us(stats.wait_cycles));
+	append_field(str, "max_wait_time", TimeManager::cycles_to_us(stats.max_wait_cycles));
+	append_field(str, "voluntary_switches", stats.voluntary_switches);
+	append_field(str, "involuntary_switches", stats.involuntary_switches);
+	append_field(str, "wakeups", stats.wakeups);
+
+	char numbuf[12];
+	str += "\nwakeup_latency = ";
+	for (int i = 0; i < THREAD_LATENCY_BUCKETS; i++) {
+		itoa(stats.wakeup_latency[i], numbuf, 10);
+		str += numbuf;
+		if (i != THREAD_LATENCY_BUCKETS - 1)
+			str += ",";
+	}
+}
 
 ResultRet<kstd::string> ProcFSContent::mem_info() {
 	char numbuf[12];
@@ -74,6 +106,25 @@ ResultRet<kstd::string> ProcFSContent::cpu_info() {
 		percent_used -= (int) percent_used;
 		num_decimals++;
 	}
+
+	// Load averages are written with two decimal places
+	uint32_t loads[3];
+	TaskManager::load_averages(loads);
+	const char* load_names[] = {"load_1", "load_5", "load_15"};
+	for (int i = 0; i < 3; i++) {
+		str += "\n";
+		str += load_names[i];
+		str += " = ";
+		itoa(loads[i] >> LOAD_FIXED_SHIFT, numbuf, 10);
+		str += numbuf;
+		int hundredths = ((loads[i] & (LOAD_FIXED_1 - 1)) * 100) >> LOAD_FIXED_SHIFT;
+		str += hundredths < 10 ? ".0" : ".";
+		itoa(hundredths, numbuf, 10);
+		str += numbuf;
+	}
+
+	append_field(str, "context_switches", TaskManager::context_switches());
+	str += "\n";
 	return str;
 }
 
@@ -123,6 +174,10 @@ ResultRet<kstd::string> ProcFSContent::status(pid_t pid) {
 	itoa(proc->used_shmem(), numbuf, 10);
 	str += numbuf;
 
+	auto stats = proc->stats();
+	append_field(str, "cpu", TimeManager::cycles_to_us(stats.cpu_cycles()) / 1000);
+	append_stats(str, stats);
+
 	str += "\nthreads = ";
 	auto& threads = proc->threads();
 	for (size_t i = 0; i < threads.size(); i++) {
@@ -227,25 +282,131 @@ ResultRet<kstd::string> ProcFSContent::vmspace(pid_t pid) {
 	return string;
 }
 
-#ifdef DEBUG
-extern kstd::map<Lock*, int> g_lock_registry;
-#endif
+ResultRet<kstd::string> ProcFSContent::threads(pid_t pid) {
+	auto proc = TRY(TaskManager::process_for_pid(pid));
+	kstd::string str;
+	char numbuf[12];
+	for (auto& tid : proc->threads()) {
+		auto thread = proc->get_thread(tid);
+		if (!thread)
+			continue;
+		itoa(tid, numbuf, 10);
+		str += "[";
+		str += numbuf;
+		str += "]\nstate = ";
+		str += thread->state_name();
+		append_stats(str, thread->stats());
+		str += "\n";
+	}
+	return str;
+}
 
 ResultRet<kstd::string> ProcFSContent::lock_info() {
-#ifdef DEBUG
-	kstd::string string;
+	struct LockStats {
+		char name[48];
+		unsigned long acquired;
+		unsigned long contended;
+		uint64_t wait_time;
+	};
+
+	// We can't allocate while iterating, since the allocator creates locks too. So, count the locks first.
+	// Only locks that threads have had to wait for are listed, since there are a whole lot of locks.
+	size_t num_locks = 0;
+	Lock::iterate_locks([&] (Lock* lock) -> kstd::IterationAction {
+		if (lock->contest_count())
+			num_locks++;
+		return kstd::IterationAction::Continue;
+	});
+
+	kstd::vector<LockStats> stats;
+	stats.resize(num_locks + 16);
+	size_t stats_count = 0;
+	Lock::iterate_locks([&] (Lock* lock) -> kstd::IterationAction {
+		if (!lock->contest_count())
+			return kstd::IterationAction::Continue;
+		if (stats_count == stats.size())
+			return kstd::IterationAction::Break;
+		auto& stat = stats[stats_count++];
+		auto& name = lock->name();
+		size_t name_length = min(name.length(), sizeof(stat.name) - 1);
+		memcpy(stat.name, name.c_str(), name_length);
+		stat.name[name_length] = '\0';
+		stat.acquired = lock->acquire_count();
+		stat.contended = lock->contest_count();
+		stat.wait_time = lock->wait_time();
+		return kstd::IterationAction::Continue;
+	});
+
+	kstd::string string = "name\tacquired\tcontended\twait_us\n";
 	char numbuf[32];
-	for (auto pair : g_lock_registry) {
-		if (pair.first->contest_count() == 0)
-			continue;
-		string += pair.first->name();
+	for (size_t i = 0; i < stats_count; i++) {
+		string += stats[i].name;
+		string += "\t";
+		lltoa(stats[i].acquired, numbuf, 10);
+		string += numbuf;
+		string += "\t";
+		lltoa(stats[i].contended, numbuf, 10);
+		string += numbuf;
 		string += "\t";
-		lltoa(pair.first->contest_count(), numbuf, 10);
+		lltoa(stats[i].wait_time, numbuf, 10);
 		string += numbuf;
 		string += "\n";
 	}
 	return string;
-#else
-	return kstd::string("");
-#endif
-}
\ No newline at end of file
+}
+
+ssize_t ProcFSContent::snapshot(size_t start, size_t length, SafePointer<uint8_t> buffer) {
+	if (start)
+		return 0;
+	if (length < sizeof(proc_snapshot_header))
+		return -EINVAL;
+
+	proc_snapshot_header header = {
+		.version = PROC_SNAPSHOT_VERSION,
+		.record_size = sizeof(proc_snapshot_record),
+		.num_processes = 0,
+		.num_records = 0,
+		.uptime = 0
+	};
+	auto uptime = TimeManager::uptime();
+	header.uptime = (uint64_t) uptime.tv_sec * 1000 + uptime.tv_usec / 1000;
+
+	// Fill in the records first, since the process list can't stay locked while copying them out to userspace
+	size_t max_records = (length - sizeof(proc_snapshot_header)) / sizeof(proc_snapshot_record);
+	kstd::vector<proc_snapshot_record> records;
+	{
+		LOCK(TaskManager::g_process_lock);
+		auto procs = TaskManager::process_list();
+		records.reserve(min(max_records, procs->size()));
+		for (auto proc : *procs) {
+			if (proc->state() == Process::DEAD)
+				continue;
+			header.num_processes++;
+			if (records.size() >= max_records)
+				continue;
+
+			proc_snapshot_record record;
+			record.pid = proc->pid();
+			record.ppid = proc->ppid();
+			record.uid = proc->user().euid;
+			record.gid = proc->user().egid;
+			record.state = proc->all_threads_state();
+			record.num_threads = proc->threads().size();
+			record.cpu_time = proc->cpu_time();
+			record.pmem = proc->used_pmem();
+			record.vmem = proc->used_vmem();
+			record.shmem = proc->used_shmem();
+			auto& name = proc->name();
+			size_t name_length = min(name.length(), sizeof(record.name) - 1);
+			memset(record.name, 0, sizeof(record.name));
+			memcpy(record.name, name.c_str(), name_length);
+			records.push_back(record);
+		}
+	}
+
+	header.num_records = records.size();
+	buffer.write((uint8_t*) &header, sizeof(header));
+	size_t records_size = records.size() * sizeof(proc_snapshot_record);
+	buffer.write((uint8_t*) records.storage(), sizeof(header), records_size);
+	return sizeof(header) + records_size;
+}
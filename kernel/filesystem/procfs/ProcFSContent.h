@@ -6,6 +6,7 @@
 #include <kernel/kstd/string.h>
 #include <kernel/Result.hpp>
 #include <kernel/api/types.h>
+#include <kernel/memory/SafePointer.h>
 
 namespace ProcFSContent {
 	ResultRet<kstd::string> mem_info();
@@ -14,5 +15,7 @@ namespace ProcFSContent {
 	ResultRet<kstd::string> status(pid_t pid);
 	ResultRet<kstd::string> stacks(pid_t pid);
 	ResultRet<kstd::string> vmspace(pid_t pid);
+	ResultRet<kstd::string> threads(pid_t pid);
 	ResultRet<kstd::string> lock_info();
+	ssize_t snapshot(size_t start, size_t length, SafePointer<uint8_t> buffer);
 };
@@ -86,6 +86,11 @@ ProcFSEntry::ProcFSEntry(ProcFSInodeType type, pid_t pid): type(type), pid(pid)
 			dirent_type = TYPE_FILE;
 			parent = 1;
 			break;
+		case RootSnapshot:
+			name = "snapshot";
+			dirent_type = TYPE_FILE;
+			parent = 1;
+			break;
 
 		case ProcCwd:
 			name = "cwd";
@@ -116,6 +121,11 @@ ProcFSEntry::ProcFSEntry(ProcFSInodeType type, pid_t pid): type(type), pid(pid)
 			dirent_type = TYPE_FILE;
 			parent = ProcFS::id_for_entry(pid, RootProcEntry);
 			break;
+		case ProcThreads:
+			name = "threads";
+			dirent_type = TYPE_FILE;
+			parent = ProcFS::id_for_entry(pid, RootProcEntry);
+			break;
 	}
 
 	dir_entry = DirectoryEntry(ProcFS::id_for_entry(pid, type), dirent_type, name);
@@ -83,6 +83,8 @@ ResultRet<kstd::string> ProcFSInode::get_string_contents() {
 			return ProcFSContent::stacks(pid);
 		case ProcVMSpace:
 			return ProcFSContent::vmspace(pid);
+		case ProcThreads:
+			return ProcFSContent::threads(pid);
 		default:
 			return Result(-EINVAL);
 	}
@@ -91,6 +93,8 @@ ResultRet<kstd::string> ProcFSInode::get_string_contents() {
 ssize_t ProcFSInode::read(size_t start, size_t length, SafePointer<uint8_t> buffer, FileDescriptor* fd) {
 	if(_metadata.is_directory())
 		return -EISDIR;
+	if(type == RootSnapshot)
+		return ProcFSContent::snapshot(start, length, buffer);
 
 	auto string_res = get_string_contents();
 	if (string_res.is_error())
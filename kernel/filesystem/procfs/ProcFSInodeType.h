@@ -32,12 +32,14 @@ enum ProcFSInodeType {
 	RootUptime,
 	RootCpuInfo,
 	RootLockInfo,
+	RootSnapshot,
 
 	//Process entries
 	ProcExe,
 	ProcCwd,
 	ProcStatus,
 	ProcStacks,
-	ProcVMSpace
+	ProcVMSpace,
+	ProcThreads
 };
 
@@ -46,6 +46,16 @@ sockid_t SocketFS::client_hash(const void* fd_pointer) {
 	return hash;
 }
 
+uint32_t SocketFS::name_hash(const kstd::string& name) {
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < name.length(); i++) {
+		hash ^= (uint8_t) name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
 char* SocketFS::name() {
 	return "socketfs";
 }
@@ -55,10 +65,9 @@ ResultRet<kstd::Arc<Inode>> SocketFS::get_inode(ino_t id) {
 		return static_cast<kstd::Arc<Inode>>(root_entry);
 
 	LOCK(lock);
-	for(size_t i = 0; i < sockets.size(); i++) {
-		if(sockets[i]->id == id)
-			return static_cast<kstd::Arc<Inode>>(sockets[i]);
-	}
+	auto socket = socket_with_id(id);
+	if(socket)
+		return static_cast<kstd::Arc<Inode>>(socket);
 
 	return Result(-ENOENT);
 }
@@ -70,3 +79,41 @@ ino_t SocketFS::root_inode_id() {
 uint8_t SocketFS::fsid() {
 	return SOCKETFS_FSID;
 }
+
+void SocketFS::add_socket(const kstd::Arc<SocketFSInode>& socket) {
+	sockets.push_back(socket);
+	name_buckets[name_hash(socket->name) % SOCKETFS_HASH_BUCKETS].push_back(socket);
+	id_buckets[socket->id % SOCKETFS_HASH_BUCKETS].push_back(socket);
+}
+
+static bool remove_from(kstd::vector<kstd::Arc<SocketFSInode>>& list, SocketFSInode* socket) {
+	for(size_t i = 0; i < list.size(); i++) {
+		if(list[i].get() == socket) {
+			list.erase(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SocketFS::remove_socket(SocketFSInode* socket) {
+	remove_from(name_buckets[name_hash(socket->name) % SOCKETFS_HASH_BUCKETS], socket);
+	remove_from(id_buckets[socket->id % SOCKETFS_HASH_BUCKETS], socket);
+	return remove_from(sockets, socket);
+}
+
+kstd::Arc<SocketFSInode> SocketFS::socket_named(const kstd::string& name) {
+	for(auto& socket : name_buckets[name_hash(name) % SOCKETFS_HASH_BUCKETS]) {
+		if(socket->name == name)
+			return socket;
+	}
+	return {};
+}
+
+kstd::Arc<SocketFSInode> SocketFS::socket_with_id(ino_t id) {
+	for(auto& socket : id_buckets[id % SOCKETFS_HASH_BUCKETS]) {
+		if(socket->id == id)
+			return socket;
+	}
+	return {};
+}
@@ -22,9 +22,11 @@
 #include <kernel/filesystem/Filesystem.h>
 #include "socketfs_defines.h"
 #include <kernel/kstd/vector.hpp>
+#include <kernel/kstd/string.h>
 #include <kernel/tasking/Mutex.h>
 
 #define SOCKETFS_FSID 3
+#define SOCKETFS_HASH_BUCKETS 64
 
 struct SocketFSPacket {
 	int type;
@@ -54,6 +56,7 @@ public:
 	static pid_t get_pid(ino_t inode);
 	static uint16_t get_fileno(ino_t inode);
 	static sockid_t client_hash(const void* fd_pointer);
+	static uint32_t name_hash(const kstd::string& name);
 
 	//Filesystem
 	char* name() override;
@@ -63,7 +66,17 @@ public:
 
 protected:
 	friend class SocketFSInode;
+
+	// These must be called with lock held.
+	void add_socket(const kstd::Arc<SocketFSInode>& socket);
+	bool remove_socket(SocketFSInode* socket);
+	kstd::Arc<SocketFSInode> socket_named(const kstd::string& name);
+	kstd::Arc<SocketFSInode> socket_with_id(ino_t id);
+
 	kstd::vector<kstd::Arc<SocketFSInode>> sockets;
+	// Sockets are also hashed by name and by inode id, so they can be looked up without going through all of them.
+	kstd::vector<kstd::Arc<SocketFSInode>> name_buckets[SOCKETFS_HASH_BUCKETS];
+	kstd::vector<kstd::Arc<SocketFSInode>> id_buckets[SOCKETFS_HASH_BUCKETS];
 	kstd::Arc<SocketFSInode> root_entry;
 	Mutex lock {"SocketFS"};
 
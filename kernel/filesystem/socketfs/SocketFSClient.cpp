@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "SocketFSClient.h"
+#include <kernel/memory/kliballoc.h>
+
+SocketFSMessage* SocketFSMessage::alloc(size_t length) {
+	auto* message = (SocketFSMessage*) kmalloc(sizeof(SocketFSMessage) + length);
+	if(message)
+		message->next = nullptr;
+	return message;
+}
+
+SocketFSClient::~SocketFSClient() {
+	while(m_head) {
+		auto* next = m_head->next;
+		kfree(m_head);
+		m_head = next;
+	}
+}
+
+void SocketFSClient::push(SocketFSMessage* message) {
+	message->next = nullptr;
+	if(m_tail)
+		m_tail->next = message;
+	else
+		m_head = message;
+	m_tail = message;
+	m_queued_bytes += message->size();
+}
+
+size_t SocketFSClient::read(SafePointer<uint8_t> buf, size_t length) {
+	size_t nread = 0;
+	while(m_head) {
+		size_t count = m_head->size() - m_head_offset;
+		if(count > length - nread) {
+			// Messages are only split up if there's no room for anything else
+			if(nread)
+				break;
+			count = length;
+		}
+
+		buf.write(m_head->bytes() + m_head_offset, nread, count);
+		nread += count;
+		m_head_offset += count;
+		m_queued_bytes -= count;
+		if(m_head_offset < m_head->size())
+			break;
+
+		auto* next = m_head->next;
+		kfree(m_head);
+		m_head = next;
+		m_head_offset = 0;
+		if(!m_head)
+			m_tail = nullptr;
+	}
+	return nread;
+}
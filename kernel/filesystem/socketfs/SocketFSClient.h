@@ -19,20 +19,56 @@
 
 #pragma once
 
+#include "SocketFS.h"
 #include <kernel/kstd/Arc.h>
-#include <kernel/kstd/queue.hpp>
 #include <kernel/kstd/unix_types.h>
+#include <kernel/memory/SafePointer.h>
 #include <kernel/tasking/Mutex.h>
 
+/**
+ * A message waiting to be read by a client. It's allocated with kmalloc() in one piece, with the payload right after
+ * the packet header, so it can be copied out to the reader as-is.
+ */
+struct SocketFSMessage {
+	SocketFSMessage* next;
+	SocketFSPacket packet;
+
+	/** Allocates a message with room for length bytes of payload, or returns null if it can't. **/
+	static SocketFSMessage* alloc(size_t length);
+	[[nodiscard]] size_t size() const { return sizeof(SocketFSPacket) + packet.length; }
+	[[nodiscard]] const uint8_t* bytes() const { return (const uint8_t*) &packet; }
+};
+
 class Process;
+class File;
 class SocketFSClient {
 public:
-	explicit SocketFSClient(sockid_t id, pid_t pid): id(id), pid(pid), data_queue() {}
+	explicit SocketFSClient(sockid_t id, pid_t pid): id(id), pid(pid) {}
+	~SocketFSClient();
+
+	/** Adds a message to the end of the queue and takes ownership of it. data_lock must be held. **/
+	void push(SocketFSMessage* message);
+
+	/**
+	 * Copies the rest of the message at the front of the queue to buf, followed by as many whole messages as fit. If
+	 * not even the rest of the first message fits, as much of it as does is copied. data_lock must be held.
+	 * @return The number of bytes copied.
+	 */
+	size_t read(SafePointer<uint8_t> buf, size_t length);
+
+	/** The number of bytes waiting to be read. **/
+	[[nodiscard]] size_t queued_bytes() const { return m_queued_bytes; }
+	[[nodiscard]] bool empty() const { return !m_head; }
 
 	sockid_t id;
 	pid_t pid;
-	kstd::queue<uint8_t> data_queue;
 	Mutex data_lock {"SocketFSClient"};
 	BooleanBlocker blocker;
-};
+	File* file = nullptr; ///< The file the client reads from, which is notified when a message is pushed. Guarded by data_lock.
 
+private:
+	SocketFSMessage* m_head = nullptr;
+	SocketFSMessage* m_tail = nullptr;
+	size_t m_head_offset = 0; ///< How much of the message at the front has been read already.
+	size_t m_queued_bytes = 0;
+};
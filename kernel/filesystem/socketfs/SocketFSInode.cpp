@@ -59,10 +59,10 @@ InodeMetadata SocketFSInode::metadata() {
 }
 
 ino_t SocketFSInode::find_id(const kstd::string& find_name) {
-	for(size_t i = 0; i < fs.sockets.size(); i++) {
-		if(fs.sockets[i]->name == find_name)
-			return fs.sockets[i]->id;
-	}
+	LOCK(fs.lock);
+	auto socket = fs.socket_named(find_name);
+	if(socket)
+		return socket->id;
 	return -ENOENT;
 }
 
@@ -80,19 +80,8 @@ ssize_t SocketFSInode::read(size_t start, size_t length, SafePointer<uint8_t> bu
 		return -EIO;
 
 	LOCK(reader->data_lock);
-
-	if(length > reader->data_queue.size())
-		length = reader->data_queue.size();
-
-	//Read into the buffer from the queue
-	auto& queue = reader->data_queue;
-	for(size_t i = 0; i < length; i++) {
-		buffer.set(i, queue.front());
-		queue.pop_front();
-	}
-
+	length = reader->read(buffer, length);
 	reader->blocker.set_ready(true);
-
 	return length;
 }
 
@@ -118,20 +107,37 @@ ssize_t SocketFSInode::write(size_t start, size_t length, SafePointer<uint8_t> b
 	if(!fd)
 		return -EINVAL;
 
-	auto packet = SafePointer<SocketFSPacket>(buf).get();
-	auto packet_data = SafePointer<uint8_t>(buf.raw() + sizeof(SocketFSPacket), buf.is_user());
-	bool is_broadcast = packet.type == SOCKETFS_TYPE_BROADCAST;
-
-	//Find the client that the packet is coming from
+	//Find the client that the packets are coming from
 	auto sender = get_client(fd);
-	kstd::Arc<SocketFSClient> recipient;
-
 	if(!sender) {
 		//Couldn't find the client it came from...
 		return -EIO;
 	}
 
-	if(is_broadcast && sender == host) {
+	//Several packets can be written back to back, so send each of them
+	size_t offset = 0;
+	while(offset + sizeof(SocketFSPacket) <= length) {
+		auto packet = SafePointer<SocketFSPacket>((SocketFSPacket*) (buf.raw() + offset), buf.is_user()).get();
+		if(packet.length > length - offset - sizeof(SocketFSPacket))
+			return offset ? (ssize_t) offset : -EINVAL;
+
+		auto packet_data = SafePointer<uint8_t>(buf.raw() + offset + sizeof(SocketFSPacket), buf.is_user());
+		auto res = send_packet(sender, packet, packet_data, fd->nonblock());
+		if(res.is_error())
+			return offset ? (ssize_t) offset : res.code();
+		offset += sizeof(SocketFSPacket) + packet.length;
+	}
+
+	if(!offset)
+		return -EINVAL;
+
+	return (ssize_t) offset;
+}
+
+Result SocketFSInode::send_packet(const kstd::Arc<SocketFSClient>& sender, const SocketFSPacket& packet, SafePointer<uint8_t> packet_data, bool nonblock) {
+	kstd::Arc<SocketFSClient> recipient;
+
+	if(packet.type == SOCKETFS_TYPE_BROADCAST && sender == host) {
 		//If it's a broadcast, send it to all clients
 		LOCK(m_clients_lock);
 		for(auto& client : m_clients) {
@@ -139,9 +145,9 @@ ssize_t SocketFSInode::write(size_t start, size_t length, SafePointer<uint8_t> b
 			if(packet.shm_id)
 				TaskManager::current_process()->sys_shmallow(packet.shm_id, client->pid, packet.shm_perms);
 			//We don't care about errors here, we should just continue sending it to the rest of the clients
-			write_packet(client, SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data, fd->nonblock());
+			write_packet(client, SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data, nonblock);
 		}
-		return SUCCESS;
+		return Result(SUCCESS);
 	} else if(sender == host) {
 		//Find the client this packet has to go to
 		LOCK(m_clients_lock);
@@ -151,27 +157,26 @@ ssize_t SocketFSInode::write(size_t start, size_t length, SafePointer<uint8_t> b
 				break;
 			}
 		}
-	} else if(sender != host) {
+	} else {
 		//Clients can only send packets to the host
 		if(packet.recipient != SOCKETFS_RECIPIENT_HOST)
-			return -EINVAL;
+			return Result(-EINVAL);
 		recipient = host;
 	}
 
 	if(!recipient) {
-		return -EINVAL; //No such recipient
+		return Result(-EINVAL); //No such recipient
 	}
 
 	//Share shm with recipient if we need to
 	if(packet.shm_id) {
 		int shm_res = TaskManager::current_process()->sys_shmallow(packet.shm_id, recipient->pid, packet.shm_perms);
 		if (shm_res != SUCCESS)
-			return shm_res;
+			return Result(shm_res);
 	}
 
 	//Finally, write the packet to the correct queue
-	auto res = write_packet(recipient, SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data, fd->nonblock());
-	return res.code();
+	return write_packet(recipient, SOCKETFS_TYPE_MSG, sender->id, packet.length, packet.shm_id, packet.shm_perms, packet_data, nonblock);
 }
 
 Result SocketFSInode::add_entry(const kstd::string& add_name, Inode& inode) {
@@ -195,14 +200,12 @@ ResultRet<kstd::Arc<Inode>> SocketFSInode::create_entry(const kstd::string& crea
 	ino_t create_id = SocketFS::get_inode_id(proc->pid(), hash);
 
 	//Make sure that nothing exists with the same name / id
-	for(size_t i = 0; i < fs.sockets.size(); i++) {
-		if(fs.sockets[i]->name == create_name || fs.sockets[i]->id == create_id)
-			return Result(-EEXIST);
-	}
+	if(fs.socket_named(create_name) || fs.socket_with_id(create_id))
+		return Result(-EEXIST);
 
 	//Create the socket and return it
 	auto new_inode = kstd::make_shared<SocketFSInode>(fs, create_id, create_name, mode, uid, gid);
-	fs.sockets.push_back(new_inode);
+	fs.add_socket(new_inode);
 	return static_cast<kstd::Arc<Inode>>(new_inode);
 }
 
@@ -234,12 +237,16 @@ void SocketFSInode::open(FileDescriptor& fd, int options) {
 	if(host->id == 0 && (options & O_CREAT)) {
 		host->id = client_hash;
 		host->pid = TaskManager::current_process()->pid();
+		LOCK(host->data_lock);
+		host->file = fd.file().get();
 		return;
 	}
 
 	//Add the client and send the connect message to the host
 	LOCK(m_clients_lock);
-	m_clients.push_back(kstd::Arc<SocketFSClient>::make(client_hash, fd.owner()));
+	auto client = kstd::Arc<SocketFSClient>::make(client_hash, fd.owner());
+	client->file = fd.file().get();
+	m_clients.push_back(client);
 	write_packet(host, SOCKETFS_TYPE_MSG_CONNECT, client_hash, 0, 0, 0, KernelPointer<uint8_t>(nullptr), true);
 }
 
@@ -249,13 +256,13 @@ void SocketFSInode::close(FileDescriptor& fd) {
 	if(client_hash == host->id) {
 		//Remove the socket
 		is_open = false;
-		ScopedLocker __locker2(fs.lock);
-		for(size_t i = 0; i < fs.sockets.size(); i++) {
-			if(fs.sockets[i].get() == this) {
-				fs.sockets.erase(i);
-				return;
-			}
+		{
+			LOCK(host->data_lock);
+			host->file = nullptr;
 		}
+		ScopedLocker __locker2(fs.lock);
+		if(fs.remove_socket(this))
+			return;
 		KLog::warn("SocketFS", "Socket {} was closed by host but couldn't find an entry to remove!", id);
 		return;
 	}
@@ -264,47 +271,59 @@ void SocketFSInode::close(FileDescriptor& fd) {
 	for(size_t i = 0; i < m_clients.size(); i++) {
 		if(client_hash == m_clients[i]->id) {
 			write_packet(host, SOCKETFS_TYPE_MSG_DISCONNECT, client_hash, 0, 0, 0, KernelPointer<uint8_t>(nullptr), true);
+			{
+				LOCK(m_clients[i]->data_lock);
+				m_clients[i]->file = nullptr;
+			}
 			m_clients.erase(i);
 			break;
 		}
 	}
 }
 
+bool SocketFSInode::notifies_readiness() {
+	return true;
+}
+
 bool SocketFSInode::can_read(const FileDescriptor& fd) {
 	auto id = SocketFS::client_hash(&fd);
 	if(id == host->id)
-		return !host->data_queue.empty();
+		return !host->empty();
 	for(auto& client : m_clients)
 		if(client->id == id)
-			return !client->data_queue.empty();
+			return !client->empty();
 	return false;
 }
 
 Result SocketFSInode::write_packet(const kstd::Arc<SocketFSClient>& client, int type, sockid_t sender, size_t length, int shm_id, int shm_perms, SafePointer<uint8_t> buffer, bool nonblock) {
-	//If there's room in the buffer, block (if O_NONBLOCK isn't set)
-	while(sizeof(SocketFSPacket) + length + client->data_queue.size() > SOCKETFS_MAX_BUFFER_SIZE) {
+	size_t size = sizeof(SocketFSPacket) + length;
+	if(size > SOCKETFS_MAX_BUFFER_SIZE)
+		return Result(-EMSGSIZE);
+
+	//If there's no room in the buffer, block (if O_NONBLOCK isn't set)
+	while(size + client->queued_bytes() > SOCKETFS_MAX_BUFFER_SIZE) {
 		if(!nonblock) {
 			client->blocker.set_ready(false);
 			TaskManager::current_thread()->block(client->blocker);
 			if(client->blocker.was_interrupted())
-				return Result(EINTR);
+				return Result(-EINTR);
 		} else {
 			return Result(-ENOSPC);
 		}
 	}
 
-	//Acquire the lock
-	LOCK(client->data_lock);
-
-	//Write the packet header
-	SocketFSPacket packet_header = {type, sender, TaskManager::current_process()->pid(), length, shm_id, shm_perms};
-	auto* data = (const uint8_t*) &packet_header;
-	for(size_t i = 0; i < sizeof(SocketFSPacket); i++)
-		client->data_queue.push_back(*data++);
+	//Copy the whole packet into a message before taking the lock, so the reader isn't held up by it
+	auto* message = SocketFSMessage::alloc(length);
+	if(!message)
+		return Result(-ENOMEM);
+	message->packet = {type, sender, TaskManager::current_process()->pid(), length, shm_id, shm_perms};
+	if(length)
+		buffer.read(message->packet.data, 0, length);
 
-	//Write the packet body
-	for(size_t i = 0; i < length; i++)
-		client->data_queue.push_back(buffer.get(i));
+	LOCK(client->data_lock);
+	client->push(message);
+	if(client->file)
+		client->file->notify_readiness();
 
 	return Result(SUCCESS);
 }
@@ -54,12 +54,14 @@ public:
 	void open(FileDescriptor& fd, int options) override;
 	void close(FileDescriptor& fd) override;
 	bool can_read(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 
 	SocketFS& fs;
 	ino_t id;
 	kstd::string name;
 
 private:
+	Result send_packet(const kstd::Arc<SocketFSClient>& sender, const SocketFSPacket& packet, SafePointer<uint8_t> packet_data, bool nonblock);
 	Result write_packet(const kstd::Arc<SocketFSClient>& recipient, int type, sockid_t sender, size_t size, int shm_id, int shm_perms, SafePointer<uint8_t> buffer, bool nonblock);
 
 	[[nodiscard]] kstd::Arc<SocketFSClient> get_client(const FileDescriptor* fd) const;
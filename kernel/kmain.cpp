@@ -45,6 +45,7 @@
 #include "bootlogo.h"
 #include "arch/Processor.h"
 #include "net/NetworkAdapter.h"
+#include "device/VirtioBlockDevice.h"
 
 #if defined(__i386__)
 #include "arch/i386/device/PATADevice.h"
@@ -100,14 +101,18 @@ void kmain_late(){
 #elif defined(__i386__)
 	KLog::dbg("kinit", "Initializing disk...");
 
-	//Setup the disk (Assumes we're using primary master drive
-	auto disk = kstd::Arc<PATADevice>(PATADevice::find(
+	//Setup the disk (Prefers a virtio disk, otherwise assumes we're using primary master drive)
+	kstd::Arc<DiskDevice> disk;
+	if(auto* virtio_disk = VirtioBlockDevice::find())
+		disk = kstd::Arc<DiskDevice>(virtio_disk);
+	else if(auto* pata_disk = PATADevice::find(
 					PATADevice::PRIMARY,
 					PATADevice::MASTER,
 					CommandLine::inst().has_option("use_pio") //Use PIO if the command line option is present
-				));
+				))
+		disk = kstd::Arc<DiskDevice>(pata_disk);
 	if(!disk) {
-		KLog::crit("kinit", "Couldn't find IDE controller! Hanging...");
+		KLog::crit("kinit", "Couldn't find a disk! Hanging...");
 		while(1);
 	}
 
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "types.h"
+#include "unix_types.h"
+#include "kstdlib.h"
+#include "cstring.h"
+#include "../memory/kliballoc.h"
+
+namespace kstd {
+	/**
+	 * A fixed-size ring of bytes. Unlike circular_queue<uint8_t>, data goes in and out in bulk: the contents are at
+	 * most two contiguous spans (the end of the storage, then the start), so copies are at most two memcpys.
+	 *
+	 * If the storage can't be allocated, the ring has a capacity of zero (see allocated()), and nothing fits in it.
+	 */
+	class ByteRing {
+	public:
+		explicit ByteRing(size_t capacity): _storage((uint8_t*) kmalloc(capacity)), _capacity(_storage ? capacity : 0) {}
+		ByteRing(const ByteRing& other) = delete;
+		~ByteRing() { kfree(_storage); }
+
+		/**
+		 * Appends as many of count bytes as fit, calling produce(uint8_t* span, size_t offset, size_t length) to fill in
+		 * each contiguous span of them. Returns how many were appended.
+		 */
+		template<typename F>
+		size_t push(size_t count, F produce) {
+			count = min(count, space());
+			if(!count)
+				return 0;
+			size_t end = (_start + _size) % _capacity;
+			size_t first_part = min(count, _capacity - end);
+			produce(_storage + end, 0, first_part);
+			if(first_part < count)
+				produce(_storage, first_part, count - first_part);
+			_size += count;
+			return count;
+		}
+
+		/** Appends as many of count bytes as fit, and returns how many that was. **/
+		size_t push(const uint8_t* data, size_t count) {
+			return push(count, [&](uint8_t* span, size_t offset, size_t length) {
+				memcpy(span, data + offset, length);
+			});
+		}
+
+		bool push_back(uint8_t byte) {
+			return push(&byte, 1);
+		}
+
+		/**
+		 * Removes up to count bytes from the front, calling consume(const uint8_t* span, size_t offset, size_t length)
+		 * for each contiguous span of them. Returns how many were removed.
+		 */
+		template<typename F>
+		size_t pop(size_t count, F consume) {
+			count = min(count, _size);
+			if(!count)
+				return 0;
+			size_t first_part = min(count, _capacity - _start);
+			consume(_storage + _start, 0, first_part);
+			if (first_part < count)
+				consume(_storage, first_part, count - first_part);
+			_start = (_start + count) % _capacity;
+			_size -= count;
+			if (!_size)
+				_start = 0;
+			return count;
+		}
+
+		/** Removes up to count bytes from the front into dest. **/
+		size_t pop(uint8_t* dest, size_t count) {
+			return pop(count, [&](const uint8_t* span, size_t offset, size_t length) {
+				memcpy(dest + offset, span, length);
+			});
+		}
+
+		/** Moves the contents into new storage of new_capacity bytes. Fails if they don't fit or it can't be allocated. **/
+		bool resize(size_t new_capacity) {
+			if(new_capacity < _size)
+				return false;
+			auto* new_storage = (uint8_t*) kmalloc(new_capacity);
+			if(!new_storage)
+				return false;
+			size_t size = _size;
+			pop(new_storage, size);
+			kfree(_storage);
+			_storage = new_storage;
+			_capacity = new_capacity;
+			_start = 0;
+			_size = size;
+			return true;
+		}
+
+		uint8_t pop_back() {
+			_size--;
+			return _storage[(_start + _size) % _capacity];
+		}
+
+		/** Returns the offset from the front of the first occurrence of byte, or -1 if there is none. **/
+		ssize_t find(uint8_t byte) const {
+			size_t first_part = min(_size, _capacity - _start);
+			auto* found = (const uint8_t*) memchr(_storage + _start, byte, first_part);
+			if (found)
+				return found - (_storage + _start);
+			found = (const uint8_t*) memchr(_storage, byte, _size - first_part);
+			if (found)
+				return (ssize_t) (first_part + (found - _storage));
+			return -1;
+		}
+
+		uint8_t operator[](size_t index) const { return _storage[(_start + index) % _capacity]; }
+		uint8_t back() const { return (*this)[_size - 1]; }
+		[[nodiscard]] bool empty() const { return !_size; }
+		[[nodiscard]] size_t size() const { return _size; }
+		[[nodiscard]] size_t space() const { return _capacity - _size; }
+		[[nodiscard]] size_t capacity() const { return _capacity; }
+		[[nodiscard]] bool allocated() const { return _storage; }
+
+	private:
+		uint8_t* _storage;
+		size_t _capacity;
+		size_t _start = 0;
+		size_t _size = 0;
+	};
+}
@@ -63,6 +63,14 @@ namespace kstd {
 			return kstd::nullopt;
 		}
 
+		/** Gets the item with the given key without promoting it, so the cache isn't modified. **/
+		kstd::Optional<Value> peek(Key key) {
+			auto item = m_map.get(key);
+			if(item)
+				return *item;
+			return kstd::nullopt;
+		}
+
 		/** Prunes a number of items from the cache. **/
 		void prune(size_t num) {
 			while(!m_lru_list.empty() && num--) {
@@ -84,6 +92,25 @@ namespace kstd {
 			return kstd::pair<Key, Value&> {m_lru_list[0], m_map[m_lru_list[0]]};
 		}
 
+		/**
+		 * Returns the least recently used item that the given predicate returns true for, with a null value if there
+		 * isn't one. Nothing is allocated, so this is safe to use while reclaiming memory.
+		 */
+		template<typename F>
+		kstd::pair<Key, Value*> lru_matching(F predicate) {
+			for(size_t i = 0; i < m_lru_list.size(); i++) {
+				auto* value = m_map.get(m_lru_list[i]);
+				if(predicate(*value))
+					return {m_lru_list[i], value};
+			}
+			return {Key(), nullptr};
+		}
+
+		/** Gets a pointer to the item with the given key without promoting it, or nullptr if it isn't present. **/
+		Value* peek_unsafe(Key key) {
+			return m_map.get(key);
+		}
+
 		[[nodiscard]] size_t size() const { return m_lru_list.size(); }
 		[[nodiscard]] bool empty() const { return m_lru_list.empty(); }
 
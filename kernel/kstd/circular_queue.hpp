@@ -104,6 +104,10 @@ namespace kstd {
 			return _storage[_back];
 		}
 
+		T& operator[](size_t index) const {
+			return _storage[(_front + index) % _capacity];
+		}
+
 		bool empty() const {
 			return _size == 0;
 		}
@@ -46,8 +46,13 @@ bool strcmp(const char* str1, const char* str2){
 
 extern "C" void* memset(void* dest, int c, size_t n) {
 #if defined(__i386__)
+	// Fill a dword at a time, then the remaining bytes. The kernel doesn't preserve SSE state, so no vector stores here.
 	void* odest = dest;
-	asm volatile( "rep stosb" : "=D"(dest), "=c"(n) : "0"(dest), "1"(n), "a"(c) : "memory");
+	uint32_t value = (uint8_t) c * 0x01010101u;
+	size_t dwords = n / 4;
+	size_t bytes = n % 4;
+	asm volatile("rep stosl" : "+D"(dest), "+c"(dwords) : "a"(value) : "memory");
+	asm volatile("rep stosb" : "+D"(dest), "+c"(bytes) : "a"(value) : "memory");
 	return odest;
 #else
 	auto* ptr = (uint8_t*) dest;
@@ -62,7 +67,10 @@ extern "C" void* memset(void* dest, int c, size_t n) {
 extern "C" void *memcpy(void *dest, const void *src, size_t count){
 #if defined(__i386__)
 	void* odest = dest;
-	asm volatile( "rep movsb" : "+D"(dest), "+S"(src), "+c"(count)::"memory");
+	size_t dwords = count / 4;
+	size_t bytes = count % 4;
+	asm volatile("rep movsl" : "+D"(dest), "+S"(src), "+c"(dwords) :: "memory");
+	asm volatile("rep movsb" : "+D"(dest), "+S"(src), "+c"(bytes) :: "memory");
 	return odest;
 #elif defined(__aarch64__)
 	auto* dptr = (uint8_t*) dest;
@@ -76,18 +84,46 @@ extern "C" void *memcpy(void *dest, const void *src, size_t count){
 #endif
 }
 
-extern "C" void* memmove(void* dest, const void* src, size_t n) {
-	if (dest < src) 
+// The optimize attribute keeps GCC from turning the byte loop back into a call to memmove
+extern "C" __attribute__((optimize("no-tree-loop-distribute-patterns"))) void* memmove(void* dest, const void* src, size_t n) {
+	// Copying forwards is fine unless the destination starts inside of the source
+	if ((uintptr_t) dest - (uintptr_t) src >= n)
 		return memcpy(dest, src, n);
 
-	uint8_t* dest8 = (uint8_t*) dest;
-	const uint8_t* src8 = (const uint8_t*) src;
-	for (dest8 += n, src8 += n; n--;)
+	typedef uint32_t __attribute__((may_alias, aligned(1))) unaligned_u32;
+	uint8_t* dest8 = (uint8_t*) dest + n;
+	const uint8_t* src8 = (const uint8_t*) src + n;
+	for (; n >= 4; n -= 4) {
+		dest8 -= 4;
+		src8 -= 4;
+		*(unaligned_u32*) dest8 = *(const unaligned_u32*) src8;
+	}
+	while (n--)
 		*--dest8 = *--src8;
 
 	return dest;
 }
 
+extern "C" void* memchr(const void* s, int c, size_t n) {
+	// Check a dword at a time once aligned. (x - 0x01..) & ~x & 0x80.. is nonzero iff one of x's bytes is zero.
+	auto* p = (const uint8_t*) s;
+	for (; n && (uintptr_t) p % sizeof(uint32_t); n--, p++) {
+		if (*p == (uint8_t) c)
+			return (void*) p;
+	}
+	uint32_t pattern = (uint8_t) c * 0x01010101u;
+	for (; n >= sizeof(uint32_t); n -= sizeof(uint32_t), p += sizeof(uint32_t)) {
+		uint32_t word = *(const uint32_t*) p ^ pattern;
+		if ((word - 0x01010101u) & ~word & 0x80808080u)
+			break;
+	}
+	for (; n; n--, p++) {
+		if (*p == (uint8_t) c)
+			return (void*) p;
+	}
+	return nullptr;
+}
+
 void* memcpy_uint32(uint32_t* d, uint32_t* s, size_t n) {
 #if defined(__i386__)
 	void* od = d;
@@ -99,10 +135,21 @@ void* memcpy_uint32(uint32_t* d, uint32_t* s, size_t n) {
 }
 
 int strlen(const char *str){
-	const char *s;
+	// Check a dword at a time once aligned. Aligned reads can't cross into an unmapped page.
+	const char *s = str;
+	for (; (uintptr_t) s % 4; s++) {
+		if (!*s)
+			return s - str;
+	}
 
-	for (s = str; *s; ++s)
-		;
+	typedef uint32_t __attribute__((may_alias)) aliased_u32;
+	for (;; s += 4) {
+		uint32_t word = *(const aliased_u32*) s;
+		if ((word - 0x01010101u) & ~word & 0x80808080u)
+			break;
+	}
+	while (*s)
+		s++;
 	return (s - str);
 }
 
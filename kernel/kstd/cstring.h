@@ -28,6 +28,7 @@ bool strcmp(const char *str1, const char *str2);
 extern "C" void *memset(void *dest, int val, size_t count);
 extern "C" void *memcpy(void *dest, const void *src, size_t count);
 void* memcpy_uint32(uint32_t* d, uint32_t* s, size_t n);
+extern "C" void* memchr(const void* s, int c, size_t n);
 int strlen(const char *str);
 void substr(int i, char *src, char *dest);
 void substri(int i, char *src, char *dest);
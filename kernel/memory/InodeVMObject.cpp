@@ -2,12 +2,31 @@
 /* Copyright © 2016-2023 Byteduck */
 
 #include "InodeVMObject.h"
+#include "MemoryManager.h"
 
 kstd::Arc<InodeVMObject> InodeVMObject::make_for_inode(kstd::string name, kstd::Arc<Inode> inode, InodeVMObject::Type type) {
+	auto size = inode->metadata().size;
+	if(type == Type::Private)
+		return make_private(kstd::move(name), kstd::move(inode), 0, size, size);
+
+	kstd::vector<PageIndex> pages;
+	pages.resize((size + PAGE_SIZE - 1) / PAGE_SIZE);
+	memset(pages.storage(), 0, pages.size() * sizeof(PageIndex));
+	auto object = kstd::Arc<InodeVMObject>(new InodeVMObject(name, pages, kstd::move(inode), type, false));
+	object->m_file_size = size;
+	return object;
+}
+
+kstd::Arc<InodeVMObject> InodeVMObject::make_private(kstd::string name, kstd::Arc<Inode> inode, size_t offset, size_t file_size, size_t size) {
 	kstd::vector<PageIndex> pages;
-	pages.resize((inode->metadata().size + PAGE_SIZE - 1) / PAGE_SIZE);
+	pages.resize((size + PAGE_SIZE - 1) / PAGE_SIZE);
 	memset(pages.storage(), 0, pages.size() * sizeof(PageIndex));
-	return kstd::Arc<InodeVMObject>(new InodeVMObject(name, pages, kstd::move(inode), type, false));
+	auto shared = (offset % PAGE_SIZE == 0) ? inode->shared_vm_object(name) : kstd::Arc<InodeVMObject>();
+	auto object = kstd::Arc<InodeVMObject>(new InodeVMObject(kstd::move(name), pages, kstd::move(inode), Type::Private, false));
+	object->m_file_offset = offset;
+	object->m_file_size = file_size;
+	object->m_shared = kstd::move(shared);
+	return object;
 }
 
 ResultRet<kstd::Arc<VMObject>> InodeVMObject::clone() {
@@ -17,6 +36,9 @@ ResultRet<kstd::Arc<VMObject>> InodeVMObject::clone() {
 	become_cow_and_ref_pages();
 	auto new_object = kstd::Arc(new InodeVMObject(m_name, m_physical_pages, m_inode, m_type, m_type == Type::Private));
 	new_object->m_committed_pages = this->m_committed_pages;
+	new_object->m_file_offset = m_file_offset;
+	new_object->m_file_size = m_file_size;
+	new_object->m_shared = m_shared;
 	return kstd::static_pointer_cast<VMObject>(new_object);
 }
 
@@ -38,15 +60,24 @@ ResultRet<bool> InodeVMObject::try_fault_in_page(size_t index) {
 			return false;
 	}
 
+	// Pages that are entirely in the file don't need a copy of their own until they're written to.
+	if(m_shared && (index + 1) * PAGE_SIZE <= m_file_size)
+		return borrow_shared_page(index);
+
 	// Allocate and read the page WITHOUT holding VMObject::Page.
 	auto new_page_res = MM.alloc_physical_page();
 	if(new_page_res.is_error())
 		return new_page_res.result();
 	auto new_page = new_page_res.value();
 
+	size_t page_start = index * PAGE_SIZE;
+	size_t to_read = page_start < m_file_size ? min(m_file_size - page_start, (size_t) PAGE_SIZE) : 0;
 	ssize_t nread = 0;
 	MM.with_quickmapped(new_page, [&](void* buf) {
-		nread = m_inode->read(index * PAGE_SIZE, PAGE_SIZE, KernelPointer<uint8_t>((uint8_t*) buf), nullptr);
+		if(to_read)
+			nread = m_inode->read(m_file_offset + page_start, to_read, KernelPointer<uint8_t>((uint8_t*) buf), nullptr);
+		if(nread >= 0)
+			memset((uint8_t*) buf + nread, 0, PAGE_SIZE - nread);
 	});
 	if(nread < 0) {
 		MM.free_physical_page(new_page);
@@ -66,4 +97,25 @@ ResultRet<bool> InodeVMObject::try_fault_in_page(size_t index) {
 	}
 
 	return true;
-}
\ No newline at end of file
+}
+
+ResultRet<bool> InodeVMObject::borrow_shared_page(PageIndex index) {
+	auto shared_index = m_file_offset / PAGE_SIZE + index;
+	TRY(m_shared->try_fault_in_page(shared_index));
+
+	PageIndex page;
+	{
+		LOCK(m_shared->m_page_lock);
+		page = m_shared->m_physical_pages[shared_index];
+		MM.get_physical_page(page).ref();
+	}
+
+	LOCK(m_page_lock);
+	if(m_physical_pages[index]) {
+		MM.get_physical_page(page).unref();
+		return false;
+	}
+	m_physical_pages[index] = page;
+	m_cow_pages.set(index, true);
+	return true;
+}
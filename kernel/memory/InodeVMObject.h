@@ -14,6 +14,18 @@ public:
 
 	static kstd::Arc<InodeVMObject> make_for_inode(kstd::string name, kstd::Arc<Inode> inode, Type type);
 
+	/**
+	 * Makes a private object for part of an inode, like an ELF segment. Its first file_size bytes are read from the inode
+	 * starting at offset, and the rest of it is zero-filled. Pages that are entirely read from the file are shared with
+	 * the inode's shared object until they're written to, as long as offset is page-aligned.
+	 * @param name The name of the object.
+	 * @param inode The inode to read from.
+	 * @param offset Where in the inode the object starts.
+	 * @param file_size The number of bytes to read from the inode.
+	 * @param size The size of the object, which is rounded up to the nearest page.
+	 */
+	static kstd::Arc<InodeVMObject> make_private(kstd::string name, kstd::Arc<Inode> inode, size_t offset, size_t file_size, size_t size);
+
 	/**
 	 * Reads in the page at the given index if it isn't allocated yet.
 	 * @param index The index of the page to read in.
@@ -35,7 +47,13 @@ public:
 private:
 	explicit InodeVMObject(kstd::string name, kstd::vector<PageIndex> physical_pages, kstd::Arc<Inode> inode, Type type, bool cow);
 
+	/** Maps in a page of the shared object as a CoW page at the given index. **/
+	ResultRet<bool> borrow_shared_page(PageIndex index);
+
 	kstd::Arc<Inode> m_inode;
 	Type m_type;
 	size_t m_committed_pages = 0;
+	size_t m_file_offset = 0;
+	size_t m_file_size = 0; ///< The number of bytes read from the inode. Anything after it is zero-filled.
+	kstd::Arc<InodeVMObject> m_shared; ///< The inode's shared object, which clean pages of a private object come from.
 };
@@ -31,7 +31,7 @@ void PageDirectory::map(VMRegion& region, VirtualRange range) {
 		auto ppage = region.object()->physical_page(page_index + page_offset).index();
 		VMProt page_prot = {
 			.read = prot.read,
-			.write = region.object()->page_is_cow(page_index) ? false : prot.write,
+			.write = region.object()->page_is_cow(page_index + page_offset) ? false : prot.write,
 			.execute = prot.execute
 		};
 
@@ -31,7 +31,7 @@ VMSpace::~VMSpace() {
 }
 
 kstd::Arc<VMSpace> VMSpace::fork(PageDirectory& page_directory, kstd::vector<kstd::Arc<VMRegion>>& regions_vec) {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	auto new_space = kstd::Arc<VMSpace>(new VMSpace(m_start, m_size, page_directory));
 	new_space->m_used = m_used;
 	delete new_space->m_region_map;
@@ -188,7 +188,7 @@ Result VMSpace::unmap_region(VirtualAddress address) {
 }
 
 ResultRet<kstd::Arc<VMRegion>> VMSpace::get_region_at(VirtualAddress address) {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	VMSpaceRegion* cur_region = m_region_map;
 	while(cur_region) {
 		if(cur_region->start == address) {
@@ -202,7 +202,7 @@ ResultRet<kstd::Arc<VMRegion>> VMSpace::get_region_at(VirtualAddress address) {
 }
 
 ResultRet<kstd::Arc<VMRegion>> VMSpace::get_region_containing(VirtualAddress address) {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	VMSpaceRegion* cur_region = m_region_map;
 	while(cur_region) {
 		if(cur_region->contains(address)) {
@@ -221,7 +221,7 @@ Result VMSpace::reserve_region(VirtualAddress start, size_t size) {
 }
 
 Result VMSpace::try_pagefault(PageFault fault) {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	auto cur_region = m_region_map;
 	while(cur_region) {
 		if(cur_region->contains(fault.address)) {
@@ -258,7 +258,7 @@ Result VMSpace::try_pagefault(PageFault fault) {
 				}
 
 				// Or, we may have encountered a race where the page was created by another thread after the fault.
-				m_page_directory.map(*vmRegion, VirtualRange { object_page * PAGE_SIZE, PAGE_SIZE });
+				m_page_directory.map(*vmRegion, VirtualRange { error_page * PAGE_SIZE, PAGE_SIZE });
 				return Result(SUCCESS);
 			}
 
@@ -277,7 +277,7 @@ Result VMSpace::try_pagefault(PageFault fault) {
 }
 
 ResultRet<VirtualAddress> VMSpace::find_free_space(size_t size) {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	auto cur_region = m_region_map;
 	while(cur_region) {
 		if(!cur_region->used && cur_region->size >= size)
@@ -288,7 +288,7 @@ ResultRet<VirtualAddress> VMSpace::find_free_space(size_t size) {
 }
 
 size_t VMSpace::calculate_regular_anonymous_total() {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	size_t total_pages = 0;
 	auto cur_region = m_region_map;
 	while(cur_region) {
@@ -302,7 +302,7 @@ size_t VMSpace::calculate_regular_anonymous_total() {
 }
 
 void VMSpace::iterate_regions(kstd::IterationFunc<VMRegion*> callback) {
-	LOCK(m_lock);
+	LOCK_READ(m_lock);
 	auto cur_region = m_region_map;
 	while(cur_region) {
 		if(cur_region->used)
@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "ARPCache.h"
+#include "NetworkManager.h"
+#include "../kstd/KLog.h"
+
+Mutex ARPCache::s_lock { "ARPCache" };
+ARPCache::Entry ARPCache::s_entries[num_entries];
+ARPCache::Entry* ARPCache::s_buckets[num_buckets];
+ARPCache::Entry* ARPCache::s_lru_head = nullptr;
+ARPCache::Entry* ARPCache::s_lru_tail = nullptr;
+ARPCache::Entry* ARPCache::s_free_entries = nullptr;
+bool ARPCache::s_initialized = false;
+size_t ARPCache::s_num_pending = 0;
+Atomic<uint32_t> ARPCache::s_generation = 0;
+const Time ARPCache::request_interval = {1, 0};
+const Time ARPCache::entry_lifetime = {60, 0};
+
+ResultRet<MACAddress> ARPCache::resolve(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter) {
+	// We cannot do this on the NetworkManager thread because we might need to block
+	ASSERT(NetworkManager::inst().thread() != TaskManager::current_thread());
+
+	for (bool first_try = true;; first_try = false) {
+		uint32_t generation;
+		Time deadline;
+		{
+			LOCK(s_lock);
+			// If the entry disappears while we're waiting, the address didn't answer
+			auto* entry = first_try ? get_or_create(addr, adapter) : find(addr);
+			if (!entry)
+				return Result(ENOENT);
+			if (entry->state == State::Reachable) {
+				KLog::dbg_if<ARP_DEBUG>("ARPCache", "Found ARP entry for {}: {}", addr, entry->mac);
+				return entry->mac;
+			}
+			generation = s_generation.load(MemoryOrder::Acquire);
+			deadline = entry->last_request + request_interval;
+		}
+
+		// Wait for a reply, or until it's time to ask again
+		ResolveBlocker blocker(generation, deadline);
+		TaskManager::current_thread()->block(blocker);
+		if (blocker.was_interrupted())
+			return Result(ENOENT);
+	}
+}
+
+ResultRet<MACAddress> ARPCache::lookup(const IPv4Address& addr) {
+	LOCK(s_lock);
+	auto* entry = find(addr);
+	if (!entry || entry->state != State::Reachable)
+		return Result(ENOENT);
+	promote(entry);
+	return entry->mac;
+}
+
+void ARPCache::send_packet(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter, NetworkAdapter::Packet* packet) {
+	auto* header = (NetworkAdapter::FrameHeader*) packet->buffer;
+	{
+		LOCK(s_lock);
+		auto* entry = get_or_create(addr, adapter);
+		if (!entry)
+			return;
+		if (entry->state != State::Reachable) {
+			if (entry->num_pending >= max_pending_per_entry || s_num_pending >= max_pending) {
+				KLog::dbg_if<ARP_DEBUG>("ARPCache", "Dropping packet for {}, too many waiting to be resolved", addr);
+				return;
+			}
+
+			adapter->retain_packet(packet);
+			entry->pending[entry->num_pending++] = {packet, adapter};
+			s_num_pending++;
+			return;
+		}
+		header->destination = entry->mac;
+	}
+	adapter->send_packet(packet);
+}
+
+void ARPCache::update(const IPv4Address& addr, const MACAddress& mac, const kstd::Arc<NetworkAdapter>& adapter, bool create) {
+	PendingPacket pending[max_pending_per_entry];
+	size_t num_pending;
+	{
+		LOCK(s_lock);
+		auto* entry = find(addr);
+		if (!entry) {
+			if (!create)
+				return;
+			entry = ARPCache::create(addr, adapter);
+		}
+
+		if (entry->state != State::Reachable)
+			KLog::dbg_if<ARP_DEBUG>("ARPCache", "{} is at {}", addr, mac);
+		entry->mac = mac;
+		entry->adapter = adapter;
+		entry->state = State::Reachable;
+		entry->updated = Time::now();
+		entry->num_requests = 0;
+		promote(entry);
+
+		num_pending = entry->num_pending;
+		for (size_t i = 0; i < num_pending; i++)
+			pending[i] = kstd::move(entry->pending[i]);
+		s_num_pending -= num_pending;
+		entry->num_pending = 0;
+	}
+	s_generation.add(1, MemoryOrder::Release);
+
+	// Send everything that was waiting on the address, each from the adapter it was sent with
+	for (size_t i = 0; i < num_pending; i++) {
+		auto& waiting = pending[i];
+		((NetworkAdapter::FrameHeader*) waiting.packet->buffer)->destination = mac;
+		waiting.adapter->send_packet(waiting.packet);
+		waiting.adapter->release_packet(waiting.packet);
+	}
+}
+
+bool ARPCache::ResolveBlocker::is_ready() {
+	return s_generation.load(MemoryOrder::Acquire) != m_generation || Time::now() >= m_deadline;
+}
+
+ARPCache::Entry* ARPCache::find(const IPv4Address& addr) {
+	auto* entry = s_buckets[bucket_for(addr)];
+	while (entry && entry->addr != addr)
+		entry = entry->hash_next;
+	if (!entry)
+		return nullptr;
+
+	auto now = Time::now();
+	if (entry->state == State::Reachable) {
+		// Stale entries are still used while we ask again, and forgotten if nobody answers for long enough
+		if (now < entry->updated + entry_lifetime)
+			return entry;
+		if (now >= entry->updated + entry_lifetime + entry_lifetime) {
+			remove(entry);
+			return nullptr;
+		}
+		if (entry->num_requests < max_requests && now >= entry->last_request + request_interval)
+			send_request(entry);
+		return entry;
+	}
+
+	// Give up on addresses that haven't answered any of our requests
+	if (entry->num_requests >= max_requests && now >= entry->last_request + request_interval) {
+		KLog::dbg_if<ARP_DEBUG>("ARPCache", "{} didn't answer, giving up", addr);
+		remove(entry);
+		return nullptr;
+	}
+	if (now >= entry->last_request + request_interval)
+		send_request(entry);
+	return entry;
+}
+
+ARPCache::Entry* ARPCache::get_or_create(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter) {
+	if (auto* entry = find(addr)) {
+		promote(entry);
+		return entry;
+	}
+	if (!adapter)
+		return nullptr;
+	auto* entry = create(addr, adapter);
+	send_request(entry);
+	return entry;
+}
+
+ARPCache::Entry* ARPCache::create(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter) {
+	if (!s_initialized) {
+		for (auto& entry : s_entries) {
+			entry.hash_next = s_free_entries;
+			s_free_entries = &entry;
+		}
+		s_initialized = true;
+	}
+
+	// Take a free entry, or reuse the least recently used one
+	if (!s_free_entries)
+		remove(s_lru_tail);
+	auto* entry = s_free_entries;
+	s_free_entries = entry->hash_next;
+
+	entry->addr = addr;
+	entry->state = State::Incomplete;
+	entry->num_requests = 0;
+	entry->adapter = adapter;
+	auto& bucket = s_buckets[bucket_for(addr)];
+	entry->hash_next = bucket;
+	bucket = entry;
+	entry->lru_prev = nullptr;
+	entry->lru_next = s_lru_head;
+	if (s_lru_head)
+		s_lru_head->lru_prev = entry;
+	s_lru_head = entry;
+	if (!s_lru_tail)
+		s_lru_tail = entry;
+	return entry;
+}
+
+void ARPCache::remove(Entry* entry) {
+	// Unlink from the hash table
+	auto** link = &s_buckets[bucket_for(entry->addr)];
+	while (*link != entry)
+		link = &(*link)->hash_next;
+	*link = entry->hash_next;
+
+	// Unlink from the LRU list
+	if (entry->lru_prev)
+		entry->lru_prev->lru_next = entry->lru_next;
+	else
+		s_lru_head = entry->lru_next;
+	if (entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		s_lru_tail = entry->lru_prev;
+
+	// Drop anything that was waiting on it
+	for (size_t i = 0; i < entry->num_pending; i++) {
+		auto& waiting = entry->pending[i];
+		waiting.adapter->release_packet(waiting.packet);
+		waiting.adapter = kstd::Arc<NetworkAdapter>(nullptr);
+	}
+	s_num_pending -= entry->num_pending;
+	entry->num_pending = 0;
+
+	entry->state = State::Free;
+	entry->adapter = kstd::Arc<NetworkAdapter>(nullptr);
+	entry->hash_next = s_free_entries;
+	s_free_entries = entry;
+}
+
+void ARPCache::promote(Entry* entry) {
+	if (entry == s_lru_head)
+		return;
+	entry->lru_prev->lru_next = entry->lru_next;
+	if (entry->lru_next)
+		entry->lru_next->lru_prev = entry->lru_prev;
+	else
+		s_lru_tail = entry->lru_prev;
+	entry->lru_prev = nullptr;
+	entry->lru_next = s_lru_head;
+	s_lru_head->lru_prev = entry;
+	s_lru_head = entry;
+}
+
+void ARPCache::send_request(Entry* entry) {
+	KLog::dbg_if<ARP_DEBUG>("ARPCache", "Making ARP request for {}", entry->addr);
+	ARPPacket packet;
+	packet.operation = ARPOp::Req;
+	packet.sender_protoaddr = entry->adapter->ipv4_address();
+	packet.sender_hwaddr = entry->adapter->mac_address();
+	packet.target_protoaddr = entry->addr;
+	packet.target_hwaddr = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	entry->adapter->send_arp_packet(packet.target_hwaddr, packet);
+	entry->last_request = Time::now();
+	entry->num_requests++;
+}
+
+size_t ARPCache::bucket_for(const IPv4Address& addr) {
+	// The last octet is in the high byte of val(), so take the high bits of the product, which depend on every octet.
+	return (uint32_t) (addr.val() * 0x9E3779B1u) >> (32 - bucket_bits);
+}
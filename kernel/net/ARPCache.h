@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "../tasking/Mutex.h"
+#include "../tasking/Blocker.h"
+#include "../time/Time.h"
+#include "../api/ipv4.h"
+#include "../api/net.h"
+#include "NetworkAdapter.h"
+
+#define ARP_DEBUG false
+
+/**
+ * The neighbour cache, which maps the IPv4 addresses of hosts on our networks to their MAC addresses.
+ *
+ * Entries live in a fixed pool, indexed by a hash table and kept in least-recently-used order. Once every entry is in
+ * use, the least recently used one is reused. Resolved entries go stale after entry_lifetime: they're still used, but
+ * the next lookup asks the host again, and they're forgotten if it doesn't answer for another entry_lifetime.
+ *
+ * While an address is being resolved, requests are resent every request_interval up to max_requests times. Threads
+ * that can block wait for the reply in resolve(), and packets sent with send_packet() are queued on the entry and sent
+ * once it's resolved (or dropped if it never is).
+ */
+class ARPCache {
+public:
+	/** Gets the MAC address for addr, sending requests out of adapter and blocking until it's resolved or times out. **/
+	static ResultRet<MACAddress> resolve(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter);
+
+	/** Gets the MAC address for addr if it's known, without blocking or sending a request. **/
+	static ResultRet<MACAddress> lookup(const IPv4Address& addr);
+
+	/**
+	 * Sends an ethernet frame to addr without blocking, filling in its destination MAC address. If addr isn't resolved
+	 * yet, the packet is retained and queued until it is. Either way, the caller still has to release the packet.
+	 */
+	static void send_packet(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter, NetworkAdapter::Packet* packet);
+
+	/**
+	 * Records that addr (reachable through adapter) is at mac, and sends anything that was waiting for it. Unless create
+	 * is set, this only refreshes addresses we already know about or are asking for, so unsolicited replies can't fill
+	 * up the cache.
+	 */
+	static void update(const IPv4Address& addr, const MACAddress& mac, const kstd::Arc<NetworkAdapter>& adapter, bool create);
+
+private:
+	enum class State {
+		Free,
+		Incomplete, ///< We've asked, but haven't gotten an answer yet.
+		Reachable
+	};
+
+	static constexpr size_t num_entries = 256;
+	static constexpr size_t bucket_bits = 6;
+	static constexpr size_t num_buckets = 1 << bucket_bits;
+	static constexpr size_t max_pending_per_entry = 4;
+	static constexpr size_t max_pending = 32; ///< So unresolvable addresses can't hog the adapters' packet buffers.
+	static constexpr int max_requests = 3;
+	static const Time request_interval;
+	static const Time entry_lifetime;
+
+	/** A packet waiting for its destination to be resolved, along with the adapter it's retained by and sent from. **/
+	struct PendingPacket {
+		NetworkAdapter::Packet* packet = nullptr;
+		kstd::Arc<NetworkAdapter> adapter;
+	};
+
+	struct Entry {
+		IPv4Address addr;
+		MACAddress mac;
+		State state = State::Free;
+		Time updated; ///< When the entry was resolved.
+		Time last_request; ///< When we last asked for the address.
+		int num_requests = 0; ///< How many times we've asked since we last heard from the host.
+		kstd::Arc<NetworkAdapter> adapter; ///< Where requests and queued packets go.
+		PendingPacket pending[max_pending_per_entry];
+		size_t num_pending = 0;
+		Entry* hash_next = nullptr;
+		Entry* lru_prev = nullptr;
+		Entry* lru_next = nullptr;
+	};
+
+	/** Ready once any address is resolved or the deadline passes, whichever happens first. **/
+	class ResolveBlocker: public Blocker {
+	public:
+		ResolveBlocker(uint32_t generation, Time deadline): m_generation(generation), m_deadline(deadline) {}
+		bool is_ready() override;
+	private:
+		uint32_t m_generation;
+		Time m_deadline;
+	};
+
+	static Entry* find(const IPv4Address& addr);
+	static Entry* get_or_create(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter);
+	static Entry* create(const IPv4Address& addr, const kstd::Arc<NetworkAdapter>& adapter);
+	static void remove(Entry* entry);
+	static void promote(Entry* entry);
+	static void send_request(Entry* entry);
+	static size_t bucket_for(const IPv4Address& addr);
+
+	static Mutex s_lock;
+	static Entry s_entries[num_entries];
+	static Entry* s_buckets[num_buckets];
+	static Entry* s_lru_head; ///< Most recently used.
+	static Entry* s_lru_tail; ///< Least recently used.
+	static Entry* s_free_entries;
+	static bool s_initialized;
+	static size_t s_num_pending;
+	static Atomic<uint32_t> s_generation; ///< Incremented whenever an address is resolved.
+};
@@ -5,6 +5,7 @@
 #include "../IO.h"
 #include "../kstd/KLog.h"
 #include "../memory/MemoryManager.h"
+#include "../tasking/TaskManager.h"
 
 // https://wiki.osdev.org/Intel_Ethernet_i217
 
@@ -35,6 +36,9 @@
 #define REG_TXDESCTAIL  0x3818
 
 
+#define REG_TIDV         0x3820 // TX Interrupt Delay Value
+#define REG_TADV         0x382C // TX Int. Absolute Delay Timer
+
 #define REG_RDTR         0x2820 // RX Delay Timer Register
 #define REG_RXDCTL       0x2828 // RX Descriptor Control
 #define REG_RADV         0x282C // RX Int. Absolute Delay Timer
@@ -114,6 +118,13 @@
 
 #define E1000_DBG false
 
+// Interrupt moderation. The throttle is in units of 256ns, and the delay timers are in units of 1.024us.
+#define ITHROTTLE_INTERVAL 500 // About 8000 interrupts per second at most
+#define TX_INT_DELAY       64
+#define TX_INT_ABS_DELAY   256
+#define RX_INT_DELAY       32
+#define RX_INT_ABS_DELAY   128
+
 void E1000Adapter::probe() {
 	PCI::enumerate_devices([](PCI::Address address, PCI::ID id, uint16_t type, void* dataPtr) {
 		if(id.vendor == INTEL_VEND && id.device == E1000_DEV) {
@@ -180,7 +191,11 @@ void E1000Adapter::init_rx() {
 	auto first_buffer_page = m_rx_buffer_region->object()->physical_page(0).paddr();
 	for (int i = 0; i < num_rx_descriptors; i++) {
 		// Region should be contiguous in physical pages...
-		descriptors[i].addr = first_buffer_page + (rx_buffer_size * i);
+		auto& pkt = m_rx_packets[i];
+		pkt.buffer = (uint8_t*) (m_rx_buffer_region->start() + (rx_buffer_size * i));
+		pkt.buffer_paddr = first_buffer_page + (rx_buffer_size * i);
+		pkt.recycle = true;
+		descriptors[i].addr = pkt.buffer_paddr;
 		descriptors[i].status = 0;
 	}
 	auto desc_paddr = m_rx_desc_region->object()->physical_page(0).paddr();
@@ -191,18 +206,17 @@ void E1000Adapter::init_rx() {
 		m_window.out32(REG_RXDESCHI, 0); // BUG FIX: sebelumnya REG_TXDESCHI (typo), harusnya REG_RXDESCHI
 	m_window.out32(REG_RXDESCLEN, num_rx_descriptors * sizeof(RxDesc));
 	m_window.out32(REG_RXDESCHEAD, 0);
-	m_window.out32(REG_RXDESCTAIL, num_rx_descriptors - 1);
-	m_window.out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
+	m_window.out32(REG_RXDESCTAIL, m_rx_tail);
+	m_window.out32(REG_RDTR, RX_INT_DELAY);
+	m_window.out32(REG_RADV, RX_INT_ABS_DELAY);
+	m_window.out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_2048);
 }
 
 void E1000Adapter::init_tx() {
 	m_tx_desc_region = MM.alloc_dma_region(sizeof(TxDesc) * num_tx_descriptors);
-	m_tx_buffer_region = MM.alloc_dma_region(tx_buffer_size * num_tx_descriptors);
 	auto* descriptors = (TxDesc*) m_tx_desc_region->start();
-	auto first_buffer_page = m_tx_buffer_region->object()->physical_page(0).paddr();
 	for (int i = 0; i < num_tx_descriptors; i++) {
-		// Region should be contiguous in physical pages...
-		descriptors[i].addr = first_buffer_page + (tx_buffer_size * i);
+		descriptors[i].addr = 0;
 		descriptors[i].cmd = 0;
 		descriptors[i].status = TSTA_DD;
 	}
@@ -216,6 +230,8 @@ void E1000Adapter::init_tx() {
 	m_window.out32(REG_TXDESCLEN, num_tx_descriptors * sizeof(TxDesc));
 	m_window.out32(REG_TXDESCHEAD, 0);
 	m_window.out32(REG_TXDESCTAIL, 0);
+	m_window.out32(REG_TIDV, TX_INT_DELAY);
+	m_window.out32(REG_TADV, TX_INT_ABS_DELAY);
 	m_window.out32(REG_TCTRL, m_window.in32(REG_TCTRL) | TCTL_PSP | TCTL_EN);
 	m_window.out32(REG_TIPG, 0x0060200A);
 }
@@ -233,10 +249,13 @@ void E1000Adapter::handle_irq(IRQRegisters* regs) {
 		KLog::warn_if<E1000_DBG>("E1000", "RX buffer overrun");
 	}
 
-	if (cause & INT_RXT0) {
-		send_eoi();
+	if (cause & (INT_RXT0 | INT_RXDMT0 | INT_RXO)) {
 		receive();
 	}
+
+	if (cause & INT_TXDW) {
+		reclaim_tx();
+	}
 }
 
 void E1000Adapter::init_irq() {
@@ -245,8 +264,8 @@ void E1000Adapter::init_irq() {
 	reinstall_irq();
 	KLog::dbg_if<E1000_DBG>("E1000", "{} Interrupt line: {}", name(), irq);
 
-	m_window.out32(REG_ITHROTTLE, 5580);
-	m_window.out32(REG_IMASK, INT_LSC | INT_RXT0 | INT_RXO);
+	m_window.out32(REG_ITHROTTLE, ITHROTTLE_INTERVAL);
+	m_window.out32(REG_IMASK, INT_LSC | INT_RXT0 | INT_RXDMT0 | INT_RXO | INT_TXDW);
 	m_window.in32(REG_ICAUSE);
 	PCI::enable_interrupt(m_pci_address);
 }
@@ -260,41 +279,79 @@ void E1000Adapter::init_link() {
 void E1000Adapter::receive() {
 	auto* descs = (RxDesc*) m_rx_desc_region->start();
 	while (true) {
-		auto cur_desc = (m_window.in32(REG_RXDESCTAIL) + 1) % num_rx_descriptors;
-		auto& desc = descs[cur_desc];
+		auto& desc = descs[m_rx_next];
 		if (!(desc.status & 1))
 			break; // No more packets!
 		ASSERT(desc.length <= rx_buffer_size);
 		KLog::dbg_if<E1000_DBG>("E1000", "Received packet ({} bytes)", desc.length);
-		desc.status = 0;
-		receive_bytes({(uint8_t*) (m_rx_buffer_region->start() + (rx_buffer_size * cur_desc)), desc.length}, desc.length);
-		m_window.out32(REG_RXDESCTAIL, cur_desc);
+
+		// The descriptor is given back to the card once the network stack is done with the packet
+		auto& pkt = m_rx_packets[m_rx_next];
+		pkt.size = desc.length;
+		pkt.refs.store(1, MemoryOrder::Release);
+		m_rx_next = (m_rx_next + 1) % num_rx_descriptors;
+		if (pkt.size < sizeof(FrameHeader)) {
+			release_packet(&pkt);
+			continue;
+		}
+		receive_packet(&pkt);
 	}
 }
 
-void E1000Adapter::send_bytes(const ReadableBytes& bytes, size_t count) {
-	ASSERT(count <= tx_buffer_size);
-	PCI::disable_interrupt(m_pci_address);
-	auto cur_tx_desc = m_window.in32(REG_TXDESCTAIL) % num_tx_descriptors;
-	auto& desc = ((TxDesc*) m_tx_desc_region->start())[cur_tx_desc];
-	auto* buf = (uint8_t*) (m_tx_buffer_region->start() + (tx_buffer_size * cur_tx_desc));
-	bytes.read(buf, count);
-	desc.status = 0;
-	desc.length = count;
-	desc.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
-	KLog::dbg_if<E1000_DBG>("E1000", "Sending packet ({} bytes)", desc.length);
-	TaskManager::enter_critical();
-	PCI::enable_interrupt(m_pci_address);
-	m_window.out32(REG_TXDESCTAIL, (cur_tx_desc + 1) % num_tx_descriptors);
-	// BUG FIX: sebelumnya infinite loop tanpa timeout. Jika hardware hang,
-	// kernel stuck selamanya dalam critical section. Tambah batas iterasi.
-	static constexpr int TX_TIMEOUT_ITERS = 100000;
-	for (int timeout = 0; timeout < TX_TIMEOUT_ITERS; timeout++) {
-		if (desc.status) {
-			TaskManager::leave_critical();
+void E1000Adapter::recycle_packet(Packet* packet) {
+	ASSERT(packet >= m_rx_packets && packet < m_rx_packets + num_rx_descriptors);
+	TaskManager::IRQSafeCritical crit;
+	auto index = packet - m_rx_packets;
+	((RxDesc*) m_rx_desc_region->start())[index].status = 0;
+	m_rx_returned[index] = true;
+
+	// The card only takes descriptors back in order, so hand back as many as we can in a row
+	auto old_tail = m_rx_tail;
+	while (m_rx_returned[(m_rx_tail + 1) % num_rx_descriptors]) {
+		m_rx_tail = (m_rx_tail + 1) % num_rx_descriptors;
+		m_rx_returned[m_rx_tail] = false;
+	}
+	if (m_rx_tail != old_tail)
+		m_window.out32(REG_RXDESCTAIL, m_rx_tail);
+}
+
+void E1000Adapter::transmit(Packet* packet) {
+	ASSERT(packet->size <= packet_buffer_size);
+	TaskManager::IRQSafeCritical crit;
+
+	// If the ring is full, take back whatever has been sent since the last TX interrupt. If nothing has, the card is
+	// behind, so drop the packet rather than waiting with interrupts off.
+	auto* descs = (TxDesc*) m_tx_desc_region->start();
+	if ((m_tx_tail + 1) % num_tx_descriptors == m_tx_clean) {
+		reclaim_tx();
+		if ((m_tx_tail + 1) % num_tx_descriptors == m_tx_clean) {
+			KLog::dbg_if<E1000_DBG>("E1000", "Dropping packet because the transmit ring is full");
 			return;
 		}
 	}
-	KLog::warn("E1000", "TX timeout: hardware did not acknowledge packet send");
-	TaskManager::leave_critical();
-}
\ No newline at end of file
+
+	retain_packet(packet);
+	auto& desc = descs[m_tx_tail];
+	m_tx_packets[m_tx_tail] = packet;
+	desc.addr = packet->buffer_paddr;
+	desc.length = packet->size;
+	desc.status = 0;
+	desc.cmd = CMD_EOP | CMD_IFCS | CMD_RS | CMD_IDE;
+	KLog::dbg_if<E1000_DBG>("E1000", "Sending packet ({} bytes)", desc.length);
+	m_tx_tail = (m_tx_tail + 1) % num_tx_descriptors;
+	m_window.out32(REG_TXDESCTAIL, m_tx_tail);
+}
+
+void E1000Adapter::reclaim_packets() {
+	TaskManager::IRQSafeCritical crit;
+	reclaim_tx();
+}
+
+void E1000Adapter::reclaim_tx() {
+	auto* descs = (TxDesc*) m_tx_desc_region->start();
+	while (m_tx_clean != m_tx_tail && (descs[m_tx_clean].status & TSTA_DD)) {
+		release_packet(m_tx_packets[m_tx_clean]);
+		m_tx_packets[m_tx_clean] = nullptr;
+		m_tx_clean = (m_tx_clean + 1) % num_tx_descriptors;
+	}
+}
@@ -15,7 +15,9 @@ public:
 
 protected:
 	void handle_irq(IRQRegisters *regs) override;
-	void send_bytes(const ReadableBytes &bytes, size_t count) override;
+	void transmit(Packet* packet) override;
+	void reclaim_packets() override;
+	void recycle_packet(Packet* packet) override;
 
 private:
 	explicit E1000Adapter(PCI::Address addr);
@@ -46,20 +48,32 @@ private:
 	void init_irq();
 	void init_link();
 	void receive();
+	void reclaim_tx();
 
 	uint32_t eeprom_read(uint8_t addr);
 
 	PCI::Address m_pci_address;
 	bool m_eeprom = false;
 	IO::Window m_window;
+	bool m_link = false;
+
+	static constexpr size_t num_rx_descriptors = 128;
+	static constexpr size_t num_tx_descriptors = 128;
+	static constexpr size_t rx_buffer_size = packet_buffer_size;
+
+	// Each RX descriptor has its own packet which is handed to the network stack as-is, and it's given back to the card
+	// once that packet is released. Descriptors from m_rx_next up to m_rx_tail are owned by the card.
 	kstd::Arc<VMRegion> m_rx_desc_region;
 	kstd::Arc<VMRegion> m_rx_buffer_region;
-	kstd::Arc<VMRegion> m_tx_desc_region;
-	kstd::Arc<VMRegion> m_tx_buffer_region;
-	bool m_link = false;
+	Packet m_rx_packets[num_rx_descriptors];
+	bool m_rx_returned[num_rx_descriptors] = {};
+	size_t m_rx_next = 0;
+	size_t m_rx_tail = num_rx_descriptors - 1;
 
-	static constexpr size_t num_rx_descriptors = 32;
-	static constexpr size_t num_tx_descriptors = 16;
-	static constexpr size_t rx_buffer_size = 8192;
-	static constexpr size_t tx_buffer_size = 8192;
+	// Packets are sent straight from their buffers, and are held onto until the card is done with them. Descriptors from
+	// m_tx_clean up to m_tx_tail are in flight.
+	kstd::Arc<VMRegion> m_tx_desc_region;
+	Packet* m_tx_packets[num_tx_descriptors] = {};
+	size_t m_tx_clean = 0;
+	size_t m_tx_tail = 0;
 };
@@ -78,6 +78,8 @@ ResultRet<size_t> ICMPSocket::do_send(SafePointer<uint8_t> buf, size_t len) {
 		return Result(set_error(EHOSTUNREACH));
 
 	const size_t packet_len = sizeof(IPv4Packet) + len;
+	if (packet_len > route.adapter->mtu())
+		return Result(set_error(EMSGSIZE));
 	auto pkt = TRY(route.adapter->alloc_packet(packet_len));
 	auto* ipv4 = route.adapter->setup_ipv4_packet(pkt, route.mac, m_dest_addr, ICMP, len, 0, 64);
 
@@ -98,8 +100,7 @@ ResultRet<size_t> ICMPSocket::do_send(SafePointer<uint8_t> buf, size_t len) {
 	icmp_hdr->checksum = ~(uint16_t) sum;
 
 	route.adapter->send_packet(pkt);
-	if (pkt->buffer)
-		route.adapter->release_packet(pkt);
+	route.adapter->release_packet(pkt);
 
 	return len;
 }
@@ -20,6 +20,14 @@ IPSocket::IPSocket(Socket::Type type, int protocol): Socket(Domain::Inet, type,
 
 }
 
+IPSocket::~IPSocket() {
+	while (m_receive_queue_head) {
+		auto* next = m_receive_queue_head->next;
+		kfree(m_receive_queue_head);
+		m_receive_queue_head = next;
+	}
+}
+
 ResultRet<kstd::Arc<IPSocket>> IPSocket::make(Socket::Type type, int protocol) {
 	switch (type) {
 	case Type::Dgram:
@@ -77,12 +85,14 @@ ssize_t IPSocket::recvfrom(FileDescriptor& fd, SafePointer<uint8_t> buf, size_t
 	m_receive_queue_lock.acquire();
 
 	// Verify addrlen ptr
-	if (src_addr && addrlen && addrlen.get() != sizeof(sockaddr_in))
+	if (src_addr && addrlen && addrlen.get() != sizeof(sockaddr_in)) {
+		m_receive_queue_lock.release();
 		return -set_error(EINVAL);
+	}
 
 	// Block until we have a packet to read
-	while (!can_read(fd)) {
-		if (fd.nonblock()) {
+	while (!m_receive_queue_head) {
+		if (fd.nonblock() || (flags & MSG_DONTWAIT)) {
 			m_receive_queue_lock.release();
 			return -set_error(EAGAIN);
 		}
@@ -96,7 +106,11 @@ ssize_t IPSocket::recvfrom(FileDescriptor& fd, SafePointer<uint8_t> buf, size_t
 	}
 
 	// Read our packet
-	auto* packet = m_receive_queue.pop_front();
+	auto* packet = m_receive_queue_head;
+	m_receive_queue_head = packet->next;
+	if (!m_receive_queue_head)
+		m_receive_queue_tail = nullptr;
+	m_receive_queue_bytes -= sizeof(RecvdPacket) + packet->size;
 	m_receive_queue_lock.release();
 	auto res = do_recv(packet, buf, len);
 
@@ -162,16 +176,29 @@ Result IPSocket::recv_packet(const void* buf, size_t len) {
 	LOCK(m_receive_queue_lock);
 	ASSERT(len <= received_packet_max_size);
 
-	if (m_receive_queue.size() == m_receive_queue.capacity()) {
-		KLog::warn("IPSocket", "Dropping packet because receive queue is full");
+	// Small packets only take up as much of the buffer as they need, so a burst of them doesn't fill it up
+	if (m_receive_queue_bytes + sizeof(RecvdPacket) + len > m_receive_buffer_size) {
+		KLog::warn("IPSocket", "Dropping packet because receive buffer is full");
 		return Result(set_error(ENOSPC));
 	}
 
 	auto* src_pkt = (const IPv4Packet*) buf;
 	auto* new_pkt = (RecvdPacket*) kmalloc(sizeof(RecvdPacket) + len);
+	if (!new_pkt) {
+		KLog::warn("IPSocket", "Dropping packet because it couldn't be allocated");
+		return Result(set_error(ENOMEM));
+	}
+	new_pkt->next = nullptr;
+	new_pkt->size = len;
 	memcpy(&new_pkt->data, src_pkt, len);
 
-	m_receive_queue.push_back(new_pkt);
+	if (m_receive_queue_tail)
+		m_receive_queue_tail->next = new_pkt;
+	else
+		m_receive_queue_head = new_pkt;
+	m_receive_queue_tail = new_pkt;
+	m_receive_queue_bytes += sizeof(RecvdPacket) + len;
+	notify_readiness();
 
 	return Result(SUCCESS);
 }
@@ -185,7 +212,12 @@ Result IPSocket::listen(int backlog) {
 }
 
 bool IPSocket::can_read(const FileDescriptor& fd) {
-	return !m_receive_queue.empty();
+	// A listening socket is readable when there's a connection to accept
+	return m_receive_queue_head || !m_client_backlog.empty();
+}
+
+bool IPSocket::notifies_readiness() {
+	return true;
 }
 
 bool IPSocket::can_write(const FileDescriptor& fd) {
@@ -5,11 +5,11 @@
 
 #include "Socket.h"
 #include "../api/ipv4.h"
-#include "../kstd/ListQueue.h"
 
 class IPSocket: public Socket {
 public:
 	static ResultRet<kstd::Arc<IPSocket>> make(Socket::Type type, int protocol);
+	~IPSocket() override;
 
 	// Socket
 	Result bind(SafePointer<sockaddr> addr, socklen_t addrlen) override;
@@ -25,13 +25,17 @@ public:
 	// File
 	bool can_read(const FileDescriptor& fd) override;
 	bool can_write(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 	int ioctl(unsigned int request, SafePointer<void *> argp) override;
 
 protected:
 	IPSocket(Socket::Type type, int protocol);
 
 	static constexpr size_t received_packet_max_size = 8192;
+	/** A received packet, allocated to fit. Counts against the receive buffer with its header. **/
 	struct RecvdPacket {
+		RecvdPacket* next;
+		size_t size;
 		uint16_t port;
 		uint8_t data[];
 		IPv4Packet& header() { return *((IPv4Packet*) data); }
@@ -50,7 +54,9 @@ protected:
 	bool m_bound = false;
 	uint16_t m_bound_port = 0, m_dest_port = 0;
 	IPv4Address m_bound_addr = {}, m_dest_addr = {};
-	kstd::circular_queue<RecvdPacket*> m_receive_queue { 16 };
+	RecvdPacket* m_receive_queue_head = nullptr;
+	RecvdPacket* m_receive_queue_tail = nullptr;
+	size_t m_receive_queue_bytes = 0; ///< Bytes used out of m_receive_buffer_size.
 	Mutex m_receive_queue_lock { "IPSocket::receive_queue" };
 	uint8_t m_type_of_service = 0;
 	uint8_t m_ttl = 64;
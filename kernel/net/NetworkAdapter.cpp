@@ -5,13 +5,24 @@
 #include "../api/errno.h"
 #include "../kstd/KLog.h"
 #include "E1000Adapter.h"
+#include "VirtioNetAdapter.h"
 #include "NetworkManager.h"
 #include "Router.h"
+#include "../memory/MemoryManager.h"
 
 kstd::vector<kstd::Arc<NetworkAdapter>> NetworkAdapter::s_interfaces;
 
 NetworkAdapter::NetworkAdapter(kstd::string name):
-	m_name(kstd::move(name)) {}
+	m_name(kstd::move(name))
+{
+	m_packet_region = MM.alloc_dma_region(packet_buffer_size * num_packets);
+	auto first_buffer_page = m_packet_region->object()->physical_page(0).paddr();
+	for (size_t i = 0; i < num_packets; i++) {
+		// Region should be contiguous in physical pages...
+		m_packets[i].buffer = (uint8_t*) (m_packet_region->start() + packet_buffer_size * i);
+		m_packets[i].buffer_paddr = first_buffer_page + packet_buffer_size * i;
+	}
+}
 
 const kstd::string& NetworkAdapter::name() const {
 	return m_name;
@@ -31,6 +42,7 @@ void NetworkAdapter::set_netmask(IPv4Address mask) {
 
 void NetworkAdapter::setup() {
 	E1000Adapter::probe();
+	VirtioNetAdapter::probe();
 }
 
 ResultRet<kstd::Arc<NetworkAdapter>> NetworkAdapter::get_interface(const kstd::string& name) {
@@ -51,30 +63,27 @@ const kstd::vector<kstd::Arc<NetworkAdapter>>& NetworkAdapter::interfaces() {
 }
 
 void NetworkAdapter::receive_bytes(const ReadableBytes& bytes, size_t count) {
-	ASSERT(count <= max_packet_buffer_size);
-
-	auto pkt_res = alloc_packet(count);
+	auto pkt_res = alloc_packet(count - sizeof(FrameHeader));
 	if (pkt_res.is_error()) {
 		KLog::warn("NetworkAdapter", "{} had to drop packet, no more space in buffer!", name());
 		return;
 	}
 
 	auto pkt = pkt_res.value();
-	bytes.read(*pkt->buffer, count);
-	pkt->next = nullptr;
+	bytes.read(pkt->buffer, count);
+	receive_packet(pkt);
+}
 
-	// BUG FIX: akses m_packet_queue dari IRQ handler (receive()) dan dequeue_packet()
-	// tanpa sinkronisasi → race condition. Gunakan ScopedCritical untuk atomic enqueue.
+void NetworkAdapter::receive_packet(Packet* packet) {
+	packet->next = nullptr;
 	{
-		TaskManager::ScopedCritical crit;
-		if (!m_packet_queue) {
-			m_packet_queue = pkt;
-		} else {
-			auto* prev_packet = m_packet_queue;
-			while (prev_packet->next)
-				prev_packet = prev_packet->next;
-			prev_packet->next = pkt;
-		}
+		// Packets are received in IRQ handlers
+		TaskManager::IRQSafeCritical crit;
+		if (m_packet_queue_tail)
+			m_packet_queue_tail->next = packet;
+		else
+			m_packet_queue = packet;
+		m_packet_queue_tail = packet;
 	}
 
 	NetworkManager::inst().wakeup();
@@ -92,7 +101,16 @@ void NetworkAdapter::send_arp_packet(MACAddress dest, const ARPPacket& packet) {
 }
 
 void NetworkAdapter::send_raw_packet(const ReadableBytes& bytes, size_t count) {
-	send_bytes(bytes, count);
+	auto pkt_res = alloc_packet(count - sizeof(FrameHeader));
+	if (pkt_res.is_error()) {
+		KLog::warn("NetworkAdapter", "{} had to drop outgoing packet, no more space in buffer!", name());
+		return;
+	}
+
+	auto pkt = pkt_res.value();
+	bytes.read(pkt->buffer, count);
+	transmit(pkt);
+	release_packet(pkt);
 }
 
 NetworkAdapter::Packet* NetworkAdapter::dequeue_packet() {
@@ -101,41 +119,52 @@ NetworkAdapter::Packet* NetworkAdapter::dequeue_packet() {
 		return nullptr;
 	auto* pkt = m_packet_queue;
 	m_packet_queue = m_packet_queue->next;
+	if (!m_packet_queue)
+		m_packet_queue_tail = nullptr;
 	return pkt;
 }
 
 ResultRet<NetworkAdapter::Packet*> NetworkAdapter::alloc_packet(size_t size) {
-	ASSERT(size < (max_packet_buffer_size - sizeof(FrameHeader)));
-
-	auto buf = TRY(KBuffer::alloc(sizeof(FrameHeader) + size));
+	if (sizeof(FrameHeader) + size > packet_buffer_size)
+		return Result(EMSGSIZE);
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		// Start looking after the last packet we handed out, since it's likely the ones before it are still in use
+		auto start = m_next_packet.load(MemoryOrder::Relaxed);
+		for (size_t i = 0; i < num_packets; i++) {
+			auto& pkt = m_packets[(start + i) % num_packets];
+			int exp = 0;
+			if (!pkt.refs.compare_exchange_strong(exp, 1, MemoryOrder::Acquire))
+				continue;
+			m_next_packet.store((start + i + 1) % num_packets, MemoryOrder::Relaxed);
+			pkt.size = sizeof(FrameHeader) + size;
+			pkt.csum_start = 0;
+			pkt.next = nullptr;
+			return &pkt;
+		}
 
-	int i;
-	for (i = 0; i < 32; i++) {
-		bool exp = false;
-		if (m_packets[i].used.compare_exchange_strong(exp, true, MemoryOrder::Acquire))
-			break;
+		// The adapter may be holding onto packets that it's already sent
+		reclaim_packets();
 	}
 
-	if (i == 32)
-		return Result(ENOSPC);
+	return Result(ENOBUFS);
+}
 
-	auto& pkt = m_packets[i];
-	pkt.size = sizeof(FrameHeader) + size;
-	ASSERT(!pkt.buffer);
-	pkt.buffer = buf;
-	return &m_packets[i];
+void NetworkAdapter::retain_packet(NetworkAdapter::Packet* packet) {
+	packet->refs.add(1, MemoryOrder::Relaxed);
 }
 
 void NetworkAdapter::release_packet(NetworkAdapter::Packet* packet) {
-	packet->size = 0;
-	packet->buffer.reset();
-	packet->used.store(false, MemoryOrder::Release);
+	auto refs = packet->refs.sub(1, MemoryOrder::Release);
+	ASSERT(refs > 0);
+	if (refs == 1 && packet->recycle)
+		recycle_packet(packet);
 }
 
 IPv4Packet* NetworkAdapter::setup_ipv4_packet(Packet* packet, const MACAddress& dest, const IPv4Address& dest_addr, IPv4Proto proto, size_t payload_size, uint8_t dscp, uint8_t ttl) {
-	ASSERT(packet && packet->buffer && packet->buffer->size() > sizeof(FrameHeader) + sizeof(IPv4Packet));
+	ASSERT(packet && packet->size >= sizeof(FrameHeader) + sizeof(IPv4Packet));
 
-	auto* frame = (FrameHeader*) packet->buffer->ptr();
+	auto* frame = (FrameHeader*) packet->buffer;
 	frame->type = EtherProto::IPv4;
 	frame->destination = dest;
 	frame->source = m_mac_addr;
@@ -159,6 +188,6 @@ IPv4Packet* NetworkAdapter::setup_ipv4_packet(Packet* packet, const MACAddress&
 }
 
 void NetworkAdapter::send_packet(NetworkAdapter::Packet* packet) {
-	ASSERT(packet->size < m_mtu);
-	send_raw_packet(*packet->buffer, packet->size);
+	ASSERT(packet->size <= m_mtu + sizeof(FrameHeader));
+	transmit(packet);
 }
\ No newline at end of file
@@ -9,20 +9,31 @@
 #include "../Result.hpp"
 #include "../memory/SafePointer.h"
 #include "ARP.h"
-#include "../memory/KBuffer.h"
-#include "../kstd/ListQueue.h"
+#include "../memory/Bytes.h"
+#include "../memory/VMRegion.h"
 
 class NetworkAdapter: public kstd::ArcSelf<NetworkAdapter> {
 public:
 	virtual ~NetworkAdapter() = default;
 	static void setup();
 
-	static constexpr size_t max_packet_buffer_size = 8192;
+	static constexpr size_t packet_buffer_size = 2048; ///< Big enough for any frame that fits in the MTU.
+	static constexpr size_t num_packets = 128;
 
+	/**
+	 * A frame being sent or received. Packet buffers are in DMA memory, so adapters can send and receive them without
+	 * copying. Packets are reference counted so that an adapter can hold onto one until it's done sending it.
+	 */
 	struct Packet {
-		kstd::Arc<KBuffer> buffer {};
-		Atomic<bool> used = false;
+		uint8_t* buffer = nullptr;
+		PhysicalAddress buffer_paddr = 0;
+		Atomic<int> refs = 0;
 		size_t size = 0;
+		/// If nonzero, the adapter fills in the checksum: the one's complement of the sum from csum_start to the end of
+		/// the frame, stored at csum_start + csum_offset. See checksum_offload().
+		uint16_t csum_start = 0;
+		uint16_t csum_offset = 0;
+		bool recycle = false; ///< Whether the packet belongs to the adapter, which gets it back with recycle_packet().
 		Packet* next = nullptr;
 	};
 
@@ -38,6 +49,7 @@ public:
 	void send_packet(Packet* packet);
 	Packet* dequeue_packet();
 	ResultRet<Packet*> alloc_packet(size_t size);
+	void retain_packet(Packet* packet);
 	void release_packet(Packet* packet);
 	IPv4Packet* setup_ipv4_packet(Packet* packet, const MACAddress& dest, const IPv4Address& dest_addr, IPv4Proto proto, size_t payload_size, uint8_t dscp, uint8_t ttl);
 
@@ -48,6 +60,8 @@ public:
 	void set_netmask(IPv4Address mask);
 	const kstd::string& name() const;
 	[[nodiscard]] size_t mtu() const { return m_mtu; }
+	/** Whether the adapter can calculate transport checksums for outgoing packets (see Packet::csum_start). **/
+	[[nodiscard]] bool checksum_offload() const { return m_checksum_offload; }
 
 	static ResultRet<kstd::Arc<NetworkAdapter>> get_interface(const kstd::string& name);
 	static const kstd::vector<kstd::Arc<NetworkAdapter>>& interfaces();
@@ -57,9 +71,16 @@ protected:
 	static void register_interface(kstd::Arc<NetworkAdapter> adapter);
 
 	void set_mac(MACAddress addr);
+	void set_checksum_offload(bool offload) { m_checksum_offload = offload; }
 
-	virtual void send_bytes(const ReadableBytes& bytes, size_t count) = 0;
+	/** Sends a packet. The adapter should retain it until it's done with it, and must not block. **/
+	virtual void transmit(Packet* packet) = 0;
+	/** Called when we run out of packets, so the adapter can release the ones it's done sending. **/
+	virtual void reclaim_packets() {}
+	/** Called when the last reference to a packet with recycle set is released. **/
+	virtual void recycle_packet(Packet* packet) {}
 	void receive_bytes(const ReadableBytes& bytes, size_t count);
+	void receive_packet(Packet* packet);
 
 private:
 	static kstd::vector<kstd::Arc<NetworkAdapter>> s_interfaces;
@@ -69,6 +90,10 @@ private:
 	IPv4Address m_ipv4_netmask = {0, 0, 0, 0};
 	MACAddress m_mac_addr;
 	Packet* m_packet_queue = nullptr;
-	Packet m_packets[32];
+	Packet* m_packet_queue_tail = nullptr;
+	kstd::Arc<VMRegion> m_packet_region;
+	Packet m_packets[num_packets];
+	Atomic<size_t> m_next_packet = 0;
 	size_t m_mtu = 1500;
+	bool m_checksum_offload = false;
 };
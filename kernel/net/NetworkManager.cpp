@@ -8,6 +8,7 @@
 #include "UDPSocket.h"
 #include "../api/udp.h"
 #include "Router.h"
+#include "ARPCache.h"
 #include "TCPSocket.h"
 #include "../api/tcp.h"
 
@@ -46,7 +47,7 @@ void NetworkManager::wakeup() {
 
 void NetworkManager::handle_packet(const kstd::Arc<NetworkAdapter>& adapter, NetworkAdapter::Packet* packet) {
 	ASSERT(packet->size >= sizeof(NetworkAdapter::FrameHeader));
-	auto* hdr = (NetworkAdapter::FrameHeader*) packet->buffer->ptr();
+	auto* hdr = (NetworkAdapter::FrameHeader*) packet->buffer;
 	switch (hdr->type) {
 		case EtherProto::ARP:
 			handle_arp(adapter, packet);
@@ -69,12 +70,17 @@ void NetworkManager::handle_arp(const kstd::Arc<NetworkAdapter>& adapter, const
 		return; // BUG FIX: sebelumnya tidak return, lanjut proses packet invalid
 	}
 
-	auto& packet = *((ARPPacket*) ((NetworkAdapter::FrameHeader*) raw_packet->buffer->ptr())->payload);
+	auto& packet = *((ARPPacket*) ((NetworkAdapter::FrameHeader*) raw_packet->buffer)->payload);
 
 	switch (packet.operation) {
 	case ARPOp::Req: {
+		if (packet.target_protoaddr != adapter->ipv4_address())
+			break;
 		KLog::dbg_if<ARP_DEBUG>("NetworkManager", "Got ARP request from {} ({}), responding", packet.sender_protoaddr, packet.sender_hwaddr);
 
+		// They're about to talk to us, so we'll probably need their address too
+		ARPCache::update(packet.sender_protoaddr, packet.sender_hwaddr, adapter, true);
+
 		ARPPacket resp;
 		resp.operation = ARPOp::Resp;
 		resp.sender_hwaddr = adapter->mac_address();
@@ -87,7 +93,7 @@ void NetworkManager::handle_arp(const kstd::Arc<NetworkAdapter>& adapter, const
 	}
 	case ARPOp::Resp:
 		KLog::dbg_if<ARP_DEBUG>("NetworkManager", "Received ARP response from {} ({})", packet.sender_protoaddr, packet.sender_hwaddr);
-		Router::arp_put(packet.sender_protoaddr, packet.sender_hwaddr);
+		ARPCache::update(packet.sender_protoaddr, packet.sender_hwaddr, adapter, false);
 		break;
 	default:
 		KLog::warn("NetworkManager", "Got ARP packet with unknown operation {}!", packet.operation.val());
@@ -100,7 +106,7 @@ void NetworkManager::handle_ipv4(const kstd::Arc<NetworkAdapter>& adapter, const
 		return; // BUG FIX: sebelumnya tidak return, lanjut proses packet invalid
 	}
 
-	auto& packet = *((IPv4Packet*) ((NetworkAdapter::FrameHeader* ) raw_packet->buffer->ptr())->payload);
+	auto& packet = *((IPv4Packet*) ((NetworkAdapter::FrameHeader* ) raw_packet->buffer)->payload);
 
 	if (packet.length < sizeof(IPv4Packet)) {
 		KLog::warn("NetworkManager", "Got IPv4 packet with invalid size!");
@@ -115,7 +121,7 @@ void NetworkManager::handle_ipv4(const kstd::Arc<NetworkAdapter>& adapter, const
 		auto interface_network = interface->ipv4_address() & adapter->netmask();
 		auto sender_network = packet.source_addr & interface->netmask();
 		if (interface_network == sender_network)
-			Router::arp_put(packet.source_addr, ((NetworkAdapter::FrameHeader* ) raw_packet->buffer->ptr())->source);
+			ARPCache::update(packet.source_addr, ((NetworkAdapter::FrameHeader* ) raw_packet->buffer)->source, adapter, false);
 	}
 
 	switch (packet.proto) {
@@ -147,12 +153,8 @@ void NetworkManager::handle_icmp(const kstd::Arc<NetworkAdapter>& adapter, const
 			return;
 		}
 
-		// Gunakan MAC dari ARP cache saja - tidak boleh block di NetworkManager thread
-		// ARP cache sudah diisi saat menerima packet dari sender di handle_ipv4
-		auto mac_res = Router::arp_lookup(packet.source_addr);
-		if (mac_res.is_error())
-			return;
-		Router::Route route { mac_res.value(), adapter };
+		// We can't block on the NetworkManager thread, so the reply waits in the ARP cache if the sender isn't resolved
+		Router::Route route { {}, adapter };
 
 		// Payload size = total ICMP data (echo packet + any extra payload)
 		size_t icmp_size = packet.length.val() - sizeof(IPv4Packet);
@@ -181,7 +183,7 @@ void NetworkManager::handle_icmp(const kstd::Arc<NetworkAdapter>& adapter, const
 		sum = (sum & 0xFFFF) + (sum >> 16);
 	reply->header.checksum = ~(uint16_t) sum;
 
-		route.adapter->send_packet(pkt);
+		ARPCache::send_packet(packet.source_addr, route.adapter, pkt);
 		route.adapter->release_packet(pkt);
 
 	} else if ((ICMPType) header.type == ICMPType::EchoReply) {
@@ -229,11 +231,8 @@ void NetworkManager::handle_tcp(const kstd::Arc<NetworkAdapter>& adapter, const
 
 		KLog::warn("NetworkManager", "Received TCP packet for {}:{} but no such port is bound.", packet.dest_addr, tcp_segment->dest_port);
 
-		// Send an RST to the sender - gunakan ARP cache saja, tidak boleh block
-		auto mac_res = Router::arp_lookup(packet.source_addr);
-		if (mac_res.is_error())
-			return;
-		Router::Route route { mac_res.value(), adapter };
+		// Send an RST to the sender (without blocking on ARP, see handle_icmp)
+		Router::Route route { {}, adapter };
 
 		auto pkt_res = route.adapter->alloc_packet(sizeof(IPv4Packet) + sizeof(TCPSegment));
 		if (pkt_res.is_error())
@@ -252,7 +251,7 @@ void NetworkManager::handle_tcp(const kstd::Arc<NetworkAdapter>& adapter, const
 		rst_segment->urgent_pointer = 0;
 		rst_segment->checksum = rst_segment->calculate_checksum(ipv4_packet->source_addr, ipv4_packet->dest_addr, 0);
 
-		adapter->send_packet(pkt);
+		ARPCache::send_packet(packet.source_addr, adapter, pkt);
 		adapter->release_packet(pkt);
 
 		return;
@@ -2,16 +2,12 @@
 /* Copyright © 2016-2024 Byteduck */
 
 #include "Router.h"
-#include "NetworkManager.h"
+#include "ARPCache.h"
 
 #define ROUTE_DEBUG false
 
 Mutex Router::s_routing_lock {"Router::routing_table" };
 Router::Entry* Router::s_routing_entries = nullptr;
-Mutex Router::s_arp_lock { "Router::arp_table" };
-kstd::map<IPv4Address, MACAddress> Router::s_arp_entries;
-kstd::vector<Router::ARPBlocker> Router::s_arp_blockers;
-Mutex Router::s_arp_blocker_lock { "Router::arp_blockers" };
 
 void Router::add_entry(Router::Entry* ent) {
 	LOCK(s_routing_lock);
@@ -103,7 +99,7 @@ Router::Route Router::get_route(const IPv4Address& dest, const IPv4Address& sour
 
 	// ARP lookup
 	KLog::dbg_if<ROUTE_DEBUG>("Router", "Could not find route to {}, looking up ARP entry for {}", dest, next_hop);
-	auto mac = arp_lookup(next_hop, adapter);
+	auto mac = ARPCache::resolve(next_hop, adapter);
 	if (mac.is_error())
 		return {{}, {}};
 	return { mac.value(), adapter };
@@ -117,82 +113,4 @@ void Router::set_route(const IPv4Address& dest, const IPv4Address& gateway, cons
 		.netmask = mask,
 		.adapter = kstd::move(adapter)
 	});
-}
-
-ResultRet<MACAddress> Router::arp_lookup(const IPv4Address& dest, const kstd::Arc<NetworkAdapter>& request_adapter) {
-	s_arp_lock.acquire();
-	auto* ent = s_arp_entries.find_node(dest);
-	if (ent) {
-		auto ret = ent->data.second;
-		s_arp_lock.release();
-		KLog::dbg_if<ARP_DEBUG>("Router", "Found ARP entry for {}: {}", dest, ret);
-		return ret;
-	}
-
-	s_arp_lock.release();
-
-	if (!request_adapter)
-		return Result(ENOENT);
-
-	// We cannot do this on the NetworkManager thread if we need to request because we will need to block
-	ASSERT(NetworkManager::inst().thread() != TaskManager::current_thread());
-
-	// Send the ARP request
-	KLog::dbg_if<ARP_DEBUG>("Router", "Making ARP request for {}", dest);
-	ARPPacket packet;
-	packet.operation = ARPOp::Req;
-	packet.sender_protoaddr = request_adapter->ipv4_address();
-	packet.sender_hwaddr = request_adapter->mac_address();
-	packet.target_protoaddr = dest;
-	packet.target_hwaddr = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-
-	// Wait for a reply
-	s_arp_blocker_lock.acquire();
-	ARPBlocker blocker { dest, kstd::make_shared<BooleanBlocker>() };
-	s_arp_blockers.push_back(blocker);
-	s_arp_blocker_lock.release();
-
-	request_adapter->send_arp_packet(packet.target_hwaddr, packet);
-
-	// TODO: What if we never receive a response..? A timeout would probably be good.
-	TaskManager::current_thread()->block(*blocker.blocker);
-
-	if (blocker.blocker->was_interrupted())
-		return Result(ENOENT);
-
-	// Check the table again
-	s_arp_lock.acquire();
-	ent = s_arp_entries.find_node(dest);
-	if (ent) {
-		auto ret = ent->data.second;
-		s_arp_lock.release();
-		return ret;
-	}
-	s_arp_lock.release();
-
-	return Result(ENOENT);
-}
-
-void Router::arp_put(const IPv4Address& ip, const MACAddress& mac) {
-	// Add entry
-	{
-		LOCK(s_arp_lock);
-		if (s_arp_entries.contains(ip))
-			return;
-		KLog::dbg_if<ARP_DEBUG>("Router", "Adding ARP entry for {}: {}", ip, mac);
-		s_arp_entries[ip] = mac;
-	}
-
-	// Notify any blockers
-	{
-		LOCK(s_arp_blocker_lock);
-		for (size_t i = 0; i < s_arp_blockers.size(); i++) {
-			auto& blocker = s_arp_blockers[i];
-			if (blocker.addr == ip) {
-				blocker.blocker->set_ready(true);
-				s_arp_blockers.erase(i);
-				i--;
-			}
-		}
-	}
-}
+}
\ No newline at end of file
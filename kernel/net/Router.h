@@ -8,8 +8,6 @@
 #include "../api/net.h"
 #include "NetworkAdapter.h"
 
-#define ARP_DEBUG false
-
 class Router {
 public:
 	struct Entry {
@@ -27,15 +25,8 @@ public:
 
 	static Route get_route(const IPv4Address& dest, const IPv4Address& source, const kstd::Arc<NetworkAdapter>& adapter = kstd::Arc<NetworkAdapter>(nullptr), bool allow_broadcast = false);
 	static void set_route(const IPv4Address& dest, const IPv4Address& gateway, const IPv4Address& mask, kstd::Arc<NetworkAdapter> adapter);
-	static ResultRet<MACAddress> arp_lookup(const IPv4Address& dest, const kstd::Arc<NetworkAdapter>& request_adapter = {});
-	static void arp_put(const IPv4Address& ip, const MACAddress& mac);
 
 private:
-	struct ARPBlocker {
-		IPv4Address addr;
-		kstd::Arc<BooleanBlocker> blocker;
-	};
-
 	template<typename F>
 	static void foreach_entry(const F& f) {
 		LOCK(s_routing_lock);
@@ -51,8 +42,4 @@ private:
 
 	static Mutex s_routing_lock;
 	static Entry* s_routing_entries;
-	static Mutex s_arp_lock;
-	static kstd::map<IPv4Address, MACAddress> s_arp_entries;
-	static kstd::vector<ARPBlocker> s_arp_blockers;
-	static Mutex s_arp_blocker_lock;
 };
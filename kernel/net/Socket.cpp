@@ -24,6 +24,10 @@ ssize_t Socket::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buf
 	return recvfrom(fd, buffer, count, 0, {}, {});
 }
 
+ssize_t Socket::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
+	return sendto(fd, buffer, count, 0, {}, 0);
+}
+
 Result Socket::setsockopt(int level, int optname, UserspacePointer<void*> optval, socklen_t optlen) {
 	if (level != SOL_SOCKET)
 		return Result(EINVAL);
@@ -43,6 +47,22 @@ Result Socket::setsockopt(int level, int optname, UserspacePointer<void*> optval
 		m_allow_broadcast = optval.as<int>().get();
 		return Result(SUCCESS);
 
+	case SO_RCVBUF:
+	case SO_SNDBUF: {
+		if (optlen < sizeof(int))
+			return Result(EINVAL);
+		auto size = optval.as<int>().get();
+		if (size < 0)
+			return Result(EINVAL);
+		size_t clamped_size = min(max((size_t) size, min_buffer_size), max_buffer_size);
+		if (optname == SO_SNDBUF) {
+			m_send_buffer_size = clamped_size;
+		} else {
+			TRYRES(resize_receive_buffer(clamped_size));
+		}
+		return Result(SUCCESS);
+	}
+
 	default:
 		return Result(EINVAL);
 	}
@@ -68,6 +88,14 @@ Result Socket::getsockopt(int level, int optname, UserspacePointer<void*> optval
 			optlen.set(sizeof(int));
 			return Result(SUCCESS);
 
+		case SO_RCVBUF:
+		case SO_SNDBUF:
+			if (optlen.get() < sizeof(int))
+				return Result(EINVAL);
+			optval.as<int>().set((int) (optname == SO_RCVBUF ? m_receive_buffer_size : m_send_buffer_size));
+			optlen.set(sizeof(int));
+			return Result(SUCCESS);
+
 		default:
 			return Result(EINVAL);
 	}
@@ -113,4 +141,9 @@ ResultRet<kstd::Arc<Socket>> Socket::accept(FileDescriptor& fd, UserspacePointer
 
 Result Socket::do_accept() {
 	return Result::Success;
+}
+
+Result Socket::resize_receive_buffer(size_t new_size) {
+	m_receive_buffer_size = new_size;
+	return Result::Success;
 }
\ No newline at end of file
@@ -49,6 +49,7 @@ public:
 	// File
 	bool is_socket() override { return true; }
 	ssize_t read(FileDescriptor &fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
+	ssize_t write(FileDescriptor &fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 
 protected:
 	Socket(Domain domain, Type type, int protocol);
@@ -60,6 +61,13 @@ protected:
 	virtual Result shutdown_writing() = 0;
 	virtual void get_dest_addr(UserspacePointer<sockaddr> addr, UserspacePointer<socklen_t> len) = 0;
 	virtual Result do_accept();
+	/** Called when SO_RCVBUF changes. Updates m_receive_buffer_size, along with anything that's sized by it. **/
+	virtual Result resize_receive_buffer(size_t new_size);
+
+	// Defaults and limits for SO_RCVBUF and SO_SNDBUF
+	static constexpr size_t default_buffer_size = 64 * 1024;
+	static constexpr size_t min_buffer_size = 2 * 1024;
+	static constexpr size_t max_buffer_size = 1024 * 1024;
 
 	int m_error = 0;
 	const Domain m_domain;
@@ -72,4 +80,6 @@ protected:
 	size_t m_max_backlog_size = 0;
 	kstd::queue<kstd::Arc<Socket>> m_client_backlog;
 	BooleanBlocker m_accept_blocker;
+	size_t m_receive_buffer_size = default_buffer_size;
+	size_t m_send_buffer_size = default_buffer_size;
 };
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "../kstd/vector.hpp"
+#include "../kstd/Arc.h"
+#include "../tasking/RWLock.h"
+
+/**
+ * A hash table of sockets used to demultiplex incoming packets. Each bucket has its own lock, so lookups for different
+ * connections don't contend with each other (or with sockets being bound and closed), and a lookup only has to look at
+ * the few sockets that hash to the same bucket.
+ *
+ * Hash is a functor type that turns a Key into a uint32_t. num_buckets must be a power of two.
+ */
+template<typename Key, typename T, typename Hash, size_t num_buckets = 128>
+class SocketTable {
+	static_assert((num_buckets & (num_buckets - 1)) == 0, "num_buckets must be a power of two");
+public:
+	/**
+	 * Adds a socket under key. Returns false if there's already one with that key, unless it's being destroyed: then
+	 * the new socket takes its place.
+	 */
+	bool insert(const Key& key, const kstd::Arc<T>& socket) {
+		auto& bucket = bucket_for(key);
+		LOCK(bucket.lock);
+		for (size_t i = 0; i < bucket.entries.size(); i++) {
+			auto& entry = bucket.entries[i];
+			if (entry.key != key)
+				continue;
+			if (entry.socket)
+				return false;
+			entry.socket = socket;
+			entry.owner = socket.get();
+			return true;
+		}
+		bucket.entries.push_back({key, socket, socket.get()});
+		return true;
+	}
+
+	/** Removes socket from under key. Does nothing if another socket has taken its place since. **/
+	void erase(const Key& key, const T* socket) {
+		auto& bucket = bucket_for(key);
+		LOCK(bucket.lock);
+		for (size_t i = 0; i < bucket.entries.size(); i++) {
+			if (bucket.entries[i].key == key) {
+				if (bucket.entries[i].owner == socket)
+					bucket.entries.erase(i);
+				return;
+			}
+		}
+	}
+
+	bool contains(const Key& key) {
+		auto& bucket = bucket_for(key);
+		LOCK_READ(bucket.lock);
+		for (size_t i = 0; i < bucket.entries.size(); i++) {
+			if (bucket.entries[i].key == key)
+				return bucket.entries[i].socket;
+		}
+		return false;
+	}
+
+	/** Gets the socket with the given key, or a null Arc if there isn't one (or it's being destroyed). **/
+	kstd::Arc<T> get(const Key& key) {
+		auto& bucket = bucket_for(key);
+		LOCK_READ(bucket.lock);
+		for (size_t i = 0; i < bucket.entries.size(); i++) {
+			if (bucket.entries[i].key == key)
+				return bucket.entries[i].socket.lock();
+		}
+		return kstd::Arc<T>(nullptr);
+	}
+
+private:
+	struct Entry {
+		Key key;
+		kstd::Weak<T> socket;
+		const T* owner; ///< Which socket the entry belongs to, even after socket has expired.
+	};
+
+	struct Bucket {
+		RWLock lock { "SocketTable::bucket" };
+		kstd::vector<Entry> entries;
+	};
+
+	Bucket& bucket_for(const Key& key) {
+		return m_buckets[Hash()(key) & (num_buckets - 1)];
+	}
+
+	Bucket m_buckets[num_buckets];
+};
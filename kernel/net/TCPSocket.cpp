@@ -5,86 +5,79 @@
 #include "../api/tcp.h"
 #include "../random.h"
 #include "NetworkManager.h"
+#include "../tasking/FileBlockers.h"
+#include "../filesystem/FileDescriptor.h"
 
 #define TCP_DBG true
 
-kstd::map<TCPSocket::ID, kstd::Weak<TCPSocket>> TCPSocket::s_sockets;
+TCPSocket::Table TCPSocket::s_connected_sockets;
+TCPSocket::Table TCPSocket::s_bound_sockets;
 kstd::map<TCPSocket::ID, kstd::Arc<TCPSocket>> TCPSocket::s_closing_sockets;
-Mutex TCPSocket::s_sockets_lock { "TCPSocket::sockets" };
+Mutex TCPSocket::s_closing_sockets_lock { "TCPSocket::closing_sockets" };
 
 TCPSocket::TCPSocket(): IPSocket(Type::Stream, 0) {
 
 }
 
 ResultRet<kstd::Arc<TCPSocket>> TCPSocket::make() {
-	return kstd::Arc(new TCPSocket());
+	auto sock = kstd::Arc(new TCPSocket());
+	if (!sock->m_recv_buffer.allocated())
+		return Result(ENOMEM);
+	return sock;
 }
 
 kstd::Arc<TCPSocket> TCPSocket::get_socket(const IPv4Address& dest_addr, uint16_t dest_port, const IPv4Address& src_addr, uint16_t src_port) {
-	LOCK(s_sockets_lock);
-	const ID exact_id = {dest_addr, dest_port, src_addr, src_port}; // Exact match
-	const ID bound_id = {dest_addr, dest_port, {0, 0, 0, 0}, 0}; // Matches bound port and address
-	const ID port_id = {{0, 0, 0, 0}, dest_port, {0, 0, 0, 0}, 0}; // Matches bound port
-
 	// Exact match
-	auto pair = s_sockets.find_node(exact_id);
-	if (pair)
-		return pair->data.second.lock();
+	if (auto sock = s_connected_sockets.get({dest_addr, dest_port, src_addr, src_port}))
+		return sock;
 
 	// Bound port and addr match
-	pair = s_sockets.find_node(bound_id);
-	if (pair)
-		return pair->data.second.lock();
+	if (auto sock = s_bound_sockets.get({dest_addr, dest_port, {0, 0, 0, 0}, 0}))
+		return sock;
 
 	// Bound port match
-	pair = s_sockets.find_node(port_id);
-	if (pair)
-		return pair->data.second.lock();
-
-	// No match
-	return {};
+	return s_bound_sockets.get({{0, 0, 0, 0}, dest_port, {0, 0, 0, 0}, 0});
 }
 
 TCPSocket::~TCPSocket() {
-	LOCK(s_sockets_lock);
 	if (m_bound) {
-		s_sockets.erase(m_id);
+		table_for(m_id).erase(m_id, this);
 		KLog::dbg_if<TCP_DBG>("TCPSocket", "Unbinding from {}:{} -> {}:{}", m_bound_addr, m_bound_port, m_dest_addr, m_dest_port);
 	}
 }
 
 Result TCPSocket::do_bind() {
-	LOCK(s_sockets_lock);
+	// Inserting only succeeds if nobody else has the ID, so there's no window for another socket to take it
+	auto try_bind = [&](uint16_t port) {
+		const ID new_id = {m_bound_addr, port, m_dest_addr, m_dest_port};
+		if (!table_for(new_id).insert(new_id, self()))
+			return false;
+		m_bound_port = port;
+		m_bound = true;
+		m_id = new_id;
+		return true;
+	};
 
 	if(m_bound_port == 0) {
 		// If we didn't specify a port, we want an ephemeral port
 		// (Range suggested by IANA and RFC 6335)
 		// First try a random port, then go through all of them if that one's taken
-		auto ephem = rand_range<uint16_t>(49152, 65535);
-		if (s_sockets.contains({m_bound_addr, ephem, m_dest_addr, m_dest_port})) {
+		if (!try_bind(rand_range<uint16_t>(49152, 65535))) {
+			uint16_t ephem;
 			for(ephem = 49152; ephem < 65535; ephem++) {
-				if(!s_sockets.contains({m_bound_addr, ephem, m_dest_addr, m_dest_port}))
+				if(try_bind(ephem))
 					break;
 			}
 			if (ephem == 65535) {
-				KLog::warn("UDPSocket", "Out of ephemeral ports!");
+				KLog::warn("TCPSocket", "Out of ephemeral ports!");
 				return Result(set_error(EADDRINUSE));
 			}
 		}
-
-		m_bound_port = ephem;
-	}
-
-	const ID new_id = {m_bound_addr, m_bound_port, m_dest_addr, m_dest_port};
-	if(s_sockets.contains(new_id))
+	} else if (!try_bind(m_bound_port)) {
 		return Result(set_error(EADDRINUSE));
+	}
 
 	KLog::dbg_if<TCP_DBG>("TCPSocket", "Binding to {}:{}", m_bound_addr, m_bound_port);
-
-	s_sockets[new_id] = self();
-	m_bound = true;
-	m_id = new_id;
-
 	return Result(Result::Success);
 }
 
@@ -104,10 +97,10 @@ Result TCPSocket::do_connect() {
 
 		const ID new_id = {m_bound_addr, m_bound_port, m_dest_addr, m_dest_port};
 		if (m_id != new_id) {
-			LOCK_N(s_sockets_lock, socklock);
-			s_sockets.erase(m_id);
+			if (!table_for(new_id).insert(new_id, self()))
+				return Result(set_error(EADDRINUSE));
+			table_for(m_id).erase(m_id, this);
 			m_id = new_id;
-			s_sockets[m_id] = self();
 		}
 
 		// Setup sequencing
@@ -188,16 +181,23 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 	}
 
 	if (segment->flags() & TCP_ACK) {
+		LOCK(m_lock);
+		bool acked_data = false;
 		while (!m_unacked_packets.empty()) {
 			auto& unacked_pkt = m_unacked_packets.front();
 			if(unacked_pkt.sequence <= segment->ack) {
 				unacked_pkt.adapter->release_packet(unacked_pkt.pkt);
+				m_unacked_bytes -= unacked_pkt.payload_size;
+				acked_data |= unacked_pkt.payload_size > 0;
 				m_unacked_packets.pop_front();
 			} else {
 				break;
 			}
 			// TODO: What if packet remains unacked? retransmit
 		}
+		// There might be room to send more now
+		if (acked_data)
+			notify_readiness();
 	}
 
 	switch (m_state) {
@@ -209,7 +209,12 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 			KLog::dbg_if<TCP_DBG>("TCPSocket", "Unexpected flags while in Listen state: {#x}", segment->flags());
 			return Result(EINVAL);
 		} else {
-			auto new_sock = kstd::Arc(new TCPSocket());
+			auto new_sock_res = make();
+			if (new_sock_res.is_error()) {
+				KLog::warn("TCPSocket", "Couldn't allocate new socket client for {}:{}", pkt->source_addr, segment->source_port);
+				break;
+			}
+			auto new_sock = new_sock_res.value();
 			new_sock->m_bound_addr = pkt->dest_addr;
 			new_sock->m_bound_port = segment->dest_port;
 			new_sock->m_dest_addr = pkt->source_addr;
@@ -231,6 +236,7 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 			LOCK(m_lock);
 			m_client_backlog.push_back(new_sock);
 			m_accept_blocker.set_ready(true);
+			notify_readiness();
 		}
 		break;
 	case SynRecvd:
@@ -266,6 +272,7 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 			if (window_scale)
 				m_window_scale = window_scale.value();
 			m_connect_blocker.set_ready(true);
+			notify_readiness();
 		}  else if (segment->flags() == TCP_SYN) {
 			m_ack = segment->sequence + payload_len + 1;
 			send_tcp(TCP_SYN | TCP_ACK);
@@ -278,6 +285,7 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 			finish_closing();
 			m_error = EINVAL; // Is this correct?
 			m_connect_blocker.set_ready(true);
+			notify_readiness();
 		}
 
 		break;
@@ -303,7 +311,7 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 		}
 		m_num_ooo_packets = 0;
 
-		const auto recv_res = payload_len ? IPSocket::recv_packet(buf, len) : Result(Result::Success);
+		const auto recv_res = payload_len ? buffer_payload(segment->payload(), payload_len) : Result(Result::Success);
 
 		if(segment->flags() & TCP_FIN) {
 			m_ack = segment->sequence + payload_len + 1;
@@ -350,7 +358,7 @@ Result TCPSocket::recv_packet(const void* buf, size_t len) {
 			finish_closing();
 		} else if (segment->flags() == TCP_ACK && payload_len) {
 			// Still got some data packet(s) left to process
-			if (IPSocket::recv_packet(buf, len).is_success()) {
+			if (buffer_payload(segment->payload(), payload_len).is_success()) {
 				m_ack = segment->sequence + payload_len + 1;
 				send_ack(false);
 			}
@@ -415,7 +423,7 @@ Result TCPSocket::send_tcp(uint16_t flags, SafePointer<uint8_t> payload, size_t
 	}
 	tcp_segment->set_flags(flags);
 	tcp_segment->set_data_offset(tcp_header_size / sizeof(uint32_t));
-	auto avail_buf = received_packet_max_size * (m_receive_queue.capacity() - m_receive_queue.size()); // TODO: Window scaling
+	auto avail_buf = m_recv_buffer.space(); // TODO: Window scaling
 	tcp_segment->window_size = min(avail_buf, 65535);
 
 	// Setup options
@@ -443,14 +451,22 @@ Result TCPSocket::send_tcp(uint16_t flags, SafePointer<uint8_t> payload, size_t
 		payload.read(tcp_segment->payload(), payload_size);
 	m_sequence += (flags & TCP_SYN) ? 1 : payload_size;
 
-	// Calculate checksum
-	tcp_segment->checksum = 0;
-	tcp_segment->checksum = tcp_segment->calculate_checksum(m_bound_addr, m_dest_addr, payload_size);
+	// Calculate checksum, or leave all but the pseudo-header to the adapter if it can do it for us
+	if (route.adapter->checksum_offload()) {
+		tcp_segment->checksum = tcp_segment->pseudo_header_checksum(m_bound_addr, m_dest_addr, payload_size);
+		pkt->csum_start = (uint8_t*) tcp_segment - pkt->buffer;
+		pkt->csum_offset = __builtin_offsetof(TCPSegment, checksum);
+	} else {
+		tcp_segment->checksum = 0;
+		tcp_segment->checksum = tcp_segment->calculate_checksum(m_bound_addr, m_dest_addr, payload_size);
+	}
 
 	// If we're going to expect an ack after this, make sure we keep track of it
 	const bool expect_ack = (flags & TCP_SYN) || payload_size > 0;
-	if (expect_ack)
-		m_unacked_packets.push_back({pkt, route.adapter, m_sequence});
+	if (expect_ack) {
+		m_unacked_packets.push_back({pkt, route.adapter, m_sequence, payload_size});
+		m_unacked_bytes += payload_size;
+	}
 	// Send packet
 	KLog::dbg_if<TCP_DBG>("TCPSocket", "Sending packet (flags:{}{}{}{}{}{}{}) to {}:{} ({} byte payload)",
 						  flags & TCP_FIN ? " FIN" : "",
@@ -477,15 +493,100 @@ Result TCPSocket::send_ack(bool dupe) {
 }
 
 ssize_t TCPSocket::do_recv(IPSocket::RecvdPacket* pkt, SafePointer<uint8_t> buf, size_t len) {
-	auto* segment = (const TCPSegment*) pkt->header().payload;
-	ASSERT(pkt->header().length >= sizeof(IPv4Packet) + sizeof(TCPSegment)); // Should've been rejected at IP layer
-	size_t payload_len = pkt->header().length - sizeof(IPv4Packet) - segment->data_offset() * sizeof(uint32_t);
-	const size_t nread = min(len, payload_len);
-	buf.write(segment->payload(), nread);
-	pkt->port = segment->source_port;
+	// Payloads never go through the packet queue, they're read straight out of the receive buffer in recvfrom()
+	ASSERT(false);
+	return -EINVAL;
+}
+
+ssize_t TCPSocket::recvfrom(FileDescriptor& fd, SafePointer<uint8_t> buf, size_t len, int flags, SafePointer<sockaddr> src_addr, SafePointer<socklen_t> addrlen) {
+	if (src_addr && addrlen && addrlen.get() != sizeof(sockaddr_in))
+		return -set_error(EINVAL);
+
+	// Block until there's something to read, or the other side is done sending
+	m_recv_lock.acquire();
+	while (m_recv_buffer.empty()) {
+		if (peer_closed()) {
+			m_recv_lock.release();
+			return 0;
+		}
+
+		if (fd.nonblock() || (flags & MSG_DONTWAIT)) {
+			m_recv_lock.release();
+			return -set_error(EAGAIN);
+		}
+
+		m_recv_lock.release();
+		ReadBlocker blocker {fd};
+		TaskManager::current_thread()->block(blocker);
+		if (blocker.was_interrupted())
+			return -set_error(EINTR);
+		m_recv_lock.acquire();
+	}
+
+	// Read as much as we can, which may span several segments
+	const size_t free_before = m_recv_buffer.space();
+	const size_t nread = m_recv_buffer.pop(len, [&](const uint8_t* span, size_t offset, size_t length) {
+		buf.write(span, offset, length);
+	});
+	m_recv_lock.release();
+
+	if (src_addr && addrlen) {
+		src_addr.as<sockaddr_in>().set(m_dest_addr.as_sockaddr(m_dest_port));
+		addrlen.set(sizeof(sockaddr_in));
+	}
+
+	// If our window had mostly closed, let the other side know that it's open again
+	if (free_before < m_receive_buffer_size / 4 && m_state == Established)
+		send_ack(true);
+
 	return (ssize_t) nread;
 }
 
+Result TCPSocket::buffer_payload(const uint8_t* payload, size_t size) {
+	LOCK(m_recv_lock);
+	if (size > m_recv_buffer.space()) {
+		// Don't acknowledge it, so it's sent again once there's room
+		KLog::dbg_if<TCP_DBG>("TCPSocket", "Dropping segment because receive buffer is full");
+		return Result(ENOSPC);
+	}
+
+	m_recv_buffer.push(payload, size);
+	notify_readiness();
+	return Result(SUCCESS);
+}
+
+Result TCPSocket::resize_receive_buffer(size_t new_size) {
+	LOCK(m_recv_lock);
+	if (new_size < m_recv_buffer.size())
+		return Result(EBUSY);
+	if (!m_recv_buffer.resize(new_size))
+		return Result(ENOMEM);
+	m_receive_buffer_size = new_size;
+	return Result(SUCCESS);
+}
+
+bool TCPSocket::peer_closed() const {
+	switch (m_state) {
+	case CloseWait:
+	case LastAck:
+	case Closing:
+	case TimeWait:
+		return true;
+	case Closed:
+		return m_direction != Direction::None;
+	default:
+		return false;
+	}
+}
+
+bool TCPSocket::can_read(const FileDescriptor& fd) {
+	return !m_recv_buffer.empty() || !m_client_backlog.empty() || peer_closed();
+}
+
+bool TCPSocket::can_write(const FileDescriptor& fd) {
+	return IPSocket::can_write(fd) && m_unacked_bytes < m_send_buffer_size;
+}
+
 ResultRet<size_t> TCPSocket::do_send(SafePointer<uint8_t> buf, size_t len) {
 	if (m_connection_state != Connected)
 		return Result(EPIPE);
@@ -493,7 +594,7 @@ ResultRet<size_t> TCPSocket::do_send(SafePointer<uint8_t> buf, size_t len) {
 	if (!route.mac || !route.adapter)
 		return Result(set_error(EHOSTUNREACH));
 	const size_t payload_size = min(route.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPSegment), len);
-	TRYRES(send_tcp(TCP_PSH | TCP_ACK, buf, len, route));
+	TRYRES(send_tcp(TCP_PSH | TCP_ACK, buf, payload_size, route));
 	return payload_size;
 }
 
@@ -505,9 +606,9 @@ Result TCPSocket::do_listen() {
 void TCPSocket::close(FileDescriptor& fd) {
 	IPSocket::close(fd);
 
-	s_sockets_lock.acquire();
+	s_closing_sockets_lock.acquire();
 	s_closing_sockets[m_id] = self();
-	s_sockets_lock.release();
+	s_closing_sockets_lock.release();
 
 	shutdown_writing();
 	LOCK(m_lock);
@@ -533,6 +634,6 @@ Result TCPSocket::shutdown_reading() {
 }
 
 void TCPSocket::finish_closing() {
-	LOCK(s_sockets_lock);
+	LOCK(s_closing_sockets_lock);
 	s_closing_sockets.erase(m_id);
 }
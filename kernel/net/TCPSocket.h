@@ -5,6 +5,8 @@
 
 #include "IPSocket.h"
 #include "Router.h"
+#include "SocketTable.h"
+#include "../kstd/ByteRing.h"
 
 class TCPSocket: public IPSocket, public kstd::ArcSelf<TCPSocket> {
 public:
@@ -49,6 +51,15 @@ public:
 			}
 			return my_ip < other.my_ip;
 		}
+
+		struct Hash {
+			uint32_t operator()(const ID& id) const {
+				uint32_t hash = id.their_ip.val() ^ (((uint32_t) id.my_port << 16) | id.their_port);
+				hash ^= id.my_ip.val() * 0x9E3779B1;
+				hash *= 0x85EBCA6B;
+				return hash ^ (hash >> 16);
+			}
+		};
 	};
 
 	~TCPSocket() override;
@@ -57,9 +68,13 @@ public:
 	static kstd::Arc<TCPSocket> get_socket(const IPv4Address& dest_addr, uint16_t dest_port, const IPv4Address& src_addr, uint16_t src_port);
 
 	Result recv_packet(const void* buf, size_t len) override;
+	ssize_t recvfrom(FileDescriptor &fd, SafePointer<uint8_t> buf, size_t len, int flags, SafePointer<sockaddr> src_addr, SafePointer<socklen_t> addrlen) override;
 	[[nodiscard]] State state() const { return m_state; }
 
+	// File
 	void close(FileDescriptor &fd) override;
+	bool can_read(const FileDescriptor& fd) override;
+	bool can_write(const FileDescriptor& fd) override;
 
 protected:
 	TCPSocket();
@@ -70,6 +85,7 @@ protected:
 		NetworkAdapter::Packet* pkt;
 		kstd::Arc<NetworkAdapter> adapter;
 		uint32_t sequence;
+		size_t payload_size;
 	};
 
 	Result do_bind() override;
@@ -79,14 +95,23 @@ protected:
 	Result do_listen() override;
 	Result shutdown_writing() override;
 	Result shutdown_reading() override;
+	Result resize_receive_buffer(size_t new_size) override;
 
 	Result send_tcp(uint16_t flags, SafePointer<uint8_t> payload = {}, size_t size = 0, const kstd::Optional<Router::Route>& route = kstd::nullopt);
 	Result send_ack(bool dupe);
 	void finish_closing();
+	Result buffer_payload(const uint8_t* payload, size_t size);
+	bool peer_closed() const;
+
+	using Table = SocketTable<ID, TCPSocket, ID::Hash>;
 
-	static kstd::map<ID, kstd::Weak<TCPSocket>> s_sockets;
+	/** Connected sockets are looked up by their whole ID, and bound or listening ones by their address and port. **/
+	static Table& table_for(const ID& id) { return id.their_port ? s_connected_sockets : s_bound_sockets; }
+
+	static Table s_connected_sockets;
+	static Table s_bound_sockets;
 	static kstd::map<ID, kstd::Arc<TCPSocket>> s_closing_sockets;
-	static Mutex s_sockets_lock;
+	static Mutex s_closing_sockets_lock;
 
 	State m_state = Closed;
 	ID m_id {{0, 0, 0, 0}, 0, {0, 0, 0, 0}, 0};
@@ -96,6 +121,12 @@ protected:
 	uint8_t m_window_scale = 0;
 	size_t m_num_ooo_packets = 0;
 	kstd::queue<UnacknowledgedPacket> m_unacked_packets;
+	size_t m_unacked_bytes = 0; ///< Payload sent but not acknowledged yet, limited by m_send_buffer_size.
+
+	// Received payloads go into a ring of m_receive_buffer_size bytes, so reads aren't limited to one segment at a time
+	// and the window we advertise is exactly the space that's left.
+	kstd::ByteRing m_recv_buffer { m_receive_buffer_size };
+	Mutex m_recv_lock { "TCPSocket::recv" };
 	Mutex m_lock { "TCPSocket::lock" };
 	BooleanBlocker m_connect_blocker;
 	Direction m_direction = Direction::None;
@@ -9,29 +9,21 @@
 
 #define UDP_DBG true
 
-kstd::map<uint16_t, kstd::Weak<UDPSocket>> UDPSocket::s_sockets;
-Mutex UDPSocket::s_sockets_lock { "UDPSocket::sockets" };
+SocketTable<uint16_t, UDPSocket, UDPSocket::PortHash, 256> UDPSocket::s_sockets;
 
 UDPSocket::UDPSocket(): IPSocket(Type::Dgram, 0) {
 
 }
 
 UDPSocket::~UDPSocket() {
-	LOCK(s_sockets_lock);
 	if (m_bound) {
-		s_sockets.erase(m_bound_port);
+		s_sockets.erase(m_bound_port, this);
 		KLog::dbg_if<UDP_DBG>("UDPSocket", "Unbinding from port {}", m_bound_port);
 	}
 }
 
 kstd::Arc<UDPSocket> UDPSocket::get_socket(uint16_t port) {
-	LOCK(s_sockets_lock);
-	auto sock = s_sockets.get(port);
-	if (!sock)
-		return kstd::Arc<UDPSocket>(nullptr);
-	auto locked = (*sock).lock();
-	ASSERT(locked);
-	return locked;
+	return s_sockets.get(port);
 }
 
 ResultRet<kstd::Arc<UDPSocket>> UDPSocket::make() {
@@ -39,7 +31,7 @@ ResultRet<kstd::Arc<UDPSocket>> UDPSocket::make() {
 }
 
 Result UDPSocket::do_bind() {
-	LOCK(s_sockets_lock);
+	LOCK(m_lock);
 	if (m_bound)
 		return Result(set_error(EINVAL));
 
@@ -48,10 +40,11 @@ Result UDPSocket::do_bind() {
 		// (Range suggested by IANA and RFC 6335)
 		// First try a random port, then go through all of them if that one's taken
 		auto ephem = rand_range<uint16_t>(49152, 65535);
-		if (s_sockets.contains(ephem)) {
+		if (!s_sockets.insert(ephem, self())) {
 			bool found = false;
-			for(ephem = 49152; ephem <= 65535; ephem++) { // BUG FIX: < 65535 → <= 65535 agar port 65535 ikut dicek
-				if(!s_sockets.contains(ephem)) {
+			for (uint32_t port = 49152; port <= 65535; port++) {
+				if (s_sockets.insert(port, self())) {
+					ephem = port;
 					found = true;
 					break;
 				}
@@ -63,14 +56,11 @@ Result UDPSocket::do_bind() {
 		}
 
 		m_bound_port = ephem;
-	}
-
-	if (s_sockets.contains(m_bound_port))
+	} else if (!s_sockets.insert(m_bound_port, self())) {
 		return Result(set_error(EADDRINUSE));
+	}
 
 	KLog::dbg_if<UDP_DBG>("UDPSocket", "Binding to port {}", m_bound_port);
-
-	s_sockets[m_bound_port] = self();
 	m_bound = true;
 
 	return Result(SUCCESS);
@@ -105,6 +95,8 @@ ResultRet<size_t> UDPSocket::do_send(SafePointer<uint8_t> buf, size_t len) {
 		return Result(set_error(EHOSTUNREACH));
 
 	const size_t packet_len = sizeof(IPv4Packet) + sizeof(UDPPacket) + len;
+	if (packet_len > route.adapter->mtu())
+		return Result(set_error(EMSGSIZE));
 	auto pkt = TRY(route.adapter->alloc_packet(packet_len));
 	auto* ipv4_packet = route.adapter->setup_ipv4_packet(pkt, route.mac, m_dest_addr, UDP, sizeof(UDPPacket) + len, m_type_of_service, m_ttl);
 	auto* udp_packet = (UDPPacket*) ipv4_packet->payload;
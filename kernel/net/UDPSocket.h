@@ -4,6 +4,7 @@
 #pragma once
 
 #include "IPSocket.h"
+#include "SocketTable.h"
 
 class UDPSocket: public IPSocket, public kstd::ArcSelf<UDPSocket> {
 public:
@@ -22,6 +23,9 @@ protected:
 	ResultRet<size_t> do_send(SafePointer<uint8_t> buf, size_t len) override;
 	Result do_listen() override;
 
-	static kstd::map<uint16_t, kstd::Weak<UDPSocket>> s_sockets;
-	static Mutex s_sockets_lock;
+	struct PortHash {
+		uint32_t operator()(uint16_t port) const { return port; }
+	};
+
+	static SocketTable<uint16_t, UDPSocket, PortHash, 256> s_sockets;
 };
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "VirtioNetAdapter.h"
+#include "../kstd/KLog.h"
+#include "../memory/MemoryManager.h"
+#include "../tasking/TaskManager.h"
+
+// https://docs.oasis-open.org/virtio/virtio/v1.1/virtio-v1.1.html (5.1, Network Device)
+
+#define VIRTIO_NET_F_CSUM       0  // Device can checksum packets we send
+#define VIRTIO_NET_F_MAC        5  // Device has a MAC address in its config
+#define VIRTIO_NET_F_MRG_RXBUF  15 // Received packets can span multiple buffers, and headers have num_buffers
+
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1
+
+#define CONFIG_MAC 0
+
+#define QUEUE_RX 0
+#define QUEUE_TX 1
+
+#define VIRTIO_NET_DBG false
+
+void VirtioNetAdapter::probe() {
+	PCI::enumerate_devices([](PCI::Address address, PCI::ID id, uint16_t type, void* dataPtr) {
+		if (id.vendor != VIRTIO_VENDOR || id.device != VIRTIO_DEV_NET)
+			return;
+		char index[2] = {(char) ('0' + NetworkAdapter::interfaces().size()), '\0'};
+		auto adapter = kstd::Arc(new VirtioNetAdapter(address, kstd::string("en") + index));
+		if (adapter->init())
+			NetworkAdapter::register_interface(adapter);
+	}, nullptr);
+}
+
+VirtioNetAdapter::VirtioNetAdapter(PCI::Address addr, kstd::string name):
+	NetworkAdapter(kstd::move(name)), VirtioDevice(addr) {}
+
+bool VirtioNetAdapter::init() {
+	// TSO isn't negotiated since TCPSocket never builds segments bigger than the MTU, so frames always fit one buffer.
+	// Neither is VIRTIO_NET_F_GUEST_CSUM, so received packets always come with complete checksums.
+	negotiate_features((1u << VIRTIO_NET_F_CSUM) | (1u << VIRTIO_NET_F_MAC) |
+					   (1u << VIRTIO_NET_F_MRG_RXBUF) | (1u << VIRTIO_RING_F_EVENT_IDX));
+	if (!has_feature(VIRTIO_NET_F_MAC)) {
+		KLog::warn("VirtioNet", "{} has no MAC address!", name());
+		fail();
+		return false;
+	}
+
+	MACAddress addr = {config_read8(CONFIG_MAC + 0), config_read8(CONFIG_MAC + 1), config_read8(CONFIG_MAC + 2),
+					   config_read8(CONFIG_MAC + 3), config_read8(CONFIG_MAC + 4), config_read8(CONFIG_MAC + 5)};
+	KLog::dbg_if<VIRTIO_NET_DBG>("VirtioNet", "{} MAC Address: {}", name(), addr);
+	set_mac(addr);
+	set_checksum_offload(has_feature(VIRTIO_NET_F_CSUM));
+	if (!has_feature(VIRTIO_NET_F_MRG_RXBUF))
+		m_header_size = sizeof(Header) - sizeof(Header::num_buffers);
+
+	m_rx_queue = setup_queue(QUEUE_RX);
+	m_tx_queue = setup_queue(QUEUE_TX);
+	if (!m_rx_queue || !m_tx_queue) {
+		KLog::warn("VirtioNet", "{} is missing its queues!", name());
+		fail();
+		return false;
+	}
+
+	m_rx_buffer_region = MM.alloc_dma_region(rx_buffer_size * num_rx_buffers);
+	auto first_buffer_page = m_rx_buffer_region->object()->physical_page(0).paddr();
+	for (size_t i = 0; i < num_rx_buffers; i++) {
+		// Region should be contiguous in physical pages...
+		auto& pkt = m_rx_packets[i];
+		pkt.buffer = (uint8_t*) (m_rx_buffer_region->start() + rx_buffer_size * i + m_header_size);
+		pkt.buffer_paddr = first_buffer_page + rx_buffer_size * i + m_header_size;
+		pkt.recycle = true;
+		if (!post_rx_buffer(&pkt))
+			break; // The queue is smaller than we'd like
+	}
+
+	m_tx_header_region = MM.alloc_dma_region(sizeof(Header) * m_tx_queue->size());
+
+	finish_init();
+	m_rx_queue->kick();
+	return true;
+}
+
+bool VirtioNetAdapter::post_rx_buffer(Packet* packet) {
+	VirtQueue::Buffer buffer = {packet->buffer_paddr - m_header_size, rx_buffer_size, true};
+	return m_rx_queue->add(&buffer, 1, packet);
+}
+
+void VirtioNetAdapter::handle_queue_irq() {
+	receive();
+	reclaim_tx();
+}
+
+void VirtioNetAdapter::receive() {
+	do {
+		uint32_t length;
+		while (auto* pkt = (Packet*) m_rx_queue->pop_used(length)) {
+			auto* header = (Header*) (pkt->buffer - m_header_size);
+			pkt->refs.store(1, MemoryOrder::Release);
+
+			if (m_header_size == sizeof(Header) && header->num_buffers > 1) {
+				// We don't negotiate any offloads that make frames bigger than a buffer, so this shouldn't happen
+				KLog::warn("VirtioNet", "{} received a frame spanning {} buffers, dropping!", name(), header->num_buffers);
+				for (int i = 1; i < header->num_buffers; i++) {
+					uint32_t extra_length;
+					auto* extra_pkt = (Packet*) m_rx_queue->pop_used(extra_length);
+					if (!extra_pkt)
+						break;
+					extra_pkt->refs.store(1, MemoryOrder::Release);
+					release_packet(extra_pkt);
+				}
+				release_packet(pkt);
+				continue;
+			}
+
+			if (length < m_header_size + sizeof(FrameHeader)) {
+				release_packet(pkt);
+				continue;
+			}
+
+			KLog::dbg_if<VIRTIO_NET_DBG>("VirtioNet", "Received packet ({} bytes)", length - m_header_size);
+			pkt->size = length - m_header_size;
+			receive_packet(pkt);
+		}
+	} while (m_rx_queue->enable_interrupts());
+}
+
+void VirtioNetAdapter::recycle_packet(Packet* packet) {
+	ASSERT(packet >= m_rx_packets && packet < m_rx_packets + num_rx_buffers);
+	TaskManager::IRQSafeCritical crit;
+	post_rx_buffer(packet);
+	m_rx_queue->kick();
+}
+
+void VirtioNetAdapter::transmit(Packet* packet) {
+	ASSERT(packet->size <= packet_buffer_size);
+	TaskManager::IRQSafeCritical crit;
+
+	// Each packet takes two descriptors. If the queue is full, take back whatever the device has finished sending. If
+	// that isn't enough, the device is behind, so drop the packet rather than waiting with interrupts off.
+	if (m_tx_queue->free_descriptors() < 2) {
+		reclaim_tx();
+		if (m_tx_queue->free_descriptors() < 2) {
+			KLog::dbg_if<VIRTIO_NET_DBG>("VirtioNet", "Dropping packet because the transmit queue is full");
+			return;
+		}
+	}
+
+	auto head = m_tx_queue->next_head();
+	auto* header = (Header*) (m_tx_header_region->start() + sizeof(Header) * head);
+	memset(header, 0, sizeof(Header));
+	if (packet->csum_start) {
+		header->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		header->csum_start = packet->csum_start;
+		header->csum_offset = packet->csum_offset;
+	}
+
+	auto header_paddr = m_tx_header_region->object()->physical_page(0).paddr() + sizeof(Header) * head;
+	VirtQueue::Buffer buffers[] = {
+		{header_paddr, (uint32_t) m_header_size, false},
+		{packet->buffer_paddr, (uint32_t) packet->size, false}
+	};
+	retain_packet(packet);
+	m_tx_queue->add(buffers, 2, packet);
+	KLog::dbg_if<VIRTIO_NET_DBG>("VirtioNet", "Sending packet ({} bytes)", packet->size);
+	m_tx_queue->kick();
+}
+
+void VirtioNetAdapter::reclaim_packets() {
+	TaskManager::IRQSafeCritical crit;
+	reclaim_tx();
+}
+
+void VirtioNetAdapter::reclaim_tx() {
+	do {
+		uint32_t length;
+		while (auto* pkt = (Packet*) m_tx_queue->pop_used(length))
+			release_packet(pkt);
+		// There's no hurry to get sent packets back, so only ask to be interrupted once most of them are done
+	} while (m_tx_queue->enable_interrupts((m_tx_queue->size() - m_tx_queue->free_descriptors()) / 2 * 3 / 4));
+}
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "NetworkAdapter.h"
+#include "../pci/VirtioDevice.h"
+
+/**
+ * A driver for virtio-net devices, which are much cheaper to emulate than an E1000 since packets are passed through
+ * shared rings instead of one register access at a time.
+ */
+class VirtioNetAdapter: public NetworkAdapter, VirtioDevice {
+public:
+	static void probe();
+
+protected:
+	// NetworkAdapter
+	void transmit(Packet* packet) override;
+	void reclaim_packets() override;
+	void recycle_packet(Packet* packet) override;
+
+	// VirtioDevice
+	void handle_queue_irq() override;
+
+private:
+	explicit VirtioNetAdapter(PCI::Address addr, kstd::string name);
+
+	struct Header {
+		uint8_t flags;
+		uint8_t gso_type;
+		uint16_t header_length;
+		uint16_t gso_size;
+		uint16_t csum_start;
+		uint16_t csum_offset;
+		uint16_t num_buffers; ///< Only present with VIRTIO_NET_F_MRG_RXBUF.
+	} __attribute__((packed));
+
+	bool init();
+	void receive();
+	void reclaim_tx();
+	bool post_rx_buffer(Packet* packet);
+
+	static constexpr size_t num_rx_buffers = 128;
+	static constexpr size_t rx_buffer_size = packet_buffer_size;
+
+	VirtQueue* m_rx_queue = nullptr;
+	VirtQueue* m_tx_queue = nullptr;
+	size_t m_header_size = sizeof(Header);
+
+	// Each RX buffer has its own packet, which is handed to the network stack as-is (with the buffer pointing just past
+	// the virtio header) and posted to the device again once it's released.
+	kstd::Arc<VMRegion> m_rx_buffer_region;
+	Packet m_rx_packets[num_rx_buffers];
+
+	// Packets are sent from their own buffers, with the header in a separate descriptor. Headers are indexed by the
+	// chain's first descriptor, so each chain in flight has its own.
+	kstd::Arc<VMRegion> m_tx_header_region;
+};
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "VirtQueue.h"
+#include "VirtioDevice.h"
+#include "../memory/MemoryManager.h"
+
+#define VIRTQ_DESC_F_NEXT  1
+#define VIRTQ_DESC_F_WRITE 2
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 1
+#define VIRTQ_USED_F_NO_NOTIFY     1
+
+// Legacy devices need the used ring to start on its own page
+#define VIRTQ_ALIGN 4096
+
+static inline size_t align_up(size_t size, size_t align) {
+	return (size + align - 1) & ~(align - 1);
+}
+
+// Whether the other side asked to be notified when the index moved from old_idx to new_idx
+static inline bool need_event(uint16_t event_idx, uint16_t new_idx, uint16_t old_idx) {
+	return (uint16_t) (new_idx - event_idx - 1) < (uint16_t) (new_idx - old_idx);
+}
+
+VirtQueue::VirtQueue(VirtioDevice& device, uint16_t index, uint16_t size, bool event_idx):
+	m_device(device),
+	m_index(index),
+	m_size(size),
+	m_event_idx(event_idx),
+	m_num_free(size)
+{
+	const size_t avail_offset = sizeof(Descriptor) * size;
+	const size_t used_offset = align_up(avail_offset + sizeof(AvailableRing) + sizeof(uint16_t) * (size + 1), VIRTQ_ALIGN);
+	const size_t used_size = sizeof(UsedRing) + sizeof(UsedElement) * size + sizeof(uint16_t);
+	m_region = MM.alloc_dma_region(used_offset + align_up(used_size, VIRTQ_ALIGN));
+	memset((void*) m_region->start(), 0, m_region->size());
+
+	m_descriptors = (Descriptor*) m_region->start();
+	m_avail = (AvailableRing*) (m_region->start() + avail_offset);
+	m_used = (UsedRing*) (m_region->start() + used_offset);
+
+	for (uint16_t i = 0; i < size; i++)
+		m_descriptors[i].next = i + 1;
+	m_cookies.resize(size);
+}
+
+PhysicalAddress VirtQueue::ring_paddr() const {
+	return m_region->object()->physical_page(0).paddr();
+}
+
+int VirtQueue::next_head() const {
+	return m_num_free ? m_free_head : -1;
+}
+
+bool VirtQueue::add(const Buffer* buffers, size_t count, void* cookie) {
+	if (!count || count > m_num_free)
+		return false;
+
+	auto head = m_free_head;
+	auto desc_idx = head;
+	for (size_t i = 0; i < count; i++) {
+		auto& desc = m_descriptors[desc_idx];
+		desc.addr = buffers[i].addr;
+		desc.length = buffers[i].size;
+		desc.flags = (buffers[i].device_writable ? VIRTQ_DESC_F_WRITE : 0) | (i + 1 < count ? VIRTQ_DESC_F_NEXT : 0);
+		desc_idx = desc.next;
+	}
+	m_free_head = desc_idx;
+	m_num_free -= count;
+	m_cookies[head] = cookie;
+
+	// The descriptors have to be written before the device can see them in the ring
+	auto avail_idx = m_avail->idx;
+	m_avail->ring[avail_idx % m_size] = head;
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	*((volatile uint16_t*) &m_avail->idx) = avail_idx + 1;
+	return true;
+}
+
+void VirtQueue::kick() {
+	// Make sure we see the device's latest avail_event / flags after publishing the new index
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	uint16_t new_idx = m_avail->idx;
+	uint16_t old_idx = m_last_kicked;
+	if (new_idx == old_idx)
+		return;
+	m_last_kicked = new_idx;
+
+	bool notify;
+	if (m_event_idx)
+		notify = need_event(avail_event(), new_idx, old_idx);
+	else
+		notify = !(*((volatile uint16_t*) &m_used->flags) & VIRTQ_USED_F_NO_NOTIFY);
+	if (notify)
+		m_device.notify_queue(m_index);
+}
+
+bool VirtQueue::has_used() const {
+	return *((volatile uint16_t*) &m_used->idx) != m_last_used;
+}
+
+void* VirtQueue::pop_used(uint32_t& length) {
+	if (!has_used())
+		return nullptr;
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	auto& elem = m_used->ring[m_last_used % m_size];
+	auto head = (uint16_t) elem.id;
+	length = elem.length;
+	m_last_used++;
+
+	// Put the chain back on the free list
+	auto* cookie = m_cookies[head];
+	m_cookies[head] = nullptr;
+	auto tail = head;
+	size_t count = 1;
+	while (m_descriptors[tail].flags & VIRTQ_DESC_F_NEXT) {
+		tail = m_descriptors[tail].next;
+		count++;
+	}
+	m_descriptors[tail].next = m_free_head;
+	m_free_head = head;
+	m_num_free += count;
+	return cookie;
+}
+
+bool VirtQueue::enable_interrupts(uint16_t delay) {
+	if (m_event_idx)
+		used_event() = m_last_used + delay;
+	else
+		*((volatile uint16_t*) &m_avail->flags) = 0;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return has_used();
+}
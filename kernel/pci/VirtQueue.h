@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "../kstd/vector.hpp"
+#include "../memory/VMRegion.h"
+
+class VirtioDevice;
+
+/**
+ * A split virtqueue, which is how buffers are passed to and from a virtio device. Buffers are added to the available
+ * ring as chains of descriptors, and the device puts them on the used ring once it's done with them.
+ *
+ * If the device supports VIRTIO_RING_F_EVENT_IDX, each side tells the other at which index it next wants to be
+ * notified, so a device that's already busy isn't kicked for every buffer and we aren't interrupted for every buffer it
+ * finishes. VirtQueue doesn't lock anything itself; the device driver is responsible for that.
+ */
+class VirtQueue {
+public:
+	struct Buffer {
+		PhysicalAddress addr;
+		uint32_t size;
+		bool device_writable;
+	};
+
+	VirtQueue(VirtioDevice& device, uint16_t index, uint16_t size, bool event_idx);
+
+	[[nodiscard]] uint16_t index() const { return m_index; }
+	[[nodiscard]] uint16_t size() const { return m_size; }
+	[[nodiscard]] uint16_t free_descriptors() const { return m_num_free; }
+	[[nodiscard]] PhysicalAddress ring_paddr() const;
+
+	/** The descriptor index that the next chain added will start at, or -1 if the queue is full. **/
+	[[nodiscard]] int next_head() const;
+
+	/**
+	 * Adds a chain of buffers for the device to use. The device isn't told about them until kick() is called.
+	 * @param buffers The buffers to add.
+	 * @param count The number of buffers.
+	 * @param cookie A pointer that's returned by pop_used() once the device is done with the chain.
+	 * @return Whether there were enough free descriptors to add the chain.
+	 */
+	bool add(const Buffer* buffers, size_t count, void* cookie);
+
+	/** Tells the device about the buffers added since the last kick, if it wants to know. **/
+	void kick();
+
+	/** Whether the device has finished with any chains we haven't popped yet. **/
+	[[nodiscard]] bool has_used() const;
+
+	/**
+	 * Gets the next chain that the device is done with and frees its descriptors.
+	 * @param length Set to the number of bytes the device wrote to the chain.
+	 * @return The cookie the chain was added with, or nullptr if there are none.
+	 */
+	void* pop_used(uint32_t& length);
+
+	/**
+	 * Asks the device to interrupt us once it's used another chain, after we've popped everything. If the device
+	 * finished another chain while we were doing so, returns true and the caller should keep popping.
+	 * @param delay With VIRTIO_RING_F_EVENT_IDX, how many more chains the device should use before interrupting us.
+	 */
+	bool enable_interrupts(uint16_t delay = 0);
+
+private:
+	struct Descriptor {
+		uint64_t addr;
+		uint32_t length;
+		uint16_t flags;
+		uint16_t next;
+	};
+
+	struct AvailableRing {
+		uint16_t flags;
+		uint16_t idx;
+		uint16_t ring[]; ///< Followed by used_event if VIRTIO_RING_F_EVENT_IDX is negotiated.
+	};
+
+	struct UsedElement {
+		uint32_t id;
+		uint32_t length;
+	};
+
+	struct UsedRing {
+		uint16_t flags;
+		uint16_t idx;
+		UsedElement ring[]; ///< Followed by avail_event if VIRTIO_RING_F_EVENT_IDX is negotiated.
+	};
+
+	volatile uint16_t& used_event() { return m_avail->ring[m_size]; }
+	volatile uint16_t& avail_event() {
+		return *((volatile uint16_t*) ((uint8_t*) m_used + sizeof(UsedRing) + sizeof(UsedElement) * m_size));
+	}
+
+	VirtioDevice& m_device;
+	uint16_t m_index;
+	uint16_t m_size;
+	bool m_event_idx;
+	kstd::Arc<VMRegion> m_region;
+	Descriptor* m_descriptors;
+	AvailableRing* m_avail;
+	UsedRing* m_used;
+	kstd::vector<void*> m_cookies;
+	uint16_t m_free_head = 0;
+	uint16_t m_num_free;
+	uint16_t m_last_used = 0;
+	uint16_t m_last_kicked = 0;
+};
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "VirtioDevice.h"
+#include "../kstd/KLog.h"
+
+// https://docs.oasis-open.org/virtio/virtio/v1.1/virtio-v1.1.html (4.1.4.8, Legacy Interfaces)
+
+#define REG_DEVICE_FEATURES 0x00
+#define REG_DRIVER_FEATURES 0x04
+#define REG_QUEUE_ADDRESS   0x08
+#define REG_QUEUE_SIZE      0x0C
+#define REG_QUEUE_SELECT    0x0E
+#define REG_QUEUE_NOTIFY    0x10
+#define REG_DEVICE_STATUS   0x12
+#define REG_ISR_STATUS      0x13
+
+#define ISR_QUEUE  0x1
+#define ISR_CONFIG 0x2
+
+#define VIRTIO_DBG false
+
+VirtioDevice::VirtioDevice(PCI::Address addr): m_pci_address(addr) {
+	PCI::enable_bus_mastering(addr);
+	m_window = IO::Window(addr, PCI_BAR0);
+}
+
+VirtioDevice::~VirtioDevice() {
+	for (auto* queue : m_queues)
+		delete queue;
+}
+
+uint32_t VirtioDevice::negotiate_features(uint32_t supported) {
+	set_status(0);
+	set_status(VIRTIO_STATUS_ACKNOWLEDGE);
+	set_status(m_status | VIRTIO_STATUS_DRIVER);
+
+	auto device_features = m_window.in32(REG_DEVICE_FEATURES);
+	m_features = device_features & supported;
+	m_window.out32(REG_DRIVER_FEATURES, m_features);
+	KLog::dbg_if<VIRTIO_DBG>("Virtio", "Device features: {#x}, using {#x}", device_features, m_features);
+	return m_features;
+}
+
+VirtQueue* VirtioDevice::setup_queue(uint16_t index) {
+	m_window.out16(REG_QUEUE_SELECT, index);
+	auto size = m_window.in16(REG_QUEUE_SIZE);
+	if (!size)
+		return nullptr;
+
+	auto* queue = new VirtQueue(*this, index, size, has_feature(VIRTIO_RING_F_EVENT_IDX));
+	m_window.out32(REG_QUEUE_ADDRESS, queue->ring_paddr() / PAGE_SIZE);
+	m_queues.push_back(queue);
+	KLog::dbg_if<VIRTIO_DBG>("Virtio", "Queue {} has {} descriptors", index, size);
+	return queue;
+}
+
+void VirtioDevice::finish_init() {
+	int irq = PCI::read_byte(m_pci_address, PCI_INTERRUPT_LINE);
+	set_irq(irq);
+	reinstall_irq();
+	m_window.in8(REG_ISR_STATUS);
+	PCI::enable_interrupt(m_pci_address);
+	set_status(m_status | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void VirtioDevice::fail() {
+	set_status(m_status | VIRTIO_STATUS_FAILED);
+}
+
+void VirtioDevice::notify_queue(uint16_t index) {
+	m_window.out16(REG_QUEUE_NOTIFY, index);
+}
+
+void VirtioDevice::handle_irq(IRQRegisters* regs) {
+	// Reading the ISR status acknowledges the interrupt. It may be zero if we're sharing the line with another device.
+	auto isr = m_window.in8(REG_ISR_STATUS);
+	if (isr & ISR_CONFIG)
+		handle_config_change();
+	if (isr & ISR_QUEUE)
+		handle_queue_irq();
+}
+
+void VirtioDevice::set_status(uint8_t status) {
+	m_status = status;
+	m_window.out8(REG_DEVICE_STATUS, status);
+}
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "PCI.h"
+#include "VirtQueue.h"
+#include "../IO.h"
+#include "../interrupt/IRQHandler.h"
+
+#define VIRTIO_VENDOR 0x1AF4
+
+// Legacy (transitional) device IDs
+#define VIRTIO_DEV_NET   0x1000
+#define VIRTIO_DEV_BLOCK 0x1001
+
+// Device status bits
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01
+#define VIRTIO_STATUS_DRIVER      0x02
+#define VIRTIO_STATUS_DRIVER_OK   0x04
+#define VIRTIO_STATUS_FAILED      0x80
+
+// Feature bits common to all devices
+#define VIRTIO_RING_F_INDIRECT_DESC 28
+#define VIRTIO_RING_F_EVENT_IDX     29
+
+/**
+ * The base of drivers for virtio devices, using the legacy PCI interface (which QEMU's transitional devices provide
+ * in BAR0). It takes care of negotiating features, setting up virtqueues, and dispatching interrupts.
+ *
+ * Subclasses should call negotiate_features(), then set up their queues with setup_queue(), then call finish_init().
+ */
+class VirtioDevice: public IRQHandler {
+public:
+	/** Notifies the device that there are new buffers in a queue. Called by VirtQueue::kick(). **/
+	void notify_queue(uint16_t index);
+
+protected:
+	explicit VirtioDevice(PCI::Address addr);
+	virtual ~VirtioDevice();
+
+	/**
+	 * Resets the device and negotiates which features to use.
+	 * @param supported A mask of the feature bits the driver supports.
+	 * @return The features that both the driver and device support.
+	 */
+	uint32_t negotiate_features(uint32_t supported);
+	[[nodiscard]] bool has_feature(int bit) const { return m_features & (1u << bit); }
+
+	/** Sets up a virtqueue. Returns nullptr if the device doesn't have it. **/
+	VirtQueue* setup_queue(uint16_t index);
+	/** Tells the device we're ready to go, and enables interrupts. **/
+	void finish_init();
+	/** Tells the device we've given up on it. **/
+	void fail();
+
+	uint8_t config_read8(size_t offset) { return m_window.in8(config_offset + offset); }
+	uint16_t config_read16(size_t offset) { return m_window.in16(config_offset + offset); }
+	uint32_t config_read32(size_t offset) { return m_window.in32(config_offset + offset); }
+	uint64_t config_read64(size_t offset) { return config_read32(offset) | ((uint64_t) config_read32(offset + 4) << 32); }
+
+	/** Called from the IRQ handler when the device may have used some buffers. **/
+	virtual void handle_queue_irq() = 0;
+	/** Called from the IRQ handler when the device's configuration changed. **/
+	virtual void handle_config_change() {}
+
+	// IRQHandler
+	void handle_irq(IRQRegisters* regs) override;
+
+	PCI::Address m_pci_address;
+
+private:
+	static constexpr size_t config_offset = 0x14;
+
+	void set_status(uint8_t status);
+
+	IO::Window m_window;
+	uint32_t m_features = 0;
+	uint8_t m_status = 0;
+	kstd::vector<VirtQueue*> m_queues;
+};
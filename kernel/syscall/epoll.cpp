@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "../tasking/Process.h"
+#include "../memory/SafePointer.h"
+#include "../filesystem/FileDescriptor.h"
+#include "../filesystem/Epoll.h"
+#include "../api/epoll.h"
+
+#define get_epoll(epfd) \
+	m_fd_lock.acquire(); \
+	if(epfd < 0 || epfd >= (int) _file_descriptors.size() || !_file_descriptors[epfd]) { \
+		m_fd_lock.release(); \
+		return -EBADF; \
+	} \
+	auto epoll_desc = _file_descriptors[epfd]; \
+	m_fd_lock.release(); \
+	if(!epoll_desc->file()->is_epoll()) \
+		return -EINVAL; \
+	auto epoll = kstd::static_pointer_cast<Epoll>(epoll_desc->file());
+
+int Process::sys_epoll_create(int flags) {
+	if(flags & ~EPOLL_CLOEXEC)
+		return -EINVAL;
+
+	auto epoll = kstd::Arc<Epoll>(new Epoll());
+	return m_fd_lock.synced<int>([&] {
+		auto fd = kstd::Arc(new FileDescriptor(epoll, this));
+		fd->set_options(O_RDWR | ((flags & EPOLL_CLOEXEC) ? O_CLOEXEC : 0));
+		_file_descriptors.push_back(fd);
+		fd->set_id((int) _file_descriptors.size() - 1);
+		return (int) _file_descriptors.size() - 1;
+	});
+}
+
+int Process::sys_epoll_ctl(UserspacePointer<struct epoll_ctl_args> args_ptr) {
+	auto args = args_ptr.get();
+	get_epoll(args.epfd);
+
+	m_fd_lock.acquire();
+	if(args.fd < 0 || args.fd >= (int) _file_descriptors.size() || !_file_descriptors[args.fd]) {
+		m_fd_lock.release();
+		return -EBADF;
+	}
+	auto desc = _file_descriptors[args.fd];
+	m_fd_lock.release();
+
+	Result res = Result(SUCCESS);
+	switch(args.op) {
+		case EPOLL_CTL_ADD:
+			res = epoll->add(args.fd, desc, UserspacePointer<epoll_event>(args.event).get());
+			break;
+		case EPOLL_CTL_MOD:
+			res = epoll->modify(args.fd, desc, UserspacePointer<epoll_event>(args.event).get());
+			break;
+		case EPOLL_CTL_DEL:
+			res = epoll->remove(args.fd, desc);
+			break;
+		default:
+			return -EINVAL;
+	}
+	return -res.code();
+}
+
+int Process::sys_epoll_wait(UserspacePointer<struct epoll_wait_args> args_ptr) {
+	auto args = args_ptr.get();
+	if(args.max_events <= 0)
+		return -EINVAL;
+	get_epoll(args.epfd);
+	return epoll->wait(UserspacePointer<epoll_event>(args.events), args.max_events, args.timeout);
+}
@@ -22,6 +22,7 @@ int Process::exec(const kstd::string& filename, ProcessArgs* args) {
 		new_proc->_sid  = _sid;
 		new_proc->_tty  = _tty;   // inherit TTY for job control / SIGINT etc.
 		new_proc->_name = _name;  // keep name consistent until new image starts
+		new_proc->_dead_thread_stats = stats();
 		if (_kernel_mode) {
 			//Kernel processes have no file descriptors, so we need to initialize them
 			auto ttydesc = kstd::make_shared<FileDescriptor>(VirtualTTY::current_tty());
@@ -7,38 +7,52 @@
 #include "../filesystem/FileDescriptor.h"
 #include "../tasking/Futex.h"
 
-int Process::sys_futex(UserspacePointer<futex_t> futex, int op) {
+static ResultRet<FutexTable::Key> futex_key(VMSpace& space, UserspacePointer<futex_t> futex) {
 	auto addr = (uintptr_t) futex.raw();
-	if (addr > HIGHER_HALF)
-		return -EFAULT;
-	auto reg_res = _vm_space->get_region_containing(addr);
-	if (reg_res.is_error())
-		return -EFAULT;
-	auto reg = reg_res.value();
+	if (addr > HIGHER_HALF || addr % sizeof(futex_t))
+		return Result(EFAULT);
+	auto reg = TRY(space.get_region_containing(addr));
 	if (!reg->prot().read || !reg->prot().write)
-		return -EPERM;
+		return Result(EPERM);
+	return FutexTable::Key {reg->object(), addr - reg->start() + reg->object_start()};
+}
+
+int Process::sys_futex(UserspacePointer<futex_t> futex, int op, size_t arg) {
+	auto key_res = futex_key(*_vm_space, futex);
+	if (key_res.is_error())
+		return -key_res.code();
+	auto& key = key_res.value();
 
 	switch (op) {
 	case FUTEX_REGFD:
-		return m_fd_lock.synced<int>([this, addr, reg] {
-			auto futex = kstd::Arc(new Futex(reg->object(), addr - reg->start()));
+		return m_fd_lock.synced<int>([this, &key] {
+			auto futex = kstd::Arc(new Futex(key.object, key.offset));
 			auto fd = kstd::Arc(new FileDescriptor(futex, this));
 			_file_descriptors.push_back(fd);
 			fd->set_id((int) _file_descriptors.size() - 1);
 			return (int)_file_descriptors.size() - 1;
 		});
 	case FUTEX_WAIT: {
-		Futex k_futex {reg->object(), addr - reg->start()};
-		// leave_syscall() sebelum block() — kalau tidak,
-		// leave_critical() setelah unblock akan ASSERT(!_in_syscall) → BSOD.
-		// Pola ini sama dengan sys_waitpid, sys_sleep, dll.
-		auto* thread = TaskManager::current_thread().get();
-		thread->leave_syscall();
-		thread->block(k_futex);
-		thread->enter_syscall();
-		return SUCCESS;
+		auto res = FutexTable::wait(key, futex, FutexTable::Condition::NotPositive, 0, nullptr);
+		return res == -EAGAIN ? SUCCESS : res;
+	}
+	case FUTEX_WAIT_VALUE: {
+		auto args = UserspacePointer<futex_args>((futex_args*) arg).get();
+		if (!args.timeout)
+			return FutexTable::wait(key, futex, FutexTable::Condition::Equal, args.value, nullptr);
+		auto timeout = Time(UserspacePointer<timespec>((timespec*) args.timeout).get());
+		return FutexTable::wait(key, futex, FutexTable::Condition::Equal, args.value, &timeout);
+	}
+	case FUTEX_WAKE:
+		return FutexTable::wake(key, (int) arg);
+	case FUTEX_REQUEUE: {
+		auto args = UserspacePointer<futex_args>((futex_args*) arg).get();
+		auto key2_res = futex_key(*_vm_space, args.futex2);
+		if (key2_res.is_error())
+			return -key2_res.code();
+		return FutexTable::requeue(key, futex, args.value, args.count, key2_res.value(), args.requeue_count);
 	}
 	default:
 		return -EINVAL;
 	}
-}
\ No newline at end of file
+}
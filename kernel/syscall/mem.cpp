@@ -145,13 +145,22 @@ Result Process::sys_mmap(UserspacePointer<struct mmap_args> args_ptr) {
 		if((!file_desc->readable() && prot.read) || (!file_desc->writable() && prot.write && (args.flags & MAP_SHARED)))
 			return Result(EPERM);
 		auto file = file_desc->file();
-		if(!file || !file->is_inode())
+		if(!file)
 			return Result(EBADF);
-		auto inode = kstd::static_pointer_cast<InodeFile>(file)->inode();
-		if(args.flags & MAP_SHARED)
-			vm_object = inode->shared_vm_object(file_desc->path());
-		else
-			vm_object = InodeVMObject::make_for_inode(file_desc->path(), inode, InodeVMObject::Type::Private);
+		if(file->is_inode()) {
+			auto inode = kstd::static_pointer_cast<InodeFile>(file)->inode();
+			if(args.flags & MAP_SHARED)
+				vm_object = inode->shared_vm_object(file_desc->path());
+			else
+				vm_object = InodeVMObject::make_for_inode(file_desc->path(), inode, InodeVMObject::Type::Private);
+		} else {
+			// Other files (like profilers) may have memory of their own to share
+			if(!(args.flags & MAP_SHARED))
+				return Result(EINVAL);
+			vm_object = file->vm_object();
+			if(!vm_object)
+				return Result(ENODEV);
+		}
 	}
 
 	if(!vm_object)
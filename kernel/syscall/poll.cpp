@@ -9,7 +9,9 @@
 int Process::sys_poll(UserspacePointer<pollfd> pollfd, nfds_t nfd, int timeout) {
 	//Build the list of PollBlocker::PollFDs
 	kstd::vector<PollBlocker::PollFD> polls;
+	kstd::vector<nfds_t> poll_indices;
 	polls.reserve(nfd);
+	poll_indices.reserve(nfd);
 	for(nfds_t i = 0; i < nfd; i++) {
 		auto poll = pollfd.get(i);
 		//Make sure the fd is valid. If not, set revents to POLLINVAL
@@ -18,25 +20,28 @@ int Process::sys_poll(UserspacePointer<pollfd> pollfd, nfds_t nfd, int timeout)
 		} else {
 			poll.revents = 0;
 			polls.push_back({poll.fd, _file_descriptors[poll.fd], poll.events});
+			poll_indices.push_back(i);
 		}
 		pollfd.set(i, poll);
 	}
 
 	//Block
-	PollBlocker blocker(polls, Time(0, timeout * 1000));
+	PollBlocker blocker(polls, Time(timeout / 1000, (timeout % 1000) * 1000));
 	TaskManager::current_thread()->block(blocker);
 	if(blocker.was_interrupted())
 		return -EINTR;
 
-	//Set appropriate revent
-	for(nfds_t i = 0; i < nfd; i++) {
-		auto poll = pollfd.get(i);
-		if(poll.fd == blocker.polled) {
-			poll.revents = blocker.polled_revent;
-			pollfd.set(i, poll);
-			break;
-		}
+	//Report every fd that's ready, not just the one that woke us up
+	int num_ready = 0;
+	for(size_t i = 0; i < polls.size(); i++) {
+		auto revents = PollBlocker::ready_events(polls[i]);
+		if(!revents)
+			continue;
+		auto poll = pollfd.get(poll_indices[i]);
+		poll.revents = revents;
+		pollfd.set(poll_indices[i], poll);
+		num_ready++;
 	}
 
-	return SUCCESS;
+	return num_ready;
 }
\ No newline at end of file
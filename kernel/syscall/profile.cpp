@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "../tasking/Process.h"
+#include "../tasking/Profiler.h"
+#include "../memory/SafePointer.h"
+#include "../filesystem/FileDescriptor.h"
+#include "../api/profile.h"
+
+int Process::sys_profile(UserspacePointer<struct profile_args> args_ptr) {
+	// Samples can show where any process is, including in the kernel, so this is limited to root like ptrace
+	if (_user.uid != 0)
+		return -EACCES;
+
+	auto args = args_ptr.get();
+	if (args.pid != PROFILE_ALL_PROCESSES) {
+		auto proc_res = TaskManager::process_for_pid(args.pid);
+		if (proc_res.is_error())
+			return -proc_res.code();
+		if (proc_res.value()->is_kernel_mode())
+			return -EACCES;
+	}
+
+	auto profiler_res = Profiler::make(args.pid, args.frequency, args.buffer_size);
+	if (profiler_res.is_error())
+		return -profiler_res.code();
+
+	return m_fd_lock.synced<int>([&] {
+		auto fd = kstd::Arc(new FileDescriptor(profiler_res.value(), this));
+		fd->set_options(O_RDWR | O_CLOEXEC);
+		_file_descriptors.push_back(fd);
+		fd->set_id((int) _file_descriptors.size() - 1);
+		return (int) _file_descriptors.size() - 1;
+	});
+}
@@ -111,6 +111,21 @@ int Process::sys_ptrace(UserspacePointer<struct ptrace_args> args_ptr) {
                 // Kembalikan -EFAULT daripada BSOD.
                 if (obj_offset >= reg->object()->size())
                         return -EFAULT;
+                // Writing to a file's shared object (like program text) would change it for everything mapping the file
+                if (args.request == PTRACE_POKE && reg->object()->fork_action() == VMObject::ForkAction::Share && reg->object()->is_inode())
+                        return -EPERM;
+                // Private pages may still be shared with the file's (or a forked process's) pages, so copy them first
+                if (args.request == PTRACE_POKE) {
+                        auto page = obj_offset / PAGE_SIZE;
+                        if (reg->object()->try_fault_in_page(page).is_error() && !reg->object()->physical_page_index(page))
+                                return -EFAULT;
+                        if (reg->object()->page_is_cow(page)) {
+                                if (reg->object()->try_cow_page(page).is_error())
+                                        return -ENOMEM;
+                                auto region_page = ((VirtualAddress) args.addr - reg->start()) / PAGE_SIZE;
+                                tracer->tracee_thread()->process()->page_directory()->map(*reg, VirtualRange { region_page * PAGE_SIZE, PAGE_SIZE });
+                        }
+                }
                 auto kreg = MM.map_object(reg->object());
                 auto* kptr = (uintptr_t*) (kreg->start() + obj_offset);
                 if (args.request == PTRACE_PEEK)
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "../tasking/Process.h"
+#include "../memory/SafePointer.h"
+#include "../filesystem/FileDescriptor.h"
+#include "../api/sendfile.h"
+#include "../kstd/kstdlib.h"
+
+// The most that's moved through the kernel buffer at a time.
+#define SPLICE_CHUNK_SIZE (64 * 1024)
+
+#define get_desc(fd, desc) \
+	m_fd_lock.acquire(); \
+	if(fd < 0 || fd >= (int) _file_descriptors.size() || !_file_descriptors[fd]) { \
+		m_fd_lock.release(); \
+		return -EBADF; \
+	} \
+	auto desc = _file_descriptors[fd]; \
+	m_fd_lock.release();
+
+/**
+ * Moves up to count bytes from in to out without going through userspace. Reads from inodes go straight from the disk
+ * cache into the kernel buffer, and writes to sockets are sent from it.
+ * If in_offset or out_offset are given, they're used (and updated) instead of the descriptors' offsets.
+ *
+ * Everything still goes through one kernel buffer, including file-to-file copies: the disk cache isn't made of pages
+ * we could hand to the destination, so the data is copied out of it and then into the destination's cache.
+ */
+static ssize_t splice_files(FileDescriptor& in, off_t* in_offset, FileDescriptor& out, off_t* out_offset, size_t count) {
+	if(!in.readable() || !out.writable())
+		return -EBADF;
+	if((in_offset && !in.file()->is_inode()) || (out_offset && !out.file()->is_inode()))
+		return -ESPIPE;
+	if((in_offset && *in_offset < 0) || (out_offset && *out_offset < 0))
+		return -EINVAL;
+	if(!count)
+		return 0;
+
+	auto buffer_size = min(count, (size_t) SPLICE_CHUNK_SIZE);
+	auto* buffer = (uint8_t*) kmalloc(buffer_size);
+	if(!buffer)
+		return -ENOMEM;
+	KernelPointer<uint8_t> buffer_ptr(buffer);
+
+	size_t total = 0;
+	ssize_t error = 0;
+	while(total < count) {
+		size_t chunk = min(count - total, buffer_size);
+		ssize_t nread;
+		if(in_offset) {
+			nread = in.file()->read(in, *in_offset, buffer_ptr, chunk);
+			if(nread > 0)
+				*in_offset += nread;
+		} else {
+			nread = in.read(buffer_ptr, chunk);
+		}
+		if(nread <= 0) {
+			error = nread;
+			break;
+		}
+
+		size_t nwritten = 0;
+		while(nwritten < (size_t) nread) {
+			ssize_t ret;
+			if(out_offset) {
+				ret = out.file()->write(out, *out_offset, KernelPointer<uint8_t>(buffer + nwritten), nread - nwritten);
+				if(ret > 0)
+					*out_offset += ret;
+			} else {
+				ret = out.write(KernelPointer<uint8_t>(buffer + nwritten), nread - nwritten);
+			}
+			if(ret <= 0) {
+				error = ret ? ret : -EIO;
+				break;
+			}
+			nwritten += ret;
+		}
+		total += nwritten;
+
+		if(nwritten < (size_t) nread) {
+			// Put back what we read but couldn't write, if we can
+			if(in_offset)
+				*in_offset -= (off_t) (nread - nwritten);
+			else if(in.file()->is_inode())
+				in.seek(-(off_t) (nread - nwritten), SEEK_CUR);
+			break;
+		}
+
+		// A short read means we hit the end of a file, or a pipe or socket had nothing more for now
+		if((size_t) nread < chunk)
+			break;
+	}
+
+	kfree(buffer);
+	return total ? (ssize_t) total : error;
+}
+
+ssize_t Process::sys_sendfile(UserspacePointer<struct sendfile_args> args_ptr) {
+	auto args = args_ptr.get();
+	get_desc(args.in_fd, in_desc);
+	get_desc(args.out_fd, out_desc);
+
+	if(!args.offset)
+		return splice_files(*in_desc, nullptr, *out_desc, nullptr, args.count);
+
+	auto offset_ptr = UserspacePointer<off_t>(args.offset);
+	off_t offset = offset_ptr.get();
+	auto ret = splice_files(*in_desc, &offset, *out_desc, nullptr, args.count);
+	offset_ptr.set(offset);
+	return ret;
+}
+
+ssize_t Process::sys_splice(UserspacePointer<struct splice_args> args_ptr) {
+	auto args = args_ptr.get();
+	// We can't stop a pipe or socket from blocking partway through a splice, so SPLICE_F_NONBLOCK isn't supported
+	if(args.flags & ~(SPLICE_F_MOVE | SPLICE_F_MORE | SPLICE_F_GIFT))
+		return -EINVAL;
+	get_desc(args.fd_in, in_desc);
+	get_desc(args.fd_out, out_desc);
+	if(in_desc == out_desc)
+		return -EINVAL;
+
+	auto in_offset_ptr = UserspacePointer<off_t>(args.off_in);
+	auto out_offset_ptr = UserspacePointer<off_t>(args.off_out);
+	off_t in_offset = args.off_in ? in_offset_ptr.get() : 0;
+	off_t out_offset = args.off_out ? out_offset_ptr.get() : 0;
+
+	auto ret = splice_files(*in_desc, args.off_in ? &in_offset : nullptr, *out_desc, args.off_out ? &out_offset : nullptr, args.len);
+	if(args.off_in)
+		in_offset_ptr.set(in_offset);
+	if(args.off_out)
+		out_offset_ptr.set(out_offset);
+	return ret;
+}
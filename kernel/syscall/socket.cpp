@@ -9,6 +9,9 @@
 #include "../api/ifaddrs.h"
 #include "syscall_numbers.h"
 
+// The most messages recvmmsg and sendmmsg will handle in one call.
+#define MMSG_MAX_VLEN 1024
+
 int Process::sys_socket(int domain, int type, int protocol) {
 	auto socket_res = Socket::make((Socket::Domain) domain, (Socket::Type) type, protocol);
 	if (socket_res.is_error())
@@ -29,6 +32,7 @@ int Process::sys_socket(int domain, int type, int protocol) {
 		return -EBADF; \
 	} \
 	auto desc = _file_descriptors[fd]; \
+	m_fd_lock.release(); \
 	if (!desc->file()->is_socket()) \
 		return -ENOTSOCK; \
 	auto socket = kstd::static_pointer_cast<Socket>(desc->file());
@@ -57,8 +61,7 @@ int Process::sys_getsockopt(UserspacePointer<struct getsockopt_args> ptr) {
 	return res.code();
 }
 
-int Process::sys_recvmsg(int sockfd, UserspacePointer<struct msghdr> msg_ptr, int flags) {
-	get_socket(sockfd);
+static ssize_t recv_message(Socket& socket, FileDescriptor& desc, UserspacePointer<struct msghdr> msg_ptr, int flags) {
 	auto msg = msg_ptr.get();
 
 	// TODO: More than one entry in iovec
@@ -73,12 +76,10 @@ int Process::sys_recvmsg(int sockfd, UserspacePointer<struct msghdr> msg_ptr, in
 	// TODO: Control messages
 	UserspacePointer(&msg_ptr.raw()->msg_controllen).set(0);
 
-	return socket->recvfrom(*desc, buf, iov.iov_len, flags, addr_ptr, addrlen_ptr);
+	return socket.recvfrom(desc, buf, iov.iov_len, flags, addr_ptr, addrlen_ptr);
 }
 
-int Process::sys_sendmsg(int sockfd, UserspacePointer<struct msghdr> msg_ptr, int flags) {
-	get_socket(sockfd);
-
+static ssize_t send_message(Socket& socket, FileDescriptor& desc, UserspacePointer<struct msghdr> msg_ptr, int flags) {
 	auto msg = msg_ptr.get();
 
 	// TODO: More than one entry in iovec
@@ -93,7 +94,53 @@ int Process::sys_sendmsg(int sockfd, UserspacePointer<struct msghdr> msg_ptr, in
 	// TODO: Control messages
 	UserspacePointer(&msg_ptr.raw()->msg_controllen).set(0);
 
-	return socket->sendto(*desc, buf, iov.iov_len, flags, addr_ptr, addrlen_ptr.get());
+	return socket.sendto(desc, buf, iov.iov_len, flags, addr_ptr, addrlen_ptr.get());
+}
+
+int Process::sys_recvmsg(int sockfd, UserspacePointer<struct msghdr> msg_ptr, int flags) {
+	get_socket(sockfd);
+	return recv_message(*socket, *desc, msg_ptr, flags);
+}
+
+int Process::sys_sendmsg(int sockfd, UserspacePointer<struct msghdr> msg_ptr, int flags) {
+	get_socket(sockfd);
+	return send_message(*socket, *desc, msg_ptr, flags);
+}
+
+int Process::sys_recvmmsg(UserspacePointer<struct mmsg_args> args_ptr) {
+	auto args = args_ptr.get();
+	get_socket(args.sockfd);
+	auto vlen = min(args.vlen, (unsigned int) MMSG_MAX_VLEN);
+	auto flags = args.flags & ~MSG_WAITFORONE;
+
+	// Once we've got at least one message, we only return errors from the first one
+	unsigned int count = 0;
+	for (; count < vlen; count++) {
+		auto msg_ptr = UserspacePointer(&args.msgvec[count].msg_hdr);
+		auto nread = recv_message(*socket, *desc, msg_ptr, flags);
+		if (nread < 0)
+			return count ? (int) count : (int) nread;
+		UserspacePointer(&args.msgvec[count].msg_len).set((unsigned int) nread);
+		if (args.flags & MSG_WAITFORONE)
+			flags |= MSG_DONTWAIT;
+	}
+	return (int) count;
+}
+
+int Process::sys_sendmmsg(UserspacePointer<struct mmsg_args> args_ptr) {
+	auto args = args_ptr.get();
+	get_socket(args.sockfd);
+	auto vlen = min(args.vlen, (unsigned int) MMSG_MAX_VLEN);
+
+	unsigned int count = 0;
+	for (; count < vlen; count++) {
+		auto msg_ptr = UserspacePointer(&args.msgvec[count].msg_hdr);
+		auto nsent = send_message(*socket, *desc, msg_ptr, args.flags);
+		if (nsent < 0)
+			return count ? (int) count : (int) nsent;
+		UserspacePointer(&args.msgvec[count].msg_len).set((unsigned int) nsent);
+	}
+	return (int) count;
 }
 
 template<typename T>
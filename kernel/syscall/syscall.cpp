@@ -200,10 +200,26 @@ int handle_syscall(ThreadRegisters& regs, size_t call, size_t arg1, size_t arg2,
 		case SYS_ACCEPT:
 			return cur_proc->sys_accept(arg1, (struct sockaddr*) arg2, (uint32_t*) arg3);
 		case SYS_FUTEX:
-			return cur_proc->sys_futex((int*) arg1, arg2);
+			return cur_proc->sys_futex((int*) arg1, arg2, arg3);
 		case SYS_YIELD:
 			TaskManager::yield();
 			return 0;
+		case SYS_PROFILE:
+			return cur_proc->sys_profile((struct profile_args*) arg1);
+		case SYS_EPOLL_CREATE:
+			return cur_proc->sys_epoll_create(arg1);
+		case SYS_EPOLL_CTL:
+			return cur_proc->sys_epoll_ctl((struct epoll_ctl_args*) arg1);
+		case SYS_EPOLL_WAIT:
+			return cur_proc->sys_epoll_wait((struct epoll_wait_args*) arg1);
+		case SYS_SENDFILE:
+			return cur_proc->sys_sendfile((struct sendfile_args*) arg1);
+		case SYS_SPLICE:
+			return cur_proc->sys_splice((struct splice_args*) arg1);
+		case SYS_RECVMMSG:
+			return cur_proc->sys_recvmmsg((struct mmsg_args*) arg1);
+		case SYS_SENDMMSG:
+			return cur_proc->sys_sendmmsg((struct mmsg_args*) arg1);
 
 		
 		case SYS_REBOOT:
@@ -93,6 +93,14 @@
 #define SYS_FUTEX 90
 #define SYS_YIELD 91
 #define SYS_REBOOT 92
+#define SYS_PROFILE 93
+#define SYS_EPOLL_CREATE 94
+#define SYS_EPOLL_CTL 95
+#define SYS_EPOLL_WAIT 96
+#define SYS_SENDFILE 97
+#define SYS_SPLICE 98
+#define SYS_RECVMMSG 99
+#define SYS_SENDMMSG 100
 
 #ifndef NUSAOS_KERNEL
 #include <sys/types.h>
@@ -119,4 +127,11 @@ struct setsockopt_args {
 	int option_name;
 	const void* option_value;
 	uint32_t option_len;
+};
+
+struct mmsg_args {
+	int sockfd;
+	struct mmsghdr* msgvec;
+	unsigned int vlen;
+	int flags;
 };
\ No newline at end of file
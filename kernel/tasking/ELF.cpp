@@ -22,7 +22,8 @@
 #include <kernel/memory/MemoryManager.h>
 #include <kernel/filesystem/FileDescriptor.h>
 #include <kernel/kstd/KLog.h>
-#include <kernel/memory/AnonymousVMObject.h>
+#include <kernel/memory/InodeVMObject.h>
+#include <kernel/filesystem/InodeFile.h>
 
 bool ELF::is_valid_elf_header(elf32_header* header) {
 	return header->magic == ELF_MAGIC;
@@ -113,28 +114,38 @@ ResultRet<kstd::string> ELF::read_interp(FileDescriptor& fd, kstd::vector<elf32_
 }
 
 ResultRet<kstd::vector<kstd::Arc<VMRegion>>> ELF::load_sections(FileDescriptor& fd, kstd::vector<elf32_segment_header>& headers, const kstd::Arc<VMSpace>& vm_space) {
+	if(!fd.file()->is_inode())
+		return Result(-ENOEXEC);
+	auto inode = kstd::static_pointer_cast<InodeFile>(fd.file())->inode();
+
 	kstd::vector<kstd::Arc<VMRegion>> regions;
 	for(uint32_t i = 0; i < headers.size(); i++) {
 		auto& header = headers[i];
 		if(header.p_type == ELF_PT_LOAD) {
-			size_t loadloc_pagealigned = (header.p_vaddr/PAGE_SIZE) * PAGE_SIZE;
-			size_t loadsize_pagealigned = header.p_memsz + (header.p_vaddr % PAGE_SIZE);
-
-			//Allocate a kernel memory region to load the section into
-			auto object = TRY(AnonymousVMObject::alloc(loadsize_pagealigned, fd.path()));
-			auto tmp_region = MM.map_object(object);
-
-			//Read the section into the region
-			fd.seek(header.p_offset, SEEK_SET);
-			fd.read(KernelPointer<uint8_t>((uint8_t*) tmp_region->start() + (header.p_vaddr - loadloc_pagealigned)), header.p_filesz);
+			size_t page_offset = header.p_vaddr % PAGE_SIZE;
+			if(header.p_offset < page_offset || header.p_filesz > header.p_memsz)
+				return Result(-ENOEXEC);
+			size_t loadloc_pagealigned = header.p_vaddr - page_offset;
+			size_t loadsize_pagealigned = kstd::ceil_div(header.p_memsz + page_offset, PAGE_SIZE) * PAGE_SIZE;
+			size_t file_offset = header.p_offset - page_offset;
 
-			//Map it into the program's vmem
 			VMProt prot = {
 				.read = (bool) (header.p_flags & ELF_PF_R),
 				.write = (bool) (header.p_flags & ELF_PF_W),
 				.execute = (bool) (header.p_flags & ELF_PF_X)
 			};
-			auto vmem_region = TRY(vm_space->map_object(object, prot, VirtualRange { loadloc_pagealigned, tmp_region->size() }));
+
+			//Nothing is read in now; pages are read from the file when they're first touched. Read-only segments are
+			//mapped straight from the file's shared object, so every process running it uses the same pages. Writable
+			//ones (or ones with a zero-filled tail) are private, and only get copies of their own once they're written to.
+			kstd::Arc<VMRegion> vmem_region;
+			if(!prot.write && header.p_filesz == header.p_memsz && file_offset % PAGE_SIZE == 0) {
+				auto object = inode->shared_vm_object(fd.path());
+				vmem_region = TRY(vm_space->map_object(object, prot, VirtualRange { loadloc_pagealigned, loadsize_pagealigned }, file_offset));
+			} else {
+				auto object = InodeVMObject::make_private(fd.path(), inode, file_offset, header.p_filesz + page_offset, loadsize_pagealigned);
+				vmem_region = TRY(vm_space->map_object(object, prot, VirtualRange { loadloc_pagealigned, loadsize_pagealigned }));
+			}
 			regions.push_back(vmem_region);
 		}
 	}
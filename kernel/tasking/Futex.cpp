@@ -3,6 +3,8 @@
 
 #include "Futex.h"
 #include "../memory/MemoryManager.h"
+#include "TaskManager.h"
+#include "Thread.h"
 
 Futex::Futex(kstd::Arc<VMObject> object, size_t offset_in_object):
 	m_object(kstd::move(object)),
@@ -19,3 +21,139 @@ bool Futex::is_ready() {
 bool Futex::can_read(const FileDescriptor& fd) {
 	return is_ready();
 }
+
+FutexTable::Bucket FutexTable::s_buckets[FutexTable::num_buckets];
+
+FutexTable::Waiter::Waiter(const Key& key, const Time* timeout):
+	key(key),
+	thread(TaskManager::current_thread().get()),
+	has_timeout(timeout),
+	end_time(timeout ? Time::now() + *timeout : Time())
+{}
+
+bool FutexTable::Waiter::is_ready() {
+	return woken || (has_timeout && Time::now() >= end_time);
+}
+
+void FutexTable::Bucket::append(Waiter* waiter) {
+	waiter->prev = tail;
+	waiter->next = nullptr;
+	if(tail)
+		tail->next = waiter;
+	else
+		head = waiter;
+	tail = waiter;
+}
+
+void FutexTable::Bucket::remove(Waiter* waiter) {
+	if(waiter->prev)
+		waiter->prev->next = waiter->next;
+	else
+		head = waiter->next;
+	if(waiter->next)
+		waiter->next->prev = waiter->prev;
+	else
+		tail = waiter->prev;
+	waiter->prev = nullptr;
+	waiter->next = nullptr;
+}
+
+FutexTable::Bucket& FutexTable::bucket_for(const Key& key) {
+	auto hash = ((uintptr_t) key.object.get() >> 4) ^ (key.offset >> 2) ^ (key.offset >> 8);
+	return s_buckets[hash % num_buckets];
+}
+
+void FutexTable::wake_waiter(Waiter* waiter) {
+	TaskManager::ScopedCritical crit;
+	waiter->woken = true;
+	waiter->thread->unblock();
+}
+
+int FutexTable::wait(const Key& key, UserspacePointer<futex_t> futex, Condition condition, int value, const Time* timeout) {
+	Waiter waiter {key, timeout};
+	{
+		auto& bucket = bucket_for(key);
+		LOCK(bucket.lock);
+		auto cur_value = futex.get();
+		bool should_wait = condition == Condition::Equal ? cur_value == value : cur_value <= 0;
+		if(!should_wait)
+			return -EAGAIN;
+		bucket.append(&waiter);
+	}
+
+	auto* thread = TaskManager::current_thread().get();
+	thread->leave_syscall();
+	thread->block(waiter);
+	thread->enter_syscall();
+
+	if(waiter.woken)
+		return SUCCESS;
+
+	// We timed out or were interrupted, so take ourselves out of the queue unless we were woken in the meantime.
+	// We may have been moved to another futex by requeue(), so make sure we lock the right bucket.
+	while(true) {
+		auto& bucket = bucket_for(waiter.key);
+		LOCK(bucket.lock);
+		if(waiter.woken)
+			return SUCCESS;
+		if(&bucket_for(waiter.key) != &bucket)
+			continue;
+		bucket.remove(&waiter);
+		return waiter.was_interrupted() ? -EINTR : -ETIMEDOUT;
+	}
+}
+
+int FutexTable::wake(const Key& key, int count) {
+	auto& bucket = bucket_for(key);
+	LOCK(bucket.lock);
+	int num_woken = 0;
+	auto waiter = bucket.head;
+	while(waiter && num_woken < count) {
+		auto next = waiter->next;
+		if(waiter->key == key) {
+			bucket.remove(waiter);
+			wake_waiter(waiter);
+			num_woken++;
+		}
+		waiter = next;
+	}
+	return num_woken;
+}
+
+int FutexTable::requeue(const Key& key, UserspacePointer<futex_t> futex, int value, int wake_count, const Key& key2, int requeue_count) {
+	// Requeueing to the same futex would just be a wake
+	if(key == key2)
+		requeue_count = 0;
+
+	auto& bucket = bucket_for(key);
+	auto& bucket2 = bucket_for(key2);
+
+	// Always lock buckets in the same order so two requeues can't deadlock
+	auto& first_lock = &bucket < &bucket2 ? bucket.lock : bucket2.lock;
+	auto& second_lock = &bucket < &bucket2 ? bucket2.lock : bucket.lock;
+	LOCK_N(first_lock, first_locker);
+	LOCK_N(second_lock, second_locker);
+
+	if(futex.get() != value)
+		return -EAGAIN;
+
+	int num_woken = 0;
+	int num_requeued = 0;
+	auto waiter = bucket.head;
+	while(waiter && (num_woken < wake_count || num_requeued < requeue_count)) {
+		auto next = waiter->next;
+		if(waiter->key == key) {
+			bucket.remove(waiter);
+			if(num_woken < wake_count) {
+				wake_waiter(waiter);
+				num_woken++;
+			} else {
+				waiter->key = key2;
+				bucket2.append(waiter);
+				num_requeued++;
+			}
+		}
+		waiter = next;
+	}
+	return num_woken + num_requeued;
+}
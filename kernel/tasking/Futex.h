@@ -4,8 +4,12 @@
 #pragma once
 
 #include "Blocker.h"
+#include "Mutex.h"
 #include "../memory/VMRegion.h"
+#include "../memory/SafePointer.h"
 #include "../filesystem/File.h"
+#include "../time/Time.h"
+#include "../api/futex.h"
 
 class Futex: public Blocker, public File {
 public:
@@ -22,3 +26,88 @@ private:
 	kstd::Arc<VMRegion> m_k_region;
 	Atomic<int>* m_var;
 };
+
+/**
+ * Keeps track of the threads waiting on futexes, so they can be woken up as soon as the futex is changed.
+ *
+ * Futexes are identified by the VMObject and offset they're at rather than their address, so threads in processes
+ * that share the memory a futex is in can wait on and wake each other.
+ */
+class FutexTable {
+public:
+	struct Key {
+		kstd::Arc<VMObject> object;
+		size_t offset;
+
+		bool operator==(const Key& other) const { return object.get() == other.object.get() && offset == other.offset; }
+	};
+
+	enum class Condition {
+		Equal, ///< Wait while the futex is equal to the value.
+		NotPositive ///< Wait while the futex is less than or equal to zero.
+	};
+
+	/**
+	 * Blocks the current thread while the condition is true for the futex, until it is woken by wake() or requeue().
+	 * The futex is checked with the bucket locked, so a wake() after changing the futex can't be missed.
+	 * @param key The key of the futex.
+	 * @param futex A pointer to the futex.
+	 * @param condition The condition to wait for.
+	 * @param value The value for the condition.
+	 * @param timeout How long to wait for, or nullptr to wait forever.
+	 * @return SUCCESS, -EAGAIN if the condition was false, -ETIMEDOUT, or -EINTR.
+	 */
+	static int wait(const Key& key, UserspacePointer<futex_t> futex, Condition condition, int value, const Time* timeout);
+
+	/**
+	 * Wakes threads waiting on a futex.
+	 * @param key The key of the futex.
+	 * @param count The maximum number of threads to wake.
+	 * @return The number of threads woken.
+	 */
+	static int wake(const Key& key, int count);
+
+	/**
+	 * Wakes threads waiting on a futex and moves the rest to wait on another futex, if the first futex has a value.
+	 * @param key The key of the futex.
+	 * @param futex A pointer to the futex.
+	 * @param value The value the futex must have.
+	 * @param wake_count The maximum number of threads to wake.
+	 * @param key2 The key of the futex to move the other threads to.
+	 * @param requeue_count The maximum number of threads to move.
+	 * @return The number of threads woken and moved, or -EAGAIN if the futex's value was different.
+	 */
+	static int requeue(const Key& key, UserspacePointer<futex_t> futex, int value, int wake_count, const Key& key2, int requeue_count);
+
+private:
+	class Waiter: public Blocker {
+	public:
+		Waiter(const Key& key, const Time* timeout);
+
+		// Blocker
+		bool is_ready() override;
+
+		Key key;
+		Thread* thread;
+		bool woken = false;
+		bool has_timeout;
+		Time end_time;
+		Waiter* prev = nullptr;
+		Waiter* next = nullptr;
+	};
+
+	struct Bucket {
+		Mutex lock {"FutexBucket"};
+		Waiter* head = nullptr;
+		Waiter* tail = nullptr;
+
+		void append(Waiter* waiter);
+		void remove(Waiter* waiter);
+	};
+
+	static constexpr size_t num_buckets = 64;
+	static Bucket& bucket_for(const Key& key);
+	static void wake_waiter(Waiter* waiter);
+
+	static Bucket s_buckets[num_buckets];
+};
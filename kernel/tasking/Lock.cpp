@@ -20,35 +20,87 @@
 #include "Lock.h"
 #include "Mutex.h"
 #include "TaskManager.h"
-#include <kernel/kstd/map.hpp>
+#include <kernel/time/TimeManager.h>
 
-#ifdef DEBUG
-// Hmm, I need a simple set type, don't I.
 Mutex g_lock_registry_lock {"LockRegistry"};
-kstd::map<Lock*, int> g_lock_registry;
-#endif
+Lock* g_first_lock = nullptr;
 
 Lock::Lock(const kstd::string& name): m_name(name) {
-#ifdef DEBUG
-	if (__builtin_expect(this != &g_lock_registry_lock, true)) {
-		if (__builtin_expect(TaskManager::enabled(), true)) {
-			LOCK(g_lock_registry_lock);
-			g_lock_registry[this] = 1;
-		} else {
-			g_lock_registry[this] = 1;
-		}
+	if (__builtin_expect(this == &g_lock_registry_lock, false))
+		return;
+	auto link = [this] {
+		m_next_lock = g_first_lock;
+		if (g_first_lock)
+			g_first_lock->m_prev_lock = this;
+		g_first_lock = this;
+	};
+	if (__builtin_expect(TaskManager::enabled(), true)) {
+		LOCK(g_lock_registry_lock);
+		link();
+	} else {
+		link();
 	}
-#endif
 }
 
-#ifdef DEBUG
 Lock::~Lock() {
+	if (__builtin_expect(this == &g_lock_registry_lock, false))
+		return;
 	LOCK(g_lock_registry_lock);
-	g_lock_registry.erase(this);
+	if (m_prev_lock)
+		m_prev_lock->m_next_lock = m_next_lock;
+	else
+		g_first_lock = m_next_lock;
+	if (m_next_lock)
+		m_next_lock->m_prev_lock = m_prev_lock;
+}
+
+void Lock::iterate_locks(kstd::IterationFunc<Lock*> callback) {
+	LOCK(g_lock_registry_lock);
+	for (auto lock = g_first_lock; lock; lock = lock->m_next_lock)
+		ITER_BREAK(callback(lock));
+}
+
+void Lock::wait_for_handoff(Waiter& waiter) {
+	ASSERT(TaskManager::in_critical());
+	waiter.thread = TaskManager::current_thread().get();
+	if (m_waiters_tail)
+		m_waiters_tail->next = &waiter;
+	else
+		m_waiters_head = &waiter;
+	m_waiters_tail = &waiter;
+
+	// Leave the critical section to block. If we're handed the lock before we block, block() will return right away.
+	auto wait_start = TimeManager::uptime();
+	TaskManager::leave_critical();
+	ASSERT(!TaskManager::in_critical());
+	while (!waiter.blocker.is_ready()) {
+		TaskManager::current_thread()->block(waiter.blocker);
+		// block() returns without blocking if the thread is dying, so don't spin on it
+		if (!waiter.blocker.is_ready())
+			TaskManager::yield();
+	}
+	TaskManager::enter_critical();
+
+	auto wait_end = TimeManager::uptime();
+	m_wait_time += (wait_end.tv_sec - wait_start.tv_sec) * 1000000 + (wait_end.tv_usec - wait_start.tv_usec);
+}
+
+Lock::Waiter* Lock::dequeue_waiter() {
+	ASSERT(TaskManager::in_critical());
+	auto waiter = m_waiters_head;
+	if (waiter) {
+		m_waiters_head = waiter->next;
+		if (!m_waiters_head)
+			m_waiters_tail = nullptr;
+	}
+	return waiter;
+}
+
+void Lock::hand_off(Waiter* waiter) {
+	ASSERT(TaskManager::in_critical());
+	waiter->blocker.set_ready(true);
+	waiter->thread->unblock();
 }
-#else
-Lock::~Lock() = default;
-#endif
 
 ScopedLocker::ScopedLocker(Lock& lock): _lock(lock) {
 	_lock.acquire();
@@ -19,12 +19,17 @@
 
 #pragma once
 #include <kernel/kstd/string.h>
+#include <kernel/kstd/types.h>
+#include <kernel/kstd/Arc.h>
+#include <kernel/kstd/Iteration.h>
 #include <kernel/Atomic.h>
+#include "BooleanBlocker.h"
 
 #define LOCK(lock) const ScopedLocker __locker((lock))
 #define LOCK_N(lock, name) const ScopedLocker name((lock))
 
 class Lock;
+class Thread;
 
 class ScopedLocker {
 public:
@@ -44,9 +49,15 @@ public:
 	virtual void release() = 0;
 	virtual const kstd::string& name() { return m_name; }
 
-#ifdef DEBUG
-	virtual unsigned long contest_count() { return m_contest_count.load(MemoryOrder::Relaxed); }
-#endif
+	/** The number of times the lock was acquired. **/
+	unsigned long acquire_count() { return m_acquire_count.load(MemoryOrder::Relaxed); }
+	/** The number of times a thread found the lock held by another thread. **/
+	unsigned long contest_count() { return m_contest_count.load(MemoryOrder::Relaxed); }
+	/** The total amount of time threads have spent waiting for the lock, in microseconds. **/
+	uint64_t wait_time() { return m_wait_time; }
+
+	/** Calls the callback for every lock that exists. **/
+	static void iterate_locks(kstd::IterationFunc<Lock*> callback);
 
 	template<typename R, typename F>
 	R synced(F&& lambda) {
@@ -55,7 +66,37 @@ public:
 	}
 
 protected:
+	/**
+	 * A thread waiting for a lock. Waiters live on the waiting thread's stack and are queued in the order they arrived,
+	 * and the lock is handed directly to them on release instead of letting every waiter race for it.
+	 */
+	struct Waiter {
+		Thread* thread;
+		bool reader = false;
+		UninterruptibleBooleanBlocker blocker;
+		Waiter* next = nullptr;
+	};
+
+	/**
+	 * Queues the current thread and blocks it until the lock is handed to it with hand_off().
+	 * Must be called in a critical section, which is left while blocked and re-entered before returning.
+	 */
+	void wait_for_handoff(Waiter& waiter);
+	/** Removes the first waiter from the queue. Must be called in a critical section. **/
+	Waiter* dequeue_waiter();
+	/** Wakes up a waiter that has been given the lock. Must be called in a critical section. **/
+	void hand_off(Waiter* waiter);
+	bool has_waiters() const { return m_waiters_head; }
+	Waiter* first_waiter() const { return m_waiters_head; }
+
 	kstd::string m_name;
+	Atomic<unsigned long> m_acquire_count = 0;
 	Atomic<unsigned long> m_contest_count = 0;
-};
+	uint64_t m_wait_time = 0;
 
+private:
+	Waiter* m_waiters_head = nullptr;
+	Waiter* m_waiters_tail = nullptr;
+	Lock* m_prev_lock = nullptr;
+	Lock* m_next_lock = nullptr;
+};
@@ -19,6 +19,7 @@
 
 #include "Mutex.h"
 #include "TaskManager.h"
+#include <kernel/arch/Processor.h>
 
 extern bool g_panicking;
 
@@ -39,7 +40,15 @@ void Mutex::release() {
 	// Decrease counter. If the counter is zero, release the lock
 	if(m_times_locked.sub(1, MemoryOrder::Release) == 1) {
 		TaskManager::current_thread()->released_lock(this);
-		m_holding_thread.store(-1, MemoryOrder::SeqCst);
+
+		// If a thread is waiting, hand the lock straight to it so another thread can't take it first
+		auto waiter = dequeue_waiter();
+		if(waiter) {
+			m_holding_thread.store(waiter->thread->tid(), MemoryOrder::SeqCst);
+			hand_off(waiter);
+		} else {
+			m_holding_thread.store(-1, MemoryOrder::SeqCst);
+		}
 	}
 }
 
@@ -63,40 +72,45 @@ inline bool Mutex::acquire_with_mode() {
 		return true; //Tasking isn't initialized yet
 	auto cur_tid = cur_thread->tid();
 
-	//Loop while the lock is held
-	while(true) {
-		if constexpr(mode == AcquireMode::EnterCritical)
-			TaskManager::enter_critical();
-
-		// Try locking if no thread is holding
-		tid_t expected = -1;
-		if(m_holding_thread.compare_exchange_strong(expected, cur_tid, MemoryOrder::Acquire)) {
-			TaskManager::current_thread()->acquired_lock(this);
-			break;
-		}
-
-		// Current thread is already holding
-		if(expected == cur_tid)
-			break;
+	// Stay in a critical section until we're queued, so the holder can't release the lock in between
+	TaskManager::enter_critical();
 
-#ifdef DEBUG
+	// Try locking if no thread is holding
+	tid_t expected = -1;
+	bool newly_acquired = m_holding_thread.compare_exchange_strong(expected, cur_tid, MemoryOrder::Acquire);
+	if(!newly_acquired && expected != cur_tid) {
 		m_contest_count.add(1, MemoryOrder::Relaxed);
-#endif
 
 		if constexpr(mode == AcquireMode::Try) {
+			TaskManager::leave_critical();
 			return false;
 		}
 
-		if constexpr(mode == AcquireMode::EnterCritical) {
-			TaskManager::leave_critical();
-			ASSERT(!TaskManager::in_critical());
+		if(Processor::in_interrupt()) {
+			// We can't block in an interrupt, so all we can do is wait for the lock to be free
+			do {
+				TaskManager::leave_critical();
+				TaskManager::yield();
+				TaskManager::enter_critical();
+				expected = -1;
+			} while(!m_holding_thread.compare_exchange_strong(expected, cur_tid, MemoryOrder::Acquire));
+		} else {
+			// Wait in line until the holder hands the lock to us
+			Waiter waiter;
+			wait_for_handoff(waiter);
+			ASSERT(m_holding_thread.load(MemoryOrder::SeqCst) == cur_tid);
 		}
-
-		TaskManager::yield();
+		newly_acquired = true;
 	}
 
 	// We've got the lock!
+	if(newly_acquired)
+		cur_thread->acquired_lock(this);
 	m_times_locked.add(1, MemoryOrder::Acquire);
+	m_acquire_count.add(1, MemoryOrder::Relaxed);
+
+	if constexpr(mode != AcquireMode::EnterCritical)
+		TaskManager::leave_critical();
 	return true;
 }
 
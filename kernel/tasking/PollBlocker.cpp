@@ -28,23 +28,21 @@ PollBlocker::PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout):
 
 bool PollBlocker::is_ready() {
 	for(size_t i = 0; i < polls.size(); i++) {
-		auto& poll = polls[i];
-
-		if((poll.events & POLLIN) && poll.fd->file()->can_read(*poll.fd)) {
-			polled = poll.fd_num;
-			polled_revent = POLLIN;
-			return true;
-		}
-
-		if((poll.events & POLLOUT) && poll.fd->file()->can_write(*poll.fd)) {
-			polled = poll.fd_num;
-			polled_revent = POLLOUT;
+		if(ready_events(polls[i]))
 			return true;
-		}
 	}
 
 	if(has_timeout && Time::now() >= end_time)
 		return true;
 
 	return false;
-}
\ No newline at end of file
+}
+
+short PollBlocker::ready_events(const PollFD& poll) {
+	short revents = 0;
+	if((poll.events & POLLIN) && poll.fd->file()->can_read(*poll.fd))
+		revents |= POLLIN;
+	if((poll.events & POLLOUT) && poll.fd->file()->can_write(*poll.fd))
+		revents |= POLLOUT;
+	return revents;
+}
@@ -37,8 +37,9 @@ public:
 	PollBlocker(kstd::vector<PollFD>& pollfd, Time timeout);
 	bool is_ready() override;
 
-	int polled;
-	short polled_revent;
+	/** Gets the events a file descriptor is ready for out of the ones asked for. **/
+	static short ready_events(const PollFD& poll);
+
 private:
 	kstd::vector<PollFD> polls;
 	Time end_time;
@@ -30,6 +30,7 @@
 #include "../filesystem/procfs/ProcFS.h"
 #include "WaitBlocker.h"
 #include "kernel/KernelMapper.h"
+#include "../time/TimeManager.h"
 
 Process* Process::create_kernel(const kstd::string& name, void (*func)()){
 	ProcessArgs args = ProcessArgs(kstd::Arc<LinkedInode>(nullptr));
@@ -143,6 +144,18 @@ bool Process::is_kernel_mode() {
 	return _kernel_mode;
 }
 
+ThreadStats Process::stats() {
+	LOCK(_thread_lock);
+	ThreadStats ret = _dead_thread_stats;
+	for(auto& tid : _tids)
+		ret += _threads[tid]->stats();
+	return ret;
+}
+
+uint64_t Process::cpu_time() {
+	return TimeManager::cycles_to_us(stats().cpu_cycles()) / 1000;
+}
+
 tid_t Process::last_active_thread() {
 	return _last_active_thread;
 }
@@ -394,6 +407,7 @@ void Process::insert_thread(const kstd::Arc<Thread>& thread) {
 
 void Process::remove_thread(const kstd::Arc<Thread>& thread) {
 	LOCK(_thread_lock);
+	_dead_thread_stats += thread->stats();
 	_thread_return_values[thread->_tid] = thread->_return_value;
 	_threads.erase(thread->_tid);
 	for(size_t i = 0; i < _tids.size(); i++) {
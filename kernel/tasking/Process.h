@@ -29,6 +29,7 @@
 #include "../api/poll.h"
 #include "../api/mmap.h"
 #include "Tracer.h"
+#include "ThreadStats.h"
 #include "../kstd/KLog.h"
 
 class FileDescriptor;
@@ -75,6 +76,10 @@ public:
 	int exit_status();
 	bool is_kernel_mode();
 
+	//Accounting
+	ThreadStats stats();
+	uint64_t cpu_time();
+
 	//Threads
 	tid_t last_active_thread();
 	void set_last_active_thread(tid_t tid);
@@ -181,11 +186,19 @@ public:
 	int sys_getsockopt(UserspacePointer<struct getsockopt_args> ptr);
 	int sys_recvmsg(int sockfd, UserspacePointer<struct msghdr> msg, int flags);
 	int sys_sendmsg(int sockfd, UserspacePointer<struct msghdr> msg, int flags);
+	int sys_recvmmsg(UserspacePointer<struct mmsg_args> args);
+	int sys_sendmmsg(UserspacePointer<struct mmsg_args> args);
 	int sys_getifaddrs(UserspacePointer<struct ifaddrs> buf, size_t memsz);
 	int sys_listen(int sockfd, int backlog);
 	int sys_shutdown(int sockfd, int how);
 	int sys_accept(int sockfd, UserspacePointer<struct sockaddr> addr, UserspacePointer<uint32_t> addrlen);
-	int sys_futex(UserspacePointer<int> futex, int operation);
+	int sys_futex(UserspacePointer<int> futex, int operation, size_t arg);
+	int sys_profile(UserspacePointer<struct profile_args> args);
+	int sys_epoll_create(int flags);
+	int sys_epoll_ctl(UserspacePointer<struct epoll_ctl_args> args);
+	int sys_epoll_wait(UserspacePointer<struct epoll_wait_args> args);
+	ssize_t sys_sendfile(UserspacePointer<struct sendfile_args> args);
+	ssize_t sys_splice(UserspacePointer<struct splice_args> args);
 
 private:
 	friend class Thread;
@@ -254,6 +267,7 @@ private:
 	kstd::vector<tid_t> _tids;
 	tid_t _last_active_thread = 1;
 	Mutex _thread_lock {"Process::Thread"};
+	ThreadStats _dead_thread_stats; // The stats of threads that have exited, which are still counted in stats().
 
 	//Tracing
 	Mutex _tracing_lock {"Process::Tracing"};
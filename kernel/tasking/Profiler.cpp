@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "Profiler.h"
+#include "TaskManager.h"
+#include "Thread.h"
+#include "Process.h"
+#include "../StackWalker.h"
+#include "../memory/AnonymousVMObject.h"
+#include "../memory/MemoryManager.h"
+#include "../time/TimeManager.h"
+#include "../kstd/cstring.h"
+
+#define PROFILER_MAX_BUFFER_SIZE (16 * 1024 * 1024)
+
+Profiler* Profiler::s_first_profiler = nullptr;
+
+ResultRet<kstd::Arc<Profiler>> Profiler::make(pid_t pid, unsigned int frequency, size_t buffer_size) {
+	if(!frequency || buffer_size > PROFILER_MAX_BUFFER_SIZE)
+		return Result(EINVAL);
+
+	// The ring buffer is a power of two in size, so positions in it can be found with a mask
+	size_t data_size = PAGE_SIZE;
+	while(data_size < buffer_size)
+		data_size <<= 1;
+
+	unsigned int timer_frequency = TimeManager::tick_frequency();
+	unsigned int period = frequency >= timer_frequency ? 1 : (timer_frequency + frequency / 2) / frequency;
+
+	// The buffer is written to from an interrupt, so it's committed up front to make sure it never faults
+	auto object = TRY(AnonymousVMObject::alloc(PAGE_SIZE + data_size, "profiler", true));
+	auto profiler = kstd::Arc<Profiler>(new Profiler(pid, period, object));
+	profiler->m_header->data_offset = PAGE_SIZE;
+	profiler->m_header->data_size = data_size;
+	profiler->m_header->frequency = timer_frequency / period;
+
+	TaskManager::ScopedCritical critical;
+	profiler->m_next = s_first_profiler;
+	if(s_first_profiler)
+		s_first_profiler->m_prev = profiler.get();
+	s_first_profiler = profiler.get();
+
+	return profiler;
+}
+
+Profiler::Profiler(pid_t pid, unsigned int period, kstd::Arc<AnonymousVMObject> object):
+	m_pid(pid),
+	m_period(period),
+	m_data_size(object->size() - PAGE_SIZE),
+	m_object(kstd::move(object)),
+	m_k_region(MM.map_object(m_object)),
+	m_header((profile_buffer*) m_k_region->start()),
+	m_data((uint8_t*) m_k_region->start() + PAGE_SIZE)
+{
+	memset(m_header, 0, sizeof(profile_buffer));
+}
+
+Profiler::~Profiler() {
+	TaskManager::ScopedCritical critical;
+	if(m_prev)
+		m_prev->m_next = m_next;
+	else
+		s_first_profiler = m_next;
+	if(m_next)
+		m_next->m_prev = m_prev;
+}
+
+void Profiler::tick() {
+	if(!s_first_profiler || TaskManager::is_idle())
+		return;
+	auto& thread = TaskManager::current_thread();
+	if(!thread)
+		return;
+	for(auto profiler = s_first_profiler; profiler; profiler = profiler->m_next) {
+		if(++profiler->m_ticks < profiler->m_period)
+			continue;
+		profiler->m_ticks = 0;
+		if(profiler->m_pid == PROFILE_ALL_PROCESSES || profiler->m_pid == thread->process()->pid())
+			profiler->sample(*thread);
+	}
+}
+
+bool Profiler::can_read(const FileDescriptor& fd) {
+	return m_header->tail != m_header->head;
+}
+
+kstd::Arc<VMObject> Profiler::vm_object() {
+	return m_object;
+}
+
+void Profiler::sample(Thread& thread) {
+#if defined(__i386__)
+	uintptr_t frames[PROFILE_MAX_KERNEL_FRAMES + PROFILE_MAX_USER_FRAMES];
+	profile_record record = {
+		.size = 0,
+		.type = PROFILE_RECORD_SAMPLE,
+		.pid = thread.process()->pid(),
+		.tid = thread.tid(),
+		.num_kernel_frames = 0,
+		.num_user_frames = 0
+	};
+
+	// Walk the trap frames outwards. The innermost one is the timer interrupt. If it interrupted the kernel, the
+	// kernel stack is walked from there until it reaches the trap frame where the thread left userspace.
+	auto& page_directory = *thread.page_directory();
+	for(auto trap = thread.cur_trap_frame(); trap; trap = trap->prev) {
+		uintptr_t ip, bp, cs;
+		switch(trap->type) {
+		case TrapFrame::IRQ:
+			ip = trap->irq_regs->interrupt_frame.eip;
+			cs = trap->irq_regs->interrupt_frame.cs;
+			bp = trap->irq_regs->registers.ebp;
+			break;
+		case TrapFrame::Syscall:
+			ip = trap->syscall_regs->iret.eip;
+			cs = trap->syscall_regs->iret.cs;
+			bp = trap->syscall_regs->gp.ebp;
+			break;
+		case TrapFrame::Fault:
+			ip = trap->fault_regs->interrupt_frame.eip;
+			cs = trap->fault_regs->interrupt_frame.cs;
+			bp = trap->fault_regs->registers.ebp;
+			break;
+		}
+
+		if((cs & 3) == 0) {
+			// Any outer kernel trap frames are already part of the kernel stack we walked
+			if(record.num_kernel_frames)
+				continue;
+			frames[0] = ip;
+			record.num_kernel_frames = 1 + StackWalker::walk_stack_safe(page_directory, (StackWalker::Frame*) bp, &frames[1], PROFILE_MAX_KERNEL_FRAMES - 1);
+		} else {
+			auto user_frames = &frames[record.num_kernel_frames];
+			user_frames[0] = ip;
+			record.num_user_frames = 1 + StackWalker::walk_stack_safe(page_directory, (StackWalker::Frame*) bp, &user_frames[1], PROFILE_MAX_USER_FRAMES - 1);
+			break;
+		}
+	}
+
+	if(record.num_kernel_frames || record.num_user_frames)
+		write_record(record, frames);
+#endif
+}
+
+void Profiler::write_record(profile_record& record, const uintptr_t* frames) {
+	size_t frames_size = (record.num_kernel_frames + record.num_user_frames) * sizeof(uintptr_t);
+	record.size = sizeof(profile_record) + frames_size;
+
+	// Userspace can write to the header, so only tail is read back from it and everything else is kept here
+	uint32_t tail = __atomic_load_n(&m_header->tail, __ATOMIC_ACQUIRE);
+	size_t offset = m_head & (m_data_size - 1);
+	size_t padding = offset + record.size > m_data_size ? m_data_size - offset : 0;
+	if((uint32_t) (m_head - tail) > m_data_size || m_data_size - (m_head - tail) < padding + record.size) {
+		m_header->lost = ++m_lost;
+		return;
+	}
+
+	if(padding) {
+		auto pad = (profile_record*) (m_data + offset);
+		pad->size = padding;
+		pad->type = PROFILE_RECORD_PADDING;
+		m_head += padding;
+		offset = 0;
+	}
+
+	memcpy(m_data + offset, &record, sizeof(profile_record));
+	memcpy(m_data + offset + sizeof(profile_record), frames, frames_size);
+	m_head += record.size;
+	__atomic_store_n(&m_header->head, m_head, __ATOMIC_RELEASE);
+}
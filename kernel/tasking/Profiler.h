@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "../filesystem/File.h"
+#include "../memory/VMRegion.h"
+#include "../api/profile.h"
+
+class AnonymousVMObject;
+class Thread;
+
+/**
+ * Samples the stacks of running threads from the timer interrupt, and writes them to a ring buffer that userspace
+ * maps by calling mmap() on the profiler's file descriptor. See profile_buffer in api/profile.h for its layout.
+ *
+ * Samples are taken of whatever thread was interrupted by the timer, so a profiler for a single process only records
+ * a sample when that process happens to be running. The idle thread is never sampled.
+ */
+class Profiler: public File {
+public:
+	/**
+	 * Creates a profiler and starts sampling.
+	 * @param pid The process to profile, or PROFILE_ALL_PROCESSES.
+	 * @param frequency The number of samples to take per second.
+	 * @param buffer_size The size of the ring buffer.
+	 * @return The profiler.
+	 */
+	static ResultRet<kstd::Arc<Profiler>> make(pid_t pid, unsigned int frequency, size_t buffer_size);
+	~Profiler() override;
+
+	/** Takes a sample of the current thread for every profiler that's due. Called from the timer interrupt. **/
+	static void tick();
+
+	// File
+	bool can_read(const FileDescriptor& fd) override;
+	kstd::Arc<VMObject> vm_object() override;
+
+private:
+	Profiler(pid_t pid, unsigned int period, kstd::Arc<AnonymousVMObject> object);
+
+	void sample(Thread& thread);
+	void write_record(profile_record& record, const uintptr_t* frames);
+
+	static Profiler* s_first_profiler;
+
+	pid_t m_pid;
+	unsigned int m_period; ///< The number of timer ticks between samples.
+	unsigned int m_ticks = 0;
+	size_t m_data_size;
+	uint32_t m_head = 0;
+	uint32_t m_lost = 0;
+	kstd::Arc<AnonymousVMObject> m_object;
+	kstd::Arc<VMRegion> m_k_region;
+	profile_buffer* m_header;
+	uint8_t* m_data;
+	// The list of active profilers, which is only touched with interrupts disabled
+	Profiler* m_prev = nullptr;
+	Profiler* m_next = nullptr;
+};
@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "RWLock.h"
+#include "TaskManager.h"
+
+extern bool g_panicking;
+
+RWLock::RWLock(const kstd::string& name): Lock(name) {}
+
+RWLock::~RWLock() = default;
+
+bool RWLock::locked() {
+	return m_writer != -1 || m_readers;
+}
+
+void RWLock::acquire() {
+	auto cur_thread = TaskManager::current_thread();
+	if(!TaskManager::enabled() || !cur_thread || g_panicking)
+		return;
+	auto cur_tid = cur_thread->tid();
+
+	TaskManager::ScopedCritical crit;
+	m_acquire_count.add(1, MemoryOrder::Relaxed);
+
+	if(m_writer == cur_tid) {
+		m_write_depth++;
+		return;
+	}
+
+	if(m_writer == -1 && !m_readers) {
+		m_writer = cur_tid;
+		m_write_depth = 1;
+		cur_thread->acquired_lock(this);
+		return;
+	}
+
+	if(m_readers && cur_thread->holding_lock(this))
+		PANIC("RWLOCK_UPGRADE", "Tried to lock %s for writing while holding it for reading.", m_name.c_str());
+
+	// Wait in line for the lock. The thread releasing it will make us the writer.
+	m_contest_count.add(1, MemoryOrder::Relaxed);
+	Waiter waiter;
+	wait_for_handoff(waiter);
+	ASSERT(m_writer == cur_tid);
+	cur_thread->acquired_lock(this);
+}
+
+void RWLock::release() {
+	if(!TaskManager::enabled() || g_panicking)
+		return;
+
+	TaskManager::ScopedCritical crit;
+	ASSERT(m_write_depth > 0);
+	if(--m_write_depth)
+		return;
+	TaskManager::current_thread()->released_lock(this);
+	m_writer = -1;
+	wake_waiters();
+}
+
+void RWLock::acquire_read() {
+	auto cur_thread = TaskManager::current_thread();
+	if(!TaskManager::enabled() || !cur_thread || g_panicking)
+		return;
+	auto cur_tid = cur_thread->tid();
+
+	TaskManager::ScopedCritical crit;
+	m_acquire_count.add(1, MemoryOrder::Relaxed);
+
+	// Reading while we're the writer is just another level of writing
+	if(m_writer == cur_tid) {
+		m_write_depth++;
+		return;
+	}
+
+	// Only skip past waiting writers if we're already reading, since we'd deadlock otherwise
+	if(m_writer == -1 && (!has_waiters() || cur_thread->holding_lock(this))) {
+		m_readers++;
+		cur_thread->acquired_lock(this);
+		return;
+	}
+
+	// Wait in line for the lock. The thread releasing it will count us as a reader.
+	m_contest_count.add(1, MemoryOrder::Relaxed);
+	Waiter waiter;
+	waiter.reader = true;
+	wait_for_handoff(waiter);
+	cur_thread->acquired_lock(this);
+}
+
+void RWLock::release_read() {
+	if(!TaskManager::enabled() || g_panicking)
+		return;
+
+	TaskManager::ScopedCritical crit;
+	if(m_writer == TaskManager::current_thread()->tid()) {
+		release();
+		return;
+	}
+
+	ASSERT(m_readers > 0);
+	TaskManager::current_thread()->released_lock(this);
+	if(!--m_readers)
+		wake_waiters();
+}
+
+void RWLock::wake_waiters() {
+	auto first = first_waiter();
+	if(!first)
+		return;
+
+	if(!first->reader) {
+		dequeue_waiter();
+		m_writer = first->thread->tid();
+		m_write_depth = 1;
+		hand_off(first);
+		return;
+	}
+
+	// Let in all of the readers at the front of the line
+	while(first_waiter() && first_waiter()->reader) {
+		m_readers++;
+		hand_off(dequeue_waiter());
+	}
+}
+
+ScopedReadLocker::ScopedReadLocker(RWLock& lock): m_lock(lock) {
+	m_lock.acquire_read();
+}
+
+ScopedReadLocker::~ScopedReadLocker() {
+	m_lock.release_read();
+}
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "Lock.h"
+#include "../kstd/unix_types.h"
+
+#define LOCK_READ(lock) const ScopedReadLocker __read_locker((lock))
+#define LOCK_READ_N(lock, name) const ScopedReadLocker name((lock))
+
+class RWLock;
+
+class ScopedReadLocker {
+public:
+	explicit ScopedReadLocker(RWLock& lock);
+	~ScopedReadLocker();
+private:
+	RWLock& m_lock;
+};
+
+/**
+ * A lock that can be held by any number of readers at once, or by a single writer.
+ *
+ * acquire() and release() (and so LOCK) take the lock for writing, and acquire_read() and release_read() (LOCK_READ)
+ * take it for reading. Both are recursive, and a thread holding the lock for writing may also take it for reading.
+ * Taking the lock for writing while holding it for reading is not allowed, since that could deadlock.
+ *
+ * Once a writer is waiting, new readers wait behind it so writers can't be starved. Waiters are woken in order, with
+ * the lock handed directly to them.
+ */
+class RWLock: public Lock {
+public:
+	explicit RWLock(const kstd::string& name);
+	~RWLock();
+
+	bool locked() override;
+	void acquire() override;
+	void release() override;
+	void acquire_read();
+	void release_read();
+
+	template<typename R, typename F>
+	R synced_read(F&& lambda) {
+		LOCK_READ(*this);
+		return lambda();
+	}
+
+private:
+	/** Hands the lock to the next waiter(s) once it's free. Must be called in a critical section. **/
+	void wake_waiters();
+
+	tid_t m_writer = -1;
+	int m_write_depth = 0;
+	int m_readers = 0;
+};
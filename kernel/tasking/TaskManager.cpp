@@ -29,6 +29,7 @@
 #include <kernel/kstd/KLog.h>
 #include <kernel/net/NetworkManager.h>
 #include "../device/DiskDevice.h"
+#include "../time/TimeManager.h"
 
 TSS TaskManager::tss;
 Mutex TaskManager::g_tasking_lock {"Tasking"};
@@ -44,6 +45,14 @@ bool tasking_enabled = false;
 bool yield_async = false;
 bool preempting = false;
 
+// The load averages decay exponentially every LOAD_INTERVAL seconds. load_exps holds e^(-LOAD_INTERVAL / period) in
+// fixed point for periods of 1, 5 and 15 minutes.
+#define LOAD_INTERVAL 5
+const uint32_t load_exps[3] = {1884, 2014, 2037};
+uint32_t load_avgs[3] = {0, 0, 0};
+int load_ticks = 0;
+uint64_t num_context_switches = 0;
+
 void kidle(){
         tasking_enabled = true;
         TaskManager::yield();
@@ -178,8 +187,9 @@ void TaskManager::init(){
         kernel_process->spawn_kernel_thread(NetworkManager::task_entry);
         kernel_process->spawn_kernel_thread(DiskDevice::cache_writeback_task_entry);
 
-        //Preempt
+        //Preempt. The first thread doesn't go through a context switch, so start accounting its time here.
         cur_thread = kernel_process->get_thread(kernel_process->pid());
+        cur_thread->account_switch_in(TimeManager::cycles());
         // TODO: AARCH64
 #if defined (__i686__)
         preempt_init_asm(cur_thread->registers.gp.esp);
@@ -238,6 +248,7 @@ void TaskManager::queue_thread(const kstd::Arc<Thread>& thread) {
         }
 
         ScopedCritical crit;
+        thread->account_queued();
         if(g_next_thread)
                 g_next_thread->enqueue_thread(thread.get());
         else
@@ -296,9 +307,37 @@ void TaskManager::do_yield_async() {
 
 void TaskManager::tick() {
         ASSERT(Processor::in_interrupt());
+        if(++load_ticks >= LOAD_INTERVAL * TimeManager::tick_frequency()) {
+                load_ticks = 0;
+                update_load_averages();
+        }
         yield();
 }
 
+void TaskManager::update_load_averages() {
+        // Count the running thread and everything runnable waiting in the queue
+        uint32_t runnable = cur_thread && !is_idle() && cur_thread->can_be_run() ? 1 : 0;
+        for(auto thread = g_next_thread; thread; thread = thread->peek_next_thread()) {
+                if(thread != cur_thread.get() && thread->can_be_run())
+                        runnable++;
+        }
+
+        uint32_t active = runnable << LOAD_FIXED_SHIFT;
+        for(int i = 0; i < 3; i++)
+                load_avgs[i] = (load_avgs[i] * load_exps[i] + active * (LOAD_FIXED_1 - load_exps[i])) >> LOAD_FIXED_SHIFT;
+}
+
+uint64_t TaskManager::context_switches() {
+        ScopedCritical critical;
+        return num_context_switches;
+}
+
+void TaskManager::load_averages(uint32_t (&loads)[3]) {
+        ScopedCritical critical;
+        for(int i = 0; i < 3; i++)
+                loads[i] = load_avgs[i];
+}
+
 Atomic<int, MemoryOrder::SeqCst> g_critical_count = 0;
 
 void TaskManager::enter_critical() {
@@ -316,6 +355,16 @@ bool TaskManager::in_critical() {
         return g_critical_count.load();
 }
 
+TaskManager::IRQSafeCritical::IRQSafeCritical(): m_critical(!Processor::in_interrupt()) {
+        if(m_critical)
+                enter_critical();
+}
+
+TaskManager::IRQSafeCritical::~IRQSafeCritical() {
+        if(m_critical)
+                leave_critical();
+}
+
 void TaskManager::preempt(){
         if(!tasking_enabled)
                 return;
@@ -428,6 +477,11 @@ void TaskManager::preempt(){
                 cur_thread = next_thread;
                 next_thread.reset();
 
+                auto now = TimeManager::cycles();
+                old_thread->account_switch_out(now);
+                cur_thread->account_switch_in(now);
+                num_context_switches++;
+
                 Processor::save_fpu_state((void*&) old_thread->fpu_state);
 
                 // FIX: Jangan reset old_thread sebelum preempt_asm selesai.
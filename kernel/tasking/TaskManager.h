@@ -32,6 +32,10 @@ class Thread;
 class Mutex;
 struct TSS;
 
+// Load averages are fixed point numbers with this many fractional bits.
+#define LOAD_FIXED_SHIFT 11
+#define LOAD_FIXED_1 (1 << LOAD_FIXED_SHIFT)
+
 namespace TaskManager {
 	extern TSS tss;
 
@@ -76,6 +80,11 @@ namespace TaskManager {
 	void do_yield_async();
 	void tick();
 
+	/** The number of times the CPU has switched from one thread to another. **/
+	uint64_t context_switches();
+	/** Gets the average number of runnable threads over the last 1, 5, and 15 minutes. See LOAD_FIXED_SHIFT. **/
+	void load_averages(uint32_t (&loads)[3]);
+
 	void enter_critical();
 	extern "C" void leave_critical();
 	bool in_critical();
@@ -100,8 +109,20 @@ namespace TaskManager {
 		bool m_done = false;
 	};
 
+	/** Like ScopedCritical, but does nothing when used in an IRQ handler, where interrupts are already off and leaving
+	 *  a critical section would turn them back on. Used for state that's shared with IRQ handlers. **/
+	class IRQSafeCritical {
+	public:
+		IRQSafeCritical();
+		~IRQSafeCritical();
+
+	private:
+		bool m_critical;
+	};
+
 	pid_t get_new_pid();
 	kstd::Arc<Thread> pick_next_thread();
+	void update_load_averages();
 
 
 	extern "C" void preempt();
@@ -12,6 +12,7 @@
 #include "WaitBlocker.h"
 #include <kernel/arch/Processor.h>
 #include <kernel/kstd/kstdio.h>
+#include <kernel/time/TimeManager.h>
 
 extern "C" void panic(const char* message, ...);
 
@@ -188,14 +189,38 @@ bool Thread::can_be_run() {
         return state() == ALIVE;
 }
 
+// Syscalls enter and leave their trap frames with interrupts enabled, so they're disabled while switching frames to
+// make sure an IRQ doesn't charge the same time as we do.
+#if defined(__i386__)
+static inline uint32_t save_and_disable_interrupts() {
+        uint32_t flags;
+        asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+        return flags;
+}
+
+static inline void restore_interrupts(uint32_t flags) {
+        asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+#else
+// TODO: aarch64
+static inline uint32_t save_and_disable_interrupts() { return 0; }
+static inline void restore_interrupts(uint32_t flags) {}
+#endif
+
 void Thread::enter_trap_frame(TrapFrame* frame) {
+        auto flags = save_and_disable_interrupts();
+        account_time(TimeManager::cycles());
         frame->prev = _cur_trap_frame;
         _cur_trap_frame = frame;
+        restore_interrupts(flags);
 }
 
 void Thread::exit_trap_frame() {
         ASSERT(_cur_trap_frame);
+        auto flags = save_and_disable_interrupts();
+        account_time(TimeManager::cycles());
         _cur_trap_frame = _cur_trap_frame->prev;
+        restore_interrupts(flags);
 }
 
 PageDirectory* Thread::page_directory() const {
@@ -294,6 +319,10 @@ void Thread::block(Blocker& blocker) {
         }
 
         {
+                // The blocker may become ready and unblock() us right after we check it, so check and block atomically
+                TaskManager::ScopedCritical crit;
+                if(blocker.is_ready())
+                        return;
                 _blocker = &blocker;
                 _state = BLOCKED;
         }
@@ -307,6 +336,7 @@ void Thread::unblock() {
         _blocker = nullptr;
         if(_state == BLOCKED)
                 _state = ALIVE;
+        m_woken = true;
         TaskManager::queue_thread(self());
 }
 
@@ -366,7 +396,7 @@ Result Thread::join(const kstd::Arc<Thread>& self_ptr, const kstd::Arc<Thread>&
         return Result(SUCCESS);
 }
 
-void Thread::acquired_lock(Mutex* lock) {
+void Thread::acquired_lock(Lock* lock) {
         TaskManager::ScopedCritical crit;
         if(_held_locks.size() == _held_locks.capacity())
                 PANIC("MAX_LOCKS", "A thread is holding way too many locks.");
@@ -374,7 +404,7 @@ void Thread::acquired_lock(Mutex* lock) {
                 _held_locks.push_back(lock);
 }
 
-void Thread::released_lock(Mutex* lock) {
+void Thread::released_lock(Lock* lock) {
         TaskManager::ScopedCritical crit;
         if(lock != &MM.s_liballoc_lock && lock != &TaskManager::g_tasking_lock) {
                 ASSERT(_held_locks.size());
@@ -385,6 +415,15 @@ void Thread::released_lock(Mutex* lock) {
         }
 }
 
+bool Thread::holding_lock(Lock* lock) {
+        TaskManager::ScopedCritical crit;
+        for(size_t i = 0; i < _held_locks.size(); i++) {
+                if(_held_locks[i] == lock)
+                        return true;
+        }
+        return false;
+}
+
 bool Thread::call_signal_handler(int signal) {
         ASSERT(!_in_critical);
 
@@ -731,4 +770,59 @@ void Thread::die_from_signal(int signal) {
 }
 void print_arg(Thread* thread, KLog::FormatRules rules) {
         printf("%s(%d.%d)", thread->process()->name().c_str(), thread->process()->pid(), thread->tid());
-}
\ No newline at end of file
+}
+
+ThreadStats Thread::stats() {
+        // The stats are updated from interrupts, so copy them atomically
+        TaskManager::ScopedCritical critical;
+        return m_stats;
+}
+
+void Thread::account_queued() {
+        ASSERT(TaskManager::in_critical());
+        if(!m_queued_at)
+                m_queued_at = TimeManager::cycles();
+}
+
+void Thread::account_switch_out(uint64_t now) {
+        account_time(now);
+        if(can_be_run())
+                m_stats.involuntary_switches++;
+        else
+                m_stats.voluntary_switches++;
+}
+
+void Thread::account_switch_in(uint64_t now) {
+        m_account_start = now;
+        if(!m_queued_at)
+                return;
+
+        uint64_t wait = now - m_queued_at;
+        m_queued_at = 0;
+        m_stats.wait_cycles += wait;
+        if(wait > m_stats.max_wait_cycles)
+                m_stats.max_wait_cycles = wait;
+
+        if(m_woken) {
+                m_woken = false;
+                m_stats.wakeups++;
+                auto wait_us = TimeManager::cycles_to_us(wait);
+                int bucket = 0;
+                for(uint64_t limit = 10; bucket < THREAD_LATENCY_BUCKETS - 1 && wait_us >= limit; limit *= 10)
+                        bucket++;
+                m_stats.wakeup_latency[bucket]++;
+        }
+}
+
+void Thread::account_time(uint64_t now) {
+        // Charge the time since we last did to the context we were in. With no trap frame, that's userspace for user
+        // threads. Otherwise, it's an interrupt if the innermost frame is an IRQ, and the kernel if it isn't.
+        uint64_t elapsed = now - m_account_start;
+        m_account_start = now;
+        if(_cur_trap_frame && _cur_trap_frame->type == TrapFrame::IRQ)
+                m_stats.irq_cycles += elapsed;
+        else if(_cur_trap_frame || is_kernel_mode())
+                m_stats.kernel_cycles += elapsed;
+        else
+                m_stats.user_cycles += elapsed;
+}
@@ -31,6 +31,7 @@
 #include "kernel/kstd/circular_queue.hpp"
 #include "../kstd/KLog.h"
 #include "Tracer.h"
+#include "ThreadStats.h"
 #include <kernel/arch/registers.h>
 
 #define THREAD_STACK_SIZE 1048576 //1024KiB
@@ -88,8 +89,9 @@ public:
 	bool should_unblock();
 	bool interrupt();
 	Result join(const kstd::Arc<Thread>& self_ptr, const kstd::Arc<Thread>& other, UserspacePointer<void*> retp);
-	void acquired_lock(Mutex* lock);
-	void released_lock(Mutex* lock);
+	void acquired_lock(Lock* lock);
+	void released_lock(Lock* lock);
+	bool holding_lock(Lock* lock);
 
 	//Signals
 	bool& in_signal_handler();
@@ -105,11 +107,18 @@ public:
 	//Thread queue
 	void enqueue_thread(Thread* thread);
 	Thread* next_thread();
+	[[nodiscard]] Thread* peek_next_thread() const { return m_next; }
 
 	//Tracing
 	Result trace_attach(kstd::Arc<Tracer> tracer);
 	void trace_detach();
 
+	//Accounting
+	ThreadStats stats();
+	void account_queued();
+	void account_switch_out(uint64_t now);
+	void account_switch_in(uint64_t now);
+
 	uint8_t fpu_state[512] __attribute__((aligned(16)));
 	ThreadRegisters registers = {};
 	ThreadRegisters signal_registers = {};
@@ -128,6 +137,8 @@ private:
 	void die_from_signal(int signal);
 	void dispatch_signal(int signal);
 
+	void account_time(uint64_t now);
+
 	//Thread stuff
 	Process* _process;
 	tid_t _tid;
@@ -151,7 +162,7 @@ private:
 	bool _joined = false;
 	Mutex _join_lock {"Thread::Join"};
 	kstd::Arc<Thread> _joined_thread;
-	kstd::circular_queue<Mutex*> _held_locks { 100 };
+	kstd::circular_queue<Lock*> _held_locks { 100 };
 
 	//Signals
 	bool _in_signal = false;
@@ -169,6 +180,12 @@ private:
 	// Tracing
 	Mutex m_tracing_lock {"Thread::Tracing"};
 	kstd::Arc<Tracer> m_tracer;
+
+	// Accounting
+	ThreadStats m_stats;
+	uint64_t m_account_start = 0; ///< The last time the running time was charged to m_stats.
+	uint64_t m_queued_at = 0; ///< When the thread was put on the run queue, or 0 if it isn't on it.
+	bool m_woken = false; ///< Whether the thread was put on the run queue because it was unblocked.
 };
 
 void print_arg(Thread* thread, KLog::FormatRules rules);
\ No newline at end of file
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <kernel/kstd/types.h>
+
+// Wakeup latencies are counted in buckets of <10us, <100us, <1ms, <10ms, <100ms, and everything above.
+#define THREAD_LATENCY_BUCKETS 6
+
+/**
+ * CPU time and scheduling statistics of a thread, or the sum of them for a process. Times are in TSC cycles, and can
+ * be converted with TimeManager::cycles_to_us().
+ */
+struct ThreadStats {
+	uint64_t user_cycles = 0;
+	uint64_t kernel_cycles = 0;
+	uint64_t irq_cycles = 0;
+	uint64_t wait_cycles = 0; ///< The time spent runnable, but waiting in the run queue.
+	uint64_t max_wait_cycles = 0;
+	uint32_t voluntary_switches = 0; ///< Times the thread was switched out because it blocked, stopped or exited.
+	uint32_t involuntary_switches = 0; ///< Times the thread was switched out while it could still run.
+	uint32_t wakeups = 0;
+	uint32_t wakeup_latency[THREAD_LATENCY_BUCKETS] = {}; ///< The time between being unblocked and running.
+
+	[[nodiscard]] uint64_t cpu_cycles() const { return user_cycles + kernel_cycles + irq_cycles; }
+
+	ThreadStats& operator+=(const ThreadStats& other) {
+		user_cycles += other.user_cycles;
+		kernel_cycles += other.kernel_cycles;
+		irq_cycles += other.irq_cycles;
+		wait_cycles += other.wait_cycles;
+		if(other.max_wait_cycles > max_wait_cycles)
+			max_wait_cycles = other.max_wait_cycles;
+		voluntary_switches += other.voluntary_switches;
+		involuntary_switches += other.involuntary_switches;
+		wakeups += other.wakeups;
+		for(int i = 0; i < THREAD_LATENCY_BUCKETS; i++)
+			wakeup_latency[i] += other.wakeup_latency[i];
+		return *this;
+	}
+};
@@ -21,9 +21,12 @@
 #include "PTYControllerDevice.h"
 #include <kernel/api/ioctl.h>
 
-PTYControllerDevice::PTYControllerDevice(unsigned int id): CharacterDevice(300, id), _output_buffer(8192) {
+// How much input is copied out of the writer's buffer to be handed to the PTY at a time.
+#define PTY_INPUT_CHUNK_SIZE 512
+
+PTYControllerDevice::PTYControllerDevice(unsigned int id): CharacterDevice(300, id) {
 	_pty = (new PTYDevice(id, shared_ptr()))->shared_ptr();
-	_buffer_blocker.set_ready(true);
+	_space_blocker.set_ready(true);
 }
 
 ssize_t PTYControllerDevice::write(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
@@ -31,27 +34,37 @@ ssize_t PTYControllerDevice::write(FileDescriptor& fd, size_t offset, SafePointe
 	LOCK_N(_ref_lock, ref_locker);
 	if(!_pty)
 		return 0;
-	int off = 0;
-	while(count--)
-		_pty->emit(buffer.get(off++));
-	return count;
+	//Stop once the PTY's input buffer fills up, so the writer knows how much actually went in
+	uint8_t chunk[PTY_INPUT_CHUNK_SIZE];
+	size_t written = 0;
+	while(written < count) {
+		size_t chunk_size = min(count - written, (size_t) PTY_INPUT_CHUNK_SIZE);
+		buffer.read(chunk, written, chunk_size);
+		size_t accepted = _pty->emit(chunk, chunk_size);
+		written += accepted;
+		if(accepted < chunk_size)
+			break;
+	}
+	return written;
 }
 
 ssize_t PTYControllerDevice::read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
 	LOCK(_output_lock);
-	count = min(count, _output_buffer.size());
-	size_t count_loop = count;
-	int off = 0;
-	while(count_loop--)
-		buffer.set(off++, _output_buffer.pop_front());
-	_buffer_blocker.set_ready(_output_buffer.empty());
-	return count;
+	auto nread = _output_buffer.pop(count, [&](const uint8_t* span, size_t span_offset, size_t length) {
+		buffer.write(span, span_offset, length);
+	});
+	_space_blocker.set_ready(true);
+	return nread;
 }
 
 bool PTYControllerDevice::is_pty_controller() {
 	return true;
 }
 
+bool PTYControllerDevice::notifies_readiness() {
+	return true;
+}
+
 bool PTYControllerDevice::can_read(const FileDescriptor& fd) {
 	return !_output_buffer.empty();
 }
@@ -75,30 +88,29 @@ int PTYControllerDevice::ioctl(unsigned int request, SafePointer<void*> argp) {
 	}
 }
 
-size_t PTYControllerDevice::putchars(const uint8_t* buffer, size_t count) {
-	if(count > _output_buffer.capacity())
-		return -ENOSPC;
-
-	// Acquire lock and wait for space in buffer
+ssize_t PTYControllerDevice::putchars(const uint8_t* buffer, size_t count, bool block) {
+	size_t written = 0;
 	while(true) {
 		_output_lock.acquire();
-		if(_output_buffer.capacity() - _output_buffer.size() < count) {
-			_output_lock.release();
-			TaskManager::current_thread()->block(_buffer_blocker);
-			if(_buffer_blocker.was_interrupted())
-				return -EINTR;
-		} else {
-			break;
-		}
-	}
+		written += _output_buffer.push(buffer + written, count - written);
+		bool full = written < count;
+		if(full)
+			_space_blocker.set_ready(false);
+		_output_lock.release();
 
-	size_t count_loop = count;
-	while(count_loop--)
-		_output_buffer.push_back(*(buffer++));
+		if(!full || !block)
+			break;
 
-	_output_lock.release();
+		// Let the controller start on what we've written so far while we wait for it to make space
+		notify_readiness();
+		TaskManager::current_thread()->block(_space_blocker);
+		if(_space_blocker.was_interrupted())
+			return written ? (ssize_t) written : -EINTR;
+	}
 
-	return count;
+	if(written)
+		notify_readiness();
+	return (ssize_t) written;
 }
 
 void PTYControllerDevice::notify_pty_closed() {
@@ -20,7 +20,7 @@
 #pragma once
 
 #include <kernel/device/CharacterDevice.h>
-#include <kernel/kstd/circular_queue.hpp>
+#include <kernel/kstd/ByteRing.h>
 #include <kernel/tasking/Mutex.h>
 #include <kernel/kstd/Arc.h>
 
@@ -35,9 +35,15 @@ public:
 	bool is_pty_controller() override;
 	bool can_read(const FileDescriptor& fd) override;
 	bool can_write(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 	virtual int ioctl(unsigned request, SafePointer<void*> argp) override;
 
-	size_t putchars(const uint8_t* buffer, size_t count);
+	/**
+	 * Queues output from the PTY for the controller to read, and wakes it up once for the whole batch. If block is
+	 * false, only as much as fits right now is queued. Returns how much was queued, or -EINTR if we were interrupted
+	 * before queueing anything.
+	 */
+	ssize_t putchars(const uint8_t* buffer, size_t count, bool block);
 	void notify_pty_closed();
 	void ref_inc();
 	void ref_dec();
@@ -45,8 +51,8 @@ public:
 
 private:
 	Mutex _output_lock {"PTYController::Output"}, _write_lock {"PTYController::Write"}, _ref_lock {"PTYController::Ref"};
-	kstd::circular_queue<uint8_t> _output_buffer;
-	BooleanBlocker _buffer_blocker;
+	kstd::ByteRing _output_buffer {8192};
+	BooleanBlocker _space_blocker; ///< Ready when there might be space in _output_buffer.
 	kstd::Arc<PTYDevice> _pty;
 	unsigned int num_refs = 1;
 };
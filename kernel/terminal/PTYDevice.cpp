@@ -62,15 +62,26 @@ bool PTYDevice::is_pty() {
 	return true;
 }
 
-size_t PTYDevice::tty_write(const uint8_t* chars, size_t count) {
+kstd::Arc<PTYControllerDevice> PTYDevice::controller() {
 	LOCK(_lock);
-	if(!_controller)
+	return _controller;
+}
+
+ssize_t PTYDevice::tty_write(const uint8_t* chars, size_t count) {
+	//putchars blocks until the controller makes space, so we can't hold _lock (which echo needs) while it does
+	auto controller = this->controller();
+	if(!controller)
 		return 0;
-	return _controller->putchars(chars, count);
+	return controller->putchars(chars, count, true);
 }
 
 void PTYDevice::echo(uint8_t c) {
-	LOCK(_lock);
-	if(_controller)
-		_controller->putchars(&c, 1);
+	echo(&c, 1);
+}
+
+void PTYDevice::echo(const uint8_t* chars, size_t count) {
+	// Echoing happens while the controller is writing input, so waiting for it to read would deadlock
+	auto controller = this->controller();
+	if(controller)
+		controller->putchars(chars, count, false);
 }
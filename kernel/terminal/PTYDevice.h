@@ -40,8 +40,11 @@ public:
 
 private:
 	//TTYDevice
-	size_t tty_write(const uint8_t* chars, size_t count) override;
+	ssize_t tty_write(const uint8_t* chars, size_t count) override;
 	void echo(uint8_t c) override;
+	void echo(const uint8_t* chars, size_t count) override;
+
+	kstd::Arc<PTYControllerDevice> controller();
 
 	kstd::Arc<PTYControllerDevice> _controller;
 	kstd::string _name;
@@ -23,7 +23,7 @@
 #include <kernel/tasking/Signal.h>
 #include <kernel/api/ioctl.h>
 
-TTYDevice::TTYDevice(unsigned int major, unsigned int minor): CharacterDevice(major, minor), _input_buffer(1024) {
+TTYDevice::TTYDevice(unsigned int major, unsigned int minor): CharacterDevice(major, minor) {
 	_termios.c_iflag = 0;
 	_termios.c_oflag = 0;
 	_termios.c_cflag = 0;
@@ -44,111 +44,203 @@ ssize_t TTYDevice::write(FileDescriptor &fd, size_t offset, SafePointer<uint8_t>
 }
 
 ssize_t TTYDevice::read(FileDescriptor &fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) {
-	LOCK(_input_lock);
-	//Block until there's something to read
-	while(!_buffer_blocker.is_ready()) {
+	//Input is taken out in a critical section, so it's copied to a kernel buffer first and to userspace afterwards
+	uint8_t chunk[TTY_INPUT_BUFFER_SIZE];
+	size_t nread;
+	while(true) {
 		TaskManager::current_thread()->block(_buffer_blocker);
 		if(_buffer_blocker.was_interrupted())
 			return -EINTR;
+
+		//Another reader may have gotten to the input first
+		TaskManager::IRQSafeCritical crit;
+		if(_buffer_blocker.is_ready()) {
+			nread = take_input(chunk, min(count, sizeof(chunk)));
+			break;
+		}
 	}
 
-	size_t nread = 0;
+	buffer.write(chunk, nread);
+	return nread;
+}
 
-	count = min(count, _input_buffer.size());
+bool TTYDevice::is_tty() {
+	return true;
+}
+
+bool TTYDevice::emit(uint8_t c) {
+	return handle_input(c);
+}
+
+size_t TTYDevice::emit(const uint8_t* data, size_t count) {
 	if(_termios.c_lflag & ICANON) {
-		//Canonical mode
-		for(nread = 0; nread < count; nread++) {
-			char c = _input_buffer.pop_front();
-			if(c == '\n' || c == _termios.c_cc[VEOL]) {
-				//We got a newline, decrease the number of lines available and stop reading
-				_lines--;
-				buffer.set(nread++, c);
-				break;
-			} else if(c == '\0') {
-				//EOF, decrease lines available
-				_lines--;
-				break;
-			}
-			buffer.set(nread, c);
+		for(size_t i = 0; i < count; i++) {
+			if(!handle_input(data[i]))
+				return i;
 		}
+		return count;
+	}
 
-		//If we read all the lines or the buffer is empty, set the buffer blocker to not ready
-		_buffer_blocker.set_ready(_lines && !_input_buffer.empty());
-	} else {
-		//Non-canonical mode
-		while(count--) {
-			buffer.set(nread, _input_buffer.pop_front());
-			nread++;
+	//Non-canonical mode has nothing to cook, so copy the input in runs between any signal characters
+	size_t accepted = 0;
+	auto push_run = [&](const uint8_t* run, size_t length) {
+		size_t pushed;
+		{
+			TaskManager::IRQSafeCritical crit;
+			pushed = _input_buffer.push(run, length);
+			if(pushed)
+				_buffer_blocker.set_ready(true);
 		}
+		if(pushed && (_termios.c_lflag & ECHO))
+			echo(run, pushed);
+		accepted += pushed;
+		return pushed == length;
+	};
 
-		//If we read all the data, set the buffer blocker to not ready
-		_buffer_blocker.set_ready(!_input_buffer.empty());
+	size_t run_start = 0;
+	bool full = false;
+	for(size_t i = 0; (_termios.c_lflag & ISIG) && i < count; i++) {
+		int sig;
+		if(data[i] == _termios.c_cc[VINTR])
+			sig = SIGINT;
+		else if(data[i] == _termios.c_cc[VQUIT])
+			sig = SIGQUIT;
+		else if(data[i] == _termios.c_cc[VSUSP])
+			sig = SIGTSTP;
+		else
+			continue;
+		if(!push_run(data + run_start, i - run_start)) {
+			full = true;
+			break;
+		}
+		generate_signal(sig);
+		accepted++;
+		run_start = i + 1;
 	}
+	if(!full)
+		push_run(data + run_start, count - run_start);
 
-	return nread;
+	//Only wake up readers once for the whole batch
+	if(accepted)
+		notify_readiness();
+	return accepted;
 }
 
-bool TTYDevice::is_tty() {
-	return true;
+void TTYDevice::echo(const uint8_t* chars, size_t count) {
+	for(size_t i = 0; i < count; i++)
+		echo(chars[i]);
 }
 
-void TTYDevice::emit(uint8_t c) {
+bool TTYDevice::handle_input(uint8_t c) {
 	//Check if we should generate a signal
 	if(_termios.c_lflag & ISIG) {
 		if(c == _termios.c_cc[VINTR]) {
 			generate_signal(SIGINT);
-			return;
+			return true;
 		}
 		if(c == _termios.c_cc[VQUIT]) {
 			generate_signal(SIGQUIT);
-			return;
+			return true;
 		}
 		if(c == _termios.c_cc[VSUSP]) {
 			generate_signal(SIGTSTP);
-			return;
+			return true;
 		}
 	}
 
 	//Canonical mode stuff
 	if(_termios.c_lflag & ICANON) {
 		if(c == _termios.c_cc[VEOF]) {
-			_input_buffer.push_back('\0');
-			_lines++;
-			_buffer_blocker.set_ready(true);
-			return;
-		}
-		if(c == '\n' || c == _termios.c_cc[VEOL]) {
-			_lines++;
-			_buffer_blocker.set_ready(true);
+			{
+				TaskManager::IRQSafeCritical crit;
+				if(!_input_buffer.push_back('\0'))
+					return false;
+				_lines++;
+				_buffer_blocker.set_ready(true);
+			}
+			notify_readiness();
+			return true;
 		}
 		if(c == _termios.c_cc[VERASE]) {
 			backspace();
-			return;
+			return true;
 		}
 		if(c == _termios.c_cc[VKILL]) {
 			while(erase());
-			_buffer_blocker.set_ready(_lines && !_input_buffer.empty());
-			return;
+			return true;
 		}
 		if(c == _termios.c_cc[VWERASE]) {
-			while(_input_buffer.back() == ' ' && erase());
-			while(_input_buffer.back() != ' ' && erase());
-			_buffer_blocker.set_ready(_lines && !_input_buffer.empty());
-			return;
+			while(erase([](uint8_t last) { return last == ' '; }));
+			while(erase([](uint8_t last) { return last != ' '; }));
+			return true;
 		}
 	}
 
-	_input_buffer.push_back(c);
-
-	if(!(_termios.c_lflag & ICANON))
-		_buffer_blocker.set_ready(true);
+	bool line_done = !(_termios.c_lflag & ICANON) || c == '\n' || c == _termios.c_cc[VEOL];
+	{
+		TaskManager::IRQSafeCritical crit;
+		if(!_input_buffer.push_back(c))
+			return false;
+		if(line_done) {
+			if(_termios.c_lflag & ICANON)
+				_lines++;
+			_buffer_blocker.set_ready(true);
+		}
+	}
 
+	if(line_done)
+		notify_readiness();
 	if(_termios.c_lflag & ECHO)
 		echo(c);
+	return true;
+}
+
+size_t TTYDevice::take_input(uint8_t* dest, size_t count) {
+	size_t nread;
+	if(_termios.c_lflag & ICANON) {
+		//Canonical mode: read up to the end of the first line, which ends with a newline, EOL, or EOF (a null byte)
+		ssize_t newline = _input_buffer.find('\n');
+		ssize_t eof = _input_buffer.find('\0');
+		uint8_t eol = _termios.c_cc[VEOL];
+		if(eol && eol != '\n') {
+			ssize_t eol_pos = _input_buffer.find(eol);
+			if(eol_pos >= 0 && (newline < 0 || eol_pos < newline))
+				newline = eol_pos;
+		}
+
+		if(eof >= 0 && (newline < 0 || eof < newline)) {
+			//The EOF marker isn't returned. Once everything before it has been read, it's discarded
+			nread = _input_buffer.pop(dest, min(count, (size_t) eof));
+			if(nread == (size_t) eof) {
+				_input_buffer.pop(1, [](const uint8_t*, size_t, size_t) {});
+				_lines--;
+			}
+		} else if(newline >= 0) {
+			nread = _input_buffer.pop(dest, min(count, (size_t) newline + 1));
+			if(nread == (size_t) newline + 1)
+				_lines--;
+		} else {
+			nread = _input_buffer.pop(dest, count);
+		}
+
+		//If we read all the lines or the buffer is empty, set the buffer blocker to not ready
+		_buffer_blocker.set_ready(_lines && !_input_buffer.empty());
+	} else {
+		//Non-canonical mode
+		nread = _input_buffer.pop(dest, count);
+
+		//If we read all the data, set the buffer blocker to not ready
+		_buffer_blocker.set_ready(!_input_buffer.empty());
+	}
+	return nread;
+}
+
+bool TTYDevice::notifies_readiness() {
+	return true;
 }
 
 bool TTYDevice::can_read(const FileDescriptor& fd) {
-	return _termios.c_lflag & ICANON ? _lines : _input_buffer.empty();
+	return _termios.c_lflag & ICANON ? _lines : !_input_buffer.empty();
 }
 
 bool TTYDevice::can_write(const FileDescriptor& fd) {
@@ -207,30 +299,34 @@ void TTYDevice::generate_signal(int sig) {
 	TaskManager::kill_pgid(_pgid, sig);
 }
 
+bool TTYDevice::pop_erasable(bool (*matches)(uint8_t)) {
+	//Removes the last character of the line being typed, if there is one (and it matches)
+	TaskManager::IRQSafeCritical crit;
+	if(_input_buffer.empty())
+		return false;
+	uint8_t last_char = _input_buffer.back();
+	if(last_char == '\0' || last_char == '\n' || last_char == _termios.c_cc[VEOL])
+		return false;
+	if(matches && !matches(last_char))
+		return false;
+	_input_buffer.pop_back();
+	return true;
+}
+
 bool TTYDevice::backspace() {
-	//Check if we can backspace and do so
-	char last_char = _input_buffer.back();
-	if(!_input_buffer.empty() && last_char != '\0' && last_char != _termios.c_cc[VEOL]) {
-		_input_buffer.pop_back();
-		echo('\b');
-		echo(' ');
-		echo('\b');
-		return true;
-	} else {
+	if(!pop_erasable())
 		return false;
-	}
+	echo('\b');
+	echo(' ');
+	echo('\b');
+	return true;
 }
 
-bool TTYDevice::erase() {
-	//Check if we can erase and do so
-	char last_char = _input_buffer.back();
-	if(!_input_buffer.empty() && last_char != '\0' && last_char != _termios.c_cc[VEOL]) {
-		_input_buffer.pop_back();
-		echo(_termios.c_cc[VERASE]);
-		echo(' ');
-		echo(_termios.c_cc[VERASE]);
-		return true;
-	} else {
+bool TTYDevice::erase(bool (*matches)(uint8_t)) {
+	if(!pop_erasable(matches))
 		return false;
-	}
+	echo(_termios.c_cc[VERASE]);
+	echo(' ');
+	echo(_termios.c_cc[VERASE]);
+	return true;
 }
@@ -19,13 +19,14 @@
 
 #pragma once
 
-#include <kernel/kstd/circular_queue.hpp>
+#include <kernel/kstd/ByteRing.h>
 #include <kernel/device/CharacterDevice.h>
 #include <kernel/kstd/unix_types.h>
 #include <kernel/tasking/Mutex.h>
 #include "../api/termios.h"
 
 #define NUM_TTYS 8
+#define TTY_INPUT_BUFFER_SIZE 1024
 
 class TTYDevice: public CharacterDevice {
 public:
@@ -36,24 +37,36 @@ public:
 	ssize_t read(FileDescriptor& fd, size_t offset, SafePointer<uint8_t> buffer, size_t count) override;
 	bool can_read(const FileDescriptor& fd) override;
 	bool can_write(const FileDescriptor& fd) override;
+	bool notifies_readiness() override;
 	virtual int ioctl(unsigned request, SafePointer<void*> argp) override;
 
 	bool is_tty() override;
-	void emit(uint8_t c);
+	/** Handles input typed into the terminal. May be called from an IRQ handler. Returns false if it was dropped. **/
+	bool emit(uint8_t c);
+	/**
+	 * Handles a batch of input at once. In non-canonical mode, it goes straight into the input buffer.
+	 * Returns how much of it was accepted, which is less than count once the input buffer is full.
+	 */
+	size_t emit(const uint8_t* data, size_t count);
 	virtual void echo(uint8_t c) = 0;
-	virtual size_t tty_write(const uint8_t* buffer, size_t count) = 0;
+	virtual void echo(const uint8_t* chars, size_t count);
+	virtual ssize_t tty_write(const uint8_t* buffer, size_t count) = 0;
 
 private:
-	kstd::circular_queue<uint8_t> _input_buffer;
+	//Input can come from IRQ handlers, so the input buffer, _lines, and _buffer_blocker are only touched in an
+	//IRQSafeCritical section.
+	kstd::ByteRing _input_buffer {TTY_INPUT_BUFFER_SIZE};
 	BooleanBlocker _buffer_blocker;
-	Mutex _input_lock {"TTYDevice::Input"};
 	pid_t _pgid = -1;
 	termios _termios;
 	winsize _winsize;
 	int _lines = 0;
 
+	bool handle_input(uint8_t c);
+	size_t take_input(uint8_t* dest, size_t count);
+	bool pop_erasable(bool (*matches)(uint8_t) = nullptr);
 	void generate_signal(int sig);
 	bool backspace();
-	bool erase();
+	bool erase(bool (*matches)(uint8_t) = nullptr);
 };
 
@@ -32,7 +32,7 @@ VirtualTTY::VirtualTTY(unsigned int major, unsigned int minor):
 	terminal = new Term::Terminal({
 		(int) VGADevice::inst().get_display_width() / 8,
 		(int) VGADevice::inst().get_display_height() / 8
-	}, *this);
+	}, *this, 0);
 	register_tty(minor, this);
 }
 
@@ -97,7 +97,7 @@ void VirtualTTY::handle_key(KeyEvent event) {
 	terminal->handle_keypress(event.scancode, event.character, event.modifiers);
 }
 
-size_t VirtualTTY::tty_write(const uint8_t* buffer, size_t count) {
+ssize_t VirtualTTY::tty_write(const uint8_t* buffer, size_t count) {
 	terminal->write_chars((const char*) buffer, count);
 	return count;
 }
@@ -106,6 +106,10 @@ void VirtualTTY::echo(uint8_t c) {
 	terminal->write_char(c);
 }
 
+void VirtualTTY::echo(const uint8_t* chars, size_t count) {
+	terminal->write_chars((const char*) chars, count);
+}
+
 uint32_t vga_color_palette[] = {
 		0x000000,
 		0xAA0000,
@@ -182,6 +186,5 @@ void VirtualTTY::on_resize(const Term::Size& old_size, const Term::Size& new_siz
 }
 
 void VirtualTTY::emit(const uint8_t* data, size_t size) {
-	for(size_t i = 0; i < size; i++)
-		TTYDevice::emit(data[i]);
+	TTYDevice::emit(data, size);
 }
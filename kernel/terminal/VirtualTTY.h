@@ -51,8 +51,9 @@ private:
 	void handle_key(KeyEvent) override;
 
 	//TTYDevice
-	size_t tty_write(const uint8_t* buffer, size_t count) override;
+	ssize_t tty_write(const uint8_t* buffer, size_t count) override;
 	void echo(uint8_t c) override;
+	void echo(const uint8_t* chars, size_t count) override;
 
 	//Terminal::Listener
 	void on_character_change(const Term::Position& position, const Term::Character& character) override;
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <kernel/filesystem/Epoll.h>
+#include <kernel/filesystem/FileDescriptor.h>
+#include <kernel/filesystem/Pipe.h>
+#include <kernel/kstd/unix_types.h>
+
+struct TestPipe {
+	TestPipe(): pipe(kstd::make_shared<Pipe>()) {
+		pipe->add_reader();
+		pipe->add_writer();
+		read_fd = kstd::make_shared<FileDescriptor>(pipe);
+		read_fd->set_options(O_RDONLY | O_NONBLOCK);
+		read_fd->set_fifo_reader();
+		write_fd = kstd::make_shared<FileDescriptor>(pipe);
+		write_fd->set_options(O_WRONLY);
+		write_fd->set_fifo_writer();
+	}
+
+	kstd::Arc<Pipe> pipe;
+	kstd::Arc<FileDescriptor> read_fd;
+	kstd::Arc<FileDescriptor> write_fd;
+};
+
+static void write_byte(TestPipe& pipe) {
+	uint8_t byte = 'a';
+	pipe.write_fd->write(KernelPointer<uint8_t>(&byte), 1);
+}
+
+static void read_byte(TestPipe& pipe) {
+	uint8_t byte;
+	pipe.read_fd->read(KernelPointer<uint8_t>(&byte), 1);
+}
+
+KERNEL_TEST(epoll_level_triggered) {
+	TestPipe pipe;
+	Epoll epoll;
+	epoll_event events[2];
+	ENSURE(epoll.add(3, pipe.read_fd, {EPOLLIN, {.fd = 3}}).is_success());
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 0);
+
+	// Reported for as long as there's something to read
+	write_byte(pipe);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 1);
+	ENSURE_EQ(events[0].data.fd, 3);
+	ENSURE_EQ(events[0].events, EPOLLIN);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 1);
+	read_byte(pipe);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 0);
+
+	// And not at all once it's removed
+	write_byte(pipe);
+	ENSURE(epoll.remove(3, pipe.read_fd).is_success());
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 0);
+}
+
+KERNEL_TEST(epoll_edge_triggered) {
+	TestPipe pipe;
+	Epoll epoll;
+	epoll_event events[2];
+	ENSURE(epoll.add(3, pipe.read_fd, {EPOLLIN | EPOLLET, {.fd = 3}}).is_success());
+
+	// Only reported again once more is written
+	write_byte(pipe);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 1);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 0);
+	write_byte(pipe);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 1);
+}
+
+KERNEL_TEST(epoll_oneshot) {
+	TestPipe pipe;
+	Epoll epoll;
+	epoll_event events[2];
+	ENSURE(epoll.add(3, pipe.read_fd, {EPOLLIN | EPOLLONESHOT, {.fd = 3}}).is_success());
+	write_byte(pipe);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 1);
+	write_byte(pipe);
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 0);
+
+	// Until it's re-armed
+	ENSURE(epoll.modify(3, pipe.read_fd, {EPOLLIN | EPOLLONESHOT, {.fd = 3}}).is_success());
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 1);
+}
+
+KERNEL_TEST(epoll_closed_file) {
+	Epoll epoll;
+	epoll_event events[2];
+	{
+		TestPipe pipe;
+		ENSURE(epoll.add(3, pipe.read_fd, {EPOLLIN, {.fd = 3}}).is_success());
+		write_byte(pipe);
+	}
+	// The watch is dropped once the file is gone
+	ENSURE_EQ(epoll.wait(KernelPointer<epoll_event>(events), 2, 0), 0);
+}
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <kernel/tasking/RWLock.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Process.h>
+#include <kernel/tasking/Thread.h>
+
+static Mutex* s_handoff_mutex;
+static Atomic<int> s_handoff_step = 0;
+
+static void handoff_thread_entry() {
+	s_handoff_mutex->acquire();
+	s_handoff_step.store(1);
+	s_handoff_mutex->release();
+	TaskManager::current_thread()->die();
+}
+
+KERNEL_TEST(mutex_handoff) {
+	Mutex mutex {"TestMutex"};
+	s_handoff_mutex = &mutex;
+	s_handoff_step.store(0);
+
+	mutex.acquire();
+	kstd::Arc<Thread> waiter;
+	{
+		CRITICAL_LOCK(TaskManager::g_tasking_lock);
+		waiter = TaskManager::current_thread()->process()->spawn_kernel_thread(handoff_thread_entry);
+	}
+
+	// Wait for the other thread to start waiting on the mutex
+	while(!mutex.contest_count())
+		TaskManager::yield();
+
+	// Releasing the mutex should hand it straight to the waiting thread, so we can't take it back
+	mutex.release();
+	ENSURE_EQ(mutex.holding_thread(), waiter->tid());
+	ENSURE(!mutex.try_acquire());
+
+	while(!s_handoff_step.load() || mutex.locked())
+		TaskManager::yield();
+	ENSURE_EQ(mutex.acquire_count(), 2);
+	ENSURE_EQ(mutex.contest_count(), 2);
+}
+
+KERNEL_TEST(rwlock_recursion) {
+	RWLock lock {"TestRWLock"};
+
+	// Any number of reads can be nested
+	lock.acquire_read();
+	lock.acquire_read();
+	ENSURE(lock.locked());
+	lock.release_read();
+	lock.release_read();
+	ENSURE(!lock.locked());
+
+	// A writer can also read and write again
+	lock.acquire();
+	lock.acquire_read();
+	lock.acquire();
+	lock.release();
+	lock.release_read();
+	ENSURE(lock.locked());
+	lock.release();
+	ENSURE(!lock.locked());
+
+	ENSURE_EQ(lock.acquire_count(), 5);
+	ENSURE_EQ(lock.contest_count(), 0);
+}
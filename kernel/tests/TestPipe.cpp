@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <kernel/filesystem/FileDescriptor.h>
+#include <kernel/filesystem/Pipe.h>
+#include <kernel/kstd/unix_types.h>
+
+KERNEL_TEST(pipe_wraparound) {
+	auto pipe = kstd::make_shared<Pipe>();
+	pipe->add_reader();
+	pipe->add_writer();
+	auto read_fd = kstd::make_shared<FileDescriptor>(pipe);
+	read_fd->set_options(O_RDONLY | O_NONBLOCK);
+	read_fd->set_fifo_reader();
+	auto write_fd = kstd::make_shared<FileDescriptor>(pipe);
+	write_fd->set_options(O_WRONLY | O_NONBLOCK);
+	write_fd->set_fifo_writer();
+
+	const size_t chunk_size = PIPE_SIZE * 3 / 4;
+	auto* in = new uint8_t[PIPE_SIZE * 2];
+	auto* out = new uint8_t[PIPE_SIZE * 2];
+	for (size_t i = 0; i < PIPE_SIZE * 2; i++)
+		in[i] = i % 251;
+
+	// The second write wraps around the end of the buffer. It's bigger than the pipe, so only part of it goes in
+	ENSURE_EQ(write_fd->write(KernelPointer<uint8_t>(in), chunk_size), (ssize_t) chunk_size);
+	ENSURE_EQ(read_fd->read(KernelPointer<uint8_t>(out), chunk_size / 2), (ssize_t) chunk_size / 2);
+	ENSURE_EQ(write_fd->write(KernelPointer<uint8_t>(in + chunk_size), PIPE_SIZE), (ssize_t) (PIPE_SIZE - chunk_size / 2));
+	ENSURE_EQ(write_fd->write(KernelPointer<uint8_t>(in), 1), -EAGAIN);
+	ENSURE(!pipe->can_write(*write_fd));
+
+	ENSURE_EQ(read_fd->read(KernelPointer<uint8_t>(out + chunk_size / 2), chunk_size * 2), (ssize_t) PIPE_SIZE);
+	bool same = true;
+	for (size_t i = 0; i < chunk_size / 2 + PIPE_SIZE; i++)
+		same &= in[i] == out[i];
+	ENSURE(same);
+	ENSURE(pipe->can_write(*write_fd));
+
+	// Writes that fit in the pipe go in whole or not at all
+	ENSURE_EQ(write_fd->write(KernelPointer<uint8_t>(in), chunk_size), (ssize_t) chunk_size);
+	ENSURE_EQ(write_fd->write(KernelPointer<uint8_t>(in), chunk_size), -EAGAIN);
+	ENSURE_EQ(read_fd->read(KernelPointer<uint8_t>(out), PIPE_SIZE), (ssize_t) chunk_size);
+
+	delete[] in;
+	delete[] out;
+}
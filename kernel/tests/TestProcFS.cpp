@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <kernel/filesystem/procfs/ProcFSContent.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Process.h>
+#include <kernel/api/snapshot.h>
+#include <kernel/kstd/cstring.h>
+#include <kernel/kstd/kstdlib.h>
+#include <kernel/time/TimeManager.h>
+
+KERNEL_TEST(procfs_snapshot) {
+	auto self = TaskManager::current_process();
+	constexpr size_t max_records = 64;
+	constexpr size_t buf_size = sizeof(proc_snapshot_header) + max_records * sizeof(proc_snapshot_record);
+	kstd::vector<uint8_t> storage(buf_size);
+	auto buf = storage.storage();
+	auto header = (proc_snapshot_header*) buf;
+	auto records = (proc_snapshot_record*) (buf + sizeof(proc_snapshot_header));
+
+	ssize_t nread = ProcFSContent::snapshot(0, buf_size, KernelPointer<uint8_t>(buf));
+	ENSURE(nread > 0);
+	if(nread <= 0)
+		return;
+	ENSURE_EQ(header->version, PROC_SNAPSHOT_VERSION);
+	ENSURE_EQ(header->record_size, sizeof(proc_snapshot_record));
+	ENSURE(header->num_records);
+	ENSURE_EQ((size_t) nread, sizeof(proc_snapshot_header) + header->num_records * sizeof(proc_snapshot_record));
+
+	// We should be in there somewhere
+	bool found = false;
+	for(size_t i = 0; i < header->num_records; i++) {
+		if(records[i].pid != self->pid())
+			continue;
+		found = true;
+		ENSURE(self->name() == records[i].name);
+		ENSURE_EQ(records[i].num_threads, self->threads().size());
+	}
+	ENSURE(found);
+
+	// A buffer that's too small for every record should be filled as far as it goes
+	nread = ProcFSContent::snapshot(0, sizeof(proc_snapshot_header) + sizeof(proc_snapshot_record), KernelPointer<uint8_t>(buf));
+	ENSURE_EQ((size_t) nread, sizeof(proc_snapshot_header) + sizeof(proc_snapshot_record));
+	ENSURE_EQ(header->num_records, 1);
+	ENSURE(header->num_processes >= 1);
+
+	// Reads past the start and reads that can't fit the header don't return anything
+	ENSURE_EQ(ProcFSContent::snapshot(1, buf_size, KernelPointer<uint8_t>(buf)), 0);
+	ENSURE_EQ(ProcFSContent::snapshot(0, sizeof(proc_snapshot_header) - 1, KernelPointer<uint8_t>(buf)), -EINVAL);
+}
+
+KERNEL_TEST(procfs_thread_stats) {
+	auto& thread = TaskManager::current_thread();
+	auto before = thread->stats();
+
+	// Spin for a bit, so the timer interrupts us and switches away at least once
+	auto start = TimeManager::uptime();
+	while(TimeManager::uptime().tv_sec * 1000000 + TimeManager::uptime().tv_usec < start.tv_sec * 1000000 + start.tv_usec + 50000);
+
+	// We're a kernel thread, so everything should have been charged to the kernel or interrupts
+	auto after = thread->stats();
+	ENSURE(after.kernel_cycles > before.kernel_cycles);
+	ENSURE(after.irq_cycles > before.irq_cycles);
+	ENSURE_EQ(after.user_cycles, before.user_cycles);
+	ENSURE(TimeManager::cycles_to_us(after.cpu_cycles() - before.cpu_cycles()) >= 40000);
+
+	// And our thread should show up in the process's threads file
+	auto contents = ProcFSContent::threads(thread->process()->pid());
+	ENSURE(!contents.is_error());
+	if(contents.is_error())
+		return;
+	char section[16] = "[";
+	itoa(thread->tid(), section + 1, 10);
+	strcat(section, "]");
+	ENSURE(contents.value().find(section) != -1);
+}
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <kernel/tasking/Profiler.h>
+#include <kernel/tasking/TaskManager.h>
+#include <kernel/tasking/Process.h>
+#include <kernel/tasking/Thread.h>
+#include <kernel/memory/MemoryManager.h>
+#include <kernel/time/TimeManager.h>
+
+KERNEL_TEST(profiler_samples) {
+	auto profiler_res = Profiler::make(TaskManager::current_process()->pid(), 1000, PAGE_SIZE);
+	ENSURE(!profiler_res.is_error());
+	if(profiler_res.is_error())
+		return;
+	auto profiler = profiler_res.value();
+	auto region = MM.map_object(profiler->vm_object());
+	auto header = (profile_buffer*) region->start();
+	ENSURE_EQ(header->data_offset, PAGE_SIZE);
+	ENSURE_EQ(header->data_size, PAGE_SIZE);
+
+	// Spin until the timer interrupts us enough times to fill the buffer and start dropping samples
+	auto start = TimeManager::uptime();
+	while(!__atomic_load_n(&header->lost, __ATOMIC_ACQUIRE) && TimeManager::uptime().tv_sec < start.tv_sec + 2);
+	ENSURE(header->lost);
+
+	// We're a kernel thread, so every sample should be of our kernel stack
+	auto data = (uint8_t*) region->start() + header->data_offset;
+	uint32_t pos = header->tail;
+	size_t num_samples = 0;
+	while(pos != header->head) {
+		auto record = (profile_record*) (data + pos % header->data_size);
+		pos += record->size;
+		if(record->type == PROFILE_RECORD_PADDING)
+			continue;
+		ENSURE_EQ(record->type, PROFILE_RECORD_SAMPLE);
+		ENSURE_EQ(record->pid, TaskManager::current_process()->pid());
+		ENSURE_EQ(record->tid, TaskManager::current_thread()->tid());
+		ENSURE_EQ(record->num_user_frames, 0);
+		ENSURE(record->num_kernel_frames);
+		ENSURE(record->frames[0] >= HIGHER_HALF);
+		ENSURE_EQ(record->size, sizeof(profile_record) + record->num_kernel_frames * sizeof(uintptr_t));
+		num_samples++;
+	}
+	ENSURE(num_samples);
+
+	// Once the reader catches up, samples are written again
+	auto head = header->head;
+	__atomic_store_n(&header->tail, head, __ATOMIC_RELEASE);
+	while(header->head == head && TimeManager::uptime().tv_sec < start.tv_sec + 4);
+	ENSURE(header->head != head);
+}
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <kernel/net/TCPSocket.h>
+
+namespace {
+	struct Dummy {
+		int value;
+	};
+}
+
+KERNEL_TEST(socket_table) {
+	// More sockets than buckets, so some have to share
+	SocketTable<TCPSocket::ID, Dummy, TCPSocket::ID::Hash, 16> table;
+	kstd::vector<kstd::Arc<Dummy>> sockets;
+	for (int i = 0; i < 64; i++) {
+		sockets.push_back(kstd::make_shared<Dummy>(Dummy {i}));
+		ENSURE(table.insert({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, (uint16_t) (40000 + i)}, sockets[i]));
+	}
+	ENSURE(!table.insert({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40005}, sockets[0]));
+
+	for (int i = 0; i < 64; i++) {
+		auto sock = table.get({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, (uint16_t) (40000 + i)});
+		ENSURE(sock);
+		ENSURE_EQ(sock->value, i);
+	}
+	ENSURE(!table.get({{10, 0, 2, 15}, 80, {10, 0, 2, 3}, 40000}));
+
+	// Only the socket that's under a key can remove it
+	table.erase({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40010}, sockets[11].get());
+	ENSURE(table.contains({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40010}));
+	table.erase({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40010}, sockets[10].get());
+	ENSURE(!table.contains({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40010}));
+	ENSURE(table.contains({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40011}));
+
+	// A socket that's being destroyed doesn't hold on to its key, and can't remove its replacement once it's gone
+	auto replacement = kstd::make_shared<Dummy>(Dummy {100});
+	auto* old_socket = sockets[20].get();
+	sockets[20] = replacement;
+	ENSURE(!table.contains({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40020}));
+	ENSURE(table.insert({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40020}, sockets[20]));
+	table.erase({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40020}, old_socket);
+	ENSURE_EQ(table.get({{10, 0, 2, 15}, 80, {10, 0, 2, 2}, 40020})->value, 100);
+}
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "KernelTest.h"
+#include <libterm/Terminal.h>
+
+class NullListener: public Term::Listener {
+public:
+	void on_character_change(const Term::Position& position, const Term::Character& character) override { characters++; }
+	void on_span_change(const Term::Position& start, const Term::Character* chars, int count) override {
+		spans++;
+		last_span_start = start.col;
+		last_span_count = count;
+	}
+	void on_cursor_change(const Term::Position& old_position) override {}
+	void on_backspace(const Term::Position& position) override {}
+	void on_clear() override { clears++; }
+	void on_clear_line(int line) override {}
+	void on_scroll(int lines) override { scrolled += lines; }
+	void on_resize(const Term::Size& old_size, const Term::Size& new_size) override {}
+	void emit(const uint8_t* data, size_t length) override {}
+
+	int scrolled = 0;
+	int clears = 0;
+	int characters = 0;
+	int spans = 0;
+	int last_span_start = 0;
+	int last_span_count = 0;
+};
+
+static void write_lines(Term::Terminal& term, int first, int count) {
+	for(int i = first; i < first + count; i++) {
+		char line[] = {'a', (char) ('a' + (i / 26) % 26), (char) ('a' + i % 26), '\n'};
+		term.write_chars(line, sizeof(line));
+	}
+}
+
+static bool line_is(Term::Terminal& term, int line, int index) {
+	return term.get_character({0, line}).codepoint == 'a' &&
+		term.get_character({1, line}).codepoint == (uint32_t) ('a' + (index / 26) % 26) &&
+		term.get_character({2, line}).codepoint == (uint32_t) ('a' + index % 26);
+}
+
+KERNEL_TEST(terminal_scroll) {
+	NullListener listener;
+	Term::Terminal term({8, 4}, listener, 0);
+
+	// Writing 10 lines on a 4-line screen leaves the last 3 lines and the cursor on an empty line
+	write_lines(term, 0, 10);
+	ENSURE_EQ(listener.scrolled, 7);
+	ENSURE_EQ(term.get_scrollback_lines(), 0);
+	for(int i = 0; i < 3; i++)
+		ENSURE(line_is(term, i, 7 + i));
+	ENSURE_EQ(term.get_character({0, 3}).codepoint, 0);
+}
+
+KERNEL_TEST(terminal_scrollback) {
+	NullListener listener;
+	Term::Terminal term({8, 4}, listener, 16);
+
+	// Lines scrolled off the screen should end up in the scrollback, oldest first
+	write_lines(term, 0, 10);
+	ENSURE_EQ(term.get_scrollback_lines(), 7);
+	for(int i = 0; i < 10; i++)
+		ENSURE(line_is(term, i - 7, i));
+
+	// The scrollback is limited, so only the newest lines should be kept once it wraps around the ring
+	write_lines(term, 10, 100);
+	ENSURE_EQ(term.get_scrollback_lines(), 16);
+	for(int i = 0; i < 16 + 3; i++)
+		ENSURE(line_is(term, i - 16, 110 - 19 + i));
+
+	// Shrinking the screen pushes the top lines into the scrollback
+	term.set_dimensions({8, 2});
+	ENSURE_EQ(term.get_scrollback_lines(), 16);
+	ENSURE(line_is(term, 0, 109));
+	ENSURE(line_is(term, -1, 108));
+}
+
+KERNEL_TEST(terminal_spans) {
+	NullListener listener;
+	Term::Terminal term({8, 4}, listener, 0);
+
+	// Characters written on the same line in one call are reported as a single span, even across escape sequences
+	const char colored[] = "ab\033[31mcd";
+	term.write_chars(colored, sizeof(colored) - 1);
+	ENSURE_EQ(listener.spans, 1);
+	ENSURE_EQ(listener.last_span_start, 0);
+	ENSURE_EQ(listener.last_span_count, 4);
+	ENSURE_EQ(term.get_character({2, 0}).attr.fg, TERM_COLOR_RED);
+	ENSURE_EQ(term.get_cursor().col, 4);
+
+	// Text that wraps is split into one span per line
+	const char wrapped[] = "efghijklmn";
+	term.write_chars(wrapped, sizeof(wrapped) - 1);
+	ENSURE_EQ(listener.spans, 3);
+	ENSURE_EQ(listener.last_span_start, 0);
+	ENSURE_EQ(listener.last_span_count, 6);
+	ENSURE_EQ(term.get_character({7, 0}).codepoint, 'h');
+	ENSURE_EQ(term.get_cursor().line, 1);
+	ENSURE_EQ(term.get_cursor().col, 6);
+
+	// Single characters written outside of write_chars are still reported right away
+	term.set_character({0, 3}, {'z', {}});
+	ENSURE_EQ(listener.spans, 4);
+	ENSURE_EQ(listener.characters, 0);
+}
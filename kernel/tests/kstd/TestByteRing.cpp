@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "../KernelTest.h"
+#include "../../kstd/ByteRing.h"
+
+static bool bytes_equal(const uint8_t* a, const uint8_t* b, size_t size) {
+	for(size_t i = 0; i < size; i++) {
+		if(a[i] != b[i])
+			return false;
+	}
+	return true;
+}
+
+KERNEL_TEST(byte_ring) {
+	kstd::ByteRing ring(16);
+	const uint8_t data[] = "0123456789abcdefghij";
+	uint8_t out[20];
+
+	// Only as much as fits goes in
+	ENSURE_EQ((int) ring.push(data, 20), 16);
+	ENSURE_EQ((int) ring.space(), 0);
+	ENSURE_EQ((int) ring.pop(out, 10), 10);
+	ENSURE(bytes_equal(out, data, 10));
+
+	// Wrap around the end of the storage
+	ENSURE_EQ((int) ring.push(data + 16, 4), 4);
+	ENSURE_EQ((int) ring.size(), 10);
+	ENSURE_EQ((int) ring.find('g'), 6);
+	ENSURE_EQ((int) ring.find('i'), 8);
+	ENSURE_EQ((int) ring.find('0'), -1);
+	ENSURE_EQ((int) ring[7], (int) 'h');
+	ENSURE_EQ((int) ring.back(), (int) 'j');
+	ENSURE_EQ((int) ring.pop_back(), (int) 'j');
+
+	int spans = 0;
+	ENSURE_EQ((int) ring.pop(20, [&](const uint8_t* span, size_t offset, size_t length) {
+		memcpy(out + offset, span, length);
+		spans++;
+	}), 9);
+	ENSURE_EQ(spans, 2);
+	ENSURE(bytes_equal(out, data + 10, 9));
+	ENSURE(ring.empty());
+
+	// Resizing keeps the contents in order, even if they had wrapped around
+	ENSURE_EQ((int) ring.push(data, 12), 12);
+	ENSURE_EQ((int) ring.pop(out, 6), 6);
+	ENSURE_EQ((int) ring.push(data + 12, 8), 8);
+	ENSURE(!ring.resize(8));
+	ENSURE(ring.resize(32));
+	ENSURE_EQ((int) ring.capacity(), 32);
+	ENSURE_EQ((int) ring.pop(out, 20), 14);
+	ENSURE(bytes_equal(out, data + 6, 14));
+}
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "../KernelTest.h"
+#include "../../kstd/cstring.h"
+
+extern "C" void* memmove(void* dest, const void* src, size_t n);
+
+static uint8_t s_buf_a[1024];
+static uint8_t s_buf_b[1024];
+static uint32_t s_seed = 1;
+
+static uint32_t next_random() {
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 8;
+}
+
+static void fill_random(uint8_t* buf, size_t size) {
+	for(size_t i = 0; i < size; i++)
+		buf[i] = next_random();
+}
+
+static bool buffers_equal(const uint8_t* a, const uint8_t* b, size_t size) {
+	for(size_t i = 0; i < size; i++) {
+		if(a[i] != b[i])
+			return false;
+	}
+	return true;
+}
+
+KERNEL_TEST(cstring_memcpy_memset) {
+	// Every size up to 64 and a few larger ones, at every combination of source and destination alignment
+	for(size_t size = 0; size < 300; size += size < 64 ? 1 : 37) {
+		for(size_t src_off = 0; src_off < 4; src_off++) {
+			for(size_t dst_off = 0; dst_off < 4; dst_off++) {
+				fill_random(s_buf_a, sizeof(s_buf_a));
+				fill_random(s_buf_b, sizeof(s_buf_b));
+				uint8_t before = s_buf_b[dst_off + size];
+				memcpy(s_buf_b + dst_off, s_buf_a + src_off, size);
+				ENSURE(buffers_equal(s_buf_b + dst_off, s_buf_a + src_off, size));
+				ENSURE_EQ(s_buf_b[dst_off + size], before);
+
+				memset(s_buf_b + dst_off, 0xA5, size);
+				for(size_t i = 0; i < size; i++)
+					ENSURE_EQ(s_buf_b[dst_off + i], 0xA5);
+				ENSURE_EQ(s_buf_b[dst_off + size], before);
+			}
+		}
+	}
+}
+
+KERNEL_TEST(cstring_memmove) {
+	// Overlapping moves in both directions, checked against a byte-by-byte copy through a temporary buffer
+	uint8_t expected[sizeof(s_buf_a)];
+	for(size_t size = 0; size < 200; size += size < 32 ? 1 : 13) {
+		for(int shift = -9; shift <= 9; shift++) {
+			fill_random(s_buf_a, sizeof(s_buf_a));
+			for(size_t i = 0; i < sizeof(s_buf_a); i++)
+				expected[i] = s_buf_a[i];
+			uint8_t temp[200];
+			for(size_t i = 0; i < size; i++)
+				temp[i] = expected[100 + i];
+			for(size_t i = 0; i < size; i++)
+				expected[100 + shift + i] = temp[i];
+
+			memmove(s_buf_a + 100 + shift, s_buf_a + 100, size);
+			ENSURE(buffers_equal(s_buf_a, expected, sizeof(s_buf_a)));
+		}
+	}
+}
+
+KERNEL_TEST(cstring_strlen) {
+	for(size_t offset = 0; offset < 8; offset++) {
+		for(size_t length = 0; length < 40; length++) {
+			for(size_t i = 0; i < length; i++)
+				s_buf_a[offset + i] = 1 + next_random() % 255;
+			s_buf_a[offset + length] = '\0';
+			s_buf_a[offset + length + 1] = 'x';
+			ENSURE_EQ(strlen((const char*) s_buf_a + offset), (int) length);
+		}
+	}
+}
+
+KERNEL_TEST(cstring_memchr) {
+	// The byte at every position in a run of every length, at every alignment, with bytes that look like it around it
+	for(size_t offset = 0; offset < 4; offset++) {
+		for(size_t length = 0; length < 40; length++) {
+			for(size_t i = 0; i < sizeof(s_buf_a); i++)
+				s_buf_a[i] = 0x80 | (next_random() % 0x7f);
+			ENSURE(!memchr(s_buf_a + offset, '\n', length));
+			for(size_t pos = 0; pos < length; pos++) {
+				s_buf_a[offset + pos] = '\n';
+				ENSURE(memchr(s_buf_a + offset, '\n', length) == s_buf_a + offset + pos);
+				s_buf_a[offset + pos] = '\n' + 0x80;
+			}
+			s_buf_a[offset + length] = '\n';
+			ENSURE(!memchr(s_buf_a + offset, '\n', length));
+		}
+	}
+}
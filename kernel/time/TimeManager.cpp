@@ -20,6 +20,7 @@
 #include <kernel/tasking/TaskManager.h>
 #include "TimeManager.h"
 #include <kernel/kstd/KLog.h>
+#include <kernel/tasking/Profiler.h>
 
 #if defined(__i386__)
 #include "kernel/arch/i386/time/PIT.h"
@@ -89,6 +90,8 @@ void TimeManager::tick() {
 	if(idle_ticks.size() == 100)
 		idle_ticks.pop_front();
 	idle_ticks.push_back(TaskManager::is_idle());
+	// Sample before TaskManager::tick(), which might switch to another thread
+	Profiler::tick();
 	TaskManager::tick();
 
 #if defined(__i386__)
@@ -109,4 +112,22 @@ double TimeManager::percent_idle() {
 		if(ticks_storage[i])
 			num_idle++;
 	return (double) num_idle / 100.0;
-}
\ No newline at end of file
+}
+
+int TimeManager::tick_frequency() {
+	return _inst->_keeper->frequency();
+}
+
+uint64_t TimeManager::cycles() {
+#if defined(__i386__)
+	return read_tsc();
+#elif defined(__aarch64__)
+	return 0; // TODO: aarch64
+#endif
+}
+
+uint64_t TimeManager::cycles_to_us(uint64_t cycles) {
+	if(!_inst || !_inst->_tsc_speed)
+		return 0;
+	return cycles / _inst->_tsc_speed;
+}
@@ -31,6 +31,11 @@ public:
 	static timeval uptime();
 	static timeval now();
 	static double percent_idle();
+	static int tick_frequency();
+
+	/** Reads the CPU's cycle counter, for timing things that are shorter than a tick. **/
+	static uint64_t cycles();
+	static uint64_t cycles_to_us(uint64_t cycles);
 
 protected:
 	friend class TimeKeeper;
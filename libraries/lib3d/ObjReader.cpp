@@ -5,6 +5,7 @@
 #include <libnusa/StringStream.h>
 #include <libnusa/Log.h>
 #include <array>
+#include <map>
 
 using namespace Lib3D;
 
@@ -122,4 +123,34 @@ std::vector<std::array<Vertex, 3>> ObjReader::read(Duck::InputStream& stream) {
 		faces.push_back(verts);
 	}
 	return std::move(faces);
-}
\ No newline at end of file
+}
+
+ObjReader::Mesh ObjReader::read_mesh(Duck::InputStream& stream) {
+	auto obj = Lib3D::ObjReader::read_obj(stream);
+	auto vert_at = [&](int idx) -> const Vertex& {
+		static const Vertex empty = {};
+		return idx >= 0 && idx < (int) obj.verts.size() ? obj.verts[idx] : empty;
+	};
+
+	// Each distinct combination of position, texture coordinate, and normal becomes one vertex
+	Mesh mesh;
+	std::map<std::array<int, 3>, uint32_t> vertex_indices;
+	mesh.indices.reserve(obj.faces.size() * 3);
+	for(auto& face : obj.faces) {
+		for(int i = 0; i < 3; i++) {
+			std::array<int, 3> key = {face.pos[i], face.tex[i], face.norm[i]};
+			auto it = vertex_indices.find(key);
+			if(it == vertex_indices.end()) {
+				Vertex vert;
+				vert.pos = vert_at(face.pos[i]).pos;
+				vert.tex = vert_at(face.tex[i]).tex;
+				vert.norm = vert_at(face.norm[i]).norm;
+				vert.color = {1.0, 1.0, 1.0, 1.0};
+				it = vertex_indices.insert({key, (uint32_t) mesh.vertices.size()}).first;
+				mesh.vertices.push_back(vert);
+			}
+			mesh.indices.push_back(it->second);
+		}
+	}
+	return mesh;
+}
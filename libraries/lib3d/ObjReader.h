@@ -21,7 +21,14 @@ namespace Lib3D {
 			std::vector<Face> faces;
 		};
 
+		/// Vertices shared between faces, and three indices into them for each face. Suitable for draw_indexed().
+		struct Mesh {
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+		};
+
 		Obj read_obj(Duck::InputStream& stream);
 		std::vector<std::array<Vertex, 3>> read(Duck::InputStream& stream);
+		Mesh read_mesh(Duck::InputStream& stream);
 	};
 }
@@ -0,0 +1,387 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "Rasterizer.h"
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#define LIB3D_SSE2
+#endif
+
+using namespace Lib3D;
+
+#define f2i(f) ((int) ((f)))
+
+#ifdef LIB3D_SSE2
+static bool cpu_has_sse2() {
+	static int has_sse2 = -1;
+	if(has_sse2 == -1) {
+		unsigned int eax, ebx, ecx, edx;
+		has_sse2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+	}
+	return has_sse2;
+}
+
+__attribute__((target("sse2")))
+static void transform_sse2(const Matrix4f& mat, const Vertex* vertices, size_t count, Vec4f* out) {
+	__m128 cols[4];
+	for(int i = 0; i < 4; i++)
+		cols[i] = _mm_set_ps(mat.m_rows[3][i], mat.m_rows[2][i], mat.m_rows[1][i], mat.m_rows[0][i]);
+	for(size_t i = 0; i < count; i++) {
+		auto& pos = vertices[i].pos;
+		__m128 res = _mm_mul_ps(cols[0], _mm_set1_ps(pos[0]));
+		res = _mm_add_ps(res, _mm_mul_ps(cols[1], _mm_set1_ps(pos[1])));
+		res = _mm_add_ps(res, _mm_mul_ps(cols[2], _mm_set1_ps(pos[2])));
+		res = _mm_add_ps(res, _mm_mul_ps(cols[3], _mm_set1_ps(pos[3])));
+		_mm_storeu_ps(&out[i][0], res);
+	}
+}
+#endif
+
+/// Textures, alpha tests, and writes a pixel that's passed the coverage and depth tests.
+static inline void write_pixel(BufferSet& buffers, const Rasterizer::State& state, const Rasterizer::Triangle& tri, int x, int y, Vec4f color, float z) {
+	if(state.texture) {
+		auto& tex_buf = state.texture->buffer();
+		const float u = tri.tex[0].at(x, y), v = tri.tex[1].at(x, y);
+		const Vec4f texcol = tex_buf.get((size_t) f2i(u * tex_buf.width()), (size_t) f2i(v * tex_buf.height()));
+		color = {color[0] * texcol[0], color[1] * texcol[1], color[2] * texcol[2], color[3] * texcol[3]};
+	}
+	if(state.alpha_testing && color.w() <= 0)
+		return;
+	buffers.color.at(x, y) = color;
+	buffers.depth.at(x, y) = z;
+}
+
+/// Which pixels of the quad at (x, y) are within the box. Quads are aligned to even pixels, so the ones on the edges of
+/// the box may only be partially inside of it. Lanes are ordered (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1).
+static inline int quad_lanes(int x, int y, int min_x, int min_y, int max_x, int max_y) {
+	int lanes = 0xF;
+	if(y < min_y)
+		lanes &= 0b1100;
+	if(y + 1 > max_y)
+		lanes &= 0b0011;
+	if(x < min_x)
+		lanes &= 0b1010;
+	if(x + 1 > max_x)
+		lanes &= 0b0101;
+	return lanes;
+}
+
+#ifdef LIB3D_SSE2
+__attribute__((target("sse2")))
+static inline __m128 plane_quad_sse2(const Rasterizer::Plane& plane, __m128 xs, __m128 ys) {
+	return _mm_add_ps(_mm_set1_ps(plane.c), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.dx), xs), _mm_mul_ps(_mm_set1_ps(plane.dy), ys)));
+}
+
+__attribute__((target("sse2")))
+static void raster_quads_sse2(const Rasterizer::Triangle& tri, int min_x, int min_y, int max_x, int max_y, BufferSet& buffers, const Rasterizer::State& state) {
+	const int start_x = min_x & ~1, start_y = min_y & ~1;
+	const __m128 xs = _mm_add_ps(_mm_set1_ps((float) start_x), _mm_set_ps(1, 0, 1, 0));
+	const __m128 ys = _mm_add_ps(_mm_set1_ps((float) start_y), _mm_set_ps(1, 1, 0, 0));
+	const __m128 zero = _mm_setzero_ps();
+
+	// The edge functions and depth of the first quad, which are stepped along from quad to quad
+	__m128 row_bary[3], bary_step_x[3], bary_step_y[3];
+	for(int i = 0; i < 3; i++) {
+		row_bary[i] = plane_quad_sse2(tri.bary[i], xs, ys);
+		bary_step_x[i] = _mm_set1_ps(tri.bary[i].dx * 2);
+		bary_step_y[i] = _mm_set1_ps(tri.bary[i].dy * 2);
+	}
+	__m128 row_z = plane_quad_sse2(tri.z, xs, ys);
+	const __m128 z_step_x = _mm_set1_ps(tri.z.dx * 2);
+	const __m128 z_step_y = _mm_set1_ps(tri.z.dy * 2);
+
+	// All four channels of the color are interpolated at once
+	const __m128 color_c = _mm_setr_ps(tri.color[0].c, tri.color[1].c, tri.color[2].c, tri.color[3].c);
+	const __m128 color_dx = _mm_setr_ps(tri.color[0].dx, tri.color[1].dx, tri.color[2].dx, tri.color[3].dx);
+	const __m128 color_dy = _mm_setr_ps(tri.color[0].dy, tri.color[1].dy, tri.color[2].dy, tri.color[3].dy);
+	const __m128 color_lane[4] = {zero, color_dx, color_dy, _mm_add_ps(color_dx, color_dy)};
+
+	auto& depth_buf = buffers.depth;
+	for(int y = start_y; y <= max_y; y += 2) {
+		__m128 bary[3] = {row_bary[0], row_bary[1], row_bary[2]};
+		__m128 z = row_z;
+		for(int x = start_x; x <= max_x; x += 2) {
+			int mask = quad_lanes(x, y, min_x, min_y, max_x, max_y);
+			if(!tri.pixel) {
+				__m128 inside = _mm_and_ps(_mm_cmpge_ps(bary[0], zero), _mm_cmpge_ps(bary[1], zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(bary[2], zero));
+				mask &= _mm_movemask_ps(inside);
+			}
+
+			if(mask && state.depth_testing) {
+				__m128 depth;
+				if(mask == 0xF) {
+					depth = _mm_loadl_pi(zero, (const __m64*) &depth_buf.at(x, y));
+					depth = _mm_loadh_pi(depth, (const __m64*) &depth_buf.at(x, y + 1));
+				} else {
+					float gathered[4] = {0, 0, 0, 0};
+					for(int lane = 0; lane < 4; lane++) {
+						if(mask & (1 << lane))
+							gathered[lane] = depth_buf.at(x + (lane & 1), y + (lane >> 1));
+					}
+					depth = _mm_loadu_ps(gathered);
+				}
+				mask &= _mm_movemask_ps(_mm_cmplt_ps(depth, z));
+			}
+
+			if(mask) {
+				float zs[4];
+				_mm_storeu_ps(zs, z);
+				const __m128 quad_color = _mm_add_ps(color_c, _mm_add_ps(_mm_mul_ps(color_dx, _mm_set1_ps((float) x)), _mm_mul_ps(color_dy, _mm_set1_ps((float) y))));
+				for(int lane = 0; lane < 4; lane++) {
+					if(!(mask & (1 << lane)))
+						continue;
+					const int px = x + (lane & 1), py = y + (lane >> 1);
+					const __m128 color = _mm_add_ps(quad_color, color_lane[lane]);
+					if(!state.texture && !state.alpha_testing) {
+						_mm_storeu_ps(&buffers.color.at(px, py)[0], color);
+						depth_buf.at(px, py) = zs[lane];
+					} else {
+						Vec4f color_vec;
+						_mm_storeu_ps(&color_vec[0], color);
+						write_pixel(buffers, state, tri, px, py, color_vec, zs[lane]);
+					}
+				}
+			}
+
+			for(int i = 0; i < 3; i++)
+				bary[i] = _mm_add_ps(bary[i], bary_step_x[i]);
+			z = _mm_add_ps(z, z_step_x);
+		}
+
+		for(int i = 0; i < 3; i++)
+			row_bary[i] = _mm_add_ps(row_bary[i], bary_step_y[i]);
+		row_z = _mm_add_ps(row_z, z_step_y);
+	}
+}
+#endif
+
+static void raster_quads_scalar(const Rasterizer::Triangle& tri, int min_x, int min_y, int max_x, int max_y, BufferSet& buffers, const Rasterizer::State& state) {
+	for(int y = min_y & ~1; y <= max_y; y += 2) {
+		for(int x = min_x & ~1; x <= max_x; x += 2) {
+			const int lanes = quad_lanes(x, y, min_x, min_y, max_x, max_y);
+			for(int lane = 0; lane < 4; lane++) {
+				if(!(lanes & (1 << lane)))
+					continue;
+				const int px = x + (lane & 1), py = y + (lane >> 1);
+				if(!tri.pixel && (tri.bary[0].at(px, py) < 0 || tri.bary[1].at(px, py) < 0 || tri.bary[2].at(px, py) < 0))
+					continue;
+				const float z = tri.z.at(px, py);
+				if(state.depth_testing && buffers.depth.at(px, py) >= z)
+					continue;
+				const Vec4f color = {tri.color[0].at(px, py), tri.color[1].at(px, py), tri.color[2].at(px, py), tri.color[3].at(px, py)};
+				write_pixel(buffers, state, tri, px, py, color, z);
+			}
+		}
+	}
+}
+
+static Rasterizer::Plane interpolate(const Rasterizer::Plane (&bary)[3], float a, float b, float c) {
+	return {
+		bary[0].c * a + bary[1].c * b + bary[2].c * c,
+		bary[0].dx * a + bary[1].dx * b + bary[2].dx * c,
+		bary[0].dy * a + bary[1].dy * b + bary[2].dy * c
+	};
+}
+
+static float plane_min(const Rasterizer::Plane& plane, int min_x, int min_y, int max_x, int max_y) {
+	return plane.c + std::min(plane.dx * min_x, plane.dx * max_x) + std::min(plane.dy * min_y, plane.dy * max_y);
+}
+
+static float plane_max(const Rasterizer::Plane& plane, int min_x, int min_y, int max_x, int max_y) {
+	return plane.c + std::max(plane.dx * min_x, plane.dx * max_x) + std::max(plane.dy * min_y, plane.dy * max_y);
+}
+
+void Rasterizer::reset_depth_bounds() {
+	for(auto& tile : m_tiles)
+		tile.zmin = -INFINITY;
+}
+
+void Rasterizer::draw(BufferSet& buffers, const State& state, const Vertex* vertices, size_t num_vertices, const uint32_t* indices, size_t num_indices) {
+	if((int) buffers.color.width() != m_width || (int) buffers.color.height() != m_height)
+		resize(buffers.color.width(), buffers.color.height());
+	if(!m_width || !m_height)
+		return;
+
+	// Transform and set up everything first, and then bin the triangles in order
+	transform(state, vertices, num_vertices);
+	setup(state, vertices, indices, num_indices);
+	for(auto& tile : m_tiles)
+		tile.triangles.clear();
+	for(uint32_t i = 0; i < m_triangles.size(); i++)
+		bin(i);
+
+	m_active_tiles.clear();
+	for(uint32_t i = 0; i < m_tiles.size(); i++) {
+		if(!m_tiles[i].triangles.empty())
+			m_active_tiles.push_back(i);
+	}
+
+	// Every tile only touches its own pixels, so the workers just take whichever one is next
+	std::atomic<size_t> next_tile {0};
+	m_pool.run([&](int) {
+		for(size_t i = next_tile++; i < m_active_tiles.size(); i = next_tile++)
+			raster_tile(m_tiles[m_active_tiles[i]], buffers, state);
+	});
+}
+
+void Rasterizer::resize(int width, int height) {
+	m_width = width;
+	m_height = height;
+	m_tiles_x = (width + tile_size - 1) / tile_size;
+	m_tiles_y = (height + tile_size - 1) / tile_size;
+	m_tiles.resize(m_tiles_x * m_tiles_y);
+	for(int y = 0; y < m_tiles_y; y++) {
+		for(int x = 0; x < m_tiles_x; x++) {
+			auto& tile = m_tiles[x + y * m_tiles_x];
+			tile.min_x = x * tile_size;
+			tile.min_y = y * tile_size;
+			tile.max_x = std::min(tile.min_x + tile_size, width) - 1;
+			tile.max_y = std::min(tile.min_y + tile_size, height) - 1;
+		}
+	}
+	reset_depth_bounds();
+}
+
+void Rasterizer::transform(const State& state, const Vertex* vertices, size_t num_vertices) {
+	m_projected.resize(num_vertices);
+#ifdef LIB3D_SSE2
+	if(cpu_has_sse2()) {
+		transform_sse2(state.matrix, vertices, num_vertices, m_projected.data());
+		return;
+	}
+#endif
+	for(size_t i = 0; i < num_vertices; i++)
+		m_projected[i] = (state.matrix * vertices[i].pos).col(0);
+}
+
+void Rasterizer::setup(const State& state, const Vertex* vertices, const uint32_t* indices, size_t num_indices) {
+	m_triangles.clear();
+	m_triangles.reserve(num_indices / 3);
+	for(size_t i = 0; i + 2 < num_indices; i += 3) {
+		const uint32_t idx[3] = {indices[i], indices[i + 1], indices[i + 2]};
+		if(idx[0] >= m_projected.size() || idx[1] >= m_projected.size() || idx[2] >= m_projected.size())
+			continue;
+
+		// Backface cull and lighting calculation
+		Vec3f tri[3];
+		for(int j = 0; j < 3; j++) {
+			auto& pt = m_projected[idx[j]];
+			tri[j] = {pt.x(), pt.y(), pt.z()};
+		}
+		Vec3f norm = ((tri[2] - tri[0]) ^ (tri[1] - tri[0])).normalize();
+		if(state.backface_culling && norm.z() < 0)
+			continue;
+		const float light = state.backface_culling ? norm.z() : std::abs(norm.z());
+
+		// Transform into screenspace and calculate the bounding box
+		Vec3f ss[3];
+		Triangle out;
+		out.min_x = out.min_y = INT_MAX;
+		out.max_x = out.max_y = INT_MIN;
+		for(int j = 0; j < 3; j++) {
+			ss[j] = {(tri[j].x() + 1.0f) * 0.5f * m_width, (-tri[j].y() + 1.0f) * 0.5f * m_height, tri[j].z()};
+			out.min_x = std::min(out.min_x, f2i(ss[j].x() + 0.5f));
+			out.min_y = std::min(out.min_y, f2i(ss[j].y() + 0.5f));
+			out.max_x = std::max(out.max_x, f2i(ss[j].x() + 0.5f));
+			out.max_y = std::max(out.max_y, f2i(ss[j].y() + 0.5f));
+		}
+		out.min_x = std::max(out.min_x, 0);
+		out.min_y = std::max(out.min_y, 0);
+		out.max_x = std::min(out.max_x, m_width - 1);
+		out.max_y = std::min(out.max_y, m_height - 1);
+		if(out.min_x > out.max_x || out.min_y > out.max_y)
+			continue;
+		out.pixel = out.min_x == out.max_x && out.min_y == out.max_y;
+
+		// The barycentric coordinates as planes over screenspace
+		const float e1x = ss[1].x() - ss[0].x(), e1y = ss[1].y() - ss[0].y();
+		const float e2x = ss[2].x() - ss[0].x(), e2y = ss[2].y() - ss[0].y();
+		const float area = e2x * e1y - e1x * e2y;
+		if(area == 0 || std::isnan(area))
+			continue;
+		const float inv_area = 1.0f / area;
+		out.bary[1] = {(ss[0].x() * e2y - e2x * ss[0].y()) * inv_area, -e2y * inv_area, e2x * inv_area};
+		out.bary[2] = {(e1x * ss[0].y() - ss[0].x() * e1y) * inv_area, e1y * inv_area, -e1x * inv_area};
+		out.bary[0] = {1.0f - out.bary[1].c - out.bary[2].c, -out.bary[1].dx - out.bary[2].dx, -out.bary[1].dy - out.bary[2].dy};
+
+		auto& v0 = vertices[idx[0]];
+		auto& v1 = vertices[idx[1]];
+		auto& v2 = vertices[idx[2]];
+		out.z = interpolate(out.bary, ss[0].z(), ss[1].z(), ss[2].z());
+		for(int c = 0; c < 3; c++)
+			out.color[c] = interpolate(out.bary, v0.color[c] * light, v1.color[c] * light, v2.color[c] * light);
+		out.color[3] = interpolate(out.bary, v0.color[3], v1.color[3], v2.color[3]);
+		for(int c = 0; c < 2; c++)
+			out.tex[c] = interpolate(out.bary, v0.tex[c], v1.tex[c], v2.tex[c]);
+
+		m_triangles.push_back(out);
+	}
+}
+
+void Rasterizer::bin(uint32_t index) {
+	auto& tri = m_triangles[index];
+	const int min_tx = tri.min_x / tile_size, max_tx = tri.max_x / tile_size;
+	const int min_ty = tri.min_y / tile_size, max_ty = tri.max_y / tile_size;
+	if(min_tx == max_tx && min_ty == max_ty) {
+		m_tiles[min_tx + min_ty * m_tiles_x].triangles.push_back(index);
+		return;
+	}
+
+	for(int ty = min_ty; ty <= max_ty; ty++) {
+		for(int tx = min_tx; tx <= max_tx; tx++) {
+			auto& tile = m_tiles[tx + ty * m_tiles_x];
+			const int min_x = std::max(tri.min_x, tile.min_x), max_x = std::min(tri.max_x, tile.max_x);
+			const int min_y = std::max(tri.min_y, tile.min_y), max_y = std::min(tri.max_y, tile.max_y);
+
+			// Skip tiles that are entirely on the outside of one of the edges
+			bool outside = false;
+			for(int i = 0; i < 3 && !tri.pixel; i++)
+				outside |= plane_max(tri.bary[i], min_x, min_y, max_x, max_y) < 0;
+			if(!outside)
+				tile.triangles.push_back(index);
+		}
+	}
+}
+
+void Rasterizer::raster_tile(Tile& tile, BufferSet& buffers, const State& state) {
+	for(auto index : tile.triangles) {
+		auto& tri = m_triangles[index];
+		const int min_x = std::max(tri.min_x, tile.min_x), max_x = std::min(tri.max_x, tile.max_x);
+		const int min_y = std::max(tri.min_y, tile.min_y), max_y = std::min(tri.max_y, tile.max_y);
+
+		// If the triangle is behind everything in the tile, there's nothing to draw
+		if(state.depth_testing && plane_max(tri.z, min_x, min_y, max_x, max_y) <= tile.zmin)
+			continue;
+
+		raster_triangle(tri, min_x, min_y, max_x, max_y, buffers, state);
+
+		// Without depth testing the depth buffer can go down, so the bound is lost. With alpha testing, pixels may be
+		// left alone even when covered. Otherwise, if the triangle covered the whole tile, every pixel is now at least
+		// as deep as the triangle is there.
+		if(!state.depth_testing) {
+			tile.zmin = -INFINITY;
+		} else if(!state.alpha_testing) {
+			bool covers = min_x == tile.min_x && min_y == tile.min_y && max_x == tile.max_x && max_y == tile.max_y;
+			for(int i = 0; i < 3; i++)
+				covers &= plane_min(tri.bary[i], tile.min_x, tile.min_y, tile.max_x, tile.max_y) >= 0;
+			if(covers)
+				tile.zmin = std::max(tile.zmin, plane_min(tri.z, tile.min_x, tile.min_y, tile.max_x, tile.max_y));
+		}
+	}
+}
+
+void Rasterizer::raster_triangle(const Triangle& tri, int min_x, int min_y, int max_x, int max_y, BufferSet& buffers, const State& state) {
+#ifdef LIB3D_SSE2
+	if(cpu_has_sse2()) {
+		raster_quads_sse2(tri, min_x, min_y, max_x, max_y, buffers, state);
+		return;
+	}
+#endif
+	raster_quads_scalar(tri, min_x, min_y, max_x, max_y, buffers, state);
+}
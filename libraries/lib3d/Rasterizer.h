@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "BufferSet.h"
+#include "Texture.h"
+#include "Vertex.h"
+#include "WorkerPool.h"
+#include <vector>
+
+namespace Lib3D {
+	/**
+	 * Draws indexed triangle lists by splitting the viewport up into tiles. Vertices are transformed in bulk, then each
+	 * triangle is set up once and added to the bin of every tile it touches, and then the tiles are rasterized in
+	 * parallel by the worker pool, a 2x2 quad of pixels at a time. Triangles are drawn in the order they were given
+	 * within each tile, so the output is the same no matter how many threads are used.
+	 *
+	 * Each tile also keeps a lower bound of the depth values in it, which is raised whenever a triangle covers the
+	 * whole tile. Triangles that are entirely behind that bound are skipped without reading the depth buffer at all.
+	 */
+	class Rasterizer {
+	public:
+		static constexpr int tile_size = 32;
+
+		struct State {
+			Matrix4f matrix;
+			Texture* texture;
+			bool depth_testing;
+			bool backface_culling;
+			bool alpha_testing;
+		};
+
+		/// An attribute that varies linearly across the screen.
+		struct Plane {
+			float c, dx, dy;
+			float at(float x, float y) const { return c + dx * x + dy * y; }
+		};
+
+		struct Triangle {
+			int min_x, min_y, max_x, max_y; ///< The bounding box, clipped to the viewport.
+			bool pixel; ///< Whether the bounding box is a single pixel, which is always drawn even if not covered.
+			Plane bary[3];
+			Plane z;
+			Plane color[4];
+			Plane tex[2];
+		};
+
+		void set_threads(int threads) { m_pool.set_num_threads(threads); }
+		int threads() const { return m_pool.num_threads(); }
+
+		/// Forgets the depth bounds of every tile. Must be called whenever the depth buffer is lowered or replaced.
+		void reset_depth_bounds();
+
+		void draw(BufferSet& buffers, const State& state, const Vertex* vertices, size_t num_vertices, const uint32_t* indices, size_t num_indices);
+
+	private:
+		struct Tile {
+			int min_x, min_y, max_x, max_y;
+			float zmin; ///< No depth value in the tile is lower than this.
+			std::vector<uint32_t> triangles;
+		};
+
+		void resize(int width, int height);
+		void transform(const State& state, const Vertex* vertices, size_t num_vertices);
+		void setup(const State& state, const Vertex* vertices, const uint32_t* indices, size_t num_indices);
+		void bin(uint32_t index);
+		void raster_tile(Tile& tile, BufferSet& buffers, const State& state);
+		void raster_triangle(const Triangle& tri, int min_x, int min_y, int max_x, int max_y, BufferSet& buffers, const State& state);
+
+		WorkerPool m_pool;
+		int m_width = 0, m_height = 0;
+		int m_tiles_x = 0, m_tiles_y = 0;
+		std::vector<Tile> m_tiles;
+		std::vector<uint32_t> m_active_tiles; ///< The tiles with something to draw in them.
+		std::vector<Vec4f> m_projected;
+		std::vector<Triangle> m_triangles;
+	};
+}
@@ -13,11 +13,13 @@ RenderContext::RenderContext(Gfx::Dimensions dimensions):
 void RenderContext::set_viewport(Gfx::Rect rect) {
 	m_viewport = rect;
 	m_buffers = BufferSet(rect.dimensions());
+	m_rasterizer.reset_depth_bounds();
 }
 
 void RenderContext::clear(Vec4f color) {
 	m_buffers.depth.fill(-INFINITY);
 	m_buffers.color.fill(color);
+	m_rasterizer.reset_depth_bounds();
 }
 
 #define f2i(f) ((int) ((f)))
@@ -64,6 +66,20 @@ void RenderContext::line(Vertex a, Vertex b) {
 
 void RenderContext::tri(std::array<Vertex, 3> verts) {
 	tri_barycentric(verts);
+	// Drawing without depth testing can lower the depth buffer
+	if(!m_depth_testing)
+		m_rasterizer.reset_depth_bounds();
+}
+
+void RenderContext::draw_indexed(const Vertex* vertices, size_t num_vertices, const uint32_t* indices, size_t num_indices) {
+	Rasterizer::State state = {
+		.matrix = m_premultmat,
+		.texture = m_bound_texture,
+		.depth_testing = m_depth_testing,
+		.backface_culling = m_backface_culling,
+		.alpha_testing = m_alpha_testing
+	};
+	m_rasterizer.draw(m_buffers, state, vertices, num_vertices, indices, num_indices);
 }
 
 void RenderContext::tri_barycentric(std::array<Vertex, 3> verts) {
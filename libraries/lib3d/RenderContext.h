@@ -9,8 +9,10 @@
 #include "MatrixUtil.h"
 #include "Vertex.h"
 #include "Texture.h"
+#include "Rasterizer.h"
 #include <array>
 #include <utility>
+#include <vector>
 
 namespace Lib3D {
 	class RenderContext: public Duck::Object {
@@ -18,6 +20,7 @@ namespace Lib3D {
 		NUSA_OBJECT_DEF(RenderContext);
 
 		/// Getters and setters
+		/// If the depth buffer is lowered or filled by hand, clear() must be called before drawing with draw_indexed().
 		BufferSet& buffers() { return m_buffers; }
 		const Gfx::Rect viewport() const { return m_viewport; }
 		void set_viewport(Gfx::Rect rect);
@@ -48,6 +51,10 @@ namespace Lib3D {
 		void set_backface_culling(bool backface_culling) { m_backface_culling = backface_culling; }
 		void set_alpha_testing(bool alpha_testing) { m_alpha_testing = alpha_testing; }
 
+		/// The number of threads draw_indexed() rasterizes with, including the calling thread. Defaults to one.
+		int threads() const { return m_rasterizer.threads(); }
+		void set_threads(int threads) { m_rasterizer.set_threads(threads); }
+
 		/// Various Stuff
 		void clear(Vec4f color);
 
@@ -55,6 +62,16 @@ namespace Lib3D {
 		void line(Vertex a, Vertex b);
 		void tri(std::array<Vertex, 3> verts);
 
+		/**
+		 * Draws a list of triangles, each made of three consecutive indices into vertices. Much faster than calling
+		 * tri() for each triangle, since shared vertices are only transformed once and the triangles are rasterized
+		 * in tiles. The result is the same as drawing them one by one with tri().
+		 */
+		void draw_indexed(const Vertex* vertices, size_t num_vertices, const uint32_t* indices, size_t num_indices);
+		void draw_indexed(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+			draw_indexed(vertices.data(), vertices.size(), indices.data(), indices.size());
+		}
+
 		/// Textures
 		void bind_texture(Texture* texture) { m_bound_texture = texture; }
 
@@ -69,6 +86,7 @@ namespace Lib3D {
 		Matrix4f m_premultmat = m_projmat * m_modelmat;
 		Gfx::Rect m_viewport;
 		BufferSet m_buffers;
+		Rasterizer m_rasterizer;
 		Texture* m_bound_texture = nullptr;
 		bool m_depth_testing = true;
 		bool m_backface_culling = true;
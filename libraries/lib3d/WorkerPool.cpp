@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "WorkerPool.h"
+
+using namespace Lib3D;
+
+WorkerPool::WorkerPool(int num_threads) {
+	pthread_mutex_init(&m_lock, nullptr);
+	pthread_cond_init(&m_start_cond, nullptr);
+	pthread_cond_init(&m_done_cond, nullptr);
+	start_threads(num_threads);
+}
+
+WorkerPool::~WorkerPool() {
+	stop_threads();
+	pthread_cond_destroy(&m_done_cond);
+	pthread_cond_destroy(&m_start_cond);
+	pthread_mutex_destroy(&m_lock);
+}
+
+void WorkerPool::set_num_threads(int num_threads) {
+	if(num_threads < 1)
+		num_threads = 1;
+	if(num_threads == this->num_threads())
+		return;
+	stop_threads();
+	start_threads(num_threads);
+}
+
+void WorkerPool::run(std::function<void(int)> job) {
+	if(m_threads.empty()) {
+		job(0);
+		return;
+	}
+
+	pthread_mutex_lock(&m_lock);
+	m_job = std::move(job);
+	m_pending = (int) m_threads.size();
+	m_generation++;
+	pthread_cond_broadcast(&m_start_cond);
+	pthread_mutex_unlock(&m_lock);
+
+	// m_job isn't touched again until every thread is done with it, so it's safe to read without the lock
+	m_job(0);
+
+	pthread_mutex_lock(&m_lock);
+	while(m_pending)
+		pthread_cond_wait(&m_done_cond, &m_lock);
+	m_job = nullptr;
+	pthread_mutex_unlock(&m_lock);
+}
+
+void* WorkerPool::worker_entry(void* arg) {
+	auto& worker = *(Worker*) arg;
+	auto& pool = *worker.pool;
+
+	pthread_mutex_lock(&pool.m_lock);
+	while(true) {
+		while(!pool.m_stopping && pool.m_generation == worker.generation)
+			pthread_cond_wait(&pool.m_start_cond, &pool.m_lock);
+		if(pool.m_stopping)
+			break;
+		worker.generation = pool.m_generation;
+		pthread_mutex_unlock(&pool.m_lock);
+
+		pool.m_job(worker.index);
+
+		pthread_mutex_lock(&pool.m_lock);
+		if(!--pool.m_pending)
+			pthread_cond_signal(&pool.m_done_cond);
+	}
+	pthread_mutex_unlock(&pool.m_lock);
+	return nullptr;
+}
+
+void WorkerPool::start_threads(int num_threads) {
+	m_stopping = false;
+	// Reserved up front, since the threads hold on to pointers into m_workers
+	m_workers.reserve(num_threads - 1);
+	for(int i = 1; i < num_threads; i++) {
+		m_workers.push_back({this, i, m_generation});
+		pthread_t thread;
+		if(pthread_create(&thread, nullptr, worker_entry, &m_workers.back())) {
+			m_workers.pop_back();
+			break;
+		}
+		m_threads.push_back(thread);
+	}
+}
+
+void WorkerPool::stop_threads() {
+	pthread_mutex_lock(&m_lock);
+	m_stopping = true;
+	pthread_cond_broadcast(&m_start_cond);
+	pthread_mutex_unlock(&m_lock);
+	for(auto thread : m_threads)
+		pthread_join(thread, nullptr);
+	m_threads.clear();
+	m_workers.clear();
+}
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <pthread.h>
+#include <functional>
+#include <vector>
+
+namespace Lib3D {
+	/**
+	 * A set of threads that all run the same job at once. The thread calling run() takes part as worker zero, so a pool
+	 * of one thread runs jobs inline and never starts a thread of its own.
+	 */
+	class WorkerPool {
+	public:
+		explicit WorkerPool(int num_threads = 1);
+		~WorkerPool();
+
+		int num_threads() const { return (int) m_threads.size() + 1; }
+		void set_num_threads(int num_threads);
+
+		/// Calls job(index) on every worker with indices 0 to num_threads() - 1, and returns once they all have.
+		void run(std::function<void(int)> job);
+
+	private:
+		struct Worker {
+			WorkerPool* pool;
+			int index;
+			unsigned int generation; ///< The last job the worker saw.
+		};
+
+		static void* worker_entry(void* arg);
+		void start_threads(int num_threads);
+		void stop_threads();
+
+		std::vector<pthread_t> m_threads;
+		std::vector<Worker> m_workers;
+		pthread_mutex_t m_lock;
+		pthread_cond_t m_start_cond;
+		pthread_cond_t m_done_cond;
+		std::function<void(int)> m_job;
+		unsigned int m_generation = 0; ///< Incremented every time a job is started.
+		int m_pending = 0; ///< The number of threads that haven't finished the current job yet.
+		bool m_stopping = false;
+	};
+}
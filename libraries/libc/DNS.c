@@ -9,12 +9,14 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <poll.h>
 
 #define DNS_PORT       53
 #define DNS_MAX_PKT    512
 #define DNS_TIMEOUT_S  5
 #define DNS_TYPE_A     1
 #define DNS_CLASS_IN   1
+#define DNS_RECV_BATCH 4
 
 /* DNS packet header */
 struct dns_header {
@@ -225,12 +227,33 @@ int dns_resolve(const char* hostname, struct in_addr* result) {
 		return -1;
 	}
 
-	uint8_t resp_buf[DNS_MAX_PKT];
-	ssize_t resp_len = recvfrom(sock, resp_buf, sizeof(resp_buf), 0, NULL, NULL);
-	close(sock);
+	/* Wait for the answer, skipping stale replies to earlier queries. Whatever has
+	 * arrived is read in one go, so a burst of them doesn't cost a syscall each. */
+	uint8_t resp_bufs[DNS_RECV_BATCH][DNS_MAX_PKT];
+	struct iovec iovs[DNS_RECV_BATCH];
+	struct mmsghdr msgs[DNS_RECV_BATCH];
+	memset(msgs, 0, sizeof(msgs));
+	for (int i = 0; i < DNS_RECV_BATCH; i++) {
+		iovs[i].iov_base = resp_bufs[i];
+		iovs[i].iov_len  = DNS_MAX_PKT;
+		msgs[i].msg_hdr.msg_iov    = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
 
-	if (resp_len < 0)
-		return -1;
+	struct pollfd pfd = { .fd = sock, .events = POLLIN };
+	while (poll(&pfd, 1, DNS_TIMEOUT_S * 1000) > 0) {
+		int nmsgs = recvmmsg(sock, msgs, DNS_RECV_BATCH, MSG_WAITFORONE, NULL);
+		if (nmsgs < 0)
+			break;
+		for (int i = 0; i < nmsgs; i++) {
+			const struct dns_header* hdr = (const struct dns_header*) resp_bufs[i];
+			if (msgs[i].msg_len < sizeof(struct dns_header) || ntohs(hdr->id) != query_id)
+				continue;
+			close(sock);
+			return parse_response(resp_bufs[i], (int) msgs[i].msg_len, query_id, result);
+		}
+	}
 
-	return parse_response(resp_buf, (int) resp_len, query_id, result);
+	close(sock);
+	return -1;
 }
\ No newline at end of file
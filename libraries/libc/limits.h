@@ -53,6 +53,12 @@
 #define PATH_MAX 256
 #define LINK_MAX 256
 
+// Pipe writes of up to this many bytes are atomic
+#define PIPE_BUF PAGE_SIZE
+
+// The largest value a semaphore can be posted up to
+#define SEM_VALUE_MAX INT_MAX
+
 #ifndef PAGE_SIZE
 #include <kernel/api/page_size.h>
 #endif
@@ -3,8 +3,10 @@
 
 #include "pthread.h"
 #include <sys/thread.h>
+#include <sys/futex.h>
 #include <cerrno>
 #include <cstdio>
+#include <climits>
 
 static_assert(sizeof(tid_t) == sizeof(pthread_t));
 
@@ -70,15 +72,76 @@ int pthread_mutex_destroy(pthread_mutex_t* mutex) {
 	return 0;
 }
 
+#define MUTEX_UNLOCKED 0
+#define MUTEX_LOCKED 1
+#define MUTEX_CONTENDED 2
+#define MUTEX_MAX_SPINS 100
+
+static void mutex_lock_contended(pthread_mutex_t* mutex) {
+	// Spin for a little while first, since the holder might be about to release the lock. How long we spin for adapts
+	// to how long it took to get the lock last time, so that mutexes held for a long time go to sleep right away.
+	int max_spins = mutex->spins * 2 + 10;
+	if (max_spins > MUTEX_MAX_SPINS)
+		max_spins = MUTEX_MAX_SPINS;
+	for (int i = 0; i < max_spins; i++) {
+		int expected = MUTEX_UNLOCKED;
+		if (__atomic_compare_exchange_n(&mutex->val, &expected, MUTEX_LOCKED, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			mutex->spins += (i - mutex->spins) / 8;
+			return;
+		}
+		// If other threads are already sleeping, there's no point in spinning
+		if (expected == MUTEX_CONTENDED)
+			break;
+		__builtin_ia32_pause();
+	}
+	mutex->spins += (max_spins - mutex->spins) / 8;
+
+	// Mark the mutex as contended so that the holder wakes us up when it unlocks
+	while (__atomic_exchange_n(&mutex->val, MUTEX_CONTENDED, __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+		futex_wait_value(&mutex->val, MUTEX_CONTENDED, NULL);
+}
+
 int pthread_mutex_lock(pthread_mutex_t* mutex) {
+	pthread_t self = gettid();
+	if (mutex->type == PTHREAD_MUTEX_RECURSIVE && __atomic_load_n(&mutex->holder, __ATOMIC_RELAXED) == self) {
+		mutex->count++;
+		return 0;
+	}
+
+	int expected = MUTEX_UNLOCKED;
+	if (!__atomic_compare_exchange_n(&mutex->val, &expected, MUTEX_LOCKED, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		mutex_lock_contended(mutex);
+	__atomic_store_n(&mutex->holder, self, __ATOMIC_RELAXED);
+	mutex->count = 1;
 	return 0;
 }
 
 int pthread_mutex_trylock(pthread_mutex_t* mutex) {
+	pthread_t self = gettid();
+	if (mutex->type == PTHREAD_MUTEX_RECURSIVE && __atomic_load_n(&mutex->holder, __ATOMIC_RELAXED) == self) {
+		mutex->count++;
+		return 0;
+	}
+
+	int expected = MUTEX_UNLOCKED;
+	if (!__atomic_compare_exchange_n(&mutex->val, &expected, MUTEX_LOCKED, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return EBUSY;
+	__atomic_store_n(&mutex->holder, self, __ATOMIC_RELAXED);
+	mutex->count = 1;
 	return 0;
 }
 
 int pthread_mutex_unlock(pthread_mutex_t* mutex) {
+	if (mutex->type == PTHREAD_MUTEX_RECURSIVE) {
+		if (__atomic_load_n(&mutex->holder, __ATOMIC_RELAXED) != gettid())
+			return EPERM;
+		if (--mutex->count)
+			return 0;
+	}
+
+	__atomic_store_n(&mutex->holder, 0, __ATOMIC_RELAXED);
+	if (__atomic_exchange_n(&mutex->val, MUTEX_UNLOCKED, __ATOMIC_RELEASE) == MUTEX_CONTENDED)
+		futex_wake(&mutex->val, 1);
 	return 0;
 }
 
@@ -103,30 +166,98 @@ int pthread_mutexattr_destroy(pthread_mutexattr_t* attr) {
 	return 0;
 }
 
+// rwlock
+int pthread_rwlock_init(pthread_rwlock_t* rwlock, const pthread_rwlockattr_t* attr) {
+	rwlock->state = 0;
+	rwlock->waiters = 0;
+	rwlock->writer = 0;
+	return 0;
+}
+
+int pthread_rwlock_destroy(pthread_rwlock_t* rwlock) {
+	return 0;
+}
+
+int pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock) {
+	int state = __atomic_load_n(&rwlock->state, __ATOMIC_RELAXED);
+	while (state >= 0) {
+		if (__atomic_compare_exchange_n(&rwlock->state, &state, state + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 0;
+	}
+	return EBUSY;
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) {
+	while (pthread_rwlock_tryrdlock(rwlock) == EBUSY) {
+		__atomic_add_fetch(&rwlock->waiters, 1, __ATOMIC_ACQUIRE);
+		futex_wait_value(&rwlock->state, -1, NULL);
+		__atomic_sub_fetch(&rwlock->waiters, 1, __ATOMIC_RELAXED);
+	}
+	return 0;
+}
+
+int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock) {
+	int expected = 0;
+	if (!__atomic_compare_exchange_n(&rwlock->state, &expected, -1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return EBUSY;
+	rwlock->writer = gettid();
+	return 0;
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock) {
+	int state = 0;
+	while (!__atomic_compare_exchange_n(&rwlock->state, &state, -1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		// Wait for the state to change from what we saw. If it changes before we get to sleep, the wait fails.
+		__atomic_add_fetch(&rwlock->waiters, 1, __ATOMIC_ACQUIRE);
+		futex_wait_value(&rwlock->state, state, NULL);
+		__atomic_sub_fetch(&rwlock->waiters, 1, __ATOMIC_RELAXED);
+		state = 0;
+	}
+	rwlock->writer = gettid();
+	return 0;
+}
+
+int pthread_rwlock_unlock(pthread_rwlock_t* rwlock) {
+	if (__atomic_load_n(&rwlock->state, __ATOMIC_RELAXED) == -1) {
+		if (rwlock->writer != gettid())
+			return EPERM;
+		rwlock->writer = 0;
+		__atomic_store_n(&rwlock->state, 0, __ATOMIC_RELEASE);
+	} else if (__atomic_sub_fetch(&rwlock->state, 1, __ATOMIC_RELEASE) != 0) {
+		return 0;
+	}
+
+	if (__atomic_load_n(&rwlock->waiters, __ATOMIC_ACQUIRE))
+		futex_wake(&rwlock->state, INT_MAX);
+	return 0;
+}
+
 // spinlock
 int pthread_spin_init(pthread_spinlock_t* lock, int val) {
-	// TODO
-	return -1;
+	lock->lock = 0;
+	return 0;
 }
 
 int pthread_spin_destroy(pthread_spinlock_t* lock) {
-	// TODO
-	return -1;
+	return 0;
 }
 
 int pthread_spin_lock(pthread_spinlock_t* lock) {
-	// TODO
-	return -1;
+	while (__atomic_exchange_n(&lock->lock, 1, __ATOMIC_ACQUIRE)) {
+		// The holder can't make progress while we spin on a single processor, so give it a chance to run
+		while (__atomic_load_n(&lock->lock, __ATOMIC_RELAXED))
+			sched_yield();
+	}
+	return 0;
 }
 
 int pthread_spin_trylock(pthread_spinlock_t* lock) {
-	// TODO
-	return -1;
+	return __atomic_exchange_n(&lock->lock, 1, __ATOMIC_ACQUIRE) ? EBUSY : 0;
 }
 
 int pthread_spin_unlock(pthread_spinlock_t* lock) {
-	// TODO
-	return -1;
+	__atomic_store_n(&lock->lock, 0, __ATOMIC_RELEASE);
+	return 0;
 }
 
 // misc
@@ -147,8 +278,21 @@ int pthread_key_create(pthread_key_t* key, void (*destructor)(void*)) { return -
 int pthread_key_delete(pthread_key_t key) { return -1; }
 
 // cond
-int pthread_cond_broadcast(pthread_cond_t*) {
-	return -1;
+int pthread_cond_broadcast(pthread_cond_t* cond) {
+	pthread_mutex_t* mutex = __atomic_load_n(&cond->mutex, __ATOMIC_RELAXED);
+	int seq = __atomic_add_fetch(&cond->val, 1, __ATOMIC_RELEASE);
+	if (!mutex) {
+		futex_wake(&cond->val, INT_MAX);
+		return 0;
+	}
+
+	// Wake up one waiter and move the rest onto the mutex, so that they're woken one at a time as it gets unlocked
+	// instead of all fighting over it at once. The woken waiter locks the mutex as contended, so it'll wake the next.
+	int saved_errno = errno;
+	if (futex_requeue(&cond->val, seq, 1, &mutex->val, INT_MAX) < 0)
+		futex_wake(&cond->val, INT_MAX);
+	errno = saved_errno;
+	return 0;
 }
 
 int pthread_cond_init(pthread_cond_t* cond, pthread_condattr_t const* attr) {
@@ -163,10 +307,51 @@ int pthread_cond_destroy(pthread_cond_t*) {
 }
 
 int pthread_cond_signal(pthread_cond_t* cond) {
-	return -1;
+	__atomic_add_fetch(&cond->val, 1, __ATOMIC_RELEASE);
+	futex_wake(&cond->val, 1);
+	return 0;
+}
+
+static int cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime) {
+	int seq = __atomic_load_n(&cond->val, __ATOMIC_ACQUIRE);
+	__atomic_store_n(&cond->mutex, mutex, __ATOMIC_RELAXED);
+
+	// Fully unlock the mutex, even if it's been locked recursively
+	int count = mutex->count;
+	mutex->count = 1;
+	pthread_mutex_unlock(mutex);
+
+	int ret = 0;
+	int saved_errno = errno;
+	if (abstime) {
+		timespec now, rel;
+		clock_gettime(cond->clock, &now);
+		rel.tv_sec = abstime->tv_sec - now.tv_sec;
+		rel.tv_nsec = abstime->tv_nsec - now.tv_nsec;
+		if (rel.tv_nsec < 0) {
+			rel.tv_nsec += 1000000000;
+			rel.tv_sec--;
+		}
+		if (rel.tv_sec < 0)
+			ret = ETIMEDOUT;
+		else if (futex_wait_value(&cond->val, seq, &rel) < 0 && errno == ETIMEDOUT)
+			ret = ETIMEDOUT;
+	} else {
+		futex_wait_value(&cond->val, seq, NULL);
+	}
+	errno = saved_errno;
+
+	// We may have been moved onto the mutex by a broadcast with other threads still waiting, so lock it as contended.
+	while (__atomic_exchange_n(&mutex->val, MUTEX_CONTENDED, __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+		futex_wait_value(&mutex->val, MUTEX_CONTENDED, NULL);
+	__atomic_store_n(&mutex->holder, gettid(), __ATOMIC_RELAXED);
+	mutex->count = count;
+	return ret;
 }
 
-int pthread_cond_wait(pthread_cond_t*, pthread_mutex_t*) { return -1; }
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+	return cond_wait(cond, mutex, NULL);
+}
 
 int pthread_condattr_init(pthread_condattr_t* attr) {
 	attr->clockid = CLOCK_MONOTONIC_COARSE;
@@ -196,7 +381,9 @@ int pthread_condattr_destroy(pthread_condattr_t*) {
 	return 0;
 }
 
-int pthread_cond_timedwait(pthread_cond_t*, pthread_mutex_t*, const struct timespec*) { return -1; }
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime) {
+	return cond_wait(cond, mutex, abstime);
+}
 
 // cancel
 int pthread_cancel(pthread_t) { return -1; }
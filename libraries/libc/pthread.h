@@ -17,7 +17,9 @@
 #define PTHREAD_MUTEX_RECURSIVE 2
 #define PTHREAD_MUTEX_DEFAULT PTHREAD_MUTEX_NORMAL
 #define PTHREAD_MUTEX_INITIALIZER {}
-#define PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP {}
+#define PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP {0, 0, PTHREAD_MUTEX_RECURSIVE, 0, 0}
+#define PTHREAD_COND_INITIALIZER {}
+#define PTHREAD_RWLOCK_INITIALIZER {}
 
 #define PTHREAD_PROCESS_PRIVATE 1
 #define PTHREAD_PROCESS_SHARED 2
@@ -33,22 +35,29 @@ typedef int pthread_t;
 typedef int pthread_key_t;
 typedef uint32_t pthread_once_t;
 typedef void* pthread_attr_t;
-typedef uint64_t pthread_rwlock_t;
 typedef void* pthread_rwlockattr_t;
 
 typedef struct {
-	uint32_t val;
+	int val; ///< 0 if unlocked, 1 if locked, 2 if locked and other threads may be waiting.
 	pthread_t holder;
 	int type;
+	int count; ///< The number of times a recursive mutex has been locked.
+	int spins; ///< How many times to spin before waiting, adjusted based on how long it took to acquire before.
 } pthread_mutex_t;
 
+typedef struct {
+	int state; ///< -1 if locked for writing, otherwise the number of readers.
+	int waiters;
+	pthread_t writer;
+} pthread_rwlock_t;
+
 typedef struct {
 	int type;
 } pthread_mutexattr_t;
 
 typedef struct {
 	pthread_mutex_t* mutex;
-	uint32_t val;
+	int val; ///< A sequence number, incremented every time the condition is signalled.
 	clockid_t clock;
 } pthread_cond_t;
 
@@ -96,6 +105,15 @@ int pthread_mutexattr_settype(pthread_mutexattr_t*, int);
 int pthread_mutexattr_gettype(pthread_mutexattr_t*, int*);
 int pthread_mutexattr_destroy(pthread_mutexattr_t*);
 
+// rwlock
+int pthread_rwlock_init(pthread_rwlock_t* rwlock, const pthread_rwlockattr_t* attr);
+int pthread_rwlock_destroy(pthread_rwlock_t* rwlock);
+int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock);
+int pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock);
+int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock);
+int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock);
+int pthread_rwlock_unlock(pthread_rwlock_t* rwlock);
+
 // spinlock
 int pthread_spin_init(pthread_spinlock_t* lock, int val);
 int pthread_spin_destroy(pthread_spinlock_t* lock);
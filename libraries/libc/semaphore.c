@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "semaphore.h"
+#include "errno.h"
+#include "limits.h"
+#include <stddef.h>
+
+int sem_init(sem_t* sem, int pshared, unsigned int value) {
+	if (value > SEM_VALUE_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+	sem->value = (int) value;
+	sem->waiters = 0;
+	return 0;
+}
+
+int sem_destroy(sem_t* sem) {
+	return 0;
+}
+
+int sem_trywait(sem_t* sem) {
+	int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+	while (value > 0) {
+		if (__atomic_compare_exchange_n(&sem->value, &value, value - 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 0;
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+static int sem_wait_until(sem_t* sem, const struct timespec* abstime) {
+	int saved_errno = errno;
+	while (sem_trywait(sem) < 0) {
+		struct timespec rel;
+		if (abstime) {
+			struct timespec now;
+			clock_gettime(CLOCK_REALTIME, &now);
+			rel.tv_sec = abstime->tv_sec - now.tv_sec;
+			rel.tv_nsec = abstime->tv_nsec - now.tv_nsec;
+			if (rel.tv_nsec < 0) {
+				rel.tv_nsec += 1000000000;
+				rel.tv_sec--;
+			}
+			if (rel.tv_sec < 0) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+		}
+
+		__atomic_add_fetch(&sem->waiters, 1, __ATOMIC_ACQUIRE);
+		int res = futex_wait_value(&sem->value, 0, abstime ? &rel : NULL);
+		__atomic_sub_fetch(&sem->waiters, 1, __ATOMIC_RELAXED);
+		if (res < 0 && errno != EAGAIN)
+			return -1;
+	}
+	errno = saved_errno;
+	return 0;
+}
+
+int sem_wait(sem_t* sem) {
+	return sem_wait_until(sem, NULL);
+}
+
+int sem_timedwait(sem_t* sem, const struct timespec* abstime) {
+	return sem_wait_until(sem, abstime);
+}
+
+int sem_post(sem_t* sem) {
+	int value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+	do {
+		if (value >= SEM_VALUE_MAX) {
+			errno = EOVERFLOW;
+			return -1;
+		}
+	} while (!__atomic_compare_exchange_n(&sem->value, &value, value + 1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	if (__atomic_load_n(&sem->waiters, __ATOMIC_ACQUIRE))
+		futex_wake(&sem->value, 1);
+	return 0;
+}
+
+int sem_getvalue(sem_t* sem, int* value) {
+	*value = __atomic_load_n(&sem->value, __ATOMIC_RELAXED);
+	return 0;
+}
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <sys/futex.h>
+#include <time.h>
+
+__DECL_BEGIN
+
+#define SEM_FAILED ((sem_t*) 0)
+
+typedef struct {
+	futex_t value;
+	int waiters;
+} sem_t;
+
+int sem_init(sem_t* sem, int pshared, unsigned int value);
+int sem_destroy(sem_t* sem);
+int sem_wait(sem_t* sem);
+int sem_trywait(sem_t* sem);
+int sem_timedwait(sem_t* sem, const struct timespec* abstime);
+int sem_post(sem_t* sem);
+int sem_getvalue(sem_t* sem, int* value);
+
+__DECL_END
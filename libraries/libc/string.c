@@ -19,33 +19,381 @@
 
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <cpuid.h>
+#include <emmintrin.h>
 
-//Memory manipulation
+#define CPUID_7_EBX_ERMS (1 << 9)
 
-void* memcpy(void* dest, const void* src, size_t n) {
+//Optimized memory and string functions
+//Every function below has a portable version that works a word (or a rep instruction) at a time, and an SSE2 version.
+//The portable versions are used until the constructor below checks the CPU, so they're safe to call at any point.
+
+#define WORD_SIZE sizeof(size_t)
+#define WORD_ONES ((size_t) -1 / 0xFF)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+#define WORD_HAS_ZERO(w) (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+#define ERMS_THRESHOLD 2048
+
+typedef size_t __attribute__((may_alias)) word_t;
+typedef size_t __attribute__((may_alias, aligned(1))) unaligned_word_t;
+typedef uint32_t __attribute__((may_alias, aligned(1))) unaligned_u32_t;
+
+static int s_has_erms = 0;
+
+static void* memcpy_words(void* dest, const void* src, size_t n) {
 	void* odest = dest;
-	asm volatile( "rep movsb" : "+D"(dest), "+S"(src), "+c"(n)::"memory");
+	size_t words = n / WORD_SIZE;
+	size_t bytes = n % WORD_SIZE;
+	asm volatile("rep movsl" : "+D"(dest), "+S"(src), "+c"(words) :: "memory");
+	asm volatile("rep movsb" : "+D"(dest), "+S"(src), "+c"(bytes) :: "memory");
 	return odest;
 }
 
-void* memmove(void* dest, const void* src, size_t n) {
-	if (dest < src)
-		return memcpy(dest, src, n);
-
-	uint8_t* dest8 = (uint8_t*) dest;
-	const uint8_t* src8 = (const uint8_t*) src;
-	for (dest8 += n, src8 += n; n--;)
-		*--dest8 = *--src8;
+static void* memcpy_erms(void* dest, const void* src, size_t n) {
+	void* odest = dest;
+	asm volatile("rep movsb" : "+D"(dest), "+S"(src), "+c"(n) :: "memory");
+	return odest;
+}
 
+// Keep GCC from turning the byte loop back into a call to memmove
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+static void* memmove_words(void* dest, const void* src, size_t n) {
+	// Copying forwards is fine unless the destination starts inside of the source
+	if ((uintptr_t) dest - (uintptr_t) src >= n)
+		return memcpy_words(dest, src, n);
+
+	uint8_t* d = (uint8_t*) dest + n;
+	const uint8_t* s = (const uint8_t*) src + n;
+	for (; n >= WORD_SIZE; n -= WORD_SIZE) {
+		d -= WORD_SIZE;
+		s -= WORD_SIZE;
+		*(unaligned_word_t*) d = *(const unaligned_word_t*) s;
+	}
+	while (n--)
+		*--d = *--s;
 	return dest;
 }
 
-void* memset(void* dest, int c, size_t n) {
+static void* memset_words(void* dest, int c, size_t n) {
 	void* odest = dest;
-	asm volatile( "rep stosb" : "=D"(dest), "=c"(n) : "0"(dest), "1"(n), "a"(c) : "memory");
+	size_t word = (uint8_t) c * WORD_ONES;
+	size_t words = n / WORD_SIZE;
+	size_t bytes = n % WORD_SIZE;
+	asm volatile("rep stosl" : "+D"(dest), "+c"(words) : "a"(word) : "memory");
+	asm volatile("rep stosb" : "+D"(dest), "+c"(bytes) : "a"(word) : "memory");
 	return odest;
 }
 
+static void* memset_erms(void* dest, int c, size_t n) {
+	void* odest = dest;
+	asm volatile("rep stosb" : "+D"(dest), "+c"(n) : "a"(c) : "memory");
+	return odest;
+}
+
+static int memcmp_words(const void* a, const void* b, size_t n) {
+	const uint8_t* a8 = (const uint8_t*) a;
+	const uint8_t* b8 = (const uint8_t*) b;
+	for (; n >= WORD_SIZE; n -= WORD_SIZE, a8 += WORD_SIZE, b8 += WORD_SIZE) {
+		if (*(const unaligned_word_t*) a8 != *(const unaligned_word_t*) b8)
+			break;
+	}
+	for (; n; n--, a8++, b8++) {
+		if (*a8 != *b8)
+			return *a8 < *b8 ? -1 : 1;
+	}
+	return 0;
+}
+
+static int strcmp_bytes(const char* s1, const char* s2) {
+	while (*s1 == *s2++) {
+		if (*s1++ == 0)
+			return 0;
+	}
+	return *((const uint8_t*) s1) - *((const uint8_t*) (s2 - 1));
+}
+
+static void* memchr_words(const void* s, int c, size_t n) {
+	const uint8_t* p = (const uint8_t*) s;
+	for (; n && (uintptr_t) p % WORD_SIZE; n--, p++) {
+		if (*p == (uint8_t) c)
+			return (void*) p;
+	}
+	size_t pattern = (uint8_t) c * WORD_ONES;
+	for (; n >= WORD_SIZE; n -= WORD_SIZE, p += WORD_SIZE) {
+		size_t word = *(const word_t*) p ^ pattern;
+		if (WORD_HAS_ZERO(word))
+			break;
+	}
+	for (; n; n--, p++) {
+		if (*p == (uint8_t) c)
+			return (void*) p;
+	}
+	return NULL;
+}
+
+static char* strchr_words(const char* s, int c) {
+	for (; (uintptr_t) s % WORD_SIZE; s++) {
+		if (*s == (char) c)
+			return (char*) s;
+		if (!*s)
+			return NULL;
+	}
+	// Aligned words never cross into the next page, so it's safe to read past the end of the string
+	size_t pattern = (uint8_t) c * WORD_ONES;
+	for (;; s += WORD_SIZE) {
+		size_t word = *(const word_t*) s;
+		if (WORD_HAS_ZERO(word) || WORD_HAS_ZERO(word ^ pattern))
+			break;
+	}
+	for (;; s++) {
+		if (*s == (char) c)
+			return (char*) s;
+		if (!*s)
+			return NULL;
+	}
+}
+
+static size_t strlen_words(const char* str) {
+	const char* s = str;
+	for (; (uintptr_t) s % WORD_SIZE; s++) {
+		if (!*s)
+			return s - str;
+	}
+	while (!WORD_HAS_ZERO(*(const word_t*) s))
+		s += WORD_SIZE;
+	while (*s)
+		s++;
+	return s - str;
+}
+
+//SSE2 versions
+
+__attribute__((target("sse2")))
+static inline void copy_small_sse2(uint8_t* d, const uint8_t* s, size_t n) {
+	// Everything is loaded before anything is stored, so this works for overlapping buffers too
+	if (n >= 8) {
+		__m128i head = _mm_loadl_epi64((const __m128i*) s);
+		__m128i tail = _mm_loadl_epi64((const __m128i*) (s + n - 8));
+		_mm_storel_epi64((__m128i*) d, head);
+		_mm_storel_epi64((__m128i*) (d + n - 8), tail);
+	} else if (n >= 4) {
+		uint32_t head = *(const unaligned_u32_t*) s;
+		uint32_t tail = *(const unaligned_u32_t*) (s + n - 4);
+		*(unaligned_u32_t*) d = head;
+		*(unaligned_u32_t*) (d + n - 4) = tail;
+	} else if (n) {
+		uint8_t first = s[0], middle = s[n / 2], last = s[n - 1];
+		d[0] = first;
+		d[n / 2] = middle;
+		d[n - 1] = last;
+	}
+}
+
+__attribute__((target("sse2")))
+static void* memmove_sse2(void* dest, const void* src, size_t n) {
+	uint8_t* d = (uint8_t*) dest;
+	const uint8_t* s = (const uint8_t*) src;
+	if (n < 16) {
+		copy_small_sse2(d, s, n);
+		return dest;
+	}
+
+	// The first and last 16 bytes are loaded up front and stored last, so the loops below only have to store aligned blocks
+	__m128i head = _mm_loadu_si128((const __m128i*) s);
+	__m128i tail = _mm_loadu_si128((const __m128i*) (s + n - 16));
+	if (n > 32) {
+		if ((uintptr_t) d - (uintptr_t) s >= n) {
+			// Forwards, unless the destination starts inside of the source
+			if (n >= ERMS_THRESHOLD && s_has_erms)
+				return memcpy_erms(dest, src, n);
+			for (size_t i = 16 - ((uintptr_t) d & 15); i < n - 16; i += 16)
+				_mm_store_si128((__m128i*) (d + i), _mm_loadu_si128((const __m128i*) (s + i)));
+		} else {
+			for (size_t i = n - ((uintptr_t) (d + n) & 15); i > 16; i -= 16)
+				_mm_store_si128((__m128i*) (d + i - 16), _mm_loadu_si128((const __m128i*) (s + i - 16)));
+		}
+	}
+	_mm_storeu_si128((__m128i*) d, head);
+	_mm_storeu_si128((__m128i*) (d + n - 16), tail);
+	return dest;
+}
+
+__attribute__((target("sse2")))
+static void* memset_sse2(void* dest, int c, size_t n) {
+	uint8_t* d = (uint8_t*) dest;
+	if (n < 16) {
+		uint32_t word = (uint8_t) c * 0x01010101u;
+		if (n >= 4) {
+			*(unaligned_u32_t*) d = word;
+			*(unaligned_u32_t*) (d + n - 4) = word;
+			if (n >= 8) {
+				*(unaligned_u32_t*) (d + 4) = word;
+				*(unaligned_u32_t*) (d + n - 8) = word;
+			}
+		} else if (n) {
+			d[0] = c;
+			d[n / 2] = c;
+			d[n - 1] = c;
+		}
+		return dest;
+	}
+	if (n >= ERMS_THRESHOLD && s_has_erms)
+		return memset_erms(dest, c, n);
+
+	__m128i value = _mm_set1_epi8((char) c);
+	_mm_storeu_si128((__m128i*) d, value);
+	_mm_storeu_si128((__m128i*) (d + n - 16), value);
+	for (size_t i = 16 - ((uintptr_t) d & 15); i < n - 16; i += 16)
+		_mm_store_si128((__m128i*) (d + i), value);
+	return dest;
+}
+
+__attribute__((target("sse2")))
+static int memcmp_sse2(const void* a, const void* b, size_t n) {
+	const uint8_t* a8 = (const uint8_t*) a;
+	const uint8_t* b8 = (const uint8_t*) b;
+	for (; n >= 16; n -= 16, a8 += 16, b8 += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i*) a8);
+		__m128i vb = _mm_loadu_si128((const __m128i*) b8);
+		unsigned int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+		if (equal != 0xFFFF) {
+			int i = __builtin_ctz(~equal);
+			return a8[i] < b8[i] ? -1 : 1;
+		}
+	}
+	for (; n; n--, a8++, b8++) {
+		if (*a8 != *b8)
+			return *a8 < *b8 ? -1 : 1;
+	}
+	return 0;
+}
+
+__attribute__((target("sse2")))
+static int strcmp_sse2(const char* s1, const char* s2) {
+	const __m128i zero = _mm_setzero_si128();
+	for (;;) {
+		// Unaligned loads could cross into an unmapped page after the end of the string, so go byte by byte near the end of one
+		if (((uintptr_t) s1 & (PAGE_SIZE - 1)) > PAGE_SIZE - 16 || ((uintptr_t) s2 & (PAGE_SIZE - 1)) > PAGE_SIZE - 16) {
+			for (int i = 0; i < 16; i++, s1++, s2++) {
+				if (*s1 != *s2 || !*s1)
+					return *((const uint8_t*) s1) - *((const uint8_t*) s2);
+			}
+			continue;
+		}
+
+		__m128i a = _mm_loadu_si128((const __m128i*) s1);
+		__m128i b = _mm_loadu_si128((const __m128i*) s2);
+		unsigned int mask = (~_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) & 0xFFFF) | _mm_movemask_epi8(_mm_cmpeq_epi8(a, zero));
+		if (mask) {
+			int i = __builtin_ctz(mask);
+			return ((const uint8_t*) s1)[i] - ((const uint8_t*) s2)[i];
+		}
+		s1 += 16;
+		s2 += 16;
+	}
+}
+
+__attribute__((target("sse2")))
+static void* memchr_sse2(const void* s, int c, size_t n) {
+	if (!n)
+		return NULL;
+
+	// Aligned loads never cross into the next page, so it's safe to read a little before and after the buffer
+	const __m128i value = _mm_set1_epi8((char) c);
+	size_t offset = (uintptr_t) s & 15;
+	const uint8_t* p = (const uint8_t*) s - offset;
+	size_t remaining = n > SIZE_MAX - offset ? SIZE_MAX : n + offset;
+	unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*) p), value)) & (0xFFFF << offset);
+	for (;;) {
+		if (remaining <= 16) {
+			mask &= (1u << remaining) - 1;
+			return mask ? (void*) (p + __builtin_ctz(mask)) : NULL;
+		}
+		if (mask)
+			return (void*) (p + __builtin_ctz(mask));
+		p += 16;
+		remaining -= 16;
+		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*) p), value));
+	}
+}
+
+__attribute__((target("sse2")))
+static char* strchr_sse2(const char* s, int c) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i value = _mm_set1_epi8((char) c);
+	size_t offset = (uintptr_t) s & 15;
+	const char* p = s - offset;
+	__m128i chunk = _mm_load_si128((const __m128i*) p);
+	unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, zero), _mm_cmpeq_epi8(chunk, value))) & (0xFFFF << offset);
+	while (!mask) {
+		p += 16;
+		chunk = _mm_load_si128((const __m128i*) p);
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, zero), _mm_cmpeq_epi8(chunk, value)));
+	}
+	p += __builtin_ctz(mask);
+	return *p == (char) c ? (char*) p : NULL;
+}
+
+__attribute__((target("sse2")))
+static size_t strlen_sse2(const char* s) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t offset = (uintptr_t) s & 15;
+	const char* p = s - offset;
+	unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*) p), zero)) & (0xFFFF << offset);
+	while (!mask) {
+		p += 16;
+		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*) p), zero));
+	}
+	return p + __builtin_ctz(mask) - s;
+}
+
+//Dispatch
+
+static void* (*s_memcpy)(void*, const void*, size_t) = memcpy_words;
+static void* (*s_memmove)(void*, const void*, size_t) = memmove_words;
+static void* (*s_memset)(void*, int, size_t) = memset_words;
+static int (*s_memcmp)(const void*, const void*, size_t) = memcmp_words;
+static int (*s_strcmp)(const char*, const char*) = strcmp_bytes;
+static void* (*s_memchr)(const void*, int, size_t) = memchr_words;
+static char* (*s_strchr)(const char*, int) = strchr_words;
+static size_t (*s_strlen)(const char*) = strlen_words;
+
+__attribute__((constructor)) static void init_string_functions() {
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid_max(0, NULL) >= 7) {
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		s_has_erms = (ebx & CPUID_7_EBX_ERMS) != 0;
+	}
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2))
+		return;
+
+	// memmove's forward path is just as fast as a dedicated memcpy, so it's used for both
+	s_memcpy = memmove_sse2;
+	s_memmove = memmove_sse2;
+	s_memset = memset_sse2;
+	s_memcmp = memcmp_sse2;
+	s_strcmp = strcmp_sse2;
+	s_memchr = memchr_sse2;
+	s_strchr = strchr_sse2;
+	s_strlen = strlen_sse2;
+}
+
+//Memory manipulation
+
+void* memcpy(void* dest, const void* src, size_t n) {
+	return s_memcpy(dest, src, n);
+}
+
+void* memmove(void* dest, const void* src, size_t n) {
+	return s_memmove(dest, src, n);
+}
+
+void* memset(void* dest, int c, size_t n) {
+	return s_memset(dest, c, n);
+}
+
 //String manipulation
 
 char* strcpy(char* dest, const char* src) {
@@ -108,23 +456,11 @@ char* strndup(const char* s, size_t n) {
 //Comparison
 
 int memcmp(const void* a, const void* b, size_t n) {
-	uint8_t* a8 = (uint8_t*)a;
-	uint8_t* b8 = (uint8_t*)b;
-
-	for(size_t i = 0; i < n; i++) {
-		if(a8[i] != b8[i])
-			return a8[i] < b8[i] ? -1 : 1;
-	}
-
-	return 0;
+	return s_memcmp(a, b, n);
 }
 
 int strcmp(const char* s1, const char* s2) {
-	while(*s1 == *s2++) {
-		if(*s1++ == 0)
-			return 0;
-	}
-	return *((const uint8_t*)s1) - *((const uint8_t*)(s2 - 1));
+	return s_strcmp(s1, s2);
 }
 
 int strcoll(const char* s1, const char* s2) {
@@ -145,22 +481,11 @@ int strncmp(const char* s1, const char* s2, size_t n) {
 //Search
 
 void* memchr(const void* s, int c, size_t n) {
-	const char* sc = (const char*)s;
-	for(size_t i = 0; i < n; i++) {
-		if(sc[i] == (char)c)
-			return (void*) (&sc[i]);
-	}
-	return NULL;
+	return s_memchr(s, c, n);
 }
 
 char* strchr(const char* s, int c) {
-	for(;;) {
-		if(*s == (char)c)
-			return (char*) (s);
-		if(!*s)
-			return NULL;
-		s++;
-	}
+	return s_strchr(s, c);
 }
 
 size_t strcspn(const char* s1, const char* s2) {
@@ -300,7 +625,5 @@ char* strtok_r(char* s1, const char* s2, char** saved) {
 #include <kernel/api/strerror.c>
 
 size_t strlen(const char* str) {
-	const char *s;
-	for (s = str; *s; s++);
-	return (s - str);
+	return s_strlen(str);
 }
\ No newline at end of file
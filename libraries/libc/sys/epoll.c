@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "epoll.h"
+#include "syscall.h"
+#include <errno.h>
+
+int epoll_create1(int flags) {
+	return syscall2(SYS_EPOLL_CREATE, flags);
+}
+
+int epoll_create(int size) {
+	if(size <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	return epoll_create1(0);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event) {
+	struct epoll_ctl_args args = {
+		.epfd = epfd,
+		.op = op,
+		.fd = fd,
+		.event = event
+	};
+	return syscall2(SYS_EPOLL_CTL, (int) &args);
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int max_events, int timeout) {
+	struct epoll_wait_args args = {
+		.epfd = epfd,
+		.events = events,
+		.max_events = max_events,
+		.timeout = timeout
+	};
+	return syscall2(SYS_EPOLL_WAIT, (int) &args);
+}
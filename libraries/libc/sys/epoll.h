@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include <kernel/api/epoll.h>
+
+__DECL_BEGIN
+
+/**
+ * Creates an epoll instance, which reports which of a set of files are ready without having to pass the whole set on
+ * every call like poll() does.
+ * @param flags Either 0 or EPOLL_CLOEXEC.
+ * @return file descriptor on success, -1 on error (errno set).
+ */
+int epoll_create1(int flags);
+
+/**
+ * The same as epoll_create1(0). size is ignored, but must be positive.
+ */
+int epoll_create(int size);
+
+/**
+ * Adds, modifies, or removes a watched file.
+ * @param epfd The epoll instance.
+ * @param op EPOLL_CTL_ADD, EPOLL_CTL_MOD, or EPOLL_CTL_DEL.
+ * @param fd The file to watch.
+ * @param event The events to watch for (along with EPOLLET or EPOLLONESHOT) and the data to report them with.
+ * @return 0 on success, -1 on error (errno set).
+ */
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
+
+/**
+ * Waits for watched files to be ready.
+ * @param epfd The epoll instance.
+ * @param events The buffer to write the ready events to.
+ * @param max_events The most events to write.
+ * @param timeout How long to wait for, in milliseconds. -1 waits forever, and 0 doesn't wait at all.
+ * @return The number of events written, or -1 on error (errno set).
+ */
+int epoll_wait(int epfd, struct epoll_event* events, int max_events, int timeout);
+
+__DECL_END
@@ -35,5 +35,28 @@ int futex_trywait(futex_t* futex) {
 }
 
 void futex_signal(futex_t* futex) {
-	__atomic_fetch_add(futex, 1, __ATOMIC_ACQUIRE);
+	__atomic_fetch_add(futex, 1, __ATOMIC_RELEASE);
+	syscall4_noerr(SYS_FUTEX, (int) futex, FUTEX_WAKE, 1);
+}
+
+int futex_wait_value(futex_t* futex, int value, const struct timespec* timeout) {
+	struct futex_args args = {
+		.value = value,
+		.timeout = timeout
+	};
+	return syscall4(SYS_FUTEX, (int) futex, FUTEX_WAIT_VALUE, (int) &args);
+}
+
+int futex_wake(futex_t* futex, int count) {
+	return syscall4(SYS_FUTEX, (int) futex, FUTEX_WAKE, count);
+}
+
+int futex_requeue(futex_t* futex, int value, int wake_count, futex_t* futex2, int requeue_count) {
+	struct futex_args args = {
+		.value = value,
+		.count = wake_count,
+		.requeue_count = requeue_count,
+		.futex2 = futex2
+	};
+	return syscall4(SYS_FUTEX, (int) futex, FUTEX_REQUEUE, (int) &args);
 }
\ No newline at end of file
@@ -27,9 +27,38 @@ void futex_wait(futex_t* futex);
 int futex_trywait(futex_t* futex);
 
 /**
- * Adds one to the futex's stored value.
- * @param futex Poitner to the futex to signal.
+ * Adds one to the futex's stored value and wakes up a thread waiting on it.
+ * @param futex Pointer to the futex to signal.
  */
 void futex_signal(futex_t* futex);
 
+/**
+ * Blocks while the futex's stored value is equal to the given value, until woken by futex_wake().
+ * @param futex Pointer to the futex to wait on.
+ * @param value The value to wait on.
+ * @param timeout How long to wait for, or NULL to wait forever.
+ * @return 0 if woken, or -1 with errno set to EAGAIN if the value was different, ETIMEDOUT, or EINTR.
+ */
+int futex_wait_value(futex_t* futex, int value, const struct timespec* timeout);
+
+/**
+ * Wakes up threads waiting on a futex.
+ * @param futex Pointer to the futex.
+ * @param count The maximum number of threads to wake.
+ * @return The number of threads woken, or -1 on error (errno set).
+ */
+int futex_wake(futex_t* futex, int count);
+
+/**
+ * If the futex's stored value is equal to the given value, wakes up threads waiting on it and moves the rest to wait
+ * on another futex without waking them.
+ * @param futex Pointer to the futex.
+ * @param value The value the futex must have.
+ * @param wake_count The maximum number of threads to wake.
+ * @param futex2 Pointer to the futex to move the rest of the threads to.
+ * @param requeue_count The maximum number of threads to move.
+ * @return The number of threads woken and moved, or -1 with errno set to EAGAIN if the value was different.
+ */
+int futex_requeue(futex_t* futex, int value, int wake_count, futex_t* futex2, int requeue_count);
+
 __DECL_END
\ No newline at end of file
@@ -1,65 +0,0 @@
-/*
-	This file is part of nusaOS.
-
-	nusaOS is free software: you can redistribute it and/or modify
-	it under the terms of the GNU General Public License as published by
-	the Free Software Foundation, either version 3 of the License, or
-	(at your option) any later version.
-
-	nusaOS is distributed in the hope that it will be useful,
-	but WITHOUT ANY WARRANTY; without even the implied warranty of
-	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-	GNU General Public License for more details.
-
-	You should have received a copy of the GNU General Public License
-	along with nusaOS.  If not, see <https://www.gnu.org/licenses/>.
-
-	Copyright (c) Byteduck 2016-2021. All rights reserved.
-*/
-
-#ifndef NUSAOS_LIBC_LIBALLOC_H
-#define NUSAOS_LIBC_LIBALLOC_H
-
-/** \defgroup ALLOCHOOKS liballoc hooks
- *
- * These are the OS specific functions which need to
- * be implemented on any platform that the library
- * is expected to work on.
- */
-
-/** @{ */
-
-#include <stddef.h>
-#include <stdint.h>
-
-
-// If we are told to not define our own size_t, then we skip the define.
-//#define _HAVE_UINTPTR_T
-//typedef	unsigned long	uintptr_t;
-
-//This lets you prefix malloc and friends
-#define __NUSAOS_LIBALLOC_PREFIX(func) func
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-extern void		liballoc_lock();
-extern void		liballoc_unlock();
-extern void*	liballoc_alloc(int pages);
-extern void		liballoc_free(void* ptr, int pages);
-
-extern void    *__NUSAOS_LIBALLOC_PREFIX(malloc)(size_t);				///< The standard function.
-extern void    *__NUSAOS_LIBALLOC_PREFIX(realloc)(void *, size_t);		///< The standard function.
-extern void    *__NUSAOS_LIBALLOC_PREFIX(calloc)(size_t, size_t);		///< The standard function.
-extern void     __NUSAOS_LIBALLOC_PREFIX(free)(void *);					///< The standard function.
-
-
-#ifdef __cplusplus
-}
-#endif
-
-
-/** @} */
-
-#endif
\ No newline at end of file
@@ -0,0 +1,393 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "malloc.h"
+#include "mman.h"
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <libc/stdio.h>
+#include <sched.h>
+
+/*
+ * Small allocations come out of size classes, each of which is served from 64KiB spans that are carved into equal
+ * blocks. Spans are aligned to their size, so the span owning any pointer is found by masking off the low bits.
+ *
+ * The heap is striped across several caches, each with its own spans and lock. They aren't per-thread, since we
+ * don't have thread-local storage: the stripe a thread tries first is picked by hashing the address of its stack.
+ * Every thread's stack is a separate 1MiB mapping, so threads usually start on different stripes, but two can hash
+ * to the same one. When a stripe is locked, we try the others before waiting. A block freed by another thread goes
+ * back to the stripe that owns its span.
+ *
+ * Large allocations are mapped directly. Spans are mapped at an aligned address when possible, since the kernel can't
+ * unmap part of a mapping to trim the slack off of an oversized one. Empty spans are kept around for reuse, and only unmapped in batches once a
+ * cache collects too many of them.
+ */
+
+#define MALLOC_ALIGNMENT 16
+#define SPAN_SIZE (64 * 1024)
+#define SPAN_MASK (~((uintptr_t) SPAN_SIZE - 1))
+#define SPAN_HEADER_SIZE 64
+#define MAX_SMALL_SIZE 8192
+#define NUM_SIZE_CLASSES 32
+#define NUM_CACHES 16
+#define STACK_GRANULE (1024 * 1024)
+#define MAX_EMPTY_SPANS 8
+#define SPAN_MAGIC 0x5ba5ba5b
+#define LARGE_CLASS 0xFFFF
+#define LOCK_SPINS 64 // How long to spin on a locked cache before yielding
+
+struct Cache;
+
+struct FreeBlock {
+	FreeBlock* next;
+};
+
+struct Span {
+	uint32_t magic;
+	uint16_t size_class;
+	uint16_t in_list;
+	Cache* cache;
+	void* mapping;
+	size_t mapping_size;
+	size_t block_size; ///< For large allocations, the size requested.
+	size_t num_used;
+	FreeBlock* free_list;
+	char* bump; ///< The next block that has never been handed out, so untouched pages of the span stay unmapped.
+	char* end;
+	Span* prev;
+	Span* next;
+};
+
+static_assert(sizeof(Span) <= SPAN_HEADER_SIZE);
+
+struct Cache {
+	int lock;
+	Span* spans[NUM_SIZE_CLASSES]; ///< Spans with free blocks, for each size class.
+	Span* empty_spans;
+	int num_empty_spans;
+};
+
+// Zero-initialized, so that malloc works before static constructors run.
+static Cache s_caches[NUM_CACHES];
+
+/** Size classes **/
+
+static inline unsigned int size_class(size_t size) {
+	if(size <= 128)
+		return size ? (size - 1) / 16 : 0;
+	// Four classes for each power of two, i.e. 160, 192, 224, 256, 320...
+	unsigned int order = 31 - __builtin_clz(size - 1);
+	return 8 + (order - 7) * 4 + ((size - 1 - (1u << order)) >> (order - 2));
+}
+
+static inline size_t class_size(unsigned int size_class) {
+	if(size_class < 8)
+		return (size_class + 1) * 16;
+	unsigned int order = 7 + (size_class - 8) / 4;
+	return (1u << order) + ((size_class - 8) % 4 + 1) * (1u << (order - 2));
+}
+
+/** Locking **/
+
+static inline bool try_lock(Cache* cache) {
+	return !__atomic_exchange_n(&cache->lock, 1, __ATOMIC_ACQUIRE);
+}
+
+static inline void lock(Cache* cache) {
+	while(!try_lock(cache)) {
+		// Spin briefly in case the holder is about to finish, then yield, since it can't make progress while we spin
+		// on a single processor
+		for(int spins = 0; __atomic_load_n(&cache->lock, __ATOMIC_RELAXED); spins++) {
+			if(spins < LOCK_SPINS)
+				__builtin_ia32_pause();
+			else
+				sched_yield();
+		}
+	}
+}
+
+static inline void unlock(Cache* cache) {
+	__atomic_store_n(&cache->lock, 0, __ATOMIC_RELEASE);
+}
+
+static Cache* lock_stripe() {
+	auto index = ((uintptr_t) __builtin_frame_address(0) / STACK_GRANULE) % NUM_CACHES;
+	for(unsigned i = 0; i < NUM_CACHES; i++) {
+		auto* cache = &s_caches[(index + i) % NUM_CACHES];
+		if(try_lock(cache))
+			return cache;
+	}
+	lock(&s_caches[index]);
+	return &s_caches[index];
+}
+
+/** Spans **/
+
+static Span* map_span(size_t size, Cache* cache) {
+	size_t mapping_size = (size + PAGE_SIZE - 1) & ~((size_t) PAGE_SIZE - 1);
+	void* mapping = mmap_named(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS, 0, 0, "heap");
+	if(mapping == MAP_FAILED)
+		return NULL;
+
+	// mmap only guarantees page alignment. Mappings are placed first-fit, so if this one isn't aligned, the next
+	// aligned address after it is usually free. MAP_FIXED fails instead of replacing anything that's already there.
+	if((uintptr_t) mapping & ~SPAN_MASK) {
+		munmap(mapping, mapping_size);
+		void* aligned = (void*) (((uintptr_t) mapping + SPAN_SIZE - 1) & SPAN_MASK);
+		mapping = mmap_named(aligned, mapping_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_FIXED, 0, 0, "heap");
+		if(mapping != aligned) {
+			// Otherwise, map enough extra to find an aligned span inside, at the cost of the slack around it.
+			if(mapping != MAP_FAILED)
+				munmap(mapping, mapping_size);
+			mapping_size = (size + SPAN_SIZE - PAGE_SIZE + PAGE_SIZE - 1) & ~((size_t) PAGE_SIZE - 1);
+			mapping = mmap_named(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS, 0, 0, "heap");
+			if(mapping == MAP_FAILED)
+				return NULL;
+		}
+	}
+
+	auto* span = (Span*) (((uintptr_t) mapping + SPAN_SIZE - 1) & SPAN_MASK);
+	span->magic = SPAN_MAGIC;
+	span->cache = cache;
+	span->mapping = mapping;
+	span->mapping_size = mapping_size;
+	return span;
+}
+
+static void unmap_span(Span* span) {
+	span->magic = 0;
+	if(munmap(span->mapping, span->mapping_size) < 0)
+		fprintf(stderr, "WARNING: FAILED TO MEMRELEASE A MALLOC'D REGION");
+}
+
+static inline void link_span(Span*& head, Span* span) {
+	span->prev = NULL;
+	span->next = head;
+	if(head)
+		head->prev = span;
+	head = span;
+	span->in_list = 1;
+}
+
+static inline void unlink_span(Span*& head, Span* span) {
+	if(span->prev)
+		span->prev->next = span->next;
+	else
+		head = span->next;
+	if(span->next)
+		span->next->prev = span->prev;
+	span->in_list = 0;
+}
+
+static Span* alloc_span(Cache* cache, unsigned int size_class) {
+	Span* span = cache->empty_spans;
+	if(span) {
+		unlink_span(cache->empty_spans, span);
+		cache->num_empty_spans--;
+	} else {
+		span = map_span(SPAN_SIZE, cache);
+		if(!span)
+			return NULL;
+	}
+
+	span->size_class = size_class;
+	span->block_size = class_size(size_class);
+	span->num_used = 0;
+	span->free_list = NULL;
+	span->bump = (char*) span + SPAN_HEADER_SIZE;
+	span->end = span->bump + ((SPAN_SIZE - SPAN_HEADER_SIZE) / span->block_size) * span->block_size;
+	link_span(cache->spans[size_class], span);
+	return span;
+}
+
+static void retire_span(Cache* cache, Span* span) {
+	unlink_span(cache->spans[span->size_class], span);
+	link_span(cache->empty_spans, span);
+	if(++cache->num_empty_spans <= MAX_EMPTY_SPANS)
+		return;
+
+	// Give half of the empty spans back to the kernel at once, so that we don't unmap and remap on every free
+	while(cache->num_empty_spans > MAX_EMPTY_SPANS / 2) {
+		Span* victim = cache->empty_spans;
+		unlink_span(cache->empty_spans, victim);
+		cache->num_empty_spans--;
+		unmap_span(victim);
+	}
+}
+
+static inline Span* span_of(void* ptr) {
+	auto* span = (Span*) ((uintptr_t) ptr & SPAN_MASK);
+	if(span->magic != SPAN_MAGIC) {
+		fprintf(stderr, "WARNING: free() or realloc() called on invalid pointer %p\n", ptr);
+		return NULL;
+	}
+	return span;
+}
+
+/** Small allocations **/
+
+static void* alloc_small(size_t size) {
+	unsigned int cls = size_class(size);
+	Cache* cache = lock_stripe();
+
+	Span* span = cache->spans[cls];
+	if(!span && !(span = alloc_span(cache, cls))) {
+		unlock(cache);
+		return NULL;
+	}
+
+	void* block;
+	if(span->free_list) {
+		block = span->free_list;
+		span->free_list = span->free_list->next;
+	} else {
+		block = span->bump;
+		span->bump += span->block_size;
+	}
+
+	// Full spans are taken out of the list, and put back once something in them is freed
+	span->num_used++;
+	if(!span->free_list && span->bump == span->end)
+		unlink_span(cache->spans[cls], span);
+
+	unlock(cache);
+	return block;
+}
+
+static void free_small(Span* span, void* ptr) {
+	// The pointer might be in the middle of a block if it came from memalign
+	char* data = (char*) span + SPAN_HEADER_SIZE;
+	auto* block = (FreeBlock*) (data + (((char*) ptr - data) / span->block_size) * span->block_size);
+
+	Cache* cache = span->cache;
+	lock(cache);
+	block->next = span->free_list;
+	span->free_list = block;
+	if(!span->in_list)
+		link_span(cache->spans[span->size_class], span);
+	// Keep the only span of a size class around even when empty, so that alternating malloc and free doesn't churn
+	if(!--span->num_used && (span->prev || span->next))
+		retire_span(cache, span);
+	unlock(cache);
+}
+
+/** Large allocations **/
+
+static void* alloc_large(size_t size) {
+	if(size > SIZE_MAX - SPAN_SIZE * 2)
+		return NULL;
+	Span* span = map_span(SPAN_HEADER_SIZE + size, NULL);
+	if(!span)
+		return NULL;
+	span->size_class = LARGE_CLASS;
+	span->block_size = size;
+	return (char*) span + SPAN_HEADER_SIZE;
+}
+
+static inline size_t usable_size(Span* span, void* ptr) {
+	char* data = (char*) span + SPAN_HEADER_SIZE;
+	if(span->size_class == LARGE_CLASS)
+		return span->block_size - ((char*) ptr - data);
+	return span->block_size - ((char*) ptr - data) % span->block_size;
+}
+
+/** Public functions **/
+
+void* malloc(size_t size) {
+	void* ret = size <= MAX_SMALL_SIZE ? alloc_small(size) : alloc_large(size);
+	if(!ret)
+		errno = ENOMEM;
+	return ret;
+}
+
+void free(void* ptr) {
+	if(!ptr)
+		return;
+	Span* span = span_of(ptr);
+	if(!span)
+		return;
+	if(span->size_class == LARGE_CLASS)
+		unmap_span(span);
+	else
+		free_small(span, ptr);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+	size_t total;
+	if(__builtin_mul_overflow(nmemb, size, &total)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	void* ret = malloc(total);
+	// Large allocations are freshly mapped, so they're already zeroed
+	if(ret && total <= MAX_SMALL_SIZE)
+		memset(ret, 0, total);
+	return ret;
+}
+
+void* realloc(void* ptr, size_t size) {
+	if(!ptr)
+		return malloc(size);
+	if(!size) {
+		free(ptr);
+		return NULL;
+	}
+
+	Span* span = span_of(ptr);
+	if(!span)
+		return NULL;
+	size_t old_size = usable_size(span, ptr);
+	if(size <= old_size && (span->size_class == LARGE_CLASS ? size > MAX_SMALL_SIZE : size > old_size / 2))
+		return ptr;
+
+	void* ret = malloc(size);
+	if(!ret)
+		return NULL;
+	memcpy(ret, ptr, old_size < size ? old_size : size);
+	free(ptr);
+	return ret;
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+	if(!alignment || (alignment & (alignment - 1)) || alignment % sizeof(void*) || alignment > SPAN_SIZE / 2)
+		return EINVAL;
+	if(alignment <= MALLOC_ALIGNMENT) {
+		*memptr = malloc(size);
+		return *memptr ? 0 : ENOMEM;
+	}
+
+	// Allocate enough to align within the block. free() finds the start of the block again from the span, which is
+	// why the alignment is limited: the aligned pointer has to stay within the first SPAN_SIZE bytes of a large one.
+	// The aligned pointer must be inside the block even for a zero size, or free() would find the next block.
+	if(!size)
+		size = 1;
+	if(size > SIZE_MAX - alignment)
+		return ENOMEM;
+	void* ptr = malloc(size + alignment - MALLOC_ALIGNMENT);
+	if(!ptr)
+		return ENOMEM;
+	*memptr = (void*) (((uintptr_t) ptr + alignment - 1) & ~(alignment - 1));
+	return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	void* ret;
+	int err = posix_memalign(&ret, alignment, size);
+	if(err) {
+		errno = err;
+		return NULL;
+	}
+	return ret;
+}
+
+void* memalign(size_t alignment, size_t size) {
+	return aligned_alloc(alignment, size);
+}
+
+size_t malloc_usable_size(void* ptr) {
+	if(!ptr)
+		return 0;
+	Span* span = span_of(ptr);
+	return span ? usable_size(span, ptr) : 0;
+}
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <stddef.h>
+#include <sys/cdefs.h>
+
+__DECL_BEGIN
+
+void* malloc(size_t size);
+void* realloc(void* ptr, size_t size);
+void* calloc(size_t nmemb, size_t size);
+void free(void* ptr);
+
+/**
+ * Allocates memory aligned to a power of two no larger than 32KiB.
+ * @return 0 on success, EINVAL if the alignment is invalid, or ENOMEM.
+ */
+int posix_memalign(void** memptr, size_t alignment, size_t size);
+void* aligned_alloc(size_t alignment, size_t size);
+void* memalign(size_t alignment, size_t size);
+
+/** Returns the number of bytes that can actually be used in an allocation, which may be more than requested. **/
+size_t malloc_usable_size(void* ptr);
+
+__DECL_END
@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "profile.h"
+#include "syscall.h"
+
+int profile_open(pid_t pid, unsigned int frequency, size_t buffer_size) {
+	struct profile_args args = {
+		.pid = pid,
+		.frequency = frequency,
+		.buffer_size = buffer_size
+	};
+	return syscall2(SYS_PROFILE, (int) &args);
+}
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include <kernel/api/profile.h>
+
+__DECL_BEGIN
+
+/**
+ * Starts sampling the stacks of a process (or every process) from the timer interrupt. The samples are written to a
+ * ring buffer, which is mapped by calling mmap() with MAP_SHARED on the returned file descriptor. Sampling stops
+ * once the file descriptor is closed. Only root may profile.
+ * @param pid The process to profile, or PROFILE_ALL_PROCESSES.
+ * @param frequency The number of samples to take per second.
+ * @param buffer_size The size of the ring buffer in bytes, not including its header page.
+ * @return file descriptor on success, -1 on error (errno set).
+ */
+int profile_open(pid_t pid, unsigned int frequency, size_t buffer_size);
+
+__DECL_END
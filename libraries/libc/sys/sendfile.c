@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "sendfile.h"
+#include "syscall.h"
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+	struct sendfile_args args = {
+		.out_fd = out_fd,
+		.in_fd = in_fd,
+		.offset = offset,
+		.count = count
+	};
+	return syscall2(SYS_SENDFILE, (int) &args);
+}
+
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags) {
+	struct splice_args args = {
+		.fd_in = fd_in,
+		.off_in = off_in,
+		.fd_out = fd_out,
+		.off_out = off_out,
+		.len = len,
+		.flags = flags
+	};
+	return syscall2(SYS_SPLICE, (int) &args);
+}
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+#include <kernel/api/sendfile.h>
+
+__DECL_BEGIN
+
+/**
+ * Copies data from one file to another inside the kernel, without reading it into a userspace buffer first.
+ * @param out_fd The file to write to. This can be a file, a pipe, or a socket.
+ * @param in_fd The file to read from.
+ * @param offset If not null, where in in_fd to start reading. It's updated to just past the last byte read, and in_fd's
+ *               own offset is left alone. If null, in_fd's offset is used and updated.
+ * @param count The most bytes to copy.
+ * @return The number of bytes copied, or -1 on error (errno set).
+ */
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+/**
+ * Like sendfile(), but either side can have an explicit offset. Unlike on Linux, neither side has to be a pipe.
+ * @param fd_in The file to read from.
+ * @param off_in If not null, where in fd_in to read from (updated afterwards) instead of its own offset.
+ * @param fd_out The file to write to.
+ * @param off_out If not null, where in fd_out to write to (updated afterwards) instead of its own offset.
+ * @param len The most bytes to copy.
+ * @param flags Any of the SPLICE_F_* flags, which are accepted but ignored.
+ * @return The number of bytes copied, or -1 on error (errno set).
+ */
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t len, unsigned int flags);
+
+__DECL_END
@@ -43,6 +43,11 @@ ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags) {
 	return syscall4(SYS_SENDMSG, sockfd, (int) msg, flags);
 }
 
+int sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags) {
+	struct mmsg_args args = { sockfd, msgvec, vlen, flags };
+	return syscall2(SYS_SENDMMSG, (int) &args);
+}
+
 ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
 	return recvfrom(sockfd, buf, len, flags, NULL, NULL);
 }
@@ -65,6 +70,16 @@ ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
 	return syscall4(SYS_RECVMSG, sockfd, (int) msg, flags);
 }
 
+int recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout) {
+	// TODO: Timeouts. Use poll() first, or MSG_WAITFORONE to only wait for the first message.
+	if (timeout) {
+		errno = EINVAL;
+		return -1;
+	}
+	struct mmsg_args args = { sockfd, msgvec, vlen, flags };
+	return syscall2(SYS_RECVMMSG, (int) &args);
+}
+
 int listen(int sockfd, int backlog) {
 	return syscall3(SYS_LISTEN, sockfd, backlog);
 }
@@ -9,6 +9,8 @@
 #include "un.h"
 
 __DECL_BEGIN
+struct timespec;
+
 int socket(int domain, int type, int protocol);
 int bind(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 int connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
@@ -17,9 +19,11 @@ int getsockopt(int sockfd, int level, int option, void* option_value, socklen_t*
 ssize_t send(int sockfd, const void *buf, size_t len, int flags);
 ssize_t sendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
 ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags);
+int sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 ssize_t recv(int sockfd, void *buf, size_t len, int flags);
 ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
 ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags);
+int recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags, struct timespec *timeout);
 int listen(int sockfd, int backlog);
 int shutdown(int sockfd, int how);
 int accept(int sockfd, struct sockaddr* addr, socklen_t* addrlen);
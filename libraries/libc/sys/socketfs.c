@@ -33,6 +33,8 @@ struct socketfs_packet* read_packet(int fd) {
 	ret->sender = packet_header.sender;
 	ret->sender_pid = packet_header.sender_pid;
 	ret->length = packet_header.length;
+	ret->shm_id = packet_header.shm_id;
+	ret->shm_perms = packet_header.shm_perms;
 
 	if(packet_header.length) {
 		if(read(fd, ret->data, packet_header.length) < 0) {
@@ -44,15 +46,23 @@ struct socketfs_packet* read_packet(int fd) {
 	return ret;
 }
 
+ssize_t read_packets(int fd, void* buf, size_t size) {
+	return read(fd, buf, size);
+}
+
+ssize_t write_packets(int fd, const void* buf, size_t size) {
+	return write(fd, buf, size);
+}
+
 int write_packet_of_type(int fd, int type, sockid_t id, int shm_id, int shm_perms, size_t length, void* data) {
 	struct socketfs_packet* packet = malloc(sizeof(struct socketfs_packet) + length);
-	packet->type = SOCKETFS_TYPE_MSG;
+	packet->type = type;
 	packet->recipient = id;
 	packet->length = length;
 	packet->shm_id = shm_id;
 	packet->shm_perms = shm_perms;
 	memcpy(packet->data, data, length);
-	int ret = write(fd, packet, length);
+	int ret = write(fd, packet, sizeof(struct socketfs_packet) + length);
 	free(packet);
-	return ret;
+	return ret < 0 ? -1 : 0;
 }
\ No newline at end of file
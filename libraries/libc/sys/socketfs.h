@@ -21,6 +21,7 @@
 #define NUSAOS_LIBC_SOCKETFS_H
 
 #include <sys/types.h>
+#include <stddef.h>
 #include <kernel/filesystem/socketfs/socketfs_defines.h>
 
 struct socketfs_packet {
@@ -48,8 +49,38 @@ struct socketfs_packet {
 
 __DECL_BEGIN
 
+/**
+ * Reads a single packet from a socket. The returned packet must be freed with free().
+ */
 struct socketfs_packet* read_packet(int fd);
 
+/**
+ * Reads as many whole packets as fit into buf at once. The packets are laid out back to back with no padding, and can
+ * be stepped through with socketfs_next_packet(). Reading packets one at a time with read_packet() and in batches with
+ * read_packets() shouldn't be mixed on the same file descriptor.
+ * @return The number of bytes read, or -1 on error.
+ */
+ssize_t read_packets(int fd, void* buf, size_t size);
+
+/**
+ * Writes several packets laid out back to back (see read_packets()) with a single call.
+ * @return The number of bytes sent, which is less than size if only some of the packets were, or -1 on error.
+ */
+ssize_t write_packets(int fd, const void* buf, size_t size);
+
+/**
+ * Gets the packet after the given one in a buffer filled by read_packets(), or NULL if it's the last one.
+ */
+inline struct socketfs_packet* socketfs_next_packet(struct socketfs_packet* packet, void* buf, size_t size) {
+	size_t offset = ((uint8_t*) packet - (uint8_t*) buf) + sizeof(struct socketfs_packet) + packet->length;
+	if(offset + sizeof(struct socketfs_packet) > size)
+		return NULL;
+	struct socketfs_packet* next = (struct socketfs_packet*) ((uint8_t*) buf + offset);
+	if(offset + sizeof(struct socketfs_packet) + next->length > size)
+		return NULL;
+	return next;
+}
+
 int write_packet_of_type(int fd, int type, sockid_t id, int shm_id, int shm_perms, size_t length, void* data);
 
 inline int write_packet(int fd, sockid_t id, size_t length, void* data) {
@@ -19,6 +19,13 @@ Result LiveDebugger::attach(pid_t pid, tid_t tid) {
 	return Result::SUCCESS;
 }
 
+Result LiveDebugger::inspect(pid_t pid) {
+	m_pid = pid;
+	m_tid = 0;
+	TRYRES(reload_process_info());
+	return Result::SUCCESS;
+}
+
 ResultRet<uintptr_t> Debug::LiveDebugger::peek(size_t addr) {
 	if (!m_pid || !m_tid)
 		return Result("Not attached");
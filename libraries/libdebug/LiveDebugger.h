@@ -9,6 +9,9 @@ namespace Debug {
 	class LiveDebugger: public Debugger {
 	public:
 		Duck::Result attach(pid_t pid, tid_t tid);
+		/// Loads the memory map of a process so that addresses in it can be symbolicated, without attaching to it.
+		/// Anything that needs to read the process (peek, poke, get_registers) won't work.
+		Duck::Result inspect(pid_t pid);
 
 		// Debugger
 		Duck::ResultRet<uintptr_t> peek(size_t addr) override;
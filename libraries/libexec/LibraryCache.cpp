@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "LibraryCache.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <kernel/api/page_size.h>
+
+using namespace Exec;
+
+static bool in_bounds(size_t offset, size_t count, size_t item_size, size_t total) {
+	return offset <= total && count <= (total - offset) / item_size;
+}
+
+LibraryCache* LibraryCache::open(const char* path) {
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return nullptr;
+
+	struct stat statbuf;
+	if(fstat(fd, &statbuf) < 0 || (size_t) statbuf.st_size < sizeof(ld_cache_header)) {
+		close(fd);
+		return nullptr;
+	}
+
+	size_t size = statbuf.st_size;
+	auto* mapped = (uint8_t*) mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	if(mapped == MAP_FAILED) {
+		close(fd);
+		return nullptr;
+	}
+
+	//Make sure everything in the cache is in bounds, since we're going to trust it when loading libraries
+	auto* header = (const ld_cache_header*) mapped;
+	bool valid = header->magic == LD_CACHE_MAGIC && header->version == LD_CACHE_VERSION
+			&& in_bounds(header->entries_offset, header->num_entries, sizeof(ld_cache_entry), size)
+			&& in_bounds(header->strings_offset, header->strings_size, 1, size)
+			&& header->strings_size && mapped[header->strings_offset + header->strings_size - 1] == '\0';
+
+	for(size_t i = 0; valid && i < header->num_entries; i++) {
+		auto& entry = ((const ld_cache_entry*) (mapped + header->entries_offset))[i];
+		valid = entry.path < header->strings_size
+				&& (!entry.image_size || (entry.base % PAGE_SIZE == 0 && entry.base >= LD_CACHE_BASE
+					&& entry.image_size <= LD_CACHE_LIMIT - entry.base))
+				&& entry.image_offset % PAGE_SIZE == 0 && in_bounds(entry.image_offset, entry.image_size, 1, size)
+				&& in_bounds(entry.rels_offset, entry.num_rels, sizeof(elf32_rela), size)
+				&& in_bounds(entry.deps_offset, entry.num_deps, sizeof(uint32_t), size);
+		auto* deps = (const uint32_t*) (mapped + entry.deps_offset);
+		for(size_t dep = 0; valid && dep < entry.num_deps; dep++)
+			valid = deps[dep] < header->num_entries;
+	}
+
+	if(!valid) {
+		munmap(mapped, size);
+		close(fd);
+		return nullptr;
+	}
+
+	return new LibraryCache(fd, mapped, size);
+}
+
+LibraryCache::LibraryCache(int fd, uint8_t* mapped, size_t size):
+	m_fd(fd),
+	m_mapped(mapped),
+	m_size(size),
+	m_header((const ld_cache_header*) mapped),
+	m_entries((const ld_cache_entry*) (mapped + m_header->entries_offset)),
+	m_strings((const char*) (mapped + m_header->strings_offset))
+{}
+
+LibraryCache::~LibraryCache() {
+	munmap(m_mapped, m_size);
+	close(m_fd);
+}
+
+const ld_cache_entry* LibraryCache::find(const char* path, const struct stat& stat) const {
+	for(size_t i = 0; i < num_entries(); i++) {
+		auto& entry = m_entries[i];
+		if(strcmp(string(entry.path), path))
+			continue;
+		if(!entry.image_size || !is_current(entry, stat))
+			return nullptr;
+		return &entry;
+	}
+	return nullptr;
+}
+
+bool LibraryCache::is_current(const ld_cache_entry& entry, const struct stat& stat) {
+	return entry.inode == stat.st_ino && entry.size == (uint32_t) stat.st_size && entry.mtime == (uint32_t) stat.st_mtime;
+}
+
+const elf32_rela* LibraryCache::relocations(const ld_cache_entry& entry) const {
+	return (const elf32_rela*) (m_mapped + entry.rels_offset);
+}
+
+const uint32_t* LibraryCache::dependencies(const ld_cache_entry& entry) const {
+	return (const uint32_t*) (m_mapped + entry.deps_offset);
+}
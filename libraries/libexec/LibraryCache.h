@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <cstddef>
+#include <sys/stat.h>
+#include "elf.h"
+
+#define LD_CACHE_PATH "/etc/ld.cache"
+#define LD_CACHE_MAGIC 0x48434c44 // 'LDCH'
+#define LD_CACHE_VERSION 1
+
+// Prelinked libraries are given addresses in this range. Userspace spans PAGE_SIZE to HIGHER_HALF (0xC0000000):
+// executables and libraries that aren't prelinked are placed right after the executable, other mappings are
+// allocated first-fit from the bottom, and thread stacks are allocated downwards from the top. This range sits
+// between the two and isn't reserved, so if part of a library's range is taken, it's just loaded normally instead.
+#define LD_CACHE_BASE 0x80000000
+#define LD_CACHE_LIMIT 0xA0000000
+
+namespace Exec {
+	/**
+	 * The library cache written by ldconfig holds an image of each system library that has already been relocated
+	 * for a fixed address. If a library can be mapped at its address, the loader maps its image straight from the
+	 * cache, so its read-only pages are shared between every process using it and its relocations don't have to be
+	 * done again.
+	 *
+	 * Each image is relocated against the library's own dependencies. The symbolic relocations are kept alongside
+	 * it with their addends, so that they can be redone if a symbol is interposed by something outside of those
+	 * dependencies (usually the executable itself) or if the dependencies aren't all prelinked at runtime.
+	 */
+	struct ld_cache_header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t num_entries;
+		uint32_t entries_offset;
+		uint32_t strings_offset;
+		uint32_t strings_size;
+	};
+
+	struct ld_cache_entry {
+		uint32_t path; ///< Offset of the path of the library in the string table.
+		uint32_t base; ///< The address the image was relocated for.
+		uint32_t image_size; ///< The size of the image, a multiple of the page size. 0 if it couldn't be prelinked.
+		uint32_t image_offset; ///< Offset of the image in the cache, page aligned.
+		uint32_t rels_offset; ///< Offset of the symbolic relocations (elf32_rela) in the cache.
+		uint32_t num_rels;
+		uint32_t deps_offset; ///< Offset of the indices of the entries the library was relocated against.
+		uint32_t num_deps;
+		// The library file the image was made from, to tell if the image is stale
+		uint32_t inode;
+		uint32_t size;
+		uint32_t mtime;
+	};
+
+	class LibraryCache {
+	public:
+		/** Opens and maps the cache. Returns nullptr if it doesn't exist or isn't valid. **/
+		static LibraryCache* open(const char* path = LD_CACHE_PATH);
+		~LibraryCache();
+
+		/**
+		 * Finds the entry for a library, if its image is up to date.
+		 * @param path The path of the library.
+		 * @param stat The result of stat()ing the library.
+		 * @return The entry, or nullptr if there isn't an up-to-date one.
+		 */
+		const ld_cache_entry* find(const char* path, const struct stat& stat) const;
+
+		/** Whether an entry was made from the library file as it is now. **/
+		static bool is_current(const ld_cache_entry& entry, const struct stat& stat);
+
+		size_t num_entries() const { return m_header->num_entries; }
+		const ld_cache_entry& entry(size_t index) const { return m_entries[index]; }
+		const char* string(uint32_t offset) const { return m_strings + offset; }
+		const elf32_rela* relocations(const ld_cache_entry& entry) const;
+		const uint32_t* dependencies(const ld_cache_entry& entry) const;
+		int fd() const { return m_fd; }
+
+	private:
+		LibraryCache(int fd, uint8_t* mapped, size_t size);
+
+		int m_fd;
+		uint8_t* m_mapped;
+		size_t m_size;
+		const ld_cache_header* m_header;
+		const ld_cache_entry* m_entries;
+		const char* m_strings;
+	};
+}
@@ -21,6 +21,15 @@ Loader::Loader(std::string main_executable):
 	m_global_symbols["__dlopen"] = (uintptr_t) __dlopen;
 	m_global_symbols["__dlclose"] = (uintptr_t) __dlclose;
 	m_global_symbols["__dlsym"] = (uintptr_t) __dlsym;
+
+	//PLT slots are bound the first time they're called unless LD_BIND_NOW is set
+	auto* bind_now_env = getenv("LD_BIND_NOW");
+	m_bind_now = bind_now_env && *bind_now_env;
+
+	//Libraries are mapped prelinked from the library cache when possible, unless LD_IGNORE_CACHE is set
+	auto* ignore_cache_env = getenv("LD_IGNORE_CACHE");
+	if(!ignore_cache_env || !*ignore_cache_env)
+		m_cache = LibraryCache::open();
 }
 
 Loader* Loader::main() {
@@ -34,6 +43,7 @@ void Loader::set_main(Exec::Loader* loader) {
 Duck::Result Loader::load() {
 	m_executable = new Object();
 	m_objects[m_main_executable] = m_executable;
+	m_search_order.push_back(m_executable);
 
 	//Open the executable
 	m_executable->fd  = open(m_main_executable.c_str(), O_RDONLY);
@@ -55,16 +65,8 @@ Duck::Result Loader::load() {
 	if(m_executable->load(*this, m_main_executable.c_str()) < 0)
 		return errno;
 
-	//Read the symbols from the libraries and executable
-	auto rev_it = m_objects.rbegin();
-	while(rev_it != m_objects.rend()) {
-		auto* object = rev_it->second;
-		object->read_symbols(*this);
-		rev_it++;
-	}
-
 	//Relocate the libraries and executable
-	rev_it = m_objects.rbegin();
+	auto rev_it = m_objects.rbegin();
 	while(rev_it != m_objects.rend()) {
 		auto* object = rev_it->second;
 		object->relocate(*this);
@@ -73,9 +75,9 @@ Duck::Result Loader::load() {
 	}
 
 	// Call __init_stdio for libc.so before any other initializer
-	if(m_symbols["__init_stdio"] != 0) {
-		((void(*)()) m_symbols["__init_stdio"])();
-	}
+	auto init_stdio = get_symbol("__init_stdio");
+	if(init_stdio)
+		((void(*)()) init_stdio)();
 
 	//Call the initializer methods for the libraries and executable
 	rev_it = m_objects.rbegin();
@@ -115,6 +117,8 @@ size_t Loader::get_memloc_for(Object* object) {
 		size_t alloc_size = ((object->memsz + (object->calculated_base - alloc_start) + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
 		m_current_brk = alloc_start + alloc_size;
 		return 0;
+	} else if(object->cache_entry) {
+		return object->cache_entry->base;
 	} else {
 		size_t alloc_size = ((object->memsz + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
 		m_current_brk += alloc_size;
@@ -123,6 +127,8 @@ size_t Loader::get_memloc_for(Object* object) {
 }
 
 Object* Loader::open_library(const char* library_name) {
+	LOCK(m_lock);
+
 	//If it's already loaded, just return the loaded one
 	if(m_objects.find(library_name) != m_objects.end()) {
 		return m_objects[library_name];
@@ -149,10 +155,13 @@ Object* Loader::open_library(const char* library_name) {
 	//Add it to the objects map
 	auto* object = new Object();
 	m_objects[library_name] = object;
+	m_search_order.push_back(object);
 	object->fd = fd;
 	object->name = library_name;
 	object->mapped_file = (uint8_t*) mapped_file;
 	object->mapped_size = mapped_size;
+	if(m_cache)
+		object->cache_entry = m_cache->find(library_loc.c_str(), statbuf);
 
 	return object;
 }
@@ -181,10 +190,6 @@ std::string Loader::find_library(const char* library_name) {
 	return "";
 }
 
-void Loader::set_global_symbol(const char* name, size_t loc) {
-	m_global_symbols[name] = loc;
-}
-
 uintptr_t Loader::get_global_symbol(const char* name) {
 	auto s = m_global_symbols.find(name);
 	if (s == m_global_symbols.end())
@@ -192,13 +197,14 @@ uintptr_t Loader::get_global_symbol(const char* name) {
 	return s->second;
 }
 
-void Loader::set_symbol(const char* name, uintptr_t loc) {
-	m_symbols[name] = loc;
-}
-
-uintptr_t Loader::get_symbol(const char* name) {
-	auto s = m_symbols.find(name);
-	if (s == m_symbols.end())
-		return 0;
-	return s->second;
+uintptr_t Loader::get_symbol(const char* name, Object* skip) {
+	SymbolName symbol_name(name);
+	LOCK(m_lock);
+	for(auto* object : m_search_order) {
+		if(object == skip)
+			continue;
+		if(auto* symbol = object->lookup_symbol(symbol_name))
+			return object->symbol_address(*symbol);
+	}
+	return get_global_symbol(name);
 }
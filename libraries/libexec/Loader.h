@@ -3,11 +3,12 @@
 
 #pragma once
 
-#include <unordered_map>
 #include "Object.h"
 #include <map>
 #include <string>
+#include <vector>
 #include <libnusa/Result.h>
+#include <libnusa/SpinLock.h>
 
 namespace Exec {
 	class Loader {
@@ -23,22 +24,37 @@ namespace Exec {
 		std::string find_library(const char* library_name);
 		Object* main_executable() const;
 
-		void set_global_symbol(const char* name, uintptr_t loc);
+		/** Gets a symbol provided by the loader itself, such as __dlopen. **/
 		uintptr_t get_global_symbol(const char* name);
-		void set_symbol(const char* name, uintptr_t loc);
-		uintptr_t get_symbol(const char* name);
+
+		/**
+		 * Looks up a symbol in every loaded object in load order, starting with the executable, and then in the
+		 * symbols provided by the loader.
+		 * @param name The name of the symbol.
+		 * @param skip An object whose definition should be ignored, or nullptr.
+		 * @return The address of the symbol, or 0 if it isn't defined anywhere.
+		 */
+		uintptr_t get_symbol(const char* name, Object* skip = nullptr);
+
+		/** The loaded objects, in the order symbols are looked up in. **/
+		const std::vector<Object*>& objects() const { return m_search_order; }
+		LibraryCache* cache() const { return m_cache; }
 
 		bool debug_mode() const { return m_debug; }
+		bool bind_now() const { return m_bind_now; }
 
 	private:
 		static Loader* s_main_loader;
 
 		std::string m_main_executable;
-		std::unordered_map<std::string, uintptr_t> m_global_symbols;
-		std::unordered_map<std::string, uintptr_t> m_symbols;
+		std::map<std::string, uintptr_t, std::less<>> m_global_symbols;
 		std::map<std::string, Object*> m_objects;
+		std::vector<Object*> m_search_order;
+		Duck::SpinLock m_lock; /* Protects m_objects and m_search_order, since PLT slots can be bound during a dlopen. */
+		LibraryCache* m_cache = nullptr;
 		size_t m_current_brk = 0;
 		bool m_debug = false;
+		bool m_bind_now = false;
 		Object* m_executable;
 	};
 }
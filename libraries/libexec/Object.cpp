@@ -6,11 +6,35 @@
 #include <libnusa/Log.h>
 #include <map>
 #include <sys/mman.h>
+#include <unistd.h>
 #include "Loader.h"
 
 using Duck::Log;
 using namespace Exec;
 
+extern "C" void __dl_runtime_resolve();
+
+//Called by __dl_runtime_resolve in plt.S
+extern "C" __attribute__((visibility("hidden"))) uintptr_t __dl_bind_plt_slot(Object* object, size_t reloc_offset) {
+	return object->bind_plt_slot(*Loader::main(), reloc_offset);
+}
+
+SymbolName::SymbolName(const char* name): name(name) {
+	//The hash functions used by DT_GNU_HASH (djb2) and DT_HASH (the System V ABI's ELF hash)
+	uint32_t gnu = 5381;
+	uint32_t sysv = 0;
+	for(auto* c = (const uint8_t*) name; *c; c++) {
+		gnu = (gnu << 5) + gnu + *c;
+		sysv = (sysv << 4) + *c;
+		uint32_t high = sysv & 0xf0000000;
+		if(high)
+			sysv ^= high >> 24;
+		sysv &= ~high;
+	}
+	gnu_hash = gnu;
+	sysv_hash = sysv;
+}
+
 // TODO: We just gotta redo most of this. It's pretty gross.
 
 Object::~Object() {
@@ -37,6 +61,10 @@ int Object::load(Loader& loader, const char* name_cstr) {
 		return -1;
 	}
 
+	//The prelinked image can only be used if it actually covers the object
+	if(cache_entry && (calculated_base || memsz > cache_entry->image_size))
+		cache_entry = nullptr;
+
 	//Allocate memory to hold the object
 	memloc = loader.get_memloc_for(this);
 
@@ -52,8 +80,16 @@ int Object::load(Loader& loader, const char* name_cstr) {
 	mapped_file = nullptr;
 	mapped_size = 0;
 
+	// If the address the object was prelinked for is taken, fall back to loading and relocating it normally
+	if(cache_entry && load_prelinked_sections(*loader.cache()) < 0) {
+		if(loader.debug_mode())
+			Log::dbgf("Couldn't map prelinked {} at {#x}", name, memloc);
+		cache_entry = nullptr;
+		memloc = loader.get_memloc_for(this);
+	}
+
 	// Load the object
-	if(load_sections() < 0) {
+	if(!cache_entry && load_sections() < 0) {
 		Log::err("Failed to load ", name_cstr, " into memory: ", strerror(errno));
 		return -1;
 	}
@@ -64,12 +100,6 @@ int Object::load(Loader& loader, const char* name_cstr) {
 	// Read the dynamic table
 	read_dynamic_table([&] (size_t val) { return memloc + val; });
 
-	//Read the copy relocations of the main executable
-	if(this == loader.main_executable() && read_copy_relocations(loader) < 0) {
-		Log::err("Failed to read copy relocations of ", name_cstr, ": ", strerror(errno));
-		return -1;
-	}
-
 	//Load the required libraries
 	for(auto& library_name : required_libraries) {
 		//Open the library
@@ -163,9 +193,11 @@ void Object::read_dynamic_table(std::function<size_t(size_t)> lookup) {
 	for(auto& dynamic : dynamic_table) {
 		switch(dynamic.d_tag) {
 			case DT_HASH:
-				hash = (uint32_t*) lookup(dynamic.d_val);
-				//Size of symbol table should be the same as the number of entries in the symbol hash table
-				dsym_table_size = hash[1];
+				sysv_hash = (uint32_t*) lookup(dynamic.d_val);
+				break;
+
+			case DT_GNU_HASH:
+				gnu_hash = (uint32_t*) lookup(dynamic.d_val);
 				break;
 
 			case DT_STRTAB:
@@ -190,12 +222,73 @@ void Object::read_dynamic_table(std::function<size_t(size_t)> lookup) {
 
 			case DT_INIT_ARRAYSZ:
 				init_array_size = dynamic.d_val / sizeof(uintptr_t);
+				break;
+
+			case DT_REL:
+				rel_table = (elf32_rel*) lookup(dynamic.d_val);
+				break;
+
+			case DT_RELSZ:
+				rel_table_size = dynamic.d_val / sizeof(elf32_rel);
+				break;
+
+			case DT_JMPREL:
+				plt_rel_table = (elf32_rel*) lookup(dynamic.d_val);
+				break;
+
+			case DT_PLTRELSZ:
+				plt_rel_table_size = dynamic.d_val / sizeof(elf32_rel);
+				break;
+
+			case DT_PLTGOT:
+				plt_got = (uintptr_t*) lookup(dynamic.d_val);
+				break;
+
+			case DT_BIND_NOW:
+				bind_now = true;
+				break;
+
+			case DT_FLAGS:
+				if(dynamic.d_val & DF_BIND_NOW)
+					bind_now = true;
+				break;
+
+			case DT_FLAGS_1:
+				if(dynamic.d_val & DF_1_NOW)
+					bind_now = true;
+				break;
 
 			default:
 				break;
 		}
 	}
 
+	//DT_RELSZ may include the PLT relocations if they directly follow the others, but we handle those separately
+	if(rel_table && plt_rel_table && rel_table + rel_table_size == plt_rel_table + plt_rel_table_size)
+		rel_table_size -= plt_rel_table_size;
+
+	//Neither hash table stores the size of the symbol table directly
+	if(sysv_hash) {
+		dsym_table_size = sysv_hash[1];
+	} else if(gnu_hash) {
+		//The last symbol is at the end of the chain of the highest bucket
+		uint32_t num_buckets = gnu_hash[0];
+		uint32_t sym_offset = gnu_hash[1];
+		auto* buckets = gnu_hash + 4 + gnu_hash[2];
+		auto* chains = buckets + num_buckets - sym_offset;
+		uint32_t last = 0;
+		for(uint32_t i = 0; i < num_buckets; i++)
+			if(buckets[i] > last)
+				last = buckets[i];
+		if(last) {
+			while(!(chains[last] & 1))
+				last++;
+			dsym_table_size = last + 1;
+		} else {
+			dsym_table_size = sym_offset;
+		}
+	}
+
 	//Now that the string table is loaded, we can iterate again and find the required libraries
 	required_libraries.resize(0);
 	for(auto& dynamic : dynamic_table) {
@@ -234,23 +327,30 @@ void Object::read_section_headers() {
 }
 
 int Object::load_sections() {
+	// If relocations are applied to read-only segments, they need to be writable (and private) until we're done
+	bool has_text_relocations = false;
+	for(auto& dynamic : dynamic_table) {
+		if(dynamic.d_tag == DT_TEXTREL || (dynamic.d_tag == DT_FLAGS && (dynamic.d_val & DF_TEXTREL)))
+			has_text_relocations = true;
+	}
+
 	for(auto& pheader : pheaders) {
 		if(pheader.p_type != PT_LOAD)
 			continue;
 
-		// Allocate memory for the section
 		size_t vaddr_mod = pheader.p_vaddr % PAGE_SIZE;
 		size_t round_memloc = memloc + pheader.p_vaddr - vaddr_mod;
 		size_t round_size = ((pheader.p_memsz + vaddr_mod + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
-//		if(mmap((void*) round_memloc, round_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_FIXED, 0, 0) == MAP_FAILED)
-//			Duck::Log::errf("ld: Failed to allocate memory for section at {#x}->{#x}: {}", pheader.p_vaddr, pheader.p_vaddr + pheader.p_memsz, strerror(errno));
-//		lseek(fd, pheader.p_offset, SEEK_SET);
-//		read(fd, (void*) (memloc + pheader.p_vaddr), pheader.p_filesz);
 
-		// Map the section into memory
+		// Map the section into memory. Pages are read in from the file as they're used. Read-only segments are mapped
+		// shared so every process using the object uses the same pages, and writable ones are mapped privately, which
+		// still shares each page until it's written to.
 		size_t round_offset = pheader.p_offset - vaddr_mod;
 		size_t round_filesz = ((pheader.p_filesz + vaddr_mod + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
-		if(mmap((void*) round_memloc, round_filesz, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_PRIVATE, fd, round_offset) == MAP_FAILED)
+		bool shared = !(pheader.p_flags & PF_W) && !has_text_relocations && pheader.p_memsz == pheader.p_filesz;
+		int prot = shared ? PROT_READ : (PROT_READ | PROT_WRITE);
+		int flags = MAP_FIXED | (shared ? MAP_SHARED : MAP_PRIVATE);
+		if(mmap((void*) round_memloc, round_filesz, prot, flags, fd, round_offset) == MAP_FAILED)
 			Duck::Log::errf("ld: Failed to allocate memory for section at {#x}->{#x}: {}", pheader.p_vaddr, pheader.p_vaddr + pheader.p_memsz, strerror(errno));
 		if(pheader.p_memsz != pheader.p_filesz)
 			if(mmap_named((void*) (round_memloc + round_filesz), round_size - round_filesz, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_FIXED, 0, 0, name.c_str()) == MAP_FAILED)
@@ -265,6 +365,44 @@ int Object::load_sections() {
 	return 0;
 }
 
+int Object::load_prelinked_sections(const LibraryCache& cache) {
+	std::vector<std::pair<uintptr_t, size_t>> mapped_segments;
+	auto fail = [&] {
+		for(auto& segment : mapped_segments)
+			munmap((void*) segment.first, segment.second);
+		return -1;
+	};
+
+	for(auto& pheader : pheaders) {
+		if(pheader.p_type != PT_LOAD)
+			continue;
+
+		size_t vaddr_mod = pheader.p_vaddr % PAGE_SIZE;
+		size_t round_vaddr = pheader.p_vaddr - vaddr_mod;
+		size_t round_memloc = memloc + round_vaddr;
+		size_t round_size = ((pheader.p_memsz + vaddr_mod + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+		size_t round_filesz = ((pheader.p_filesz + vaddr_mod + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+
+		//Read-only segments are mapped shared, so every process using the library uses the same pages. Writable ones
+		//are mapped privately, but they're already relocated and bss in the image is zeroed.
+		bool writable = pheader.p_flags & PF_W;
+		int prot = writable ? (PROT_READ | PROT_WRITE) :
+				(((pheader.p_flags & PF_R) ? PROT_READ : 0) | ((pheader.p_flags & PF_X) ? PROT_EXEC : 0));
+		int flags = MAP_FIXED | (writable ? MAP_PRIVATE : MAP_SHARED);
+		if(mmap((void*) round_memloc, round_filesz, prot, flags, cache.fd(), cache_entry->image_offset + round_vaddr) == MAP_FAILED)
+			return fail();
+		mapped_segments.push_back({round_memloc, round_filesz});
+
+		if(round_size != round_filesz) {
+			if(mmap_named((void*) (round_memloc + round_filesz), round_size - round_filesz, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_FIXED, 0, 0, name.c_str()) == MAP_FAILED)
+				return fail();
+			mapped_segments.push_back({round_memloc + round_filesz, round_size - round_filesz});
+		}
+	}
+
+	return 0;
+}
+
 void Object::mprotect_sections() {
 	for(auto& pheader : pheaders) {
 		if(pheader.p_type != PT_LOAD)
@@ -280,125 +418,241 @@ void Object::mprotect_sections() {
 	}
 }
 
-int Object::read_copy_relocations(Loader& loader) {
-	//In the relocation table, find all of the copy relocations (ELF32_R_TYPE == STT_COMMON) and put them in the global symbols
-	for(auto& shdr : sheaders) {
-		if(shdr.sh_type != SHT_REL)
-			continue;
-		auto* rel_table = (elf32_rel*) (shdr.sh_addr + memloc);
-		for(size_t i = 0; i < shdr.sh_size / sizeof(elf32_rel); i++) {
-			auto& rel = rel_table[i];
-			if(ELF32_R_TYPE(rel.r_info) == R_386_COPY) {
-				auto& symbol = dsym_table[ELF32_R_SYM(rel.r_info)];
-				auto* symbol_name = (char*)((uintptr_t)dstring_table + symbol.st_name);
-				loader.set_global_symbol(symbol_name, rel.r_offset);
-			}
-		}
+int Object::relocate(Loader& loader) {
+	if(cache_entry) {
+		relocate_prelinked(loader);
+		return 0;
 	}
-	return 0;
-}
 
-int Object::read_symbols(Loader& loader) {
-	//Put all the symbols into the symbols map if they aren't there already
-	for(size_t i = 0; i < dsym_table_size; i++) {
-		auto* symbol = &dsym_table[i];
-		char* symbol_name = (char*)((uintptr_t) dstring_table + symbol->st_name);
-		if(symbol->st_shndx && !loader.get_symbol(symbol_name)) {
-			loader.set_symbol(symbol_name, symbol->st_value + memloc);
-		}
+	for(size_t i = 0; i < rel_table_size; i++)
+		relocate(loader, rel_table[i]);
+
+	//Unless we were asked to bind everything now, leave the PLT slots pointing at the PLT so that they go through
+	//the resolver the first time they're called. GOT[1] and GOT[2] are reserved for the resolver's use.
+	bool lazy = plt_got && !bind_now && !loader.bind_now();
+	if(lazy) {
+		plt_got[1] = (uintptr_t) this;
+		plt_got[2] = (uintptr_t) __dl_runtime_resolve;
+	}
+
+	for(size_t i = 0; i < plt_rel_table_size; i++) {
+		auto& rel = plt_rel_table[i];
+		if(lazy && ELF32_R_TYPE(rel.r_info) == R_386_JMP_SLOT)
+			*((uintptr_t*) (memloc + rel.r_offset)) += memloc;
+		else
+			relocate(loader, rel);
 	}
+
 	return 0;
 }
 
-int Object::relocate(Loader& loader) {
-	//Relocate the symbols
-	for(auto& shdr : sheaders) {
-		if(shdr.sh_type != SHT_REL)
-			continue;
-		auto* rel_table = (elf32_rel*) (shdr.sh_addr + memloc);
-		for(size_t i = 0; i < shdr.sh_size / sizeof(elf32_rel); i++) {
-			auto& rel = rel_table[i];
-			uint8_t rel_type = ELF32_R_TYPE(rel.r_info);
-			uint32_t rel_symbol = ELF32_R_SYM(rel.r_info);
+void Object::relocate(Loader& loader, const elf32_rel& rel) {
+	uint8_t rel_type = ELF32_R_TYPE(rel.r_info);
+	uint32_t rel_symbol = ELF32_R_SYM(rel.r_info);
+	auto* reloc_loc = (void*) (memloc + rel.r_offset);
+
+	if(rel_type == R_386_NONE)
+		return;
+
+	auto& symbol = dsym_table[rel_symbol];
+	uintptr_t symbol_loc = 0;
+
+	//Local symbols can't be interposed, but everything else has to be looked up in load order
+	if(rel_symbol && ELF32_ST_BIND(symbol.st_info) == STB_LOCAL) {
+		symbol_loc = symbol_address(symbol);
+	} else if(rel_symbol) {
+		auto* symbol_name = dstring_table + symbol.st_name;
+		//A copy relocation copies the definition in a library into the executable, so skip the executable's own
+		symbol_loc = loader.get_symbol(symbol_name, rel_type == R_386_COPY ? this : nullptr);
+		if(!symbol_loc && ELF32_ST_BIND(symbol.st_info) != STB_WEAK && loader.debug_mode())
+			Log::warn("Symbol ", symbol_name, " not found for ", name);
+	}
 
-			if(rel_type == R_386_NONE)
-				continue;
+	//Perform the actual relocation
+	switch(rel_type) {
+		case R_386_32:
+			symbol_loc += *((ssize_t*) reloc_loc);
+			*((uintptr_t*)reloc_loc) = (uintptr_t) symbol_loc;
+			break;
+
+		case R_386_PC32:
+			symbol_loc += *((ssize_t*) reloc_loc);
+			symbol_loc -= memloc + rel.r_offset;
+			*((uintptr_t*)reloc_loc) = (uintptr_t) symbol_loc;
+			break;
+
+		case R_386_COPY:
+			if(symbol_loc)
+				memcpy(reloc_loc, (const void*) symbol_loc, symbol.st_size);
+			break;
+
+		case R_386_GLOB_DAT:
+		case R_386_JMP_SLOT:
+			*((uintptr_t*) reloc_loc) = (uintptr_t) symbol_loc;
+			break;
+
+		case R_386_RELATIVE:
+			symbol_loc = memloc + *((ssize_t*) reloc_loc);
+			*((uintptr_t*) reloc_loc) = (uintptr_t) symbol_loc;
+			break;
+
+		default:
+			if(loader.debug_mode())
+				Log::warn("Unknown relocation type ", (int) rel_type, " for ",  (int) rel_symbol);
+			break;
+	}
+}
 
-			auto& symbol = dsym_table[rel_symbol];
-			uintptr_t symbol_loc = memloc + symbol.st_value;
-			char* symbol_name = (char *)((uintptr_t) dstring_table + symbol.st_name);
-
-			//If this kind of relocation is a symbol, look it up
-			if(rel_type == R_386_32 || rel_type == R_386_PC32 || rel_type == R_386_COPY || rel_type == R_386_GLOB_DAT || rel_type == R_386_JMP_SLOT) {
-				if(symbol_name) {
-					auto sym = loader.get_symbol(symbol_name);
-					if(!sym) {
-						if(loader.debug_mode())
-							Log::warn("Symbol ", symbol_name, " not found for ", name);
-						symbol_loc = 0x0;
-					} else {
-						symbol_loc = sym;
-					}
-				}
-			}
+void Object::relocate_prelinked(Loader& loader) {
+	auto& cache = *loader.cache();
+	auto* rels = cache.relocations(*cache_entry);
+	auto* deps = cache.dependencies(*cache_entry);
+
+	//The image is only correct if the libraries it was relocated against are prelinked too. Anything else that
+	//comes before them in the search order, like the executable, could interpose symbols they define.
+	auto& objects = loader.objects();
+	std::vector<bool> is_dep(objects.size());
+	size_t num_deps_found = 0;
+	size_t last_dep = 0;
+	for(size_t i = 0; i < objects.size(); i++) {
+		auto* object = objects[i];
+		for(size_t dep = 0; object->cache_entry && !is_dep[i] && dep < cache_entry->num_deps; dep++)
+			is_dep[i] = object->cache_entry == &cache.entry(deps[dep]);
+		if(is_dep[i])
+			num_deps_found++;
+		if(is_dep[i] || object == this)
+			last_dep = i;
+	}
 
-			//If this is a global symbol or weak, try finding it in the global symbol table
-			if(rel_type == R_386_GLOB_DAT || (ELF32_ST_BIND(symbol.st_info) == STB_WEAK && !symbol_loc)) {
-				if(symbol_name) {
-					auto sym = loader.get_global_symbol(symbol_name);
-					if(sym) {
-						symbol_loc = sym;
-					}
+	std::vector<Object*> others;
+	for(size_t i = 0; i < last_dep; i++)
+		if(!is_dep[i] && objects[i] != this)
+			others.push_back(objects[i]);
+
+	//If the dependencies aren't all there, redo every symbolic relocation (relative ones are still right)
+	bool redo_all = num_deps_found != cache_entry->num_deps;
+	if(redo_all && loader.debug_mode())
+		Log::dbgf("Dependencies of prelinked {} aren't all prelinked, redoing its symbolic relocations", name);
+
+	for(size_t i = 0; i < cache_entry->num_rels; i++) {
+		auto& rela = rels[i];
+		auto& symbol = dsym_table[ELF32_R_SYM(rela.r_info)];
+		auto* symbol_name = dstring_table + symbol.st_name;
+
+		if(!redo_all) {
+			SymbolName lookup_name(symbol_name);
+			bool interposed = false;
+			for(auto* other : others) {
+				if(other->lookup_symbol(lookup_name)) {
+					interposed = true;
+					break;
 				}
 			}
+			if(!interposed)
+				continue;
+		}
 
-			//Perform the actual relocation
-			auto* reloc_loc = (void*) (memloc + rel.r_offset);
-			switch(rel_type) {
-				case R_386_32:
-					symbol_loc += *((ssize_t*) reloc_loc);
-					*((uintptr_t*)reloc_loc) = (uintptr_t) symbol_loc;
-					break;
+		relocate(rela, loader.get_symbol(symbol_name));
+	}
+}
 
-				case R_386_PC32:
-					symbol_loc += *((ssize_t*) reloc_loc);
-					symbol_loc -= memloc + rel.r_offset;
-					*((uintptr_t*)reloc_loc) = (uintptr_t) symbol_loc;
-					break;
+void Object::relocate(const elf32_rela& rela, uintptr_t symbol_loc) {
+	auto* reloc_loc = (uintptr_t*) (memloc + rela.r_offset);
+	switch(ELF32_R_TYPE(rela.r_info)) {
+		case R_386_32:
+			*reloc_loc = symbol_loc + rela.r_addend;
+			break;
 
-				case R_386_COPY:
-					memcpy(reloc_loc, (const void*) symbol_loc, symbol.st_size);
-					break;
+		case R_386_PC32:
+			*reloc_loc = symbol_loc + rela.r_addend - (memloc + rela.r_offset);
+			break;
 
-				case R_386_GLOB_DAT:
-				case R_386_JMP_SLOT:
-					*((uintptr_t*) reloc_loc) = (uintptr_t) symbol_loc;
-					break;
+		case R_386_GLOB_DAT:
+		case R_386_JMP_SLOT:
+			*reloc_loc = symbol_loc;
+			break;
 
-				case R_386_RELATIVE:
-					symbol_loc = memloc + *((ssize_t*) reloc_loc);
-					*((uintptr_t*) reloc_loc) = (uintptr_t) symbol_loc;
-					break;
+		default:
+			break;
+	}
+}
 
-				default:
-					if(loader.debug_mode())
-						Log::warn("Unknown relocation type ", (int) rel_type, " for ",  (int) rel_symbol);
-					break;
-			}
+uintptr_t Object::bind_plt_slot(Loader& loader, size_t reloc_offset) {
+	auto& rel = *((elf32_rel*) ((uintptr_t) plt_rel_table + reloc_offset));
+	auto& symbol = dsym_table[ELF32_R_SYM(rel.r_info)];
+	auto* symbol_name = dstring_table + symbol.st_name;
+
+	auto symbol_loc = loader.get_symbol(symbol_name);
+	if(!symbol_loc) {
+		Log::errf("ld: {}: undefined symbol {}", name, symbol_name);
+		_exit(127);
+	}
+
+	*((uintptr_t*) (memloc + rel.r_offset)) = symbol_loc;
+	return symbol_loc;
+}
+
+const elf32_sym* Object::lookup_symbol(const SymbolName& symbol_name) const {
+	auto is_match = [&] (uint32_t index) -> const elf32_sym* {
+		auto* symbol = &dsym_table[index];
+		if(symbol->st_shndx == SHN_UNDEF || ELF32_ST_BIND(symbol->st_info) == STB_LOCAL)
+			return nullptr;
+		if(strcmp(dstring_table + symbol->st_name, symbol_name.name))
+			return nullptr;
+		return symbol;
+	};
+
+	if(gnu_hash) {
+		uint32_t num_buckets = gnu_hash[0];
+		uint32_t sym_offset = gnu_hash[1];
+		uint32_t bloom_size = gnu_hash[2];
+		uint32_t bloom_shift = gnu_hash[3];
+		auto* bloom = gnu_hash + 4;
+		auto* buckets = bloom + bloom_size;
+		auto* chains = buckets + num_buckets - sym_offset;
+
+		//The bloom filter rules out most of the objects that don't define the symbol without touching the buckets
+		uint32_t hash = symbol_name.gnu_hash;
+		uint32_t bloom_word = bloom[(hash / 32) % bloom_size];
+		uint32_t bloom_mask = (1u << (hash % 32)) | (1u << ((hash >> bloom_shift) % 32));
+		if((bloom_word & bloom_mask) != bloom_mask)
+			return nullptr;
+
+		uint32_t index = buckets[hash % num_buckets];
+		if(index < sym_offset)
+			return nullptr;
+		//Each chain entry holds the hash of its symbol, with the lowest bit set on the last entry in the chain
+		for(;; index++) {
+			uint32_t chain_hash = chains[index];
+			if((chain_hash | 1) == (hash | 1))
+				if(auto* symbol = is_match(index))
+					return symbol;
+			if(chain_hash & 1)
+				return nullptr;
 		}
 	}
 
-	return 0;
+	if(sysv_hash) {
+		uint32_t num_buckets = sysv_hash[0];
+		auto* buckets = sysv_hash + 2;
+		auto* chains = buckets + num_buckets;
+		for(uint32_t index = buckets[symbol_name.sysv_hash % num_buckets]; index; index = chains[index])
+			if(auto* symbol = is_match(index))
+				return symbol;
+	}
+
+	return nullptr;
+}
+
+uintptr_t Object::symbol_address(const elf32_sym& symbol) const {
+	if(symbol.st_shndx == SHN_ABS)
+		return symbol.st_value;
+	return symbol.st_value + memloc;
 }
 
 uintptr_t Object::get_dynamic_symbol(const char* name) {
-	for(size_t i = 0; i < dsym_table_size; i++) {
-		auto* symbol = &dsym_table[i];
-		char* symbol_name = (char*)((uintptr_t) dstring_table + symbol->st_name);
-		if (!strcmp(symbol_name, name))
-			return symbol->st_value + memloc;
-	}
-	return 0;
+	auto* symbol = lookup_symbol(SymbolName(name));
+	return symbol ? symbol_address(*symbol) : 0;
 }
 
 Object::SymbolInfo Object::symbolicate(uintptr_t offset) {
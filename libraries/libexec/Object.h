@@ -10,10 +10,21 @@
 #include <libnusa/Result.h>
 #include <functional>
 #include "elf.h"
+#include "LibraryCache.h"
 
 namespace Exec {
 	typedef int (* main_t)(int argc, char* argv[], char* envp[]);
 	class Loader;
+
+	/** A symbol name along with its hashes, so that they're only computed once per lookup across every object. **/
+	struct SymbolName {
+		explicit SymbolName(const char* name);
+
+		const char* name;
+		uint32_t gnu_hash;
+		uint32_t sysv_hash;
+	};
+
 	class Object {
 	public:
 		explicit Object() = default;
@@ -27,11 +38,23 @@ namespace Exec {
 		void read_dynamic_table(std::function<size_t(size_t)> lookup);
 		void read_section_headers();
 		int load_sections();
+		int load_prelinked_sections(const LibraryCache& cache);
 		void mprotect_sections();
-		int read_copy_relocations(Loader& loader);
-		int read_symbols(Loader& loader);
 		int relocate(Loader& loader);
+		void relocate(Loader& loader, const elf32_rel& rel);
+		void relocate_prelinked(Loader& loader);
+		void relocate(const elf32_rela& rela, uintptr_t symbol_loc);
+
+		/**
+		 * Binds a PLT slot the first time it's called. Called by the resolver trampoline.
+		 * @param reloc_offset The offset of the slot's relocation in the PLT relocation table.
+		 * @return The address of the symbol the slot now points to.
+		 */
+		uintptr_t bind_plt_slot(Loader& loader, size_t reloc_offset);
 
+		/** Looks up a symbol defined by this object using its hash table. Returns nullptr if it isn't defined here. **/
+		const elf32_sym* lookup_symbol(const SymbolName& name) const;
+		uintptr_t symbol_address(const elf32_sym& symbol) const;
 		uintptr_t get_dynamic_symbol(const char* name);
 
 		struct SymbolInfo {
@@ -47,12 +70,21 @@ namespace Exec {
 		size_t memloc = 0;
 		size_t calculated_base = 0;
 		bool loaded = false;
+		const ld_cache_entry* cache_entry = nullptr; ///< The prelinked image of this object, if it's being used.
 
 		char* dstring_table = nullptr;
 		size_t dstring_table_size = 0;
 		elf32_sym* dsym_table = nullptr;
 		size_t dsym_table_size = 0;
-		uint32_t* hash = nullptr;
+		uint32_t* sysv_hash = nullptr;
+		uint32_t* gnu_hash = nullptr;
+
+		elf32_rel* rel_table = nullptr;
+		size_t rel_table_size = 0;
+		elf32_rel* plt_rel_table = nullptr;
+		size_t plt_rel_table_size = 0;
+		uintptr_t* plt_got = nullptr;
+		bool bind_now = false;
 
 		char* string_table = nullptr;
 		size_t string_table_size = 0;
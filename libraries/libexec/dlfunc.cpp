@@ -31,10 +31,7 @@ ResultRet<uintptr_t> __dlsym(Exec::Object* obj, const char* name) {
 		auto loader = Loader::main();
 		if (!loader)
 			return Result(EINVAL);
-		auto sym = loader->get_symbol(name);
-		if (!sym)
-			sym = loader->get_global_symbol(name);
-		return sym;
+		return loader->get_symbol(name);
 	}
 	return obj->get_dynamic_symbol(name);
 }
\ No newline at end of file
@@ -63,14 +63,17 @@
 #define DT_DEBUG	21
 #define DT_TEXTREL	22
 #define DT_JMPREL	23
+#define DT_BIND_NOW	24
 #define DT_INIT_ARRAY	25
 #define DT_INIT_ARRAYSZ	27
+#define DT_FLAGS	30
 #define DT_ENCODING	32
 #define OLD_DT_LOOS		0x60000000
 #define DT_LOOS			0x6000000d
 #define DT_HIOS			0x6ffff000
 #define DT_VALRNGLO		0x6ffffd00
 #define DT_VALRNGHI		0x6ffffdff
+#define DT_GNU_HASH		0x6ffffef5
 #define DT_ADDRRNGLO	0x6ffffe00
 #define DT_ADDRRNGHI	0x6ffffeff
 #define DT_VERSYM		0x6ffffff0
@@ -85,6 +88,13 @@
 #define DT_LOPROC		0x70000000
 #define DT_HIPROC		0x7fffffff
 
+#define DF_TEXTREL		0x4
+#define DF_BIND_NOW		0x8
+#define DF_1_NOW		0x1
+
+#define SHN_UNDEF		0
+#define SHN_ABS			0xfff1
+
 #define SHT_NULL		0
 #define SHT_PROGBITS	1
 #define SHT_SYMTAB		2
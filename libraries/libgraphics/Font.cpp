@@ -19,15 +19,32 @@
 
 #include "Font.h"
 #include "Geometry.h"
+#include "GlyphAtlas.h"
 #include <cstdio>
 #include <cstring>
 #include <climits>
 #include <vector>
 #include <sys/shm.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <memory>
+#include <algorithm>
 
 using namespace Gfx;
 
+static FontGlyph s_blank_glyph;
+
+static constexpr size_t glyph_alignment = 8;
+
+static inline size_t align_glyph(size_t size) {
+	return (size + glyph_alignment - 1) & ~(glyph_alignment - 1);
+}
+
+static inline size_t glyph_record_size(const FontGlyph* glyph) {
+	return align_glyph(sizeof(FontGlyph) + glyph->width * glyph->height);
+}
+
 Font* Font::load_bdf_shm(const char* path) {
 	FILE* file = fopen(path, "r");
 	if(!file) {
@@ -96,7 +113,6 @@ Font* Font::load_bdf_shm(const char* path) {
 		// BUG-07: was stack VLA (std::shared_ptr<FontGlyph> glyphs[font.num_glyphs])
 		// which causes stack overflow for large fonts. Use heap vector instead.
 		std::vector<std::shared_ptr<FontGlyph>> glyphs(font.num_glyphs);
-		size_t total_memsz = sizeof(FontData);
 		for(size_t i = 0; i < font.num_glyphs; i++) {
 			//Find the next STARTCHAR
 			while(true) {
@@ -148,9 +164,8 @@ Font* Font::load_bdf_shm(const char* path) {
 			}
 
 			//Read the glyph bitmap
-			size_t glyph_memsz = sizeof(FontGlyph) + sizeof(uint32_t) * glyph_properties.width * glyph_properties.height;
-			total_memsz += glyph_memsz;
-			auto glyph = std::shared_ptr<FontGlyph>((FontGlyph*) malloc(glyph_memsz));
+			size_t glyph_memsz = sizeof(FontGlyph) + glyph_properties.width * glyph_properties.height;
+			auto glyph = std::shared_ptr<FontGlyph>((FontGlyph*) malloc(glyph_memsz), free);
 			memcpy(glyph.get(), &glyph_properties, sizeof(FontGlyph));
 			for(size_t y = 0; y < glyph_properties.height; y++) {
 				if(!fgets(linebuf, 512, file)) {
@@ -178,68 +193,217 @@ Font* Font::load_bdf_shm(const char* path) {
 			glyphs[i] = glyph;
 		}
 
-		//Close the file & allocate shared memory for the font data
 		fclose(file);
-		if(shmcreate_named(nullptr, total_memsz, &fontshm, "Gfx::Font") < 0) {
+
+		//Sort the glyphs by codepoint. The sort is stable, so the last definition of a duplicate codepoint wins.
+		std::stable_sort(glyphs.begin(), glyphs.end(), [](auto& a, auto& b) {
+			return a->codepoint < b->codepoint;
+		});
+
+		//Lay out the tables. See FontData for a description of the format.
+		uint32_t bmp_pages[256] = {0};
+		size_t offset = sizeof(FontData);
+		font.bmp_pages_offset = offset;
+		offset += sizeof(bmp_pages);
+		for(auto& glyph : glyphs) {
+			if(glyph->codepoint > 0xFFFF)
+				break;
+			if(!bmp_pages[glyph->codepoint >> 8]) {
+				bmp_pages[glyph->codepoint >> 8] = offset;
+				offset += sizeof(uint32_t) * 256;
+			}
+		}
+
+		font.fallback_offset = offset;
+		font.num_fallback = 0;
+		for(size_t i = 0; i < glyphs.size(); i++) {
+			if(glyphs[i]->codepoint > 0xFFFF && (i + 1 == glyphs.size() || glyphs[i + 1]->codepoint != glyphs[i]->codepoint))
+				font.num_fallback++;
+		}
+		offset += sizeof(FontFallbackEntry) * font.num_fallback;
+
+		offset = align_glyph(offset);
+		font.glyphs_offset = offset;
+		for(auto& glyph : glyphs)
+			offset += glyph_record_size(glyph.get());
+		font.total_size = offset;
+
+		//Allocate shared memory for the font data
+		if(shmcreate_named(nullptr, font.total_size, &fontshm, "Gfx::Font") < 0) {
 			perror("Couldn't load font: Couldn't create shared memory region");
 			return nullptr;
 		}
 
-		//Copy the font into shared memory
-		memcpy(fontshm.ptr, &font, sizeof(FontData));
-		void* cptr = (void*) ((size_t) fontshm.ptr + sizeof(FontData));
-		for(size_t i = 0; i < font.num_glyphs; i++) {
-			auto& glyph = glyphs[i];
-			size_t glyph_size = sizeof(FontGlyph) + (glyph->width * glyph->height * sizeof(uint32_t));
-			memcpy(cptr, glyph.get(), glyph_size);
-			cptr = (void*) ((size_t) cptr + glyph_size);
+		//Copy the header, glyphs, and tables into shared memory. The region is fresh, so it's already zeroed.
+		auto* base = (uint8_t*) fontshm.ptr;
+		memcpy(base, &font, sizeof(FontData));
+		memcpy(base + font.bmp_pages_offset, bmp_pages, sizeof(bmp_pages));
+		auto* fallback = (FontFallbackEntry*) (base + font.fallback_offset);
+		size_t num_fallback = 0;
+		offset = font.glyphs_offset;
+		for(auto& glyph : glyphs) {
+			memcpy(base + offset, glyph.get(), sizeof(FontGlyph) + glyph->width * glyph->height);
+			if(glyph->codepoint <= 0xFFFF) {
+				auto* page = (uint32_t*) (base + bmp_pages[glyph->codepoint >> 8]);
+				page[glyph->codepoint & 0xFF] = offset;
+			} else if(num_fallback && fallback[num_fallback - 1].codepoint == glyph->codepoint) {
+				fallback[num_fallback - 1].glyph_offset = offset;
+			} else {
+				fallback[num_fallback++] = {glyph->codepoint, (uint32_t) offset};
+			}
+			offset += glyph_record_size(glyph.get());
 		}
 	}
 
 	return load_from_shm(fontshm);
 }
 
+Font* Font::load_shm(const char* path) {
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		perror("Couldn't open font");
+		return nullptr;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(FontData)) {
+		fprintf(stderr, "Couldn't load font: Invalid font file\n");
+		close(fd);
+		return nullptr;
+	}
+
+	shm fontshm;
+	if(shmcreate_named(nullptr, st.st_size, &fontshm, "Gfx::Font") < 0) {
+		perror("Couldn't load font: Couldn't create shared memory region");
+		close(fd);
+		return nullptr;
+	}
+
+	//Precompiled fonts are laid out exactly how we want them in memory, so just read the whole thing in
+	size_t nread = 0;
+	while(nread < (size_t) st.st_size) {
+		ssize_t res = read(fd, (uint8_t*) fontshm.ptr + nread, st.st_size - nread);
+		if(res <= 0) {
+			perror("Couldn't load font: Couldn't read font file");
+			close(fd);
+			shmdetach(fontshm.id);
+			return nullptr;
+		}
+		nread += res;
+	}
+	close(fd);
+
+	if(!validate((FontData*) fontshm.ptr, st.st_size)) {
+		fprintf(stderr, "Couldn't load font: %s is not a valid font file\n", path);
+		shmdetach(fontshm.id);
+		return nullptr;
+	}
+
+	return new Font((FontData*) fontshm.ptr, fontshm);
+}
+
 Font* Font::load_from_shm(shm fontshm) {
-	if(memcmp(fontshm.ptr, "@FONT", 5) != 0) {
-		fprintf(stderr, "Couldn't load font from shm: magic mismatch\n");
+	if(!validate((FontData*) fontshm.ptr, fontshm.size)) {
+		fprintf(stderr, "Couldn't load font from shm: invalid font data\n");
 		return nullptr;
 	}
 
-	return new Font(fontshm);
+	return new Font((FontData*) fontshm.ptr, fontshm);
 }
 
-Font::Font(shm fontshm): fontshm(fontshm), uses_shm(true) {
-	data = (FontData*) fontshm.ptr;
+bool Font::validate(const FontData* data, size_t size) {
+	//Every table and glyph we'll look at later is checked to be inside of the font, so a malformed font can't make us
+	//read past it. Bounds are calculated with 64 bits so they can't overflow.
+	if(size < sizeof(FontData))
+		return false;
+	if(memcmp(data->MAGIC, "@FONT", 5) != 0 || data->version != FONT_FORMAT_VERSION)
+		return false;
+	uint64_t total_size = data->total_size;
+	if(total_size > size || total_size < sizeof(FontData))
+		return false;
+
+	auto in_bounds = [&](uint64_t offset, uint64_t length, size_t alignment) {
+		return offset % alignment == 0 && offset + length <= total_size;
+	};
+	auto valid_glyph = [&](uint32_t offset) {
+		if(!offset)
+			return true;
+		if(!in_bounds(offset, sizeof(FontGlyph), glyph_alignment))
+			return false;
+		auto* glyph = (const FontGlyph*) ((uintptr_t) data + offset);
+		if(glyph->width < 0 || glyph->height < 0)
+			return false;
+		return in_bounds((uint64_t) offset + sizeof(FontGlyph), (uint64_t) glyph->width * (uint64_t) glyph->height, 1);
+	};
+
+	//The BMP page directory, its pages, and their glyphs
+	if(!in_bounds(data->bmp_pages_offset, sizeof(uint32_t) * 256, alignof(uint32_t)))
+		return false;
+	auto* pages = (const uint32_t*) ((uintptr_t) data + data->bmp_pages_offset);
+	for(int page = 0; page < 256; page++) {
+		if(!pages[page])
+			continue;
+		if(!in_bounds(pages[page], sizeof(uint32_t) * 256, alignof(uint32_t)))
+			return false;
+		auto* glyph_offsets = (const uint32_t*) ((uintptr_t) data + pages[page]);
+		for(int i = 0; i < 256; i++) {
+			if(!valid_glyph(glyph_offsets[i]))
+				return false;
+		}
+	}
 
-	//Read glyphs into map
-	FontGlyph* gptr = data->glyphs;
-	for(size_t i = 0; i < data->num_glyphs; i++) {
-		glyphs[gptr->codepoint] = gptr;
-		size_t glyph_size = sizeof(FontGlyph) + (gptr->width * gptr->height * sizeof(uint32_t));
-		gptr = (FontGlyph*) ((size_t) gptr + glyph_size);
+	//The fallback table and its glyphs
+	if(data->num_fallback) {
+		if(!in_bounds(data->fallback_offset, (uint64_t) sizeof(FontFallbackEntry) * data->num_fallback, alignof(FontFallbackEntry)))
+			return false;
+		auto* fallback = (const FontFallbackEntry*) ((uintptr_t) data + data->fallback_offset);
+		for(uint32_t i = 0; i < data->num_fallback; i++) {
+			if(!valid_glyph(fallback[i].glyph_offset))
+				return false;
+		}
 	}
 
-	//Create the unknown character glyph
-	if(glyphs[0xFFFD]) { //REPLACEMENT CHARACTER
-		size_t glyph_size = sizeof(FontGlyph) + (glyphs[0xFFFD]->width * glyphs[0xFFFD]->height * sizeof(uint32_t));
-		unknown_glyph = (FontGlyph*) malloc(glyph_size);
-		memcpy(unknown_glyph, glyphs[0xFFFD], glyph_size);
-	} else {
-		//Don't have REPLACEMENT CHARACTER, just make a blank glyph
-		unknown_glyph = new FontGlyph;
+	return data->glyphs_offset <= total_size;
+}
+
+Font::Font(FontData* data, shm fontshm): fontshm(fontshm), data(data) {
+	//Find the unknown character glyph
+	unknown_glyph = find_glyph(0xFFFD); //REPLACEMENT CHARACTER
+	if(!unknown_glyph) {
+		//Don't have REPLACEMENT CHARACTER, just use a blank glyph
+		unknown_glyph = &s_blank_glyph;
 	}
 
+	//Resolve the ASCII range up front, since that's what we'll be drawing most of the time
+	for(uint32_t codepoint = 0; codepoint < 128; codepoint++) {
+		auto* glyph = find_glyph(codepoint);
+		m_ascii_glyphs[codepoint] = glyph ? glyph : unknown_glyph;
+	}
 }
 
 Font::~Font() {
-	if(uses_shm) {
-		if(shmdetach(fontshm.id) < 0)
-			fprintf(stderr, "WARNING: Failed to detach font shm %d", fontshm.id);
-	} else {
-		delete data;
+	GlyphAtlas::forget(this);
+	if(shmdetach(fontshm.id) < 0)
+		fprintf(stderr, "WARNING: Failed to detach font shm %d", fontshm.id);
+}
+
+FontGlyph* Font::find_glyph(uint32_t codepoint) {
+	if(codepoint <= 0xFFFF) {
+		auto* pages = (uint32_t*) ((uintptr_t) data + data->bmp_pages_offset);
+		uint32_t page_offset = pages[codepoint >> 8];
+		if(!page_offset)
+			return nullptr;
+		return glyph_at(((uint32_t*) ((uintptr_t) data + page_offset))[codepoint & 0xFF]);
 	}
 
-	delete unknown_glyph;
+	auto* fallback = (FontFallbackEntry*) ((uintptr_t) data + data->fallback_offset);
+	auto* end = fallback + data->num_fallback;
+	auto* entry = std::lower_bound(fallback, end, codepoint, [](const FontFallbackEntry& entry, uint32_t codepoint) {
+		return entry.codepoint < codepoint;
+	});
+	if(entry == end || entry->codepoint != codepoint)
+		return nullptr;
+	return glyph_at(entry->glyph_offset);
 }
 
 FontData::BoundingBox Font::bounding_box() {
@@ -251,12 +415,7 @@ int Font::size() {
 }
 
 int Font::shm_id() {
-	return uses_shm ? fontshm.id : -1;
-}
-
-FontGlyph* Font::glyph(uint32_t codepoint) {
-	auto* glyph = glyphs[codepoint];
-	return glyph ? glyph : unknown_glyph;
+	return fontshm.id;
 }
 
 Dimensions Font::size_of(std::string_view string) {
@@ -27,6 +27,12 @@
 #include "Geometry.h"
 
 namespace Gfx {
+	/**
+	 * The version of the precompiled font format. Bump this whenever the layout of FontData, FontGlyph, or the
+	 * tables following them changes, and update scripts/bdf2font.tcl to match.
+	 */
+	constexpr uint16_t FONT_FORMAT_VERSION = 3;
+
 	struct FontGlyph {
 		uint32_t codepoint = -1;
 
@@ -40,11 +46,32 @@ namespace Gfx {
 			int y = 0;
 		} next_offset; ///< The offset of the next glyph from the origin of this glyph
 
+		uint32_t reserved = 0; ///< Pads the header to 32 bytes so that the bitmap stays 8-byte aligned.
+
 		uint8_t bitmap[]; ///< The actual pixels making up the glyph. Should be grayscale.
 	};
 
+	static_assert(sizeof(FontGlyph) == 32, "FontGlyph must be 32 bytes to keep glyph bitmaps aligned");
+
+	/// An entry in the sorted table of glyphs outside of the Basic Multilingual Plane.
+	struct FontFallbackEntry {
+		uint32_t codepoint;
+		uint32_t glyph_offset;
+	};
+
+	/**
+	 * The header of a font, both in a precompiled font file and in shared memory.
+	 *
+	 * A font is one contiguous blob so that it can be read or shared without any fixups. All offsets are
+	 * relative to the start of the header. After the header comes a page directory of 256 offsets, one for each
+	 * 256-codepoint page of the BMP. A present page is an array of 256 glyph offsets, so any BMP codepoint is found
+	 * with two array lookups. Glyphs outside of the BMP are kept in a FontFallbackEntry table sorted by codepoint.
+	 * Glyphs are stored last, each one aligned to 8 bytes with its bitmap directly after it. An offset of 0 means
+	 * "not present".
+	 */
 	struct FontData {
 		char MAGIC[6] = "@FONT";
+		uint16_t version = FONT_FORMAT_VERSION;
 		char id[128];
 		int size;
 		typedef struct {
@@ -55,13 +82,28 @@ namespace Gfx {
 		} BoundingBox;
 		BoundingBox bounding_box;
 		int num_glyphs;
-		FontGlyph glyphs[];
+		uint32_t total_size;
+		uint32_t bmp_pages_offset; ///< Offset of the uint32_t[256] BMP page directory.
+		uint32_t fallback_offset; ///< Offset of the FontFallbackEntry table.
+		uint32_t num_fallback;
+		uint32_t glyphs_offset; ///< Offset of the first glyph.
+		uint32_t reserved = 0;
 	};
 
 	class Font {
 	public:
+		/**
+		 * Parses a BDF font and loads it into shared memory.
+		 * Prefer load_shm() with a precompiled font, since this has to parse the whole font every time.
+		 */
 		static Font* load_bdf_shm(const char* path);
 
+		/**
+		 * Loads a precompiled font (see scripts/bdf2font.tcl) into shared memory so it can be shared with other
+		 * processes. No parsing is done, the file is read as-is.
+		 */
+		static Font* load_shm(const char* path);
+
 		static Font* load_from_shm(shm shm);
 
 		int size();
@@ -70,20 +112,30 @@ namespace Gfx {
 
 		FontData::BoundingBox bounding_box();
 
-		FontGlyph* glyph(uint32_t codepoint);
+		inline FontGlyph* glyph(uint32_t codepoint) {
+			if(codepoint < 128)
+				return m_ascii_glyphs[codepoint];
+			auto* glyph = find_glyph(codepoint);
+			return glyph ? glyph : unknown_glyph;
+		}
 
 		Dimensions size_of(std::string_view string);
 
 	private:
-		explicit Font(shm fontshm);
+		Font(FontData* data, shm fontshm);
 
 		~Font();
 
-		bool uses_shm = false;
+		static bool validate(const FontData* data, size_t size);
+		FontGlyph* find_glyph(uint32_t codepoint);
+		inline FontGlyph* glyph_at(uint32_t offset) {
+			return offset ? (FontGlyph*) ((uintptr_t) data + offset) : nullptr;
+		}
+
 		shm fontshm = {nullptr, 0, 0};
 		FontData* data;
-		std::map<uint32_t, FontGlyph*> glyphs;
 		FontGlyph* unknown_glyph;
+		FontGlyph* m_ascii_glyphs[128]; ///< Direct-mapped lookups for the ASCII range.
 	};
 }
 
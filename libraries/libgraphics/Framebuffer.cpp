@@ -20,8 +20,15 @@
 #include "Framebuffer.h"
 #include "Graphics.h"
 #include "Font.h"
+#include "GlyphAtlas.h"
+#include "GlyphRun.h"
 #include "Memory.h"
 #include "Geometry.h"
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#define GFX_SSE2_BLEND
+#endif
 
 using namespace Gfx;
 
@@ -370,14 +377,90 @@ Point Framebuffer::draw_glyph(Font* font, uint32_t codepoint, const Point& glyph
 	auto* glyph = font->glyph(codepoint);
 	int y_offset = (font->bounding_box().base_y - glyph->base_y) + (font->size() - glyph->height);
 	int x_offset = glyph->base_x - font->bounding_box().base_x;
-	Point pos = {glyph_pos.x + x_offset, glyph_pos.y + y_offset};
+	draw_glyph_mask(font, glyph, {glyph_pos.x + x_offset, glyph_pos.y + y_offset}, color);
+	return glyph_pos + Point {glyph->next_offset.x, glyph->next_offset.y};
+}
+
+Point Framebuffer::draw_glyph_run(const GlyphRun& run, const Point& pos, Color color) const {
+	Rect run_area = run.bounds();
+	run_area.x += pos.x;
+	run_area.y += pos.y;
+	if(run_area.overlapping_area({0, 0, width, height}).empty())
+		return pos + run.advance();
+
+	for(auto& glyph : run.glyphs())
+		draw_glyph_mask(run.font(), glyph.glyph, pos + glyph.pos, color);
+	return pos + run.advance();
+}
+
+#ifdef GFX_SSE2_BLEND
+static bool cpu_has_sse2() {
+	static int has_sse2 = -1;
+	if(has_sse2 == -1) {
+		unsigned int eax, ebx, ecx, edx;
+		has_sse2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+	}
+	return has_sse2;
+}
+
+/**
+ * Blends as many groups of four pixels as possible with SSE2.
+ * @return The number of pixels blended.
+ */
+__attribute__((target("sse2")))
+static int blend_row_sse2(Color* dst, const Color* src, int count) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_bits = _mm_set1_epi32(0xFF000000);
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i max_alpha = _mm_set1_epi16(256);
+	int i = 0;
+	for(; i + 4 <= count; i += 4) {
+		__m128i src_px = _mm_loadu_si128((const __m128i*) (src + i));
+
+		// Skip groups of fully transparent pixels, which make up most of a glyph
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(src_px, alpha_bits), zero)) == 0xFFFF)
+			continue;
+
+		__m128i dst_px = _mm_loadu_si128((const __m128i*) (dst + i));
+		__m128i src_lo = _mm_unpacklo_epi8(src_px, zero);
+		__m128i src_hi = _mm_unpackhi_epi8(src_px, zero);
+		__m128i dst_lo = _mm_unpacklo_epi8(dst_px, zero);
+		__m128i dst_hi = _mm_unpackhi_epi8(dst_px, zero);
+
+		// Broadcast each pixel's alpha to all of its channels
+		__m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+		// (src * (a + 1) + dst * (256 - a)) >> 8, same as Color::blended(). The weights add up to 257, so this fits in 16 bits.
+		__m128i res_lo = _mm_add_epi16(_mm_mullo_epi16(src_lo, _mm_add_epi16(a_lo, one)), _mm_mullo_epi16(dst_lo, _mm_sub_epi16(max_alpha, a_lo)));
+		__m128i res_hi = _mm_add_epi16(_mm_mullo_epi16(src_hi, _mm_add_epi16(a_hi, one)), _mm_mullo_epi16(dst_hi, _mm_sub_epi16(max_alpha, a_hi)));
+		_mm_storeu_si128((__m128i*) (dst + i), _mm_packus_epi16(_mm_srli_epi16(res_lo, 8), _mm_srli_epi16(res_hi, 8)));
+	}
+	return i;
+}
+#endif
+
+/**
+ * Blends a row of pixels onto another. Equivalent to calling Color::blended() for every pixel.
+ */
+static inline void blend_row(Color* dst, const Color* src, int count) {
+	int i = 0;
+#ifdef GFX_SSE2_BLEND
+	if(cpu_has_sse2())
+		i = blend_row_sse2(dst, src, count);
+#endif
+	for(; i < count; i++)
+		dst[i] = dst[i].blended(src[i]);
+}
+
+void Framebuffer::draw_glyph_mask(Font* font, FontGlyph* glyph, const Point& pos, Color color) const {
 	Rect glyph_area = {0, 0, glyph->width, glyph->height};
 
 	//Make sure self_area is in bounds of the framebuffer
 	Rect self_area = {pos.x, pos.y, glyph_area.width, glyph_area.height};
 	self_area = self_area.overlapping_area({0, 0, width, height});
 	if(self_area.empty())
-		return glyph_pos + Point {glyph->next_offset.x, glyph->next_offset.y};
+		return;
 
 	//Update glyph_area with the changes made to self_area
 	glyph_area.x += self_area.x - pos.x;
@@ -385,6 +468,18 @@ Point Framebuffer::draw_glyph(Font* font, uint32_t codepoint, const Point& glyph
 	glyph_area.width = self_area.width;
 	glyph_area.height = self_area.height;
 
+	//Blend the pre-colored mask from the glyph atlas if we can
+	auto& atlas = GlyphAtlas::for_font(font);
+	if(auto* mask = atlas.mask(glyph, color)) {
+		for(int y = 0; y < self_area.height; y++) {
+			blend_row(
+				&data[self_area.x + (self_area.y + y) * width],
+				&mask[glyph_area.x + (glyph_area.y + y) * atlas.stride()],
+				self_area.width);
+		}
+		return;
+	}
+
 	for(int y = 0; y < self_area.height; y++) {
 		for(int x = 0; x < self_area.width; x++) {
 			auto& this_val = data[(self_area.x + x) + (self_area.y + y) * width];
@@ -393,8 +488,6 @@ Point Framebuffer::draw_glyph(Font* font, uint32_t codepoint, const Point& glyph
 				this_val = this_val.blended(color);
 		}
 	}
-
-	return glyph_pos + Point {glyph->next_offset.x, glyph->next_offset.y};
 }
 
 void Framebuffer::multiply(Color color) {
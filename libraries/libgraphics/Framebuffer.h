@@ -30,6 +30,8 @@
 
 namespace Gfx {
 	class Font;
+	class GlyphRun;
+	struct FontGlyph;
 	class Framebuffer: public Duck::Serializable {
 	public:
 		Framebuffer();
@@ -211,6 +213,15 @@ namespace Gfx {
 		 */
 		Point draw_glyph(Font* font, uint32_t codepoint, const Point& pos, Color color) const;
 
+		/**
+		 * Draws a pre-shaped run of glyphs on the Image with a certain color.
+		 * @param run The glyph run to draw.
+		 * @param pos The top-left position of where to draw.
+		 * @param color The color to draw the glyphs in.
+		 * @return The position where the next character should be drawn.
+		 */
+		Point draw_glyph_run(const GlyphRun& run, const Point& pos, Color color) const;
+
 		/**
 		 * Multiplies the image with a certain color.
 		 * @param color The color to multiply by.
@@ -238,6 +249,9 @@ namespace Gfx {
 		size_t serialized_size() const override;
 		void serialize(uint8_t*& buf) const override;
 		void deserialize(const uint8_t*& buf) override;
+
+	private:
+		void draw_glyph_mask(Font* font, FontGlyph* glyph, const Point& pos, Color color) const;
 	};
 }
 
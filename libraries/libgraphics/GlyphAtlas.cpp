@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "GlyphAtlas.h"
+#include "Font.h"
+#include <map>
+#include <memory>
+
+using namespace Gfx;
+
+static std::map<Font*, std::unique_ptr<GlyphAtlas>> s_atlases;
+
+GlyphAtlas& GlyphAtlas::for_font(Font* font) {
+	auto it = s_atlases.find(font);
+	if(it != s_atlases.end())
+		return *it->second;
+	auto* atlas = new GlyphAtlas(font, DEFAULT_CAPACITY);
+	s_atlases[font] = std::unique_ptr<GlyphAtlas>(atlas);
+	return *atlas;
+}
+
+void GlyphAtlas::forget(Font* font) {
+	s_atlases.erase(font);
+}
+
+GlyphAtlas::GlyphAtlas(Font* font, int capacity):
+	m_slot_dimensions {font->bounding_box().width, font->bounding_box().height},
+	m_capacity(capacity)
+{
+	m_slots.reserve(capacity);
+	m_index.reserve(capacity);
+}
+
+const Color* GlyphAtlas::mask(FontGlyph* glyph, Color color) {
+	if(glyph->width > m_slot_dimensions.width || glyph->height > m_slot_dimensions.height)
+		return nullptr;
+
+	size_t slot_size = m_slot_dimensions.width * m_slot_dimensions.height;
+	uint64_t key = ((uint64_t) color.value << 32) | glyph->codepoint;
+	auto it = m_index.find(key);
+	if(it != m_index.end()) {
+		touch(it->second);
+		return &m_pixels[it->second * slot_size];
+	}
+
+	// Find a slot for the glyph, either by growing the atlas or by evicting the least recently used glyph
+	int slot;
+	if((int) m_slots.size() < m_capacity) {
+		slot = m_slots.size();
+		m_slots.push_back({key, -1, -1});
+		m_pixels.resize(m_slots.size() * slot_size);
+	} else {
+		slot = m_tail;
+		unlink(slot);
+		m_index.erase(m_slots[slot].key);
+		m_slots[slot].key = key;
+	}
+	m_index[key] = slot;
+	touch(slot);
+
+	// Expand the glyph's mask into the color. Pixels outside of the glyph are left fully transparent.
+	Color* pixels = &m_pixels[slot * slot_size];
+	for(int y = 0; y < glyph->height; y++) {
+		for(int x = 0; x < glyph->width; x++) {
+			uint8_t coverage = glyph->bitmap[x + y * glyph->width];
+			pixels[x + y * m_slot_dimensions.width] = coverage ? Color(color.r, color.g, color.b, (color.a * coverage) / 255) : Color(0);
+		}
+	}
+
+	return pixels;
+}
+
+void GlyphAtlas::touch(int slot) {
+	if(m_head == slot)
+		return;
+	unlink(slot);
+	m_slots[slot].prev = -1;
+	m_slots[slot].next = m_head;
+	if(m_head != -1)
+		m_slots[m_head].prev = slot;
+	m_head = slot;
+	if(m_tail == -1)
+		m_tail = slot;
+}
+
+void GlyphAtlas::unlink(int slot) {
+	auto& entry = m_slots[slot];
+	if(entry.prev != -1)
+		m_slots[entry.prev].next = entry.next;
+	else if(m_head == slot)
+		m_head = entry.next;
+	if(entry.next != -1)
+		m_slots[entry.next].prev = entry.prev;
+	else if(m_tail == slot)
+		m_tail = entry.prev;
+	entry.prev = -1;
+	entry.next = -1;
+}
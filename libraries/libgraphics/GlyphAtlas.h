@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "Color.h"
+#include "Geometry.h"
+
+namespace Gfx {
+	class Font;
+	struct FontGlyph;
+
+	/**
+	 * A per-font cache of glyph masks that have been expanded into colored pixels, so that drawing a glyph is a
+	 * straight blend of one buffer onto another. Every slot in the atlas is the size of the font's bounding box and
+	 * slots are recycled in least-recently-used order.
+	 */
+	class GlyphAtlas {
+	public:
+		static constexpr int DEFAULT_CAPACITY = 512;
+
+		/// Gets (or creates) the atlas for a font.
+		static GlyphAtlas& for_font(Font* font);
+
+		/// Drops the atlas for a font. Called when a font is destroyed.
+		static void forget(Font* font);
+
+		/**
+		 * Gets the expanded mask for a glyph in a color, rendering it into the atlas if needed.
+		 * @return A pointer to the top-left pixel of the mask, which is stride() pixels wide. nullptr if the glyph
+		 *         doesn't fit in an atlas slot.
+		 */
+		const Color* mask(FontGlyph* glyph, Color color);
+
+		/// The width in pixels of each row of the atlas.
+		[[nodiscard]] int stride() const { return m_slot_dimensions.width; }
+
+	private:
+		GlyphAtlas(Font* font, int capacity);
+
+		struct Slot {
+			uint64_t key;
+			int prev;
+			int next;
+		};
+
+		void touch(int slot);
+		void unlink(int slot);
+
+		Dimensions m_slot_dimensions;
+		int m_capacity;
+		std::vector<Color> m_pixels;
+		std::vector<Slot> m_slots;
+		std::unordered_map<uint64_t, int> m_index;
+		int m_head = -1; ///< Most recently used
+		int m_tail = -1; ///< Least recently used
+	};
+}
@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "GlyphRun.h"
+#include "Font.h"
+
+using namespace Gfx;
+
+GlyphRun::GlyphRun(Font* font, std::string_view text): m_font(font) {
+	auto bbx = font->bounding_box();
+	m_glyphs.reserve(text.size());
+	m_bounds = {0, 0, 0, bbx.height};
+	for(auto ch : text) {
+		auto* glyph = font->glyph(ch);
+		Point pos = {
+			m_advance.x + glyph->base_x - bbx.base_x,
+			m_advance.y + (bbx.base_y - glyph->base_y) + (font->size() - glyph->height)
+		};
+		m_glyphs.push_back({glyph, pos});
+		m_bounds = m_bounds.combine({pos, glyph->width, glyph->height});
+		m_advance = m_advance + Point {glyph->next_offset.x, glyph->next_offset.y};
+	}
+}
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include "Geometry.h"
+
+namespace Gfx {
+	class Font;
+	struct FontGlyph;
+
+	/**
+	 * A string that has been shaped into positioned glyphs ahead of time, so that it can be drawn over and over
+	 * without looking up or positioning each glyph again.
+	 */
+	class GlyphRun {
+	public:
+		struct Glyph {
+			FontGlyph* glyph;
+			Point pos; ///< The top-left position of the glyph's bitmap, relative to the origin of the run.
+		};
+
+		GlyphRun() = default;
+
+		/**
+		 * Shapes a string into a glyph run.
+		 * @param font The font to use.
+		 * @param text The text to shape. Does not need to be zero-terminated.
+		 */
+		GlyphRun(Font* font, std::string_view text);
+
+		[[nodiscard]] Font* font() const { return m_font; }
+		[[nodiscard]] const std::vector<Glyph>& glyphs() const { return m_glyphs; }
+		[[nodiscard]] bool empty() const { return m_glyphs.empty(); }
+
+		/// The position where the next character after the run should be drawn, relative to the origin of the run.
+		[[nodiscard]] Point advance() const { return m_advance; }
+
+		/// The area covered by the glyphs in the run, relative to the origin of the run.
+		[[nodiscard]] Rect bounds() const { return m_bounds; }
+
+	private:
+		Font* m_font = nullptr;
+		std::vector<Glyph> m_glyphs;
+		Point m_advance = {0, 0};
+		Rect m_bounds = {0, 0, 0, 0};
+	};
+}
@@ -154,6 +154,10 @@ int Context::connection_fd() {
 	return endpoint->bus()->file_descriptor();
 }
 
+int Context::channel_fd() {
+	return endpoint->bus()->channel_file_descriptor();
+}
+
 void Context::handle_window_opened(const WindowOpenedPkt& pkt, Event& event) {
 	if(pkt.window_id < 0) {
 		event.window_create.window = NULL;
@@ -85,6 +85,13 @@ namespace Pond {
 		 */
 		int connection_fd();
 
+		/**
+		 * Returns the file descriptor that becomes readable when events arrive through the direct channel to pond,
+		 * which should be waited on alongside connection_fd().
+		 * @return The file descriptor, or -1 if there is no channel.
+		 */
+		int channel_fd();
+
 		/**
 		 * Gets the dimensions of the display.
 		 * @return The dimensions of the display.
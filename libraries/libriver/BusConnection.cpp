@@ -26,8 +26,10 @@
 #include "BusServer.h"
 #include "Function.hpp"
 #include "Message.hpp"
+#include "Channel.h"
 #include <libnusa/Log.h>
 #include <fcntl.h>
+#include <sys/futex.h>
 
 using namespace River;
 using Duck::Result, Duck::ResultRet, Duck::Log;
@@ -38,7 +40,9 @@ ResultRet<std::shared_ptr<BusConnection>> BusConnection::connect(const std::stri
 		Log::err("[River] Failed to open socket ", socket_name, " for bus connection: ", strerror(errno));
 		return Result(errno);
 	}
-	return std::make_shared<BusConnection>(fd, CUSTOM);
+	auto ret = std::make_shared<BusConnection>(fd, CUSTOM);
+	ret->open_doorbell();
+	return ret;
 }
 
 ResultRet<std::shared_ptr<BusConnection>> BusConnection::connect(BusConnection::BusType type, bool nonblock) {
@@ -48,7 +52,9 @@ ResultRet<std::shared_ptr<BusConnection>> BusConnection::connect(BusConnection::
 			Log::err("[River] Failed to open socket for system bus connection: ", strerror(errno));
 			return Result(errno);
 		}
-		return std::make_shared<BusConnection>(fd, type);
+		auto ret = std::make_shared<BusConnection>(fd, type);
+		ret->open_doorbell();
+		return ret;
 	} else {
 		Log::err("[River] Cannot open custom BusConnection without specifying a socket name!");
 		return Result(EINVAL);
@@ -58,6 +64,8 @@ ResultRet<std::shared_ptr<BusConnection>> BusConnection::connect(BusConnection::
 BusConnection::~BusConnection() {
 	if(_fd)
 		close(_fd);
+	if(_doorbell_fd >= 0)
+		close(_doorbell_fd);
 }
 
 ResultRet<std::shared_ptr<Endpoint>> BusConnection::register_endpoint(const std::string& name) {
@@ -85,6 +93,17 @@ ResultRet<std::shared_ptr<Endpoint>> BusConnection::get_endpoint(const std::stri
 	}
 	auto ret = std::make_shared<Endpoint>(shared_from_this(), name, Endpoint::PROXY);
 	_endpoints[name] = ret;
+
+	//The reply contains the pid of the endpoint's host, so we can try to open a channel directly to it. Until the host
+	//answers, everything goes through the bus.
+	if(_channels_enabled && _doorbell && packet.data.size() == sizeof(pid_t)) {
+		pid_t host_pid;
+		memcpy(&host_pid, packet.data.data(), sizeof(pid_t));
+		auto channel_res = open_channel(ret, host_pid);
+		if(channel_res.is_error())
+			Log::dbg("[River] Couldn't open channel to ", name, ", using the bus instead: ", error_str(channel_res.code()));
+	}
+
 	return ret;
 }
 
@@ -93,17 +112,27 @@ Result BusConnection::send_packet(const RiverPacket& packet) {
 }
 
 void BusConnection::read_all_packets(bool block) {
-	if(block) {
-		struct pollfd pfd = {_fd, POLLIN, 0};
-		poll(&pfd, 1, -1);
+	if(block)
+		wait_for_packets();
+	std::vector<RiverPacket> packets;
+	while(River::receive_packets(_fd, false, packets).code() != NO_PACKET) {
+		for(auto& packet : packets) {
+			//Finish opening channels as soon as their hosts answer, even if we're waiting on something else
+			if(packet.type == OPEN_CHANNEL && finish_open_channel(packet))
+				continue;
+			_packet_queue.push_back(std::move(packet));
+		}
+		packets.clear();
 	}
-	while(read_packet(false) != NO_PACKET);
+	read_channel_packets();
 }
 
 void BusConnection::read_and_handle_packets(bool block) {
 	read_all_packets(_packet_queue.empty() ? block : false);
 	while(!_packet_queue.empty()) {
-		auto& pkt = _packet_queue.front();
+		//Take the packet out of the queue first, since handling it may read more packets
+		auto pkt = std::move(_packet_queue.front());
+		_packet_queue.pop_front();
 
 		switch(pkt.type) {
 			case FUNCTION_CALL:
@@ -122,11 +151,13 @@ void BusConnection::read_and_handle_packets(bool block) {
 				handle_message(pkt);
 				break;
 
+			case OPEN_CHANNEL:
+				handle_open_channel(pkt);
+				break;
+
 			default:
 				Log::err("[River] Unhandled packet type ", pkt.type);
 		}
-
-		_packet_queue.pop_front();
 	}
 }
 
@@ -134,6 +165,14 @@ int BusConnection::file_descriptor() {
 	return _fd;
 }
 
+int BusConnection::channel_file_descriptor() {
+	return _doorbell_fd;
+}
+
+void BusConnection::set_channels_enabled(bool enabled) {
+	_channels_enabled = enabled;
+}
+
 PacketReadResult BusConnection::read_packet(bool block) {
 	auto pkt_res = River::receive_packet(_fd, block);
 	if(pkt_res.is_error())
@@ -144,19 +183,130 @@ PacketReadResult BusConnection::read_packet(bool block) {
 
 RiverPacket BusConnection::await_packet(PacketType type, const std::string& endpoint, const std::string& path) {
 	while(true) {
-		if(read_packet(true) == PACKET_READ) {
-			auto& packet = _packet_queue.back();
-			if (packet.type == type) {
-				if((endpoint.empty() || endpoint == packet.endpoint) && (path.empty() || path == packet.path)) {
-					auto ret = _packet_queue.back();
-					_packet_queue.pop_back();
-					return ret;
+		//Packets can arrive from the socket and from channels at once, so look through everything we've queued
+		for(auto it = _packet_queue.begin(); it != _packet_queue.end(); it++) {
+			auto& packet = *it;
+			if(packet.type == type && (endpoint.empty() || endpoint == packet.endpoint) && (path.empty() || path == packet.path)) {
+				auto ret = std::move(packet);
+				_packet_queue.erase(it);
+				return ret;
+			}
+		}
+		read_all_packets(true);
+	}
+}
+
+void BusConnection::open_doorbell() {
+	auto doorbell_res = Duck::SharedBuffer::alloc(sizeof(futex_t), "River doorbell");
+	if(doorbell_res.is_error()) {
+		Log::warn("[River] Couldn't allocate doorbell, channels will be unavailable: ", doorbell_res.strerror());
+		return;
+	}
+
+	auto doorbell = doorbell_res.value();
+	*doorbell->ptr<futex_t>() = 0;
+	int fd = futex_open(doorbell->ptr<futex_t>());
+	if(fd < 0) {
+		Log::warn("[River] Couldn't open doorbell, channels will be unavailable: ", strerror(errno));
+		return;
+	}
+
+	_doorbell = doorbell;
+	_doorbell_fd = fd;
+}
+
+void BusConnection::wait_for_packets() {
+	struct pollfd pfds[2] = {
+		{_fd, POLLIN, 0},
+		{_doorbell_fd, POLLIN, 0}
+	};
+	poll(pfds, _doorbell_fd >= 0 ? 2 : 1, -1);
+}
+
+void BusConnection::read_channel_packets() {
+	if(!_doorbell)
+		return;
+
+	//Reset the doorbell before reading, so that anything sent while we're reading rings it again
+	while(futex_trywait(_doorbell->ptr<futex_t>()));
+
+	for(auto& endpoint : _endpoints) {
+		if(!endpoint.second)
+			continue;
+		for(auto& channel : endpoint.second->channels()) {
+			while(true) {
+				auto pkt_res = channel.second->receive();
+				if(pkt_res.is_error()) {
+					if(pkt_res.code() == PACKET_ERR)
+						Log::warnf("[River] Malformed packet received through channel from {x}", channel.first);
+					break;
 				}
+				_packet_queue.push_back(std::move(pkt_res.value()));
 			}
 		}
 	}
 }
 
+Result BusConnection::open_channel(const std::shared_ptr<Endpoint>& endpoint, pid_t host_pid) {
+	auto channel = TRY(Channel::create(endpoint->name(), host_pid, SOCKETFS_RECIPIENT_HOST));
+
+	//Don't wait for the reply here, since the host may be busy or waiting on us. It's handled in read_all_packets.
+	auto request = channel->request(_doorbell->id());
+	RiverPacket packet = {OPEN_CHANNEL, endpoint->name()};
+	packet.data.resize(sizeof(OpenChannelRequest));
+	memcpy(packet.data.data(), &request, sizeof(OpenChannelRequest));
+	TRYRES(send_packet(packet));
+	_pending_channels[endpoint->name()] = channel;
+	return Result::SUCCESS;
+}
+
+bool BusConnection::finish_open_channel(const RiverPacket& reply) {
+	auto pending = _pending_channels.find(reply.endpoint);
+	if(pending == _pending_channels.end())
+		return false;
+	auto channel = std::move(pending->second);
+	_pending_channels.erase(pending);
+
+	auto res = [&]() -> Result {
+		auto& endpoint = _endpoints[reply.endpoint];
+		if(!endpoint || endpoint->type() != Endpoint::PROXY)
+			return Result(ENDPOINT_DOES_NOT_EXIST);
+		if(reply.error)
+			return Result(reply.error);
+		if(reply.data.size() != sizeof(OpenChannelResponse))
+			return Result(MALFORMED_DATA);
+
+		OpenChannelResponse response;
+		memcpy(&response, reply.data.data(), sizeof(OpenChannelResponse));
+		TRYRES(channel->set_peer_doorbell(response.doorbell_shm));
+		endpoint->add_channel(channel);
+		return Result::SUCCESS;
+	}();
+
+	//Anything the host has already sent through the channel is picked up when read_all_packets reads the channels
+	if(res.is_error())
+		Log::dbg("[River] Couldn't open channel to ", reply.endpoint, ", using the bus instead: ", error_str(res.code()));
+	return true;
+}
+
+Result BusConnection::attach_channel(const RiverPacket& packet) {
+	auto& endpoint = _endpoints[packet.endpoint];
+	if(!endpoint || endpoint->type() != Endpoint::HOST)
+		return Result(ENDPOINT_DOES_NOT_EXIST);
+	if(!_channels_enabled || !_doorbell)
+		return Result(ILLEGAL_REQUEST);
+	if(packet.data.size() != sizeof(OpenChannelRequest))
+		return Result(MALFORMED_DATA);
+
+	OpenChannelRequest request;
+	memcpy(&request, packet.data.data(), sizeof(OpenChannelRequest));
+	if(_doorbell->allow(request.pid) < 0)
+		return Result(errno);
+
+	endpoint->add_channel(TRY(Channel::attach(request, packet.sender)));
+	return Result::SUCCESS;
+}
+
 void BusConnection::handle_function_call(const RiverPacket& packet) {
 	if(!_endpoints[packet.endpoint]) {
 		Log::warn("[River] Got function call for unknown endpoint ", packet.endpoint);
@@ -207,6 +357,26 @@ void BusConnection::handle_client_disconnected(const RiverPacket& packet) {
 	}
 
 	auto& endpoint = _endpoints[packet.endpoint];
+	endpoint->remove_channel(packet.disconnected_id);
 	if(endpoint->on_client_disconnect)
 		endpoint->on_client_disconnect(packet.disconnected_id, packet.disconnected_pid);
+}
+
+void BusConnection::handle_open_channel(const RiverPacket& packet) {
+	//Replies are handled in read_all_packets, so this is a stray one. Answering it could bounce errors back and forth.
+	if(packet.error)
+		return;
+
+	auto res = attach_channel(packet);
+	if(res.is_error())
+		Log::warnf("[River] Couldn't open channel from {x} to {}: {}", packet.sender, packet.endpoint, error_str(res.code()));
+
+	RiverPacket reply = {OPEN_CHANNEL, packet.endpoint, "", (ErrorType) res.code()};
+	reply.recipient = packet.sender;
+	if(res.is_success()) {
+		OpenChannelResponse response = {_doorbell->id()};
+		reply.data.resize(sizeof(OpenChannelResponse));
+		memcpy(reply.data.data(), &response, sizeof(OpenChannelResponse));
+	}
+	send_packet(reply);
 }
\ No newline at end of file
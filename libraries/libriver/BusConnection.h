@@ -25,11 +25,13 @@
 #include <map>
 #include <memory>
 #include <utility>
+#include <libnusa/SharedBuffer.h>
 #include "packet.h"
 
 namespace River {
 	class Endpoint;
 	class BusServer;
+	class Channel;
 
 	class BusConnection: public std::enable_shared_from_this<BusConnection> {
 	public:
@@ -52,21 +54,40 @@ namespace River {
 		void read_all_packets(bool block);
 		void read_and_handle_packets(bool block);
 		int file_descriptor();
+		int channel_file_descriptor(); ///< Readable when a packet arrives through a Channel, or -1 if channels are unavailable.
+		void set_channels_enabled(bool enabled);
 
 		PacketReadResult read_packet(bool block);
 		RiverPacket await_packet(PacketType type, const std::string& endpoint = "", const std::string& path = "");
 
 	private:
+		void open_doorbell();
+		void wait_for_packets();
+		void read_channel_packets();
+		Duck::Result open_channel(const std::shared_ptr<Endpoint>& endpoint, pid_t host_pid);
+		bool finish_open_channel(const RiverPacket& reply);
+		Duck::Result attach_channel(const RiverPacket& packet);
+
 		void handle_function_call(const RiverPacket& packet);
 		void handle_message(const RiverPacket& packet);
 		void handle_client_connected(const RiverPacket& packet);
 		void handle_client_disconnected(const RiverPacket& packet);
+		void handle_open_channel(const RiverPacket& packet);
 
 		int _fd = 0;
 		BusServer* _server = nullptr;
 		BusType _type;
 		std::map<std::string, std::shared_ptr<Endpoint>> _endpoints;
 		std::deque<RiverPacket> _packet_queue;
+
+		/**
+		 * A futex in shared memory that every peer we have a Channel with signals after sending to us, so that all of
+		 * our channels can be waited on at once with poll().
+		 */
+		Duck::Ptr<Duck::SharedBuffer> _doorbell;
+		int _doorbell_fd = -1;
+		std::map<std::string, std::shared_ptr<Channel>> _pending_channels; ///< Channels we've asked endpoint hosts to attach to.
+		bool _channels_enabled = true;
 	};
 }
 
@@ -61,62 +61,65 @@ void BusServer::read_and_handle_packets(bool block) {
 		poll(&pfd, 1, -1);
 	}
 
-	ResultRet<RiverPacket> pkt_res(0);
-	while((pkt_res = receive_packet(_fd, false)).code() != NO_PACKET) {
-		if(pkt_res.is_error())
-			continue;
-		auto packet = pkt_res.value();
+	std::vector<RiverPacket> packets;
+	if(receive_packets(_fd, false, packets).is_error())
+		return;
 
+	for(auto& packet : packets) {
 		switch(packet.type) {
 			case SOCKETFS_CLIENT_CONNECTED:
 				client_connected(packet);
-				return;
+				break;
 
 			case SOCKETFS_CLIENT_DISCONNECTED:
 				client_disconnected(packet);
-				return;
+				break;
 
 			case REGISTER_ENDPOINT:
 				register_endpoint(packet);
-				return;
+				break;
 
 			case GET_ENDPOINT:
 				get_endpoint(packet);
-				return;
+				break;
+
+			case OPEN_CHANNEL:
+				open_channel(packet);
+				break;
 
 			case REGISTER_FUNCTION:
 				register_function(packet);
-				return;
+				break;
 
 			case GET_FUNCTION:
 				get_function(packet);
-				return;
+				break;
 
 			case FUNCTION_CALL:
 				call_function(packet);
-				return;
+				break;
 
 			case FUNCTION_RETURN:
 				function_return(packet);
-				return;
+				break;
 
 			case REGISTER_MESSAGE:
 				register_message(packet);
-				return;
+				break;
 
 			case GET_MESSAGE:
 				get_message(packet);
-				return;
+				break;
 
 			case SEND_MESSAGE:
 				send_message(packet);
-				return;
+				break;
 
 			default:
 				packet.error = MALFORMED_DATA;
 				packet.data.clear();
 				send_packet(packet.__socketfs_from_id, packet);
-				return;
+				break;
 		}
 	}
 }
@@ -244,7 +247,7 @@ void BusServer::register_endpoint(const RiverPacket& packet) {
 		return;
 	}
 
-	_endpoints[packet.endpoint] = std::make_unique<ServerEndpoint>(ServerEndpoint{packet.endpoint, packet.__socketfs_from_id});
+	_endpoints[packet.endpoint] = std::make_unique<ServerEndpoint>(ServerEndpoint{packet.endpoint, packet.__socketfs_from_id, packet.__socketfs_from_pid});
 	Log::dbg("[River] Registering endpoint ", packet.endpoint);
 
 	auto& client = _clients[packet.__socketfs_from_id];
@@ -276,12 +279,55 @@ void BusServer::get_endpoint(const RiverPacket& packet) {
 		});
 	}
 
-	send_packet(packet.__socketfs_from_id, {
+	//Tell the client who hosts the endpoint, so it can open a channel to it
+	RiverPacket reply = {
 			packet.type,
 			packet.endpoint,
 			packet.path,
 			SUCCESS
-	});
+	};
+	reply.data.resize(sizeof(pid_t));
+	memcpy(reply.data.data(), &endpoint->pid, sizeof(pid_t));
+	send_packet(packet.__socketfs_from_id, reply);
+}
+
+void BusServer::open_channel(const RiverPacket& packet) {
+	VERIFY_ENDPOINT
+
+	//The host's reply goes back to the client that asked
+	if(endpoint->id == packet.__socketfs_from_id) {
+		if(packet.recipient == SOCKETFS_RECIPIENT_HOST || packet.recipient == endpoint->id)
+			return;
+		send_packet(packet.recipient, packet);
+		return;
+	}
+
+	//Make sure the client is who it says it is before the host shares memory with it
+	OpenChannelRequest request;
+	if(packet.data.size() != sizeof(OpenChannelRequest)) {
+		send_packet(packet.__socketfs_from_id, {
+				packet.type,
+				packet.endpoint,
+				packet.path,
+				MALFORMED_DATA
+		});
+		return;
+	}
+	memcpy(&request, packet.data.data(), sizeof(OpenChannelRequest));
+	if(request.pid != packet.__socketfs_from_pid) {
+		send_packet(packet.__socketfs_from_id, {
+				packet.type,
+				packet.endpoint,
+				packet.path,
+				ILLEGAL_REQUEST
+		});
+		return;
+	}
+
+	RiverPacket channel_packet = packet;
+	channel_packet.sender = packet.__socketfs_from_id;
+	channel_packet.__socketfs_from_id = 0;
+	send_packet(endpoint->id, channel_packet);
 }
 
 void BusServer::register_function(const RiverPacket& packet) {
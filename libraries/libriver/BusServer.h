@@ -59,6 +59,7 @@ namespace River {
 		struct ServerEndpoint {
 			std::string name;
 			sockid_t id;
+			pid_t pid;
 			std::map<std::string, std::unique_ptr<ServerFunction>> functions;
 			std::map<std::string, std::unique_ptr<ServerMessage>> messages;
 		};
@@ -77,6 +78,7 @@ namespace River {
 		void client_disconnected(const RiverPacket& packet);
 		void register_endpoint(const RiverPacket& packet);
 		void get_endpoint(const RiverPacket& packet);
+		void open_channel(const RiverPacket& packet);
 		void register_function(const RiverPacket& packet);
 		void get_function(const RiverPacket& packet);
 		void call_function(const RiverPacket& packet);
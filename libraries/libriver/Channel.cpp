@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#include "Channel.h"
+#include <sys/futex.h>
+#include <unistd.h>
+
+using namespace Duck;
+using namespace River;
+
+Channel::Channel(Ptr<IPCBufferSender> sender, Ptr<IPCBufferReceiver> receiver, sockid_t peer_id):
+	m_sender(std::move(sender)),
+	m_receiver(std::move(receiver)),
+	m_peer_id(peer_id)
+{}
+
+ResultRet<Ptr<Channel>> Channel::create(const std::string& name, pid_t host_pid, sockid_t host_id) {
+	auto to_host = TRY(IPCBuffer::alloc("River channel to " + name));
+	auto to_client = TRY(IPCBuffer::alloc("River channel from " + name));
+	if(to_host->buffer()->allow(host_pid) < 0 || to_client->buffer()->allow(host_pid) < 0)
+		return Result(errno);
+
+	auto sender = TRY(IPCBufferSender::attach(to_host->buffer()));
+	auto receiver = TRY(IPCBufferReceiver::attach(to_client->buffer()));
+	return Ptr<Channel>(new Channel(sender, receiver, host_id));
+}
+
+ResultRet<Ptr<Channel>> Channel::attach(const OpenChannelRequest& request, sockid_t client_id) {
+	auto to_host = TRY(SharedBuffer::adopt(request.to_host_shm));
+	auto to_client = TRY(SharedBuffer::adopt(request.to_client_shm));
+
+	auto sender = TRY(IPCBufferSender::attach(to_client));
+	auto receiver = TRY(IPCBufferReceiver::attach(to_host));
+	auto channel = Ptr<Channel>(new Channel(sender, receiver, client_id));
+	TRYRES(channel->set_peer_doorbell(request.doorbell_shm));
+	return channel;
+}
+
+OpenChannelRequest Channel::request(int doorbell_shm) const {
+	return {
+		.to_host_shm = m_sender->buffer()->id(),
+		.to_client_shm = m_receiver->buffer()->id(),
+		.doorbell_shm = doorbell_shm,
+		.pid = getpid()
+	};
+}
+
+Result Channel::set_peer_doorbell(int shm_id) {
+	auto doorbell_res = SharedBuffer::adopt(shm_id);
+	if(doorbell_res.is_error())
+		return doorbell_res.result();
+	if(doorbell_res.value()->size() < sizeof(futex_t))
+		return Result(MALFORMED_DATA);
+	m_peer_doorbell = doorbell_res.value();
+	return Result::SUCCESS;
+}
+
+Result Channel::send(const RiverPacket& packet, bool blocking) {
+	if(!m_peer_doorbell)
+		return Result(ILLEGAL_REQUEST);
+
+	//Serialize the packet straight into the shared buffer
+	TRYRES(m_sender->send(raw_packet_size(packet), [&packet] (uint8_t* buffer) {
+		write_raw_packet(packet, (RawPacket*) buffer);
+	}, blocking));
+
+	futex_signal(m_peer_doorbell->ptr<futex_t>());
+	return Result::SUCCESS;
+}
+
+ResultRet<RiverPacket> Channel::receive() {
+	std::optional<ResultRet<RiverPacket>> packet;
+	auto res = m_receiver->recv([&packet] (const uint8_t* data, size_t size) {
+		packet = read_raw_packet((const RawPacket*) data, size);
+	}, false);
+
+	if(res.code() == IPCBuffer::NO_MESSAGE)
+		return Result(NO_PACKET);
+	if(res.is_error() || !packet || packet->is_error())
+		return Result(PACKET_ERR);
+
+	//Packets that come through a channel are always from the peer
+	auto& ret = packet->value();
+	ret.sender = m_peer_id;
+	ret.__socketfs_from_id = m_peer_id;
+	ret.__socketfs_from_pid = 0;
+	return ret;
+}
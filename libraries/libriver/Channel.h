@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+#pragma once
+
+#include "IPCBuffer.h"
+#include "packet.h"
+
+namespace River {
+	/**
+	 * A direct connection between a client and the host of an endpoint, made of a pair of IPCBuffers in shared memory.
+	 * Once a channel is open, function calls, returns and messages skip the socket and the BusServer entirely.
+	 *
+	 * After sending, each side signals the other side's doorbell, which is a futex shared by every channel of a
+	 * BusConnection so that one file descriptor can be polled for all of them.
+	 */
+	class Channel {
+	public:
+		/**
+		 * Creates the client side of a channel and allows the host to access it.
+		 * @param name The name of the endpoint, used to name the shared memory.
+		 * @param host_pid The pid of the process hosting the endpoint.
+		 * @param host_id The socket id of the host.
+		 */
+		static Duck::ResultRet<Duck::Ptr<Channel>> create(const std::string& name, pid_t host_pid, sockid_t host_id);
+
+		/**
+		 * Attaches the host side of a channel created by a client.
+		 * @param request The client's OPEN_CHANNEL request.
+		 * @param client_id The socket id of the client.
+		 */
+		static Duck::ResultRet<Duck::Ptr<Channel>> attach(const OpenChannelRequest& request, sockid_t client_id);
+
+		/** Fills in an OPEN_CHANNEL request for this (client side) channel. **/
+		OpenChannelRequest request(int doorbell_shm) const;
+
+		/** Attaches the doorbell that is signalled after sending. **/
+		Duck::Result set_peer_doorbell(int shm_id);
+
+		/**
+		 * Sends a packet through the channel.
+		 * @param packet The packet to send.
+		 * @param blocking Whether to wait for space in the buffer if it's full.
+		 */
+		Duck::Result send(const RiverPacket& packet, bool blocking);
+
+		/**
+		 * Receives a packet from the channel without blocking.
+		 * @return The packet, or NO_PACKET if there isn't one.
+		 */
+		Duck::ResultRet<RiverPacket> receive();
+
+		sockid_t peer_id() const { return m_peer_id; }
+
+	private:
+		Channel(Duck::Ptr<IPCBufferSender> sender, Duck::Ptr<IPCBufferReceiver> receiver, sockid_t peer_id);
+
+		Duck::Ptr<IPCBufferSender> m_sender;
+		Duck::Ptr<IPCBufferReceiver> m_receiver;
+		Duck::Ptr<Duck::SharedBuffer> m_peer_doorbell;
+		sockid_t m_peer_id;
+	};
+}
@@ -19,6 +19,7 @@
 
 #include "Endpoint.h"
 #include "Function.hpp"
+#include "Channel.h"
 
 using namespace River;
 
@@ -45,3 +46,32 @@ Endpoint::ConnectionType Endpoint::type() const {
 const std::shared_ptr<BusConnection>& Endpoint::bus() {
 	return _bus;
 }
+
+Duck::Result Endpoint::send_packet(const RiverPacket& packet) {
+	std::shared_ptr<Channel> channel;
+	if(_type == PROXY) {
+		if(!_channels.empty())
+			channel = _channels.begin()->second;
+	} else {
+		auto it = _channels.find(packet.recipient);
+		if(it != _channels.end())
+			channel = it->second;
+	}
+
+	//Hosts don't wait for slow clients, just like they don't on the bus's non-blocking socket
+	if(channel)
+		return channel->send(packet, _type == PROXY);
+	return _bus->send_packet(packet);
+}
+
+void Endpoint::add_channel(std::shared_ptr<Channel> channel) {
+	_channels[channel->peer_id()] = std::move(channel);
+}
+
+void Endpoint::remove_channel(sockid_t peer_id) {
+	_channels.erase(peer_id);
+}
+
+const std::map<sockid_t, std::shared_ptr<Channel>>& Endpoint::channels() const {
+	return _channels;
+}
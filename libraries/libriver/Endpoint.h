@@ -33,6 +33,7 @@ namespace River {
 	class IMessage;
 	template<typename T>
 	class Message;
+	class Channel;
 
 	template<typename T>
 	struct type_identity {
@@ -182,6 +183,15 @@ namespace River {
 		std::shared_ptr<IFunction> get_ifunction(const std::string& path);
 		std::shared_ptr<IMessage> get_imessage(const std::string& path);
 
+		/**
+		 * Sends a function call, return or message to the other side of the endpoint. If there's a Channel open to the
+		 * recipient it's sent through that, and otherwise it goes through the bus.
+		 */
+		Duck::Result send_packet(const RiverPacket& packet);
+		void add_channel(std::shared_ptr<Channel> channel);
+		void remove_channel(sockid_t peer_id);
+		const std::map<sockid_t, std::shared_ptr<Channel>>& channels() const;
+
 		const std::string& name();
 		ConnectionType type() const;
 		const std::shared_ptr<BusConnection>& bus();
@@ -191,6 +201,7 @@ namespace River {
 	private:
 		std::map<std::string, std::shared_ptr<IFunction>> _functions;
 		std::map<std::string, std::shared_ptr<IMessage>> _messages;
+		std::map<sockid_t, std::shared_ptr<Channel>> _channels; ///< Keyed by the peer's id. A proxy has at most one, to its host.
 		std::string _name;
 		ConnectionType _type;
 		std::shared_ptr<BusConnection> _bus;
@@ -79,7 +79,7 @@ namespace River {
 				Duck::Serialization::serialize(call_data, args...);
 
 				//Send the function call packet and await a reply (if the function has a non-void return type)
-				_endpoint->bus()->send_packet(packet);
+				_endpoint->send_packet(packet);
 				if constexpr(!std::is_void<RetT>()) {
 					auto pkt = _endpoint->bus()->await_packet(FUNCTION_RETURN, _endpoint->name(), _path);
 					if(pkt.error) {
@@ -108,7 +108,7 @@ namespace River {
 		void remote_call(const RiverPacket& packet) override {
 			//TODO Make sure the data is the correct size
 			/*if(packet.data.size() != buffer_size(ParamTs)) {
-				_endpoint->bus()->send_packet({
+				_endpoint->send_packet({
 					FUNCTION_RETURN,
 					packet.endpoint,
 					packet.path,
@@ -135,7 +135,7 @@ namespace River {
 				resp.data.resize(Duck::Serialization::buffer_size(ret));
 				uint8_t* resp_data = resp.data.data();
 				Duck::Serialization::serialize(resp_data, ret);
-				_endpoint->bus()->send_packet(resp);
+				_endpoint->send_packet(resp);
 			} else {
 				_callback(packet.sender, std::get<ParamTs>(data_tuple)...);
 			}
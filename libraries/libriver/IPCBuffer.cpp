@@ -25,6 +25,7 @@ Duck::ResultRet<Duck::Ptr<IPCBuffer>> IPCBuffer::alloc(std::string name, size_t
 	hdr->magic = IPC_MAGIC;
 	hdr->read_futex = 0;
 	hdr->write_futex = 0;
+	hdr->unread = 0;
 	hdr->read = 0;
 	hdr->write = 0;
 	return Duck::Ptr<IPCBuffer>(new IPCBuffer(buf));
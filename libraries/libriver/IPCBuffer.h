@@ -16,7 +16,7 @@ namespace River {
 		};
 
 		enum ResultCode {
-			NO_MESSAGE,
+			NO_MESSAGE = 1,
 			INVALID_BUFFER_STATE,
 			NO_BUFFER_SPACE,
 			MESSAGE_TOO_LARGE
@@ -71,7 +71,7 @@ namespace River {
 				Duck::Serialization::serialize(buf, data);
 
 				//Send the message packet
-				auto res =  _endpoint->bus()->send_packet(packet);
+				auto res =  _endpoint->send_packet(packet);
 				return res;
 			} else {
 				Duck::Log::err("[River] Tried sending message through proxy endpoint");
@@ -47,119 +47,150 @@ const char* River::error_str(int error) {
 	}
 }
 
-Duck::ResultRet<RiverPacket> River::receive_packet(int fd, bool block)  {
-	if(block) {
-		struct pollfd pfd = {fd, POLLIN, 0};
-		poll(&pfd, 1, -1);
-	}
+size_t River::raw_packet_size(const RiverPacket& packet) {
+	//The path is sent as "endpoint:path" with a null terminator
+	return sizeof(RawPacket) + packet.endpoint.length() + 1 + packet.path.length() + 1 + packet.data.size();
+}
 
-	socketfs_packet* raw_socketfs_packet;
-	if((raw_socketfs_packet = ::read_packet(fd))) {
-		//Handle SocketFS connect and disconnect messages
-		if(raw_socketfs_packet->type != SOCKETFS_TYPE_MSG) {
-			if(raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_CONNECT || raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_DISCONNECT) {
-				RiverPacket ret = {
-					raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_CONNECT ? SOCKETFS_CLIENT_CONNECTED : SOCKETFS_CLIENT_DISCONNECTED,
-					"",
-					"",
-					SUCCESS,
-					0,
-					raw_socketfs_packet->connected_id,
-					raw_socketfs_packet->connected_pid
-				};
-				free(raw_socketfs_packet);
-				return ret;
-			}
-
-			return Result(SOCKETFS_MESSAGE);
-		}
+void River::write_raw_packet(const RiverPacket& packet, RawPacket* raw_packet) {
+	raw_packet->__river_magic = LIBRIVER_PACKET_MAGIC;
+	raw_packet->type = packet.type;
+	raw_packet->error = packet.error;
+	raw_packet->data_length = packet.data.size();
+	raw_packet->path_length = packet.endpoint.length() + 1 + packet.path.length() + 1;
+	raw_packet->id = packet.recipient;
 
-		//Check if the packet is at least the size of the RawPacket header
-		if(raw_socketfs_packet->length < sizeof(RawPacket)) {
-			Log::errf("[River] WARN: Foreign packet received from {x}", raw_socketfs_packet->sender);
-			free(raw_socketfs_packet);
-			return Result(PACKET_ERR);
-		}
+	auto* target = (char*) raw_packet->data;
+	memcpy(target, packet.endpoint.c_str(), packet.endpoint.length());
+	target[packet.endpoint.length()] = ':';
+	memcpy(target + packet.endpoint.length() + 1, packet.path.c_str(), packet.path.length() + 1);
+	if(!packet.data.empty())
+		memcpy(raw_packet->data + raw_packet->path_length, packet.data.data(), packet.data.size());
+}
 
-		auto* raw_packet = (RawPacket*) raw_socketfs_packet->data;
+ResultRet<RiverPacket> River::read_raw_packet(const RawPacket* raw_packet, size_t length) {
+	//Copy the header first, since the packet may be in memory shared with the sender
+	RawPacket header;
+	if(length < sizeof(RawPacket))
+		return Result(PACKET_ERR);
+	memcpy(&header, raw_packet, sizeof(RawPacket));
+
+	//Make sure the magic checks out and the data and path lengths are valid
+	size_t body_length = length - sizeof(RawPacket);
+	if(
+			header.__river_magic != LIBRIVER_PACKET_MAGIC ||
+			header.path_length < 1 ||
+			header.path_length > body_length ||
+			header.data_length != body_length - header.path_length
+	) {
+		return Result(PACKET_ERR);
+	}
 
-		//Check if the RawPacket magic checks out
-		if(raw_packet->__river_magic != LIBRIVER_PACKET_MAGIC) {
-			Log::warnf("[River] RawPacket with invalid magic received from {x}", raw_socketfs_packet->sender);
-			free(raw_socketfs_packet);
-			return Result(PACKET_ERR);
-		}
+	RiverPacket packet {
+		header.type,
+		"",
+		"",
+		header.error,
+		header.id
+	};
+
+	//Get the target and data
+	auto* target_cstr = (const char*) raw_packet->data;
+	std::string target(target_cstr, strnlen(target_cstr, header.path_length));
+	if(header.data_length)
+		packet.data.assign(raw_packet->data + header.path_length, raw_packet->data + header.path_length + header.data_length);
+
+	//Parse the target
+	auto colon = target.find(':');
+	if(colon == std::string::npos) {
+		packet.endpoint = target;
+	} else {
+		packet.endpoint = target.substr(0, colon);
+		packet.path = target.substr(colon + 1);
+	}
 
-		//Make sure the data and path lengths specified in the RawPacket are valid
-		if(
-				raw_packet->data_length + raw_packet->path_length != raw_socketfs_packet->length - sizeof(RawPacket) ||
-				raw_packet->data_length > SOCKETFS_MAX_BUFFER_SIZE ||
-				raw_packet->path_length > SOCKETFS_MAX_BUFFER_SIZE ||
-				raw_packet->path_length < 1
-		) {
-			Log::warnf("[River] Malformed packet received from {x}",raw_socketfs_packet->sender);
-			free(raw_socketfs_packet);
-			return Result(PACKET_ERR);
-		}
+	return packet;
+}
 
-		//Create a new RiverPacket and add it to the deque
-		RiverPacket packet {
-			raw_packet->type,
-			"",
-			"",
-			raw_packet->error,
-			raw_packet->id,
-			raw_socketfs_packet->sender,
-			raw_socketfs_packet->sender_pid
-		};
-
-		//Get the target from the RawPacket
-		auto* target_cstr = new char[raw_packet->path_length];
-		strncpy(target_cstr, (const char*) raw_packet->data, raw_packet->path_length);
-		std::string target = target_cstr;
-		delete[] target_cstr;
-
-		//Get the data from the RawPacket
-		if(raw_packet->data_length) {
-			packet.data.resize(raw_packet->data_length);
-			memcpy(packet.data.data(), raw_packet->data + raw_packet->path_length, raw_packet->data_length);
+static ResultRet<RiverPacket> parse_socketfs_packet(const socketfs_packet* raw_socketfs_packet) {
+	//Handle SocketFS connect and disconnect messages
+	if(raw_socketfs_packet->type != SOCKETFS_TYPE_MSG) {
+		if(raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_CONNECT || raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_DISCONNECT) {
+			return RiverPacket {
+				raw_socketfs_packet->type == SOCKETFS_TYPE_MSG_CONNECT ? SOCKETFS_CLIENT_CONNECTED : SOCKETFS_CLIENT_DISCONNECTED,
+				"",
+				"",
+				SUCCESS,
+				0,
+				raw_socketfs_packet->connected_id,
+				raw_socketfs_packet->connected_pid
+			};
 		}
 
-		//Free the socketFS packet
-		free(raw_socketfs_packet);
+		return Result(SOCKETFS_MESSAGE);
+	}
 
-		//Parse the target
-		auto colon = target.find(':');
-		if(colon == std::string::npos) {
-			packet.endpoint = target;
-		} else {
-			packet.endpoint = target.substr(0, colon);
-			packet.path = target.substr(colon + 1);
-		}
+	auto packet_res = read_raw_packet((const RawPacket*) raw_socketfs_packet->data, raw_socketfs_packet->length);
+	if(packet_res.is_error()) {
+		Log::warnf("[River] Malformed packet received from {x}", raw_socketfs_packet->sender);
+		return Result(PACKET_ERR);
+	}
 
-		return packet;
+	auto& packet = packet_res.value();
+	packet.__socketfs_from_id = raw_socketfs_packet->sender;
+	packet.__socketfs_from_pid = raw_socketfs_packet->sender_pid;
+	return packet;
+}
+
+Duck::ResultRet<RiverPacket> River::receive_packet(int fd, bool block)  {
+	if(block) {
+		struct pollfd pfd = {fd, POLLIN, 0};
+		poll(&pfd, 1, -1);
+	}
+
+	socketfs_packet* raw_socketfs_packet;
+	if((raw_socketfs_packet = ::read_packet(fd))) {
+		auto packet_res = parse_socketfs_packet(raw_socketfs_packet);
+		free(raw_socketfs_packet);
+		return packet_res;
 	}
 
 	return Result(NO_PACKET);
 }
 
-Result River::send_packet(int fd, sockid_t recipient, const RiverPacket& packet, DeadClientCallback on_dead_client) {
-	auto full_name = packet.endpoint + ":" + packet.path;
-	size_t n_bytes = full_name.length() + 1 + packet.data.size();
+Result River::receive_packets(int fd, bool block, std::vector<RiverPacket>& packets) {
+	if(block) {
+		struct pollfd pfd = {fd, POLLIN, 0};
+		poll(&pfd, 1, -1);
+	}
 
-	auto* raw_packet = (RawPacket*) malloc(sizeof(RawPacket) + n_bytes);
-	raw_packet->__river_magic = LIBRIVER_PACKET_MAGIC;
-	raw_packet->type = packet.type;
-	raw_packet->error = packet.error;
-	raw_packet->data_length = packet.data.size();
-	raw_packet->path_length = full_name.length() + 1;
-	raw_packet->id = packet.recipient;
+	//A buffer of the maximum size always fits at least one whole packet
+	static thread_local uint8_t* buffer = nullptr;
+	if(!buffer)
+		buffer = (uint8_t*) malloc(SOCKETFS_MAX_BUFFER_SIZE);
+
+	ssize_t nread = read_packets(fd, buffer, SOCKETFS_MAX_BUFFER_SIZE);
+	if(nread < (ssize_t) sizeof(socketfs_packet))
+		return Result(NO_PACKET);
+
+	auto* raw_socketfs_packet = (socketfs_packet*) buffer;
+	if(sizeof(socketfs_packet) + raw_socketfs_packet->length > (size_t) nread)
+		return Result(PACKET_ERR);
+	for(; raw_socketfs_packet; raw_socketfs_packet = socketfs_next_packet(raw_socketfs_packet, buffer, nread)) {
+		auto packet_res = parse_socketfs_packet(raw_socketfs_packet);
+		if(!packet_res.is_error())
+			packets.push_back(std::move(packet_res.value()));
+	}
 
-	memcpy(raw_packet->data, full_name.c_str(), full_name.length() + 1);
-	if(!packet.data.empty())
-		memcpy(raw_packet->data + full_name.length() + 1, packet.data.data(), packet.data.size());
+	return Result::SUCCESS;
+}
+
+Result River::send_packet(int fd, sockid_t recipient, const RiverPacket& packet, DeadClientCallback on_dead_client) {
+	size_t size = raw_packet_size(packet);
+	auto* raw_packet = (RawPacket*) malloc(size);
+	write_raw_packet(packet, raw_packet);
 
-	if(::write_packet(fd, recipient, sizeof(RawPacket) + n_bytes, raw_packet)) {
+	if(::write_packet(fd, recipient, size, raw_packet)) {
 		int err = errno;
 		free(raw_packet);
 
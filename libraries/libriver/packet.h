@@ -40,6 +40,7 @@ namespace River {
 
 		REGISTER_ENDPOINT = 10,
 		GET_ENDPOINT = 11,
+		OPEN_CHANNEL = 12,
 
 		FUNCTION_CALL = 20,
 		FUNCTION_RETURN = 21,
@@ -107,10 +108,37 @@ namespace River {
 		SOCKETFS_MESSAGE,
 	};
 
+	/**
+	 * The data of an OPEN_CHANNEL request, sent by a client to the host of an endpoint it got. The shared memory is
+	 * allowed for the host's pid before the request is sent.
+	 */
+	struct OpenChannelRequest {
+		int to_host_shm; ///< The IPCBuffer the client sends into.
+		int to_client_shm; ///< The IPCBuffer the host sends into.
+		int doorbell_shm; ///< The client's doorbell, signalled by the host after sending.
+		pid_t pid; ///< The client's pid, checked by the BusServer.
+	};
+
+	/** The data of a successful OPEN_CHANNEL reply. **/
+	struct OpenChannelResponse {
+		int doorbell_shm; ///< The host's doorbell, signalled by the client after sending.
+	};
+
 	
 	using DeadClientCallback = std::function<void(int fd, sockid_t id)>;
 
+	size_t raw_packet_size(const RiverPacket& packet);
+	void write_raw_packet(const RiverPacket& packet, RawPacket* raw_packet);
+	Duck::ResultRet<RiverPacket> read_raw_packet(const RawPacket* raw_packet, size_t length);
+
 	Duck::ResultRet<RiverPacket> receive_packet(int fd, bool block);
+
+	/**
+	 * Reads every packet that's waiting on a socket (up to SOCKETFS_MAX_BUFFER_SIZE bytes of them) with a single read
+	 * and appends them to packets. Malformed packets are skipped.
+	 * @return NO_PACKET if there was nothing to read.
+	 */
+	Duck::Result receive_packets(int fd, bool block, std::vector<RiverPacket>& packets);
 	Duck::Result send_packet(int fd, sockid_t recipient, const RiverPacket& packet,
 	                         DeadClientCallback on_dead_client = nullptr);
 }
\ No newline at end of file
@@ -35,7 +35,12 @@ ResultRet<CPU::Info> CPU::get_info(Duck::InputStream& file) {
 	if(!cfg.has_section("cpu"))
 		return Result::FAILURE;
 
-	return CPU::Info {std::stod(cfg["cpu"]["util"])};
+	auto& cpu = cfg["cpu"];
+	return CPU::Info {
+		std::stod(cpu["util"]),
+		{std::stod(cpu["load_1"]), std::stod(cpu["load_5"]), std::stod(cpu["load_15"])},
+		std::stoull(cpu["context_switches"])
+	};
 }
 
 ResultRet<CPU::Info> CPU::get_info() {
@@ -26,6 +26,8 @@ namespace Sys::CPU {
 	class Info {
 	public:
 		double utilization;
+		double load_averages[3]; ///< The average number of runnable threads over the last 1, 5, and 15 minutes.
+		unsigned long long context_switches;
 	};
 
 	Duck::ResultRet<Info> get_info(Duck::InputStream& stream);
@@ -22,24 +22,74 @@
 #include <libnusa/Config.h>
 #include <unistd.h>
 #include <libnusa/File.h>
+#include <kernel/api/snapshot.h>
+#include <fcntl.h>
 
 using namespace Sys;
 using Duck::Result, Duck::ResultRet, Duck::Path;
 
+// Remembers how many processes there were last time, so the buffer is usually big enough on the first try
+static size_t s_snapshot_capacity = 64;
+
+static ResultRet<Duck::Config> read_status(pid_t pid) {
+	auto cfg = TRY(Duck::Config::read_from("/proc/" + std::to_string(pid) + "/status"));
+	if(!cfg.has_section("proc"))
+		return Result::FAILURE;
+	return cfg;
+}
+
+static void parse_threads(const std::string& str, std::vector<tid_t>& threads) {
+	Duck::StringInputStream stream { str };
+	stream.set_delimeter(',');
+	threads.clear();
+	while (!stream.eof()) {
+		std::string thrd;
+		stream >> thrd;
+		threads.push_back(std::stoi(thrd));
+	}
+}
+
 std::map<pid_t, Process> Process::get_all() {
 	std::map<pid_t, Process> ret;
 
-	auto ent_res = Path("/proc/").get_directory_entries();
-	if(ent_res.is_error())
+	int fd = open(PROC_SNAPSHOT_PATH, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
 		return ret; //This should not happen
 
-	for(const auto& ent : ent_res.value()) {
-		if(ent.is_directory() && std::isdigit(ent.name()[0])) {
-			pid_t pid = std::stoi(std::string(ent.name()));
-			auto proc_res = get(pid);
-			if(proc_res.has_value())
-				ret[pid] = proc_res.value();
+	std::vector<uint8_t> buf;
+	auto header = (proc_snapshot_header*) nullptr;
+	while(true) {
+		buf.resize(sizeof(proc_snapshot_header) + s_snapshot_capacity * sizeof(proc_snapshot_record));
+		ssize_t nread = read(fd, buf.data(), buf.size());
+		if(nread < (ssize_t) sizeof(proc_snapshot_header)) {
+			close(fd);
+			return ret;
 		}
+		header = (proc_snapshot_header*) buf.data();
+		if(header->num_records >= header->num_processes)
+			break;
+		// Processes were created since last time. Leave some room in case more show up before we try again.
+		s_snapshot_capacity = header->num_processes + header->num_processes / 2;
+		lseek(fd, 0, SEEK_SET);
+	}
+	close(fd);
+
+	auto record_data = buf.data() + sizeof(proc_snapshot_header);
+	for(size_t i = 0; i < header->num_records; i++) {
+		auto& record = *(proc_snapshot_record*) (record_data + i * header->record_size);
+		Process proc;
+		proc._name = std::string(record.name, strnlen(record.name, sizeof(record.name)));
+		proc._pid = record.pid;
+		proc._ppid = record.ppid;
+		proc._gid = record.gid;
+		proc._uid = record.uid;
+		proc._state = (State) record.state;
+		proc._physical_mem = {(size_t) record.pmem};
+		proc._virtual_mem = {(size_t) record.vmem};
+		proc._shared_mem = {(size_t) record.shmem};
+		proc._cpu_time = Duck::Time::millis((long) record.cpu_time);
+		proc._num_threads = record.num_threads;
+		ret[record.pid] = std::move(proc);
 	}
 	return ret;
 }
@@ -85,14 +135,18 @@ ResultRet<App::Info> Process::app_info() const {
 	return App::Info::from_app_directory(Path(exe()).parent());
 }
 
-Result Process::update() {
-	auto cfg_res = Duck::Config::read_from("/proc/" + std::to_string(_pid) + "/status");
-	if(cfg_res.is_error())
-		return cfg_res.result();
-	auto& cfg = cfg_res.value();
+const std::vector<tid_t>& Process::threads() const {
+	if(!_threads_loaded) {
+		auto cfg_res = read_status(_pid);
+		if(!cfg_res.is_error())
+			parse_threads(cfg_res.value()["proc"]["threads"], _threads);
+		_threads_loaded = true;
+	}
+	return _threads;
+}
 
-	if(!cfg.has_section("proc"))
-		return Result::FAILURE;
+Result Process::update() {
+	auto cfg = TRY(read_status(_pid));
 	auto& proc = cfg["proc"];
 
 	_name = proc["name"];
@@ -104,15 +158,11 @@ Result Process::update() {
 	_physical_mem = {std::stoul(proc["pmem"])};
 	_virtual_mem = {std::stoul(proc["vmem"])};
 	_shared_mem = {std::stoul(proc["shmem"])};
+	_cpu_time = Duck::Time::millis(std::stol(proc["cpu"]));
 
-	Duck::StringInputStream threads { proc["threads"] };
-	threads.set_delimeter(',');
-	_threads.clear();
-	while (!threads.eof()) {
-		std::string thrd;
-		threads >> thrd;
-		_threads.push_back(std::stoi(thrd));
-	}
+	parse_threads(proc["threads"], _threads);
+	_num_threads = _threads.size();
+	_threads_loaded = true;
 
 	return Result::SUCCESS;
 }
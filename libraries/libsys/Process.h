@@ -23,6 +23,7 @@
 #include "Memory.h"
 #include <map>
 #include <libapp/App.h>
+#include <libnusa/Time.h>
 
 namespace Sys {
 	class Process {
@@ -49,6 +50,10 @@ namespace Sys {
 			std::string name;
 		};
 
+		/**
+		 * Gets every process from a single read of /proc/snapshot. The thread list of each process isn't part of the
+		 * snapshot, so it's read from the process's status the first time threads() is called.
+		 */
 		static std::map<pid_t, Process> get_all();
 		static Duck::ResultRet<Process> get(pid_t pid);
 		static Duck::ResultRet<Process> self();
@@ -64,7 +69,9 @@ namespace Sys {
 		Mem::Amount physical_mem() const { return _physical_mem; }
 		Mem::Amount virtual_mem() const { return _virtual_mem; }
 		Mem::Amount shared_mem() const { return _shared_mem; }
-		const std::vector<tid_t>& threads() const { return _threads; }
+		Duck::Time cpu_time() const { return _cpu_time; }
+		size_t num_threads() const { return _num_threads; }
+		const std::vector<tid_t>& threads() const;
 		Duck::ResultRet<std::vector<MemoryRegion>> memory_regions() const;
 
 		Duck::ResultRet<App::Info> app_info() const;
@@ -81,7 +88,10 @@ namespace Sys {
 		Mem::Amount _physical_mem;
 		Mem::Amount _virtual_mem;
 		Mem::Amount _shared_mem;
-		std::vector<tid_t> _threads;
+		Duck::Time _cpu_time;
+		size_t _num_threads = 0;
+		mutable std::vector<tid_t> _threads;
+		mutable bool _threads_loaded = false;
 	};
 }
 
@@ -35,6 +35,10 @@ Character& Line::operator[](int index) {
 	return chars[index];
 }
 
+Character* Line::data() {
+	return &chars[0];
+}
+
 int Line::length() {
 	return chars.size();
 }
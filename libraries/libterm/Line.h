@@ -29,6 +29,7 @@ namespace Term {
 
 		Character& at(int index);
 		Character& operator[](int index);
+		Character* data();
 		int length();
 		void resize(int new_size);
 		void fill(Character fill_char);
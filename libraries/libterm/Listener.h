@@ -25,6 +25,17 @@ namespace Term {
 	class Listener {
 	public:
 		virtual void on_character_change(const Position& position, const Character& character) = 0;
+		/**
+		 * Called with a run of changed characters on one line. Writes are coalesced into these spans, so listeners that
+		 * can redraw a whole run at once should override this; by default it is split up into on_character_change calls.
+		 * @param start The position of the first changed character.
+		 * @param characters The changed characters, which are only valid for the duration of the call.
+		 * @param count The number of changed characters.
+		 */
+		virtual void on_span_change(const Position& start, const Character* characters, int count) {
+			for(int i = 0; i < count; i++)
+				on_character_change({start.col + i, start.line}, characters[i]);
+		}
 		virtual void on_cursor_change(const Position& old_position) = 0;
 		virtual void on_backspace(const Position& position) = 0;
 		virtual void on_clear() = 0;
@@ -32,30 +32,23 @@
 using namespace Term;
 using namespace Keyboard;
 
-Terminal::Terminal(const Size& dimensions, Listener& listener):
+Terminal::Terminal(const Size& dimensions, Listener& listener, int scrollback_limit):
 dimensions(dimensions),
 cursor_position({0,0}),
 current_attribute({TERM_DEFAULT_FOREGROUND, TERM_DEFAULT_BACKGROUND}),
-listener(listener)
+listener(listener),
+scrollback_limit(scrollback_limit < 0 ? 0 : scrollback_limit)
 {
-	screen.resize(dimensions.lines);
-	for(int y = 0; y < dimensions.lines; y++)
-		screen[y].resize(dimensions.cols);
+	lines.resize(dimensions.lines + this->scrollback_limit);
+	for(size_t y = 0; y < lines.size(); y++)
+		lines[y].resize(dimensions.cols);
 }
 
 void Terminal::set_dimensions(const Term::Size& new_size) {
 	if(new_size.lines <= 0 || new_size.cols <= 0)
 		return;
 
-	if(new_size.lines < dimensions.lines) {
-		for(int y = 0; y < new_size.lines; y++) {
-			screen[y] = screen[y + (dimensions.lines - new_size.lines)];
-		}
-	}
-
-	screen.resize(new_size.lines);
-	for(int y = 0; y < new_size.lines; y++)
-		screen[y].resize(new_size.cols);
+	reallocate_lines(new_size, scrollback_limit);
 
 	if(cursor_position.col >= new_size.cols)
 		cursor_position.col = new_size.cols - 1;
@@ -159,12 +152,6 @@ void Terminal::emit_str(const char* str) {
 }
 
 void Terminal::write_char(char c_signed) {
-	static uint32_t utf8_buffer = 0;
-	static int utf8_index = 0;
-	static int utf8_char_length = 1;
-	static uint8_t utf8_remaining_bits = 0;
-	static uint8_t utf8_first_char_mask = 0;
-
 	char c = (unsigned char) c_signed;
 
 	if(utf8_index == 0) {
@@ -255,66 +242,99 @@ void Terminal::write_codepoint(uint32_t codepoint) {
 		set_cursor(new_cursor_pos);
 }
 
+static inline bool is_printable(char c) {
+	return (unsigned char) c >= 0x20 && (unsigned char) c < 0x7F;
+}
+
 void Terminal::write_chars(const char* buffer, size_t length) {
-	for(size_t i = 0; i < length; i++)
-		write_char(buffer[i]);
+	bool was_writing = writing;
+	writing = true;
+
+	size_t i = 0;
+	while(i < length) {
+		if(utf8_index == 0) {
+			//Runs of printable ASCII are copied straight into the line, and escape sequences are all ASCII, so neither
+			//needs to go through UTF-8 decoding
+			if(!escape_mode && is_printable(buffer[i])) {
+				size_t written = write_printable_run(buffer + i, length - i);
+				if(written) {
+					i += written;
+					continue;
+				}
+			} else if(escape_mode && !(buffer[i] & 0x80)) {
+				evaluate_escape_codepoint(buffer[i++]);
+				continue;
+			}
+		}
+		write_char(buffer[i++]);
+	}
+
+	writing = was_writing;
+	if(!writing)
+		flush_dirty();
 }
 
 void Terminal::write_codepoints(const uint32_t* buffer, size_t length) {
+	bool was_writing = writing;
+	writing = true;
 	for(size_t i = 0; i < length; i++)
 		write_codepoint(buffer[i]);
+	writing = was_writing;
+	if(!writing)
+		flush_dirty();
 }
 
 Term::Character Terminal::get_character(const Term::Position& pos) {
-	if(pos.col >= dimensions.cols || pos.col < 0 || pos.line >= dimensions.lines || pos.line < 0)
+	if(pos.col >= dimensions.cols || pos.col < 0 || pos.line >= dimensions.lines || pos.line < -scrollback_lines)
 		return {};
-	return screen[pos.line][pos.col];
+	return line_at(pos.line)[pos.col];
 }
 
 void Terminal::set_character(const Position& pos, const Character& character) {
 	if(pos.col >= dimensions.cols || pos.col < 0 || pos.line >= dimensions.lines || pos.line < 0)
 		return;
-	screen[pos.line][pos.col] = character;
-	listener.on_character_change(pos, character);
+	line_at(pos.line)[pos.col] = character;
+	mark_dirty(pos.line, pos.col, pos.col + 1);
+	if(!writing)
+		flush_dirty();
 }
 
-void Terminal::scroll(int lines) {
-	if(lines >= dimensions.lines) {
-		clear();
+void Terminal::scroll(int num_lines) {
+	if(num_lines <= 0)
 		return;
+	flush_dirty();
+
+	//Lines scrolled off the top of the screen become scrollback, and the oldest lines in the ring are reused
+	int moved = num_lines < dimensions.lines ? num_lines : dimensions.lines;
+	first_line = (first_line + moved) % (int) lines.size();
+	scrollback_lines += moved;
+	if(scrollback_lines > scrollback_limit)
+		scrollback_lines = scrollback_limit;
+	for(int y = dimensions.lines - moved; y < dimensions.lines; y++)
+		line_at(y).clear(current_attribute);
+
+	//Scrolling the whole screen away clears it, which also puts the cursor back at the top left
+	if(num_lines >= dimensions.lines) {
+		set_cursor({0,0});
+		listener.on_clear();
+	} else {
+		listener.on_scroll(num_lines);
 	}
-
-	int clear_start_line = dimensions.lines - lines;
-	for(int y = 0; y < dimensions.lines; y++) {
-		for(int x = 0; x < dimensions.cols; x++) {
-			if(y >= clear_start_line) {
-				screen[y][x] = {0, current_attribute};
-			} else {
-				screen[y][x] = screen[y + lines][x];
-			}
-		}
-	}
-
-	listener.on_scroll(lines);
 }
 
 void Terminal::clear() {
+	flush_dirty();
 	set_cursor({0,0});
-	for(int y = 0; y < dimensions.lines; y++) {
-		auto& line = screen[y];
-		for(int x = 0; x < dimensions.cols; x++) {
-			line[x] = {0, current_attribute};
-		}
-	}
+	for(int y = 0; y < dimensions.lines; y++)
+		line_at(y).clear(current_attribute);
 	listener.on_clear();
 }
 
 void Terminal::clear_line(int line) {
 	if(line < 0 || line >= dimensions.lines)
 		return;
-	auto& line_vec = screen[line];
-	for(int x = 0; x < dimensions.cols; x++)
-		line_vec[x] = {0, current_attribute};
+	flush_dirty();
+	line_at(line).clear(current_attribute);
 	listener.on_clear_line(line);
 }
 
@@ -462,3 +482,109 @@ void Terminal::evaluate_cursor_escape() {
 void Terminal::set_prevent_scroll(bool prevent_scroll) {
 	this->prevent_scroll = prevent_scroll;
 }
+
+void Terminal::set_scrollback_limit(int limit) {
+	if(limit < 0)
+		limit = 0;
+	if(limit != scrollback_limit)
+		reallocate_lines(dimensions, limit);
+}
+
+int Terminal::get_scrollback_limit() {
+	return scrollback_limit;
+}
+
+int Terminal::get_scrollback_lines() {
+	return scrollback_lines;
+}
+
+Term::Line& Terminal::line_at(int line) {
+	int ring_size = lines.size();
+	return lines[(first_line + line + ring_size) % ring_size];
+}
+
+void Terminal::reallocate_lines(const Size& new_size, int new_scrollback_limit) {
+	flush_dirty();
+
+	//If the screen got shorter, the lines at the top of the screen are pushed into the scrollback
+	int pushed_lines = dimensions.lines > new_size.lines ? dimensions.lines - new_size.lines : 0;
+	int kept_lines = dimensions.lines < new_size.lines ? dimensions.lines : new_size.lines;
+	int new_scrollback_lines = scrollback_lines + pushed_lines;
+	if(new_scrollback_lines > new_scrollback_limit)
+		new_scrollback_lines = new_scrollback_limit;
+
+	Vector<Line> new_lines;
+	new_lines.resize(new_size.lines + new_scrollback_limit);
+	for(int i = 0; i < new_scrollback_lines + kept_lines; i++)
+		new_lines[i] = line_at(pushed_lines - new_scrollback_lines + i);
+	for(size_t i = 0; i < new_lines.size(); i++)
+		new_lines[i].resize(new_size.cols);
+
+	lines = new_lines;
+	first_line = new_scrollback_lines;
+	scrollback_lines = new_scrollback_lines;
+	scrollback_limit = new_scrollback_limit;
+}
+
+size_t Terminal::write_printable_run(const char* buffer, size_t length) {
+	size_t written = 0;
+	while(written < length) {
+		int col = cursor_position.col;
+		int line = cursor_position.line;
+		if(col < 0 || col >= dimensions.cols || line < 0 || line >= dimensions.lines)
+			break;
+
+		//Copy as much of the run as fits on the cursor's line
+		size_t space = dimensions.cols - col;
+		size_t count = 0;
+		while(count < space && written + count < length && is_printable(buffer[written + count]))
+			count++;
+		if(!count)
+			break;
+
+		Character* chars = line_at(line).data() + col;
+		for(size_t i = 0; i < count; i++)
+			chars[i] = {(uint32_t) buffer[written + i], current_attribute};
+		mark_dirty(line, col, col + count);
+		written += count;
+
+		//Then move the cursor once, wrapping and scrolling like write_codepoint does
+		Position new_cursor_pos = {col + (int) count, line};
+		if(new_cursor_pos.col == dimensions.cols) {
+			new_cursor_pos.line++;
+			new_cursor_pos.col = 0;
+		}
+		if(new_cursor_pos.line >= dimensions.lines) {
+			if(!prevent_scroll)
+				scroll(new_cursor_pos.line + 1 - dimensions.lines);
+			new_cursor_pos.line = dimensions.lines - 1;
+		}
+		set_cursor(new_cursor_pos);
+	}
+	return written;
+}
+
+void Terminal::mark_dirty(int line, int start_col, int end_col) {
+	if(dirty_span.end > dirty_span.start) {
+		if(line == dirty_span.line && start_col <= dirty_span.end && end_col >= dirty_span.start) {
+			if(start_col < dirty_span.start)
+				dirty_span.start = start_col;
+			if(end_col > dirty_span.end)
+				dirty_span.end = end_col;
+			return;
+		}
+		flush_dirty();
+	}
+	dirty_span.line = line;
+	dirty_span.start = start_col;
+	dirty_span.end = end_col;
+}
+
+void Terminal::flush_dirty() {
+	if(dirty_span.end <= dirty_span.start)
+		return;
+	int start = dirty_span.start;
+	int count = dirty_span.end - dirty_span.start;
+	dirty_span.start = dirty_span.end = 0;
+	listener.on_span_change({start, dirty_span.line}, line_at(dirty_span.line).data() + start, count);
+}
@@ -28,7 +28,7 @@ namespace Term {
 	class Terminal {
 	public:
 		Terminal() = delete;
-		Terminal(const Size& dimensions, Listener& listener);
+		Terminal(const Size& dimensions, Listener& listener, int scrollback_limit = TERM_DEFAULT_SCROLLBACK);
 
 		void set_dimensions(const Size& new_size);
 		Size get_dimensions();
@@ -43,7 +43,7 @@ namespace Term {
 		void write_codepoint(uint32_t codepoint);
 		void write_chars(const char* buffer, size_t length);
 		void write_codepoints(const uint32_t* buffer, size_t length);
-		Character get_character(const Position& position);
+		Character get_character(const Position& position); ///< Negative lines are read from the scrollback.
 		void set_character(const Position& position, const Character& character);
 		void scroll(int lines);
 		void clear();
@@ -56,18 +56,51 @@ namespace Term {
 		void evaluate_clear_line_escape();
 		void evaluate_cursor_escape();
 		void set_prevent_scroll(bool prevent_scroll);
+		void set_scrollback_limit(int limit);
+		int get_scrollback_limit();
+		int get_scrollback_lines();
 
 	private:
 		enum EscapeStatus {
 			Beginning, Value
 		};
 
+		Line& line_at(int line);
+		void reallocate_lines(const Size& new_size, int new_scrollback_limit);
+		size_t write_printable_run(const char* buffer, size_t length);
+		void mark_dirty(int line, int start_col, int end_col);
+		void flush_dirty();
+
 		Attribute current_attribute = {TERM_DEFAULT_FOREGROUND, TERM_DEFAULT_BACKGROUND};
 		Position cursor_position = {0, 0};
 		Size dimensions = {0, 0};
-		Vector<Line> screen;
+		/**
+		 * The screen and scrollback, stored as a ring of lines so that scrolling only has to move first_line. The ring
+		 * holds dimensions.lines + scrollback_limit lines. Line 0 of the screen is at first_line, and the
+		 * scrollback_lines lines before it (wrapping around) are the scrollback, newest last.
+		 */
+		Vector<Line> lines;
+		int first_line = 0;
+		int scrollback_lines = 0;
+		int scrollback_limit;
 		Listener& listener;
 
+		/**
+		 * The span of changed characters that hasn't been sent to the listener yet. Changes are collected here while
+		 * writing a buffer, and flushed when the buffer is done or before anything that moves lines around.
+		 */
+		struct {
+			int line = 0;
+			int start = 0;
+			int end = 0;
+		} dirty_span;
+		bool writing = false;
+
+		uint32_t utf8_buffer = 0;
+		int utf8_index = 0;
+		int utf8_char_length = 1;
+		uint8_t utf8_remaining_bits = 0;
+
 		bool escape_mode = false;
 		EscapeStatus escape_status = Beginning;
 		char escape_parameters[10][10];
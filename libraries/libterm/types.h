@@ -50,6 +50,8 @@
 #define TERM_DEFAULT_FOREGROUND TERM_COLOR_WHITE
 #define TERM_DEFAULT_BACKGROUND TERM_COLOR_BLACK
 
+#define TERM_DEFAULT_SCROLLBACK 1000
+
 namespace Term {
 	template<class T> using Vector = _TERM_VECTOR_TYPE<T>;
 
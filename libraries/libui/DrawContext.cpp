@@ -105,7 +105,6 @@ void UI::DrawContext::draw_text(const UI::TextLayout& layout, Gfx::Rect rect, UI
 	}
 
 	// Then, draw all the lines
-	auto text = layout.storage()->text();
 	for(auto& line : layout.lines()) {
 		if ((text_pos.y + layout.font()->bounding_box().height) >= 0 && text_pos.y < (rect.y + rect.height)) {
 			switch(h_align) {
@@ -118,10 +117,9 @@ void UI::DrawContext::draw_text(const UI::TextLayout& layout, Gfx::Rect rect, UI
 					text_pos.x = rect.x + rect.dimensions().width - line.rect.width;
 					break;
 			}
-			auto substr = text.substr(line.index, line.length);
-			auto pos = fb->draw_text(substr.data(), line.length, text_pos, layout.font(), color);
+			auto pos = fb->draw_glyph_run(line.run, text_pos, color);
 			if (line.ellipsis)
-				fb->draw_text("...", pos, layout.font(), color);
+				fb->draw_glyph_run(layout.ellipsis_run(), pos, color);
 		}
 		text_pos = {rect.x, text_pos.y + line.rect.height};
 	}
@@ -145,6 +143,10 @@ void UI::DrawContext::draw_glyph(Font* font, uint32_t codepoint, Gfx::Point pos,
 	fb->draw_glyph(font, codepoint, pos, color);
 }
 
+Gfx::Point UI::DrawContext::draw_glyph_run(const Gfx::GlyphRun& run, Gfx::Point pos, Gfx::Color color) const {
+	return fb->draw_glyph_run(run, pos, color);
+}
+
 void UI::DrawContext::draw_image(Duck::Ptr<const Image> img, Gfx::Point pos) const {
 	img->draw(*fb, pos);
 }
@@ -54,6 +54,7 @@ namespace UI {
 		void draw_text(const char* str, Gfx::Point pos, Gfx::Font* font, Gfx::Color color) const;
 		void draw_text(const char* str, Gfx::Point pos, Gfx::Color color) const;
 		void draw_glyph(Gfx::Font* font, uint32_t codepoint, Gfx::Point pos, Gfx::Color color) const;
+		Gfx::Point draw_glyph_run(const Gfx::GlyphRun& run, Gfx::Point pos, Gfx::Color color) const;
 		void draw_image(Duck::Ptr<const Gfx::Image> img, Gfx::Point pos) const;
 		void draw_image(Duck::Ptr<const Gfx::Image> img, Gfx::Rect rect) const;
 		void draw_image(const std::string& name, Gfx::Point pos) const;
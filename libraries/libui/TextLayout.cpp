@@ -107,6 +107,7 @@ void TextLayout::recalculate_layout() {
 			.ellipsis = false
 		});
 		m_dimensions = m_lines[0].rect.dimensions();
+		shape_lines();
 		return;
 	}
 
@@ -177,4 +178,13 @@ void TextLayout::recalculate_layout() {
 		finalize_line();
 
 	m_dimensions = total_dimensions;
+	shape_lines();
+}
+
+void TextLayout::shape_lines() {
+	auto contents = m_storage.lock()->text();
+	for(auto& line : m_lines)
+		line.run = {m_font, contents.substr(line.index, line.length)};
+	if(m_ellipsis_run.font() != m_font)
+		m_ellipsis_run = {m_font, "..."};
 }
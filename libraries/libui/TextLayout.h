@@ -6,6 +6,7 @@
 #include <string>
 #include <libgraphics/Geometry.h>
 #include <libgraphics/Font.h>
+#include <libgraphics/GlyphRun.h>
 #include "TextStorage.h"
 
 namespace UI {
@@ -28,6 +29,7 @@ namespace UI {
 			size_t length;
 			Gfx::Rect rect;
 			bool ellipsis;
+			Gfx::GlyphRun run; ///< The shaped text of the line, reused across repaints until the layout changes.
 		};
 
 		enum class TruncationMode {
@@ -50,14 +52,18 @@ namespace UI {
 		[[nodiscard]] Gfx::Dimensions dimensions() const { return m_dimensions; };
 		[[nodiscard]] const std::vector<Line>& lines() const { return m_lines; };
 		[[nodiscard]] Gfx::Font* font() const { return m_font; }
+		[[nodiscard]] const Gfx::GlyphRun& ellipsis_run() const { return m_ellipsis_run; }
 		[[nodiscard]] Duck::Ptr<ImmutableTextStorage> storage() const { return m_storage.lock(); }
 
 	private:
+		void shape_lines();
+
 		Duck::WeakPtr<ImmutableTextStorage> m_storage;
 		CursorPos m_cursor_pos = CursorPos::none;
 		std::vector<Line> m_lines;
 		Gfx::Dimensions m_dimensions = {200, 200};
 		Gfx::Font* m_font = nullptr;
+		Gfx::GlyphRun m_ellipsis_run;
 		TruncationMode m_truncation_mode = TruncationMode::ELLIPSIS;
 		BreakMode m_break_mode = BreakMode::WORD;
 		Gfx::Dimensions m_target_dimensions = {0, 0};
@@ -7,7 +7,7 @@
 #include "libui.h"
 #include "Theme.h"
 #include "UIException.h"
-#include <poll.h>
+#include <sys/epoll.h>
 #include <map>
 #include <utility>
 #include <libnusa/Config.h>
@@ -19,7 +19,7 @@
 using namespace UI;
 
 Pond::Context* UI::pond_context = nullptr;
-std::vector<pollfd> pollfds;
+int epoll_fd = -1;
 std::map<int, Poll> polls;
 std::map<int, std::shared_ptr<Window>> windows;
 std::weak_ptr<Window> _last_focused_window;
@@ -62,7 +62,8 @@ void UI::init(char** argv, char** envp) {
 	signal(SIGFPE,  ui_crash_handler);
 
 	pond_context = Pond::Context::init();
-	pollfds.clear();
+	if(epoll_fd < 0)
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
 
 	auto app_res = App::Info::from_current_app();
 	if(app_res.has_value()) {
@@ -74,6 +75,12 @@ void UI::init(char** argv, char** envp) {
 	pond_poll.on_ready_to_read = handle_pond_events;
 	add_poll(pond_poll);
 
+	if(pond_context->channel_fd() >= 0) {
+		Poll channel_poll = {pond_context->channel_fd()};
+		channel_poll.on_ready_to_read = handle_pond_events;
+		add_poll(channel_poll);
+	}
+
 	auto cfg_res = Duck::Config::read_from("/etc/libui.conf");
 	if(!cfg_res.is_error()) {
 		auto& cfg = cfg_res.value();
@@ -267,15 +274,18 @@ void UI::update(int timeout) {
 			window.second->repaint_now();
 	}
 
-	poll(pollfds.data(), pollfds.size(), timeout);
-	for(auto& pfd : pollfds) {
-		if(pfd.revents) {
-			auto& p = polls[pfd.fd];
-			if(p.on_ready_to_read && pfd.revents & POLLIN)
-				p.on_ready_to_read();
-			if(p.on_ready_to_write && pfd.revents & POLLOUT)
-				p.on_ready_to_write();
-		}
+	epoll_event events[16];
+	int num_events = epoll_wait(epoll_fd, events, 16, timeout);
+	for(int i = 0; i < num_events; i++) {
+		// The handlers may add polls, so look each one up again instead of holding on to a reference
+		auto p_it = polls.find(events[i].data.fd);
+		if(p_it == polls.end())
+			continue;
+		auto p = p_it->second;
+		if(p.on_ready_to_read && events[i].events & EPOLLIN)
+			p.on_ready_to_read();
+		if(p.on_ready_to_write && events[i].events & EPOLLOUT)
+			p.on_ready_to_write();
 	}
 }
 
@@ -341,13 +351,14 @@ App::Info& UI::app_info() {
 void UI::add_poll(const Poll& poll) {
 	if(!poll.on_ready_to_read && !poll.on_ready_to_write)
 		return;
-	pollfd pfd = {.fd = poll.fd, .events = 0, .revents = 0};
+	epoll_event event = {.events = 0, .data = {.fd = poll.fd}};
 	if(poll.on_ready_to_read)
-		pfd.events |= POLLIN;
+		event.events |= EPOLLIN;
 	if(poll.on_ready_to_write)
-		pfd.events |= POLLOUT;
+		event.events |= EPOLLOUT;
+	bool exists = polls.count(poll.fd);
 	polls[poll.fd] = poll;
-	pollfds.push_back(pfd);
+	epoll_ctl(epoll_fd, exists ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, poll.fd, &event);
 }
 
 Duck::Ptr<const Gfx::Image> UI::icon(Duck::Path path) {
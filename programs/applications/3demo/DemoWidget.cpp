@@ -7,8 +7,8 @@
 #include <libui/libui.h>
 #include <ctime>
 
-DemoWidget::DemoWidget(std::vector<std::array<Lib3D::Vertex, 3>> object, bool texture):
-	faces(object),
+DemoWidget::DemoWidget(Lib3D::ObjReader::Mesh object, bool texture):
+	mesh(std::move(object)),
 	use_texture(texture)
 {
 	context = Lib3D::RenderContext::make(Gfx::Dimensions {250, 250});
@@ -20,12 +20,10 @@ DemoWidget::DemoWidget(std::vector<std::array<Lib3D::Vertex, 3>> object, bool te
 	float max_dim = -INFINITY;
 	float min_dim = INFINITY;
 
-	for(auto& face : faces) {
-		for(auto& vert : face) {
-			for(int i = 0; i < 3; i++) {
-				max_dim = std::max(max_dim, vert.pos[i]);
-				min_dim = std::min(min_dim, vert.pos[i]);
-			}
+	for(auto& vert : mesh.vertices) {
+		for(int i = 0; i < 3; i++) {
+			max_dim = std::max(max_dim, vert.pos[i]);
+			min_dim = std::min(min_dim, vert.pos[i]);
 		}
 	}
 
@@ -36,9 +34,7 @@ DemoWidget::DemoWidget(std::vector<std::array<Lib3D::Vertex, 3>> object, bool te
 	timer = UI::set_interval([this] {
 		context->clear({0, 0, 0});
 		context->set_modelmat(Lib3D::rotate(0.006f, rot));
-		for(auto& face : faces) {
-			context->tri(face);
-		}
+		context->draw_indexed(mesh.vertices, mesh.indices);
 		if (do_rot)
 			rot += {1.234, 2.312, 3.231};
 		viewport->repaint();
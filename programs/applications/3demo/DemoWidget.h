@@ -6,6 +6,7 @@
 #include <libui/widget/Widget.h>
 #include <libui/Timer.h>
 #include <lib3d/ViewportWidget.h>
+#include <lib3d/ObjReader.h>
 
 class DemoWidget: public UI::Widget {
 public:
@@ -15,7 +16,7 @@ public:
 	bool on_mouse_move(Pond::MouseMoveEvent evt) override;
 
 private:
-	DemoWidget(std::vector<std::array<Lib3D::Vertex, 3>> faces, bool texture);
+	DemoWidget(Lib3D::ObjReader::Mesh mesh, bool texture);
 
 	void change_texture();
 
@@ -23,7 +24,7 @@ private:
 	Duck::Ptr<UI::Timer> timer;
 	Duck::Ptr<Lib3D::ViewportWidget> viewport;
 	Duck::Ptr<Lib3D::Texture> texture;
-	std::vector<std::array<Lib3D::Vertex, 3>> faces;
+	Lib3D::ObjReader::Mesh mesh;
 	Vec3f rot;
 	bool do_rot = true;
 	unsigned int mouse = 0;
@@ -26,8 +26,8 @@ int main(int argc, char** argv, char** envp) {
 		return fis.status().code();
 	}
 
-	auto faces = Lib3D::ObjReader::read(fis);
-	auto widget = DemoWidget::make(faces, argc < 2);
+	auto mesh = Lib3D::ObjReader::read_mesh(fis);
+	auto widget = DemoWidget::make(mesh, argc < 2);
 
 
 	window->set_contents(widget);
@@ -2,43 +2,7 @@
 /* Copyright © 2016-2026 nusaOS */
 
 #include "AppListWidget.h"
-#include <dirent.h>
-#include <cstdio>
-#include <cstring>
-#include <unistd.h>
-
-// Baca nama proses dari /proc/<pid>/cmdline — basename dari path pertama
-static std::string read_proc_name(int pid) {
-	char path[64];
-	snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
-	FILE* f = fopen(path, "r");
-	if (!f) return "";
-	char buf[256] = {};
-	fread(buf, 1, sizeof(buf) - 1, f);
-	fclose(f);
-	if (buf[0] == '\0') return "";
-	// cmdline null-separated, ambil token pertama lalu basename
-	const char* slash = strrchr(buf, '/');
-	return slash ? (slash + 1) : buf;
-}
-
-// Ambil list PID aktif dari /proc
-static std::vector<int> get_pids() {
-	std::vector<int> pids;
-	DIR* dir = opendir("/proc");
-	if (!dir) return pids;
-	struct dirent* ent;
-	while ((ent = readdir(dir)) != nullptr) {
-		bool all_digit = true;
-		for (int i = 0; ent->d_name[i]; i++) {
-			if (ent->d_name[i] < '0' || ent->d_name[i] > '9') { all_digit = false; break; }
-		}
-		if (all_digit && ent->d_name[0] != '\0')
-			pids.push_back(atoi(ent->d_name));
-	}
-	closedir(dir);
-	return pids;
-}
+#include <libsys/Process.h>
 
 void AppListWidget::update() {
 	m_apps.clear();
@@ -49,9 +13,9 @@ void AppListWidget::update() {
 	// App::Info di AppMenu juga punya run() tapi kita cuma perlu name()
 	auto known_apps = App::get_all_apps();
 
-	// Buat map: lowercase name → App::Info untuk matching dengan cmdline
+	// Buat map: lowercase name → App::Info untuk matching dengan nama proses
 	// Karena App::Info tidak punya executable(), kita cocokkan berdasarkan name
-	// yang di-lowercase dan dibandingkan dengan basename cmdline
+	// yang di-lowercase dan dibandingkan dengan nama proses
 	std::map<std::string, std::string> name_map; // basename_lower → display_name
 	for (auto& app : known_apps) {
 		if (app.hidden() || app.name().empty()) continue;
@@ -61,12 +25,12 @@ void AppListWidget::update() {
 		name_map[key] = app.name();
 	}
 
-	// Scan /proc untuk cari PID yang running
-	auto pids = get_pids();
+	// Satu kali baca /proc/snapshot untuk semua proses
+	auto procs = Sys::Process::get_all();
 	std::set<std::string> seen; // dedup per display name
 
-	for (int pid : pids) {
-		std::string proc_name = read_proc_name(pid);
+	for (auto& [pid, proc] : procs) {
+		const std::string& proc_name = proc.name();
 		if (proc_name.empty()) continue;
 
 		// Lowercase proc_name untuk matching
@@ -2,12 +2,15 @@
 /* Copyright © 2025-2026 danko1122q */
 
 #include "CpuGraphWidget.h"
+#include <cstdio>
 
 void CpuGraphWidget::update() {
     Duck::FileInputStream stream("/proc/cpuinfo");
     auto res = Sys::CPU::get_info(stream);
-    if (res.has_value())
+    if (res.has_value()) {
         m_util = res.value().utilization;
+        m_load = res.value().load_averages[0];
+    }
 
     float val = (float)m_util / 100.0f;
     if (val < 0.0f) val = 0.0f;
@@ -42,7 +45,10 @@ void CpuGraphWidget::do_repaint(const UI::DrawContext& ctx) {
         ctx.fill({x, ctx.height() - 2 - bh, 1, bh}, bar);
     }
 
-    std::string lbl = std::to_string(m_util) + "%";
+    // Load rata-rata 1 menit, dua angka di belakang koma
+    char load_buf[16];
+    snprintf(load_buf, sizeof(load_buf), "%.2f", m_load);
+    std::string lbl = std::to_string(m_util) + "% (load " + load_buf + ")";
     ctx.draw_text(lbl.c_str(), ctx.rect(),
         UI::CENTER, UI::CENTER,
         UI::Theme::font(), Gfx::Color(255, 255, 255));
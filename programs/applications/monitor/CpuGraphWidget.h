@@ -26,4 +26,5 @@ private:
 
     std::vector<float> m_values;
     int m_util = 0;
+    double m_load = 0;
 };
\ No newline at end of file
@@ -7,28 +7,34 @@
 #include <libui/widget/Cell.h>
 #include "CpuGraphWidget.h"
 #include "MemGraphWidget.h"
+#include "AppListWidget.h"
 
 int main(int argc, char** argv, char** envp) {
     UI::init(argv, envp);
 
     auto cpu = CpuGraphWidget::make();
     auto mem = MemGraphWidget::make();
+    auto apps = AppListWidget::make();
 
     // PREFERRED — grafik tidak stretch, selalu 200x50
     cpu->set_sizing_mode(UI::PREFERRED);
     mem->set_sizing_mode(UI::PREFERRED);
+    apps->set_sizing_mode(UI::PREFERRED);
 
     auto cpu_cell = UI::NamedCell::make("CPU", cpu);
     auto mem_cell = UI::NamedCell::make("Memory", mem);
+    auto apps_cell = UI::NamedCell::make("Apps", apps);
     // PREFERRED pada NamedCell juga agar tinggi tidak stretch
     cpu_cell->set_sizing_mode(UI::PREFERRED);
     mem_cell->set_sizing_mode(UI::PREFERRED);
+    apps_cell->set_sizing_mode(UI::PREFERRED);
 
-    // Baris horizontal: CPU | Memory
+    // Baris horizontal: CPU | Memory | Apps
     auto row = UI::BoxLayout::make(UI::BoxLayout::HORIZONTAL, 6);
     row->set_sizing_mode(UI::PREFERRED);
     row->add_child(cpu_cell);
     row->add_child(mem_cell);
+    row->add_child(apps_cell);
 
     // Cell luar: memusatkan baris di tengah window
     // sizing FILL agar Cell mengisi window, tapi row di dalamnya tetap PREFERRED
@@ -39,15 +45,17 @@ int main(int argc, char** argv, char** envp) {
     window->set_title("System Monitor");
     window->set_contents(outer);
     window->set_resizable(true);
-    window->resize({450, 105});
+    window->resize({620, 135});
     window->show();
 
     cpu->update();
     mem->update();
+    apps->update();
 
-    auto timer = UI::set_interval([&cpu, &mem] {
+    auto timer = UI::set_interval([&cpu, &mem, &apps] {
         cpu->update();
         mem->update();
+        apps->update();
     }, 1000);
 
     UI::run();
@@ -62,14 +62,18 @@ TerminalWidget::TerminalWidget() {
 	pty_poll.on_ready_to_read = [&]{
 		// nusaOS PTYControllerDevice::read() return 0 jika buffer kosong (bukan EOF).
 		// Jangan interpret nread==0 sebagai EOF — itu hanya "belum ada data".
-		// poll() hanya fire saat can_read()==true (buffer tidak kosong), jadi
-		// satu kali read 128 byte sudah cukup per event.
-		char buf[128];
-		ssize_t nread = read(pty_fd, buf, 128);
-		if(nread > 0) {
-			term->write_chars(buf, (size_t)nread);
-			handle_term_events();
+		//Drain everything that's buffered before repainting, so a burst of output is only painted once
+		char buf[4096];
+		ssize_t nread;
+		bool wrote = false;
+		while((nread = read(pty_fd, buf, sizeof(buf))) > 0) {
+			term->write_chars(buf, (size_t) nread);
+			wrote = true;
+			if(nread < (ssize_t) sizeof(buf))
+				break;
 		}
+		if(wrote)
+			handle_term_events();
 	};
 	UI::add_poll(pty_poll);
 
@@ -107,6 +111,7 @@ void TerminalWidget::do_repaint(const UI::DrawContext& ctx) {
 		return;
 
 	//If we need a full repaint, do so
+	scrolled_lines = 0;
 	if(needs_full_repaint) {
 		needs_full_repaint = false;
 		auto dims = term->get_dimensions();
@@ -131,6 +136,25 @@ void TerminalWidget::do_repaint(const UI::DrawContext& ctx) {
 				break;
 			}
 
+			case TerminalEvent::SPAN: {
+				auto& data = evt.data.span;
+				auto* chars = &span_characters[data.index];
+				int char_width = font->bounding_box().width;
+				Gfx::Point pos = {data.pos.col * char_width, data.pos.line * font->size()};
+
+				//Fill the background in runs of the same color, then draw the glyphs on top
+				for(int start = 0; start < data.count;) {
+					int end = start + 1;
+					while(end < data.count && chars[end].attr.bg == chars[start].attr.bg)
+						end++;
+					ctx.fill({pos.x + start * char_width, pos.y, (end - start) * char_width, font->size()}, color_palette[chars[start].attr.bg]);
+					start = end;
+				}
+				for(int i = 0; i < data.count; i++)
+					ctx.draw_glyph(font, chars[i].codepoint, {pos.x + i * char_width, pos.y}, color_palette[chars[i].attr.fg]);
+				break;
+			}
+
 			case TerminalEvent::CLEAR: {
 				ctx.fill({0, 0, ctx.width(), ctx.height()}, color_palette[evt.data.clear.attribute.bg]);
 				break;
@@ -155,7 +179,7 @@ void TerminalWidget::do_repaint(const UI::DrawContext& ctx) {
 			}
 		}
 	}
-	events.clear();
+	clear_events();
 
 	// Get cursor position
 	auto cursor = term->get_cursor();
@@ -301,10 +325,21 @@ void TerminalWidget::run(const char* command) {
 }
 
 void TerminalWidget::on_character_change(const Term::Position& position, const Term::Character& character) {
+	if(needs_full_repaint)
+		return;
 	events.push_back({TerminalEvent::CHARACTER, {.character = {position, character}}});
 }
 
+void TerminalWidget::on_span_change(const Term::Position& start, const Term::Character* characters, int count) {
+	if(needs_full_repaint)
+		return;
+	events.push_back({TerminalEvent::SPAN, {.span = {start, span_characters.size(), count}}});
+	span_characters.insert(span_characters.end(), characters, characters + count);
+}
+
 void TerminalWidget::on_cursor_change(const Term::Position& old_position) {
+	if(needs_full_repaint)
+		return;
 	events.push_back({TerminalEvent::CHARACTER, {.character = {old_position, term->get_character(old_position)}}});
 }
 
@@ -313,7 +348,9 @@ void TerminalWidget::on_backspace(const Term::Position& position) {
 }
 
 void TerminalWidget::on_clear() {
-	events.clear();
+	clear_events();
+	if(needs_full_repaint)
+		return;
 	//We are sent a clear event before the terminal is set, so handle that case
 	if(term)
 		events.push_back({TerminalEvent::CLEAR, {.clear = {term->get_current_attribute()}}});
@@ -322,10 +359,23 @@ void TerminalWidget::on_clear() {
 }
 
 void TerminalWidget::on_clear_line(int line) {
+	if(needs_full_repaint)
+		return;
 	events.push_back({TerminalEvent::CLEAR_LINE, {.clear_line = {term->get_current_attribute(), line}}});
 }
 
 void TerminalWidget::on_scroll(int lines) {
+	if(needs_full_repaint)
+		return;
+
+	//If we've scrolled a whole screen since the last repaint, none of the pending events are visible anymore
+	scrolled_lines += lines;
+	if(scrolled_lines >= term->get_dimensions().lines) {
+		clear_events();
+		needs_full_repaint = true;
+		return;
+	}
+
 	//Redraw the cursor character, as we don't want to include it in the scroll
 	events.push_back({TerminalEvent::CHARACTER, {.character = {term->get_cursor(), term->get_character(term->get_cursor())}}});
 	events.push_back({TerminalEvent::SCROLL, {.scroll = {term->get_current_attribute(), lines}}});
@@ -339,6 +389,11 @@ void TerminalWidget::on_resize(const Term::Size& old_size, const Term::Size& new
 	ioctl(pty_fd, TIOCSWINSZ, &winsz);
 }
 
+void TerminalWidget::clear_events() {
+	events.clear();
+	span_characters.clear();
+}
+
 void TerminalWidget::emit(const uint8_t* data, size_t size) {
 	write(pty_fd, data, size);
 }
@@ -48,6 +48,7 @@ public:
 
 	//Terminal::Listener
 	void on_character_change(const Term::Position& position, const Term::Character& character) override;
+	void on_span_change(const Term::Position& start, const Term::Character* characters, int count) override;
 	void on_cursor_change(const Term::Position& position) override;
 	void on_backspace(const Term::Position& position) override;
 	void on_clear() override;
@@ -67,16 +68,22 @@ private:
 	int pty_fd = -1;
 	pid_t proc_pid = -1;
 	bool needs_full_repaint = false;
+	int scrolled_lines = 0; ///< Lines scrolled since the last repaint
 	Duck::Ptr<UI::Timer> blink_timer;
 	bool blink_on = false;
 
 	struct TerminalEvent {
-		enum type {CHARACTER, CLEAR, CLEAR_LINE, SCROLL} type;
+		enum type {CHARACTER, SPAN, CLEAR, CLEAR_LINE, SCROLL} type;
 		union event {
 			struct {
 				Term::Position pos;
 				Term::Character character;
 			} character;
+			struct {
+				Term::Position pos;
+				size_t index; ///< Index of the first character in span_characters
+				int count;
+			} span;
 			struct {
 				Term::Attribute attribute;
 			} clear;
@@ -91,7 +98,10 @@ private:
 		} data;
 	};
 
+	void clear_events();
+
 	std::vector<TerminalEvent> events;
+	std::vector<Term::Character> span_characters;
 	CursorStyle cursor_style = CursorStyle::Block;
 };
 
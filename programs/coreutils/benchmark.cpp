@@ -12,6 +12,20 @@
 #include <sys/wait.h>
 #include <libnusa/Args.h>
 #include <libnusa/Time.h>
+#include <libterm/Terminal.h>
+#include <libriver/river.h>
+#include <sys/socketfs.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <kernel/api/ipv4.h>
+#include <poll.h>
+#include <libnusa/SpinLock.h>
+#include <sys/thread.h>
+#include <sched.h>
+#include <pthread.h>
+#include <lib3d/RenderContext.h>
+#include <lib3d/ObjReader.h>
+#include <libnusa/FileStream.h>
 
 // ============================================================================
 // UTILITY FUNCTIONS
@@ -303,6 +317,68 @@ static BenchResult bench_alloc() {
     return {"Alloc/Free", allocs_per_sec / 1000.0, duration_us / 1000};
 }
 
+// Keeps a pool of live allocations of mixed sizes and randomly replaces them, like a long-running program would
+static long long alloc_mixed_workload(unsigned int seed, int iterations) {
+    const int pool_size = 256;
+    void* pool[pool_size] = {};
+    long long checksum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int slot = (seed >> 8) % pool_size;
+        // Mostly small objects, with the occasional large buffer
+        size_t size = (seed >> 16) % 16 == 0 ? 16384 + (seed >> 4) % 65536 : 8 + (seed >> 12) % 512;
+        free(pool[slot]);
+        pool[slot] = malloc(size);
+        if (pool[slot]) {
+            ((char*) pool[slot])[0] = (char) i;
+            checksum += ((char*) pool[slot])[0];
+        }
+    }
+    for (auto* ptr : pool)
+        free(ptr);
+    return checksum;
+}
+
+static BenchResult bench_alloc_mixed() {
+    printf("  [MEM] Mixed-size allocation... ");
+    fflush(stdout);
+
+    const int iterations = 50000;
+    long long start = get_timestamp_us();
+    alloc_mixed_workload(1, iterations);
+    long long duration_us = get_timestamp_us() - start;
+    if (duration_us <= 0) duration_us = 1;
+
+    double allocs_per_sec = iterations / (duration_us / 1000000.0);
+    printf("%.2f K alloc/s\n", allocs_per_sec / 1000.0);
+    return {"Alloc Mixed", allocs_per_sec / 1000.0, duration_us / 1000};
+}
+
+static void* alloc_thread(void* arg) {
+    alloc_mixed_workload((unsigned int) (uintptr_t) arg, 50000);
+    return nullptr;
+}
+
+// Runs the mixed workload on several threads at once to show how much they contend on the allocator
+static BenchResult bench_alloc_threaded() {
+    const int num_threads = 4;
+    printf("  [MEM] Mixed-size allocation (%d threads)... ", num_threads);
+    fflush(stdout);
+
+    pthread_t threads[num_threads];
+    long long start = get_timestamp_us();
+    for (int i = 0; i < num_threads; ++i)
+        pthread_create(&threads[i], nullptr, alloc_thread, (void*) (uintptr_t) (i + 1));
+    for (int i = 0; i < num_threads; ++i)
+        pthread_join(threads[i], nullptr);
+    long long duration_us = get_timestamp_us() - start;
+    if (duration_us <= 0) duration_us = 1;
+
+    double allocs_per_sec = 50000.0 * num_threads / (duration_us / 1000000.0);
+    printf("%.2f K alloc/s\n", allocs_per_sec / 1000.0);
+    return {"Alloc Threaded", allocs_per_sec / 1000.0, duration_us / 1000};
+}
+
 static void run_all() {
     print_header("MEMORY BENCHMARKS");
     
@@ -310,7 +386,9 @@ static void run_all() {
         bench_seq_read(),
         bench_seq_write(),
         bench_random(),
-        bench_alloc()
+        bench_alloc(),
+        bench_alloc_mixed(),
+        bench_alloc_threaded()
     };
     
     printf("\n  Summary:\n");
@@ -452,6 +530,81 @@ static BenchResult bench_read() {
     return {"FS Read", throughput, "MB/s", duration_us / 1000};
 }
 
+// Large file copy, either through a userspace buffer like cp used to or with sendfile
+static BenchResult bench_copy(const char* name, bool use_sendfile) {
+    printf("  [I/O] %s... ", name);
+    fflush(stdout);
+
+    const char* src_filename = "/tmp/bench_copy_src.dat";
+    const char* dst_filename = "/tmp/bench_copy_dst.dat";
+    const size_t block_size = 64 * 1024;
+    const size_t total_size = 16 * 1024 * 1024; // 16MB
+
+    char* buffer = (char*)malloc(block_size);
+    if (!buffer) {
+        printf("FAILED (malloc)\n");
+        return {name, 0, "", 0};
+    }
+
+    int src_fd = open(src_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (src_fd < 0) {
+        printf("FAILED (create)\n");
+        free(buffer);
+        return {name, 0, "", 0};
+    }
+    memset(buffer, 0xCC, block_size);
+    for (size_t i = 0; i < total_size / block_size; ++i) {
+        write(src_fd, buffer, block_size);
+    }
+    close(src_fd);
+
+    long long start = get_timestamp_us();
+
+    src_fd = open(src_filename, O_RDONLY);
+    int dst_fd = open(dst_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (src_fd < 0 || dst_fd < 0) {
+        printf("FAILED (open)\n");
+        free(buffer);
+        unlink(src_filename);
+        return {name, 0, "", 0};
+    }
+
+    size_t copied = 0;
+    if (use_sendfile) {
+        ssize_t n;
+        while ((n = sendfile(dst_fd, src_fd, nullptr, total_size - copied)) > 0)
+            copied += n;
+    } else {
+        ssize_t n;
+        while ((n = read(src_fd, buffer, block_size)) > 0) {
+            if (write(dst_fd, buffer, n) != n)
+                break;
+            copied += n;
+        }
+    }
+
+    close(dst_fd);
+    close(src_fd);
+
+    long long end = get_timestamp_us();
+    long long duration_us = end - start;
+    if (duration_us <= 0) duration_us = 1;
+
+    double seconds = duration_us / 1000000.0;
+    double throughput = (copied / seconds) / (1024 * 1024);
+
+    if (copied == total_size)
+        printf("%.2f MB/s\n", throughput);
+    else
+        printf("%.2f MB/s (SHORT COPY)\n", throughput);
+
+    free(buffer);
+    unlink(src_filename);
+    unlink(dst_filename);
+
+    return {name, throughput, "MB/s", duration_us / 1000};
+}
+
 // Small file operations
 static BenchResult bench_small_files() {
     printf("  [I/O] Small file ops... ");
@@ -495,6 +648,8 @@ static void run_all() {
     BenchResult results[] = {
         bench_write(),
         bench_read(),
+        bench_copy("Copy (read/write)", false),
+        bench_copy("Copy (sendfile)", true),
         bench_small_files()
     };
     
@@ -577,12 +732,58 @@ static BenchResult bench_syscall() {
     return {"Syscall", avg_us, "µs", duration_us / 1000};
 }
 
+// Launch time of a dynamically linked program: runs this benchmark with LAUNCH_CHILD_ARG, which exits as soon as
+// main() is reached, so the time is spent in exec, the dynamic loader and static constructors. The prelinked run
+// uses the library cache written by ldconfig, and the others ignore it.
+#define LAUNCH_CHILD_ARG "--launch-child"
+
+static BenchResult bench_launch(const char* name, bool use_cache, bool bind_now) {
+    printf("  [PROC] %s... ", name);
+    fflush(stdout);
+
+    const int iterations = 50;
+
+    long long start = get_timestamp_us();
+
+    for (int i = 0; i < iterations; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (bind_now)
+                setenv("LD_BIND_NOW", "1", 1);
+            else
+                unsetenv("LD_BIND_NOW");
+            if (use_cache)
+                unsetenv("LD_IGNORE_CACHE");
+            else
+                setenv("LD_IGNORE_CACHE", "1", 1);
+            char* argv[] = {(char*) "benchmark", (char*) LAUNCH_CHILD_ARG, nullptr};
+            execv("/bin/benchmark", argv);
+            _exit(1);
+        } else if (pid > 0) {
+            waitpid(pid, nullptr, 0);
+        }
+    }
+
+    long long end = get_timestamp_us();
+    long long duration_us = end - start;
+    if (duration_us <= 0) duration_us = 1;
+
+    double avg_ms = (double)duration_us / iterations / 1000.0;
+
+    printf("%.2f ms/launch\n", avg_ms);
+
+    return {name, avg_ms, "ms", duration_us / 1000};
+}
+
 static void run_all() {
     print_header("PROCESS BENCHMARKS");
     
     BenchResult results[] = {
         bench_fork(),
-        bench_syscall()
+        bench_syscall(),
+        bench_launch("Launch (LD_BIND_NOW)", false, true),
+        bench_launch("Launch (lazy binding)", false, false),
+        bench_launch("Launch (prelinked)", true, false)
     };
     
     printf("\n  Summary:\n");
@@ -595,6 +796,1102 @@ static void run_all() {
 
 } // namespace Process
 
+// ============================================================================
+// TERMINAL BENCHMARKS
+// ============================================================================
+
+namespace Terminal {
+
+struct BenchResult {
+    const char* name;
+    double throughput;
+    const char* unit;
+    long long duration_ms;
+};
+
+// Counts what a terminal widget would have to repaint, without drawing anything
+class CountingListener: public Term::Listener {
+public:
+    long long characters = 0;
+    long long spans = 0;
+    long long scrolled_lines = 0;
+
+    void on_character_change(const Term::Position&, const Term::Character&) override { characters++; }
+    void on_span_change(const Term::Position&, const Term::Character*, int count) override { characters += count; spans++; }
+    void on_cursor_change(const Term::Position&) override {}
+    void on_backspace(const Term::Position&) override {}
+    void on_clear() override {}
+    void on_clear_line(int) override {}
+    void on_scroll(int lines) override { scrolled_lines += lines; }
+    void on_resize(const Term::Size&, const Term::Size&) override {}
+    void emit(const uint8_t*, size_t) override {}
+};
+
+// Feeds the emulator a large amount of text in read()-sized chunks, like `cat` of a log in the terminal app
+static BenchResult bench_write(const char* name, const char* line, size_t total_size) {
+    printf("  [TERM] %s... ", name);
+    fflush(stdout);
+
+    const size_t chunk_size = 4096;
+    size_t line_len = strlen(line);
+    char* chunk = (char*)malloc(chunk_size);
+    if (!chunk) {
+        printf("FAILED (malloc)\n");
+        return {name, 0, "", 0};
+    }
+    for (size_t i = 0; i < chunk_size; ++i)
+        chunk[i] = line[i % line_len];
+
+    CountingListener listener;
+    Term::Terminal term({80, 30}, listener);
+
+    long long start = get_timestamp_us();
+
+    size_t written = 0;
+    while (written < total_size) {
+        term.write_chars(chunk, chunk_size);
+        written += chunk_size;
+    }
+
+    long long end = get_timestamp_us();
+    long long duration_us = end - start;
+    if (duration_us <= 0) duration_us = 1;
+
+    double seconds = duration_us / 1000000.0;
+    double throughput = (written / seconds) / (1024 * 1024);
+
+    printf("%.2f MB/s (%lld lines scrolled, %lld spans)\n", throughput, listener.scrolled_lines, listener.spans);
+
+    free(chunk);
+    return {name, throughput, "MB/s", duration_us / 1000};
+}
+
+struct CatArgs {
+    int fd;
+    const char* line;
+    size_t total_size;
+};
+
+// Writes to the PTY like `cat` would, in read()-sized chunks
+static void* cat_thread(void* arg) {
+    auto* args = (CatArgs*) arg;
+    const size_t chunk_size = 4096;
+    size_t line_len = strlen(args->line);
+    char* chunk = (char*)malloc(chunk_size);
+    for (size_t i = 0; i < chunk_size; ++i)
+        chunk[i] = args->line[i % line_len];
+
+    size_t written = 0;
+    while (written < args->total_size) {
+        ssize_t nwritten = write(args->fd, chunk, chunk_size);
+        if (nwritten <= 0)
+            break;
+        written += nwritten;
+    }
+
+    free(chunk);
+    return nullptr;
+}
+
+// Runs `cat` of a large file through a PTY pair into the emulator, like the terminal app does
+static BenchResult bench_pty(const char* name, const char* line, size_t total_size) {
+    printf("  [TERM] %s... ", name);
+    fflush(stdout);
+
+    int controller = posix_openpt(O_RDWR);
+    char* pts_name = controller >= 0 ? ptsname(controller) : nullptr;
+    int pts = pts_name ? open(pts_name, O_RDWR) : -1;
+    if (pts < 0) {
+        printf("FAILED (pty)\n");
+        if (controller >= 0)
+            close(controller);
+        return {name, 0, "", 0};
+    }
+
+    const size_t buf_size = 4096;
+    char* buf = (char*)malloc(buf_size);
+    CountingListener listener;
+    Term::Terminal term({80, 30}, listener);
+    CatArgs args = {pts, line, total_size};
+
+    long long start = get_timestamp_us();
+    pthread_t thread;
+    pthread_create(&thread, nullptr, cat_thread, &args);
+
+    size_t received = 0;
+    while (received < total_size) {
+        ssize_t nread = read(controller, buf, buf_size);
+        if (nread <= 0)
+            break;
+        term.write_chars(buf, nread);
+        received += nread;
+    }
+
+    long long end = get_timestamp_us();
+    pthread_join(thread, nullptr);
+    long long duration_us = end - start;
+    if (duration_us <= 0) duration_us = 1;
+
+    double seconds = duration_us / 1000000.0;
+    double throughput = (received / seconds) / (1024 * 1024);
+
+    printf("%.2f MB/s (%lld lines scrolled)\n", throughput, listener.scrolled_lines);
+
+    free(buf);
+    close(pts);
+    close(controller);
+    return {name, throughput, "MB/s", duration_us / 1000};
+}
+
+static void run_all() {
+    print_header("TERMINAL BENCHMARKS");
+
+    BenchResult results[] = {
+        bench_write("Short lines", "hello, world\n", 8 * 1024 * 1024),
+        bench_write("Full lines", "The quick brown fox jumps over the lazy dog. 0123456789 ABCDEFGHIJKLMNOPQRSTUVWXY\n", 8 * 1024 * 1024),
+        bench_write("Colored text", "\033[32mok\033[39m \033[1;34m/usr/bin\033[0m \033[31merror\033[39m\n", 4 * 1024 * 1024),
+        bench_pty("cat through PTY", "The quick brown fox jumps over the lazy dog. 0123456789 ABCDEFGHIJKLMNOPQRSTUVWXY\n", 8 * 1024 * 1024)
+    };
+
+    printf("\n  Summary:\n");
+    for (auto& r : results) {
+        printf("    %-25s: %8.2f %s (%lld ms)\n",
+               r.name, r.throughput, r.unit, r.duration_ms);
+    }
+    printf("\n");
+}
+
+} // namespace Terminal
+
+// ============================================================================
+// RIVER IPC BENCHMARKS
+// ============================================================================
+
+namespace RiverIPC {
+
+struct BenchResult {
+    const char* name;
+    double latency_us;
+    double throughput;
+    long long duration_ms;
+};
+
+struct HostArgs {
+    std::string bus_name;
+    bool use_channels;
+    volatile bool ready;
+};
+
+// Hosts the benchmark endpoint on its own bus, answering calls until the program exits
+static void* host_thread(void* arg) {
+    auto* host = (HostArgs*) arg;
+    auto conn_res = River::BusConnection::connect(host->bus_name, true);
+    if (conn_res.is_error())
+        return nullptr;
+    auto conn = conn_res.value();
+    conn->set_channels_enabled(host->use_channels);
+
+    auto endpoint_res = conn->register_endpoint("benchmark");
+    if (endpoint_res.is_error())
+        return nullptr;
+    auto endpoint = endpoint_res.value();
+    endpoint->register_function<int, int>("add_one", [](sockid_t, int value) { return value + 1; });
+    endpoint->register_function<int, std::vector<uint8_t>>("sum", [](sockid_t, std::vector<uint8_t> data) {
+        int sum = 0;
+        for (auto byte : data)
+            sum += byte;
+        return sum;
+    });
+
+    host->ready = true;
+    while (true)
+        conn->read_and_handle_packets(true);
+    return nullptr;
+}
+
+// Makes calls to an endpoint in another thread, either over a direct channel or relayed through the bus
+static BenchResult bench_calls(const char* name, bool use_channels, int iterations, size_t payload_size) {
+    printf("  [RIVER] %s... ", name);
+    fflush(stdout);
+
+    auto* host = new HostArgs {"benchmark-" + std::to_string(getpid()) + (use_channels ? "-channel" : "-bus"), use_channels, false};
+    auto server_res = River::BusServer::create(host->bus_name);
+    if (server_res.is_error()) {
+        printf("FAILED (bus)\n");
+        return {name, 0, 0, 0};
+    }
+    server_res.value()->spawn_thread();
+    thread_create(host_thread, host);
+    while (!host->ready)
+        sched_yield();
+
+    auto conn_res = River::BusConnection::connect(host->bus_name);
+    if (conn_res.is_error()) {
+        printf("FAILED (connect)\n");
+        return {name, 0, 0, 0};
+    }
+    auto conn = conn_res.value();
+    conn->set_channels_enabled(use_channels);
+    auto endpoint_res = conn->get_endpoint("benchmark");
+    if (endpoint_res.is_error()) {
+        printf("FAILED (endpoint)\n");
+        return {name, 0, 0, 0};
+    }
+    auto endpoint = endpoint_res.value();
+    auto add_one = endpoint->get_function<int, int>("add_one").value();
+    auto sum = endpoint->get_function<int, std::vector<uint8_t>>("sum").value();
+
+    // Latency: small calls back and forth
+    long long start = get_timestamp_us();
+    int value = 0;
+    for (int i = 0; i < iterations; ++i)
+        value = add_one(value);
+    long long latency_duration = get_timestamp_us() - start;
+    if (latency_duration <= 0) latency_duration = 1;
+
+    // Throughput: calls carrying a large argument
+    std::vector<uint8_t> payload(payload_size, 1);
+    int throughput_iterations = iterations / 10;
+    bool correct = value == iterations;
+    start = get_timestamp_us();
+    for (int i = 0; i < throughput_iterations; ++i)
+        correct &= sum(payload) == (int) payload_size;
+    long long throughput_duration = get_timestamp_us() - start;
+    if (throughput_duration <= 0) throughput_duration = 1;
+
+    double latency = (double) latency_duration / iterations;
+    double throughput = ((double) payload_size * throughput_iterations / (throughput_duration / 1000000.0)) / (1024 * 1024);
+    printf("%.2f us/call, %.2f MB/s (%s, %s)\n", latency, throughput,
+           endpoint->channels().empty() ? "bus" : "channel", correct ? "ok" : "WRONG RESULT");
+
+    return {name, latency, throughput, (latency_duration + throughput_duration) / 1000};
+}
+
+static void run_all(bool quick) {
+    print_header("RIVER IPC BENCHMARKS");
+
+    int iterations = quick ? 2000 : 20000;
+    BenchResult results[] = {
+        bench_calls("Shared memory channel", true, iterations, 8192),
+        bench_calls("Bus relay", false, iterations, 8192)
+    };
+
+    printf("\n  Summary:\n");
+    for (auto& r : results) {
+        printf("    %-25s: %8.2f us/call %8.2f MB/s (%lld ms)\n",
+               r.name, r.latency_us, r.throughput, r.duration_ms);
+    }
+    printf("\n");
+}
+
+} // namespace RiverIPC
+
+// ============================================================================
+// SOCKETFS BENCHMARKS
+// ============================================================================
+
+namespace SocketFS {
+
+struct BenchResult {
+    const char* name;
+    double msgs_per_sec;
+    double throughput;
+    long long duration_ms;
+};
+
+struct ClientArgs {
+    std::string path;
+    size_t msg_size;
+    int num_msgs;
+    bool batched;
+};
+
+// Sends num_msgs messages of msg_size bytes to the host, either one per write() or packed into as few as possible
+static void* client_thread(void* arg) {
+    auto* client = (ClientArgs*) arg;
+    int fd = open(client->path.c_str(), O_RDWR);
+    if (fd < 0)
+        return nullptr;
+
+    size_t packet_size = sizeof(socketfs_packet) + client->msg_size;
+    size_t per_write = client->batched ? SOCKETFS_MAX_BUFFER_SIZE / packet_size : 1;
+    auto* buf = (uint8_t*) malloc(packet_size * per_write);
+    for (size_t i = 0; i < per_write; ++i) {
+        auto* packet = (socketfs_packet*) (buf + i * packet_size);
+        memset(packet, 0, sizeof(socketfs_packet));
+        packet->type = SOCKETFS_TYPE_MSG;
+        packet->recipient = SOCKETFS_RECIPIENT_HOST;
+        packet->length = client->msg_size;
+        memset(packet->data, (int) i, client->msg_size);
+    }
+
+    int sent = 0;
+    while (sent < client->num_msgs) {
+        size_t count = std::min(per_write, (size_t) (client->num_msgs - sent));
+        size_t size = count * packet_size;
+        size_t offset = 0;
+        // A batch that doesn't fit in the host's queue is only partly sent, so send the rest of it after
+        while (offset < size) {
+            ssize_t res = write_packets(fd, buf + offset, size - offset);
+            if (res < 0) {
+                free(buf);
+                close(fd);
+                return nullptr;
+            }
+            offset += res;
+        }
+        sent += count;
+    }
+
+    free(buf);
+    close(fd);
+    return nullptr;
+}
+
+static BenchResult bench_messages(const char* name, size_t msg_size, int num_msgs, bool batched) {
+    printf("  [SOCKFS] %s... ", name);
+    fflush(stdout);
+
+    static int socket_num = 0;
+    auto* client = new ClientArgs {"/sock/bench-sockfs-" + std::to_string(getpid()) + "-" + std::to_string(socket_num++),
+                                   msg_size, num_msgs, batched};
+    int fd = open(client->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_NONBLOCK);
+    if (fd < 0) {
+        printf("FAILED (socket)\n");
+        return {name, 0, 0, 0};
+    }
+
+    long long start = get_timestamp_us();
+    pthread_t thread;
+    pthread_create(&thread, nullptr, client_thread, client);
+
+    // Drain the socket until every message has arrived or the client has gone away
+    int received = 0;
+    bool disconnected = false;
+    auto* buf = (uint8_t*) malloc(SOCKETFS_MAX_BUFFER_SIZE);
+    while (received < num_msgs && !disconnected) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        poll(&pfd, 1, -1);
+        if (batched) {
+            ssize_t nread;
+            while ((nread = read_packets(fd, buf, SOCKETFS_MAX_BUFFER_SIZE)) > 0) {
+                for (auto* packet = (socketfs_packet*) buf; packet; packet = socketfs_next_packet(packet, buf, nread)) {
+                    if (packet->type == SOCKETFS_TYPE_MSG)
+                        received++;
+                    else if (packet->type == SOCKETFS_TYPE_MSG_DISCONNECT)
+                        disconnected = true;
+                }
+            }
+        } else {
+            socketfs_packet* packet;
+            while ((packet = read_packet(fd))) {
+                if (packet->type == SOCKETFS_TYPE_MSG)
+                    received++;
+                else if (packet->type == SOCKETFS_TYPE_MSG_DISCONNECT)
+                    disconnected = true;
+                free(packet);
+            }
+        }
+    }
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    pthread_join(thread, nullptr);
+    free(buf);
+    close(fd);
+    delete client;
+
+    double msgs_per_sec = received / (duration / 1000000.0);
+    double throughput = ((double) msg_size * received / (duration / 1000000.0)) / (1024 * 1024);
+    printf("%.0f msgs/s, %.2f MB/s (%s)\n", msgs_per_sec, throughput, received == num_msgs ? "ok" : "MESSAGES LOST");
+
+    return {name, msgs_per_sec, throughput, duration / 1000};
+}
+
+static void run_all(bool quick) {
+    print_header("SOCKETFS BENCHMARKS");
+
+    int num_msgs = quick ? 5000 : 50000;
+    BenchResult results[] = {
+        bench_messages("64B, one per call", 64, num_msgs, false),
+        bench_messages("64B, batched", 64, num_msgs, true),
+        bench_messages("1KB, one per call", 1024, num_msgs, false),
+        bench_messages("1KB, batched", 1024, num_msgs, true)
+    };
+
+    printf("\n  Summary:\n");
+    for (auto& r : results) {
+        printf("    %-25s: %10.0f msgs/s %8.2f MB/s (%lld ms)\n",
+               r.name, r.msgs_per_sec, r.throughput, r.duration_ms);
+    }
+    printf("\n");
+}
+
+} // namespace SocketFS
+
+// ============================================================================
+// NETWORK BENCHMARKS
+// ============================================================================
+
+namespace Network {
+
+constexpr const char* interface_name = "en0";
+constexpr in_port_t discard_port = 9;
+// Under QEMU's user networking, 10.0.2.2 is the host. Run something like `nc -l 5001 > /dev/null` there to sink data.
+constexpr IPv4Address tcp_sink_addr = {10, 0, 2, 2};
+constexpr in_port_t tcp_sink_port = 5001;
+
+struct BenchResult {
+    const char* name;
+    double ops_per_sec; ///< Packets or writes per second.
+    double throughput;
+    long long duration_ms;
+};
+
+// Broadcasts num_pkts UDP datagrams of payload_size bytes out of the network adapter as fast as possible. Nothing has to
+// be listening for them, so this measures how quickly the network stack and driver can get packets onto the wire.
+// If batch_size is more than 1, packets are sent batch_size at a time with sendmmsg instead of one sendto each.
+static BenchResult bench_udp_blast(const char* name, size_t payload_size, int num_pkts, int batch_size) {
+    printf("  [NET] %s... ", name);
+    fflush(stdout);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0) {
+        printf("FAILED (socket)\n");
+        return {name, 0, 0, 0};
+    }
+
+    int allow = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, interface_name, strlen(interface_name) + 1) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &allow, sizeof(int)) < 0) {
+        printf("FAILED (no %s)\n", interface_name);
+        close(fd);
+        return {name, 0, 0, 0};
+    }
+
+    auto* buf = (uint8_t*) malloc(payload_size);
+    memset(buf, 0xAA, payload_size);
+    sockaddr_in addr = IPv4Address(255, 255, 255, 255).as_sockaddr(discard_port);
+
+    // Every message in a batch sends the same buffer to the same address
+    iovec iov = {buf, payload_size};
+    auto* msgs = (mmsghdr*) calloc(batch_size, sizeof(mmsghdr));
+    for (int i = 0; i < batch_size; i++) {
+        msgs[i].msg_hdr.msg_name = &addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+        msgs[i].msg_hdr.msg_iov = &iov;
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = 0;
+    int errors = 0;
+    long long start = get_timestamp_us();
+    if (batch_size > 1) {
+        while (sent + errors < num_pkts) {
+            int nsent = sendmmsg(fd, msgs, std::min(batch_size, num_pkts - sent - errors), 0);
+            if (nsent <= 0)
+                errors++;
+            else
+                sent += nsent;
+        }
+    } else {
+        for (int i = 0; i < num_pkts; i++) {
+            if (sendto(fd, buf, payload_size, 0, (struct sockaddr*) &addr, sizeof(addr)) < 0)
+                errors++;
+            else
+                sent++;
+        }
+    }
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    free(msgs);
+    free(buf);
+    close(fd);
+
+    double pkts_per_sec = sent / (duration / 1000000.0);
+    double throughput = ((double) payload_size * sent / (duration / 1000000.0)) / (1024 * 1024);
+    if (errors)
+        printf("%.0f pkts/s, %.2f MB/s (%d send errors)\n", pkts_per_sec, throughput, errors);
+    else
+        printf("%.0f pkts/s, %.2f MB/s\n", pkts_per_sec, throughput);
+
+    return {name, pkts_per_sec, throughput, duration / 1000};
+}
+
+// Sends total_size bytes over a TCP connection to a sink on the host, in writes of chunk_size bytes.
+static BenchResult bench_tcp_bulk(const char* name, size_t chunk_size, size_t total_size) {
+    printf("  [NET] %s... ", name);
+    fflush(stdout);
+
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        printf("FAILED (socket)\n");
+        return {name, 0, 0, 0};
+    }
+
+    sockaddr_in addr = tcp_sink_addr.as_sockaddr(tcp_sink_port);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        printf("SKIPPED (nothing listening on 10.0.2.2:%d)\n", tcp_sink_port);
+        close(fd);
+        return {name, 0, 0, 0};
+    }
+
+    auto* buf = (uint8_t*) malloc(chunk_size);
+    memset(buf, 0x55, chunk_size);
+
+    size_t sent = 0;
+    int writes = 0;
+    long long start = get_timestamp_us();
+    while (sent < total_size) {
+        ssize_t res = send(fd, buf, std::min(chunk_size, total_size - sent), 0);
+        if (res <= 0)
+            break;
+        sent += res;
+        writes++;
+    }
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    free(buf);
+    close(fd);
+
+    double writes_per_sec = writes / (duration / 1000000.0);
+    double throughput = ((double) sent / (duration / 1000000.0)) / (1024 * 1024);
+    printf("%.2f MB/s (%s)\n", throughput, sent == total_size ? "ok" : "CONNECTION LOST");
+
+    return {name, writes_per_sec, throughput, duration / 1000};
+}
+
+// Streams a file of total_size bytes to the sink on the host with sendfile, so it never passes through userspace.
+static BenchResult bench_tcp_sendfile(const char* name, size_t total_size) {
+    printf("  [NET] %s... ", name);
+    fflush(stdout);
+
+    const char* filename = "/tmp/bench_tcp_sendfile.dat";
+    const size_t block_size = 64 * 1024;
+    int file_fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file_fd < 0) {
+        printf("FAILED (create)\n");
+        return {name, 0, 0, 0};
+    }
+    auto* buf = (uint8_t*) malloc(block_size);
+    memset(buf, 0x55, block_size);
+    for (size_t written = 0; written < total_size; written += block_size)
+        write(file_fd, buf, std::min(block_size, total_size - written));
+    close(file_fd);
+    free(buf);
+
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        printf("FAILED (socket)\n");
+        unlink(filename);
+        return {name, 0, 0, 0};
+    }
+
+    sockaddr_in addr = tcp_sink_addr.as_sockaddr(tcp_sink_port);
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        printf("SKIPPED (nothing listening on 10.0.2.2:%d)\n", tcp_sink_port);
+        close(fd);
+        unlink(filename);
+        return {name, 0, 0, 0};
+    }
+
+    file_fd = open(filename, O_RDONLY);
+    size_t sent = 0;
+    int calls = 0;
+    long long start = get_timestamp_us();
+    while (sent < total_size) {
+        ssize_t res = sendfile(fd, file_fd, nullptr, total_size - sent);
+        if (res <= 0)
+            break;
+        sent += res;
+        calls++;
+    }
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    close(file_fd);
+    close(fd);
+    unlink(filename);
+
+    double calls_per_sec = calls / (duration / 1000000.0);
+    double throughput = ((double) sent / (duration / 1000000.0)) / (1024 * 1024);
+    printf("%.2f MB/s (%s)\n", throughput, sent == total_size ? "ok" : "CONNECTION LOST");
+
+    return {name, calls_per_sec, throughput, duration / 1000};
+}
+
+static void run_all(bool quick) {
+    print_header("NETWORK BENCHMARKS");
+
+    int num_pkts = quick ? 5000 : 50000;
+    BenchResult results[] = {
+        bench_udp_blast("UDP blast, 64B", 64, num_pkts, 1),
+        bench_udp_blast("UDP blast, 512B", 512, num_pkts, 1),
+        bench_udp_blast("UDP blast, 1472B", 1472, num_pkts, 1),
+        bench_udp_blast("UDP sendmmsg, 64B", 64, num_pkts, 32),
+        bench_udp_blast("UDP sendmmsg, 1472B", 1472, num_pkts, 32),
+        bench_tcp_bulk("TCP bulk send", 16 * 1024, (quick ? 4 : 32) * 1024 * 1024),
+        bench_tcp_sendfile("TCP sendfile", (quick ? 4 : 32) * 1024 * 1024)
+    };
+
+    printf("\n  Summary:\n");
+    for (auto& r : results) {
+        printf("    %-25s: %10.0f ops/s %8.2f MB/s (%lld ms)\n",
+               r.name, r.ops_per_sec, r.throughput, r.duration_ms);
+    }
+    printf("\n");
+}
+
+} // namespace Network
+
+// ============================================================================
+// LOCK BENCHMARKS
+// ============================================================================
+
+namespace Locks {
+
+struct BenchResult {
+    const char* name;
+    double ops_per_sec;
+    long long duration_ms;
+};
+
+struct ContendArgs {
+    void (*lock)(void*);
+    void (*unlock)(void*);
+    void* lock_arg;
+    int iterations;
+    volatile long* counter;
+};
+
+static void* contend_thread(void* arg) {
+    auto* args = (ContendArgs*) arg;
+    for (int i = 0; i < args->iterations; ++i) {
+        args->lock(args->lock_arg);
+        *args->counter = *args->counter + 1;
+        args->unlock(args->lock_arg);
+    }
+    return nullptr;
+}
+
+// Has several threads increment a shared counter under the given lock
+static BenchResult bench_contended(const char* name, void (*lock)(void*), void (*unlock)(void*), void* lock_arg,
+                                   int num_threads, int iterations) {
+    printf("  [LOCK] %s (%d threads)... ", name, num_threads);
+    fflush(stdout);
+
+    volatile long counter = 0;
+    ContendArgs args = {lock, unlock, lock_arg, iterations, &counter};
+    pthread_t threads[16];
+
+    long long start = get_timestamp_us();
+    for (int i = 0; i < num_threads; ++i)
+        pthread_create(&threads[i], nullptr, contend_thread, &args);
+    for (int i = 0; i < num_threads; ++i)
+        pthread_join(threads[i], nullptr);
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    double ops = (double) iterations * num_threads / (duration / 1000000.0);
+    printf("%.0f ops/sec (%s)\n", ops, counter == (long) iterations * num_threads ? "ok" : "WRONG RESULT");
+    return {name, ops, duration / 1000};
+}
+
+struct PingPongArgs {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int turn;
+    int iterations;
+};
+
+static void* pong_thread(void* arg) {
+    auto* args = (PingPongArgs*) arg;
+    pthread_mutex_lock(&args->mutex);
+    for (int i = 0; i < args->iterations; ++i) {
+        while (args->turn != 1)
+            pthread_cond_wait(&args->cond, &args->mutex);
+        args->turn = 0;
+        pthread_cond_signal(&args->cond);
+    }
+    pthread_mutex_unlock(&args->mutex);
+    return nullptr;
+}
+
+// Passes control back and forth between two threads with a condition variable
+static BenchResult bench_cond_pingpong(int iterations) {
+    printf("  [LOCK] Condition variable ping-pong... ");
+    fflush(stdout);
+
+    PingPongArgs args;
+    pthread_mutex_init(&args.mutex, nullptr);
+    pthread_cond_init(&args.cond, nullptr);
+    args.turn = 0;
+    args.iterations = iterations;
+
+    long long start = get_timestamp_us();
+    pthread_t thread;
+    pthread_create(&thread, nullptr, pong_thread, &args);
+    pthread_mutex_lock(&args.mutex);
+    for (int i = 0; i < iterations; ++i) {
+        args.turn = 1;
+        pthread_cond_signal(&args.cond);
+        while (args.turn != 0)
+            pthread_cond_wait(&args.cond, &args.mutex);
+    }
+    pthread_mutex_unlock(&args.mutex);
+    pthread_join(thread, nullptr);
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    double ops = (double) iterations / (duration / 1000000.0);
+    printf("%.0f round trips/sec\n", ops);
+    return {"Condvar ping-pong", ops, duration / 1000};
+}
+
+static void run_all(bool quick) {
+    print_header("LOCK BENCHMARKS");
+
+    int iterations = quick ? 20000 : 200000;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    Duck::SpinLock spinlock;
+    auto mutex_lock = [](void* m) { pthread_mutex_lock((pthread_mutex_t*) m); };
+    auto mutex_unlock = [](void* m) { pthread_mutex_unlock((pthread_mutex_t*) m); };
+    auto spin_lock = [](void* l) { ((Duck::SpinLock*) l)->acquire(); };
+    auto spin_unlock = [](void* l) { ((Duck::SpinLock*) l)->release(); };
+
+    BenchResult results[] = {
+        bench_contended("pthread mutex", mutex_lock, mutex_unlock, &mutex, 1, iterations),
+        bench_contended("pthread mutex", mutex_lock, mutex_unlock, &mutex, 4, iterations),
+        bench_contended("Duck::SpinLock", spin_lock, spin_unlock, &spinlock, 1, iterations),
+        bench_contended("Duck::SpinLock", spin_lock, spin_unlock, &spinlock, 4, iterations),
+        bench_cond_pingpong(iterations / 10)
+    };
+
+    printf("\n  Summary:\n");
+    for (auto& r : results) {
+        printf("    %-25s: %12.0f ops/sec (%lld ms)\n", r.name, r.ops_per_sec, r.duration_ms);
+    }
+    printf("\n");
+}
+
+} // namespace Locks
+
+// ============================================================================
+// STRING FUNCTION BENCHMARKS
+// ============================================================================
+
+namespace Strings {
+
+struct BenchResult {
+    const char* name;
+    size_t size;
+    double throughput_mbps;
+};
+
+// Compares libc's mem/str functions against simple byte-at-a-time versions on random data, sizes and alignments
+static bool verify(int iterations) {
+    printf("  [STR] Verifying against reference implementations... ");
+    fflush(stdout);
+
+    const size_t buf_size = 4096;
+    auto* a = (uint8_t*) malloc(buf_size);
+    auto* b = (uint8_t*) malloc(buf_size);
+    auto* expected = (uint8_t*) malloc(buf_size);
+    unsigned int seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+
+    const char* failed = nullptr;
+    size_t failed_size = 0;
+    for (int iter = 0; iter < iterations && !failed; ++iter) {
+        size_t size = random() % (iter % 8 == 0 ? 2048 : 128);
+        size_t off_a = random() % 16, off_b = random() % 16;
+        for (size_t i = 0; i < buf_size; i++) {
+            a[i] = random();
+            b[i] = random();
+        }
+        failed_size = size;
+
+        // memcpy
+        for (size_t i = 0; i < buf_size; i++) expected[i] = b[i];
+        for (size_t i = 0; i < size; i++) expected[off_b + i] = a[off_a + i];
+        memcpy(b + off_b, a + off_a, size);
+        if (memcmp(b, expected, buf_size) != 0) { failed = "memcpy"; break; }
+
+        // memmove, overlapping in either direction
+        int shift = (int) (random() % 64) - 32;
+        for (size_t i = 0; i < buf_size; i++) expected[i] = a[i];
+        if (shift > 0) {
+            for (size_t i = size; i-- > 0;) expected[64 + shift + i] = expected[64 + i];
+        } else {
+            for (size_t i = 0; i < size; i++) expected[64 + shift + i] = expected[64 + i];
+        }
+        memmove(a + 64 + shift, a + 64, size);
+        for (size_t i = 0; i < buf_size; i++) {
+            if (a[i] != expected[i]) { failed = "memmove"; break; }
+        }
+        if (failed) break;
+
+        // memset
+        int value = random() & 0xFF;
+        memset(a + off_a, value, size);
+        for (size_t i = 0; i < size; i++) {
+            if (a[off_a + i] != value) { failed = "memset"; break; }
+        }
+        if (failed) break;
+
+        // memcmp
+        for (size_t i = 0; i < size; i++) b[off_b + i] = a[off_a + i];
+        if (memcmp(a + off_a, b + off_b, size) != 0) { failed = "memcmp"; break; }
+        if (size) {
+            size_t diff = random() % size;
+            b[off_b + diff] = a[off_a + diff] + 1;
+            int res = memcmp(a + off_a, b + off_b, size);
+            if ((res < 0) != (a[off_a + diff] < b[off_b + diff]) || res == 0) { failed = "memcmp"; break; }
+        }
+
+        // memchr
+        uint8_t needle = random();
+        const uint8_t* found = nullptr;
+        for (size_t i = 0; i < size; i++) {
+            if (a[off_a + i] == needle) { found = a + off_a + i; break; }
+        }
+        if (memchr(a + off_a, needle, size) != found) { failed = "memchr"; break; }
+
+        // strlen, strchr and strcmp on a string of the same length
+        for (size_t i = 0; i < size; i++) {
+            if (!a[off_a + i]) a[off_a + i] = 1;
+        }
+        a[off_a + size] = '\0';
+        auto* str = (const char*) a + off_a;
+        if (strlen(str) != size) { failed = "strlen"; break; }
+        const char* found_char = nullptr;
+        for (size_t i = 0; i <= size; i++) {
+            if (str[i] == (char) needle) { found_char = str + i; break; }
+        }
+        if (strchr(str, needle) != found_char) { failed = "strchr"; break; }
+        for (size_t i = 0; i <= size; i++) b[off_b + i] = a[off_a + i];
+        if (strcmp(str, (const char*) b + off_b) != 0) { failed = "strcmp"; break; }
+        if (size) {
+            b[off_b + random() % size] = '\0';
+            if (strcmp(str, (const char*) b + off_b) <= 0) { failed = "strcmp"; break; }
+        }
+    }
+
+    free(a);
+    free(b);
+    free(expected);
+    if (failed)
+        printf("FAILED (%s, %zu bytes)\n", failed, failed_size);
+    else
+        printf("ok (%d iterations)\n", iterations);
+    return !failed;
+}
+
+enum class Op { Memcpy, Memset, Memcmp, Strlen, Memchr };
+
+static BenchResult bench_op(const char* name, Op op, size_t size, size_t misalign) {
+    auto* src = (uint8_t*) malloc(size + 64);
+    auto* dst = (uint8_t*) malloc(size + 64);
+    memset(src, 'a', size + 64);
+    memset(dst, 'a', size + 64);
+    src[misalign + size] = '\0';
+
+    // Aim for roughly the same amount of data per test regardless of size
+    size_t iterations = (64 * 1024 * 1024) / (size + 16);
+    volatile size_t sink = 0;
+    long long start = get_timestamp_us();
+    for (size_t i = 0; i < iterations; ++i) {
+        switch (op) {
+        case Op::Memcpy: memcpy(dst + 1, src + misalign, size); break;
+        case Op::Memset: memset(dst + misalign, (int) i, size); break;
+        case Op::Memcmp: sink += memcmp(src + misalign, dst + misalign, size); break;
+        case Op::Strlen: sink += strlen((const char*) src + misalign); break;
+        case Op::Memchr: sink += (size_t) memchr(src + misalign, 'b', size); break;
+        }
+    }
+    long long duration = get_timestamp_us() - start;
+    if (duration <= 0) duration = 1;
+
+    free(src);
+    free(dst);
+    double mbps = ((double) size * iterations / (duration / 1000000.0)) / (1024 * 1024);
+    return {name, size, mbps};
+}
+
+static void run_all(bool quick) {
+    print_header("STRING FUNCTION BENCHMARKS");
+
+    if (!verify(quick ? 2000 : 20000))
+        return;
+
+    struct { const char* name; Op op; } ops[] = {
+        {"memcpy", Op::Memcpy},
+        {"memset", Op::Memset},
+        {"memcmp", Op::Memcmp},
+        {"strlen", Op::Strlen},
+        {"memchr", Op::Memchr}
+    };
+    size_t sizes[] = {16, 64, 256, 4096, 65536, 1024 * 1024};
+    size_t num_sizes = quick ? 5 : 6;
+
+    printf("\n  Throughput (MB/s), aligned / misaligned by 3 bytes:\n");
+    printf("    %-8s", "");
+    for (size_t i = 0; i < num_sizes; i++)
+        printf(" %15zu", sizes[i]);
+    printf("\n");
+    for (auto& op : ops) {
+        printf("    %-8s", op.name);
+        for (size_t i = 0; i < num_sizes; i++) {
+            size_t size = sizes[i];
+            auto aligned = bench_op(op.name, op.op, size, 0);
+            auto misaligned = bench_op(op.name, op.op, size, 3);
+            printf(" %7.0f/%-7.0f", aligned.throughput_mbps, misaligned.throughput_mbps);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+} // namespace Strings
+
+// ============================================================================
+// 3D RENDERING BENCHMARKS
+// ============================================================================
+
+namespace Render3D {
+
+constexpr const char* cube_path = "/apps/3demo.app/cube.obj";
+constexpr int width = 320;
+constexpr int height = 240;
+
+struct Model {
+    const char* name;
+    Lib3D::ObjReader::Mesh mesh;
+    bool rotating;
+    bool culling;
+};
+
+static Lib3D::Vertex make_vertex(float x, float y, float z, Vec4f color) {
+    Lib3D::Vertex vert;
+    vert.pos = {x, y, z, 0};
+    vert.color = color;
+    return vert;
+}
+
+// A UV sphere, which has lots of small triangles like a detailed model would
+static Lib3D::ObjReader::Mesh make_sphere(int stacks) {
+    Lib3D::ObjReader::Mesh mesh;
+    int slices = stacks * 2;
+    for (int i = 0; i <= stacks; i++) {
+        float theta = M_PI * i / stacks;
+        for (int j = 0; j <= slices; j++) {
+            float phi = 2 * M_PI * j / slices;
+            mesh.vertices.push_back(make_vertex(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi),
+                                                {(float) i / stacks, (float) j / slices, 1, 1}));
+        }
+    }
+    for (int i = 0; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            uint32_t a = i * (slices + 1) + j, b = a + slices + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+    return mesh;
+}
+
+// Squares stacked from front to back, so that almost everything drawn after the first one is hidden
+static Lib3D::ObjReader::Mesh make_layers(int layers) {
+    Lib3D::ObjReader::Mesh mesh;
+    for (int i = 0; i < layers; i++) {
+        float z = -0.9f + 1.8f * i / layers;
+        Vec4f color = {1.0f - (float) i / layers, 0.5f, (float) i / layers, 1};
+        auto base = (uint32_t) mesh.vertices.size();
+        mesh.vertices.push_back(make_vertex(-1, -1, z, color));
+        mesh.vertices.push_back(make_vertex(1, -1, z, color));
+        mesh.vertices.push_back(make_vertex(1, 1, z, color));
+        mesh.vertices.push_back(make_vertex(-1, 1, z, color));
+        mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+    return mesh;
+}
+
+// Returns the average time per frame in microseconds, either drawing with tri() (threads = 0) or draw_indexed()
+static long long render(Lib3D::RenderContext& context, const Model& model, int threads, int frames) {
+    auto& mesh = model.mesh;
+    context.set_backface_culling(model.culling);
+    context.set_threads(threads ? threads : 1);
+
+    long long start = get_timestamp_us();
+    for (int frame = 0; frame < frames; frame++) {
+        context.clear({0, 0, 0, 1});
+        if (model.rotating)
+            context.set_modelmat(Lib3D::rotate(0.006f, {1.234f * frame, 2.312f * frame, 3.231f * frame}));
+        if (threads) {
+            context.draw_indexed(mesh.vertices, mesh.indices);
+        } else {
+            for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+                context.tri({mesh.vertices[mesh.indices[i]], mesh.vertices[mesh.indices[i + 1]], mesh.vertices[mesh.indices[i + 2]]});
+        }
+    }
+    long long duration = get_timestamp_us() - start;
+    return duration / frames;
+}
+
+static void run_all(bool quick) {
+    print_header("3D RENDERING BENCHMARKS");
+
+    std::vector<Model> models;
+    Duck::FileInputStream cube_stream {Duck::Path(cube_path)};
+    if (cube_stream.is_open())
+        models.push_back({"cube", Lib3D::ObjReader::read_mesh(cube_stream), true, true});
+    else
+        printf("  [3D] Couldn't open %s, skipping it\n", cube_path);
+    models.push_back({"sphere", make_sphere(16), true, true});
+    models.push_back({"sphere-hi", make_sphere(96), true, true});
+    models.push_back({"layers", make_layers(32), false, false});
+
+    int frames = quick ? 10 : 50;
+    const int thread_counts[] = {1, 2, 4};
+    auto context = Lib3D::RenderContext::make(Gfx::Dimensions {width, height});
+
+    printf("\n  Time per frame at %dx%d (ms), tri() / draw_indexed() with 1, 2 and 4 threads:\n", width, height);
+    printf("    %-10s %8s %9s", "", "tris", "tri()");
+    for (int threads : thread_counts) {
+        char label[16];
+        snprintf(label, sizeof(label), "indexed x%d", threads);
+        printf("   %-15s", label);
+    }
+    printf("\n");
+
+    for (auto& model : models) {
+        float max_dim = 0;
+        for (auto& vert : model.mesh.vertices)
+            for (int i = 0; i < 3; i++)
+                max_dim = std::max(max_dim, std::abs(vert.pos[i]));
+        context->set_projmat(Lib3D::ortho(-max_dim * 2, max_dim * 2, -max_dim * 2, max_dim * 2, -max_dim * 2, max_dim * 2));
+        context->set_modelmat(Lib3D::identity<float, 4>());
+
+        long long tri_time = render(*context, model, 0, frames);
+        printf("    %-10s %8zu %6lld.%02lld", model.name, model.mesh.indices.size() / 3, tri_time / 1000, (tri_time % 1000) / 10);
+        fflush(stdout);
+        for (int threads : thread_counts) {
+            long long time = render(*context, model, threads, frames);
+            printf("   %5lld.%02lld (%3lld%%)", time / 1000, (time % 1000) / 10, time ? tri_time * 100 / time : 0);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    printf("\n  Percentages are the speed of draw_indexed() relative to tri().\n\n");
+}
+
+} // namespace Render3D
+
 // ============================================================================
 // COMPOSITE SCORE CALCULATION
 // ============================================================================
@@ -635,6 +1932,9 @@ static void print_final_score(SystemScore score) {
 // ============================================================================
 
 int main(int argc, char** argv) {
+    if (argc == 2 && !strcmp(argv[1], LAUNCH_CHILD_ARG))
+        return EXIT_SUCCESS;
+
     Duck::Args args;
     bool help = false;
     bool quick = false;
@@ -642,6 +1942,13 @@ int main(int argc, char** argv) {
     bool mem_only = false;
     bool io_only = false;
     bool proc_only = false;
+    bool term_only = false;
+    bool river_only = false;
+    bool sockfs_only = false;
+    bool net_only = false;
+    bool lock_only = false;
+    bool str_only = false;
+    bool render_only = false;
     
     args.add_flag(help, "h", "help", "Show help message");
     args.add_flag(quick, "q", "quick", "Run quick benchmark (reduced iterations)");
@@ -649,6 +1956,13 @@ int main(int argc, char** argv) {
     args.add_flag(mem_only, "", "mem", "Run memory benchmarks only");
     args.add_flag(io_only, "", "io", "Run I/O benchmarks only");
     args.add_flag(proc_only, "", "proc", "Run process benchmarks only");
+    args.add_flag(term_only, "", "term", "Run terminal emulator benchmarks only");
+    args.add_flag(river_only, "", "river", "Run River IPC benchmarks only");
+    args.add_flag(sockfs_only, "", "sockfs", "Run SocketFS message benchmarks only");
+    args.add_flag(net_only, "", "net", "Run network benchmarks only");
+    args.add_flag(lock_only, "", "lock", "Run lock benchmarks only");
+    args.add_flag(str_only, "", "str", "Run string function benchmarks only");
+    args.add_flag(render_only, "", "3d", "Run 3D rendering benchmarks only");
     
     args.parse(argc, argv);
 
@@ -662,6 +1976,13 @@ int main(int argc, char** argv) {
         printf("  --mem          Run memory benchmarks only\n");
         printf("  --io           Run I/O benchmarks only\n");
         printf("  --proc         Run process benchmarks only\n");
+        printf("  --term         Run terminal emulator benchmarks only\n");
+        printf("  --river        Run River IPC benchmarks only\n");
+        printf("  --sockfs       Run SocketFS message benchmarks only\n");
+        printf("  --net          Run network benchmarks only (not part of the full run)\n");
+        printf("  --lock         Run lock benchmarks only\n");
+        printf("  --str          Run string function benchmarks only\n");
+        printf("  --3d           Run 3D rendering benchmarks only\n");
         printf("\n");
         return EXIT_SUCCESS;
     }
@@ -675,7 +1996,7 @@ int main(int argc, char** argv) {
 
     long long total_start = get_timestamp_ms();
     
-    bool run_all = !cpu_only && !mem_only && !io_only && !proc_only;
+    bool run_all = !cpu_only && !mem_only && !io_only && !proc_only && !term_only && !river_only && !sockfs_only && !net_only && !lock_only && !str_only && !render_only;
     
     if (run_all || cpu_only) {
         CPU::run_all();
@@ -692,6 +2013,35 @@ int main(int argc, char** argv) {
     if (run_all || proc_only) {
         Process::run_all();
     }
+
+    if (run_all || term_only) {
+        Terminal::run_all();
+    }
+
+    if (run_all || river_only) {
+        RiverIPC::run_all(quick);
+    }
+
+    if (run_all || sockfs_only) {
+        SocketFS::run_all(quick);
+    }
+
+    // This floods the network with broadcasts, so it's only run when asked for
+    if (net_only) {
+        Network::run_all(quick);
+    }
+
+    if (run_all || lock_only) {
+        Locks::run_all(quick);
+    }
+
+    if (run_all || str_only) {
+        Strings::run_all(quick);
+    }
+
+    if (run_all || render_only) {
+        Render3D::run_all(quick);
+    }
     
     long long total_end = get_timestamp_ms();
     long long total_duration = total_end - total_start;
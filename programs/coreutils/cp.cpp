@@ -25,8 +25,8 @@
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <stdlib.h>
 #include <sys/types.h>
+#include <sys/sendfile.h>
 
 int main(int argc, char** argv) {
 	if(argc < 3) {
@@ -52,26 +52,16 @@ int main(int argc, char** argv) {
 		return errno;
 	}
 
-	errno = 0;
-
-	ssize_t nread;
-	auto* buf = (char*) malloc(1024);
-	while((nread = read(from_fd, buf, 1024))) {
-		ssize_t nwrote;
-		nwrote = write(to_fd, buf, nread);
-		if(nwrote <= 0) {
-			if(errno) {
-				perror("cp");
-				return errno;
-			}
-			perror("cp");
-			return 1;
-		}
+	// Let the kernel do the copying, so the data never has to come through our memory
+	ssize_t nsent;
+	while((nsent = sendfile(to_fd, from_fd, nullptr, 1024 * 1024)) > 0);
+	if(nsent < 0) {
+		perror("cp");
+		return errno;
 	}
 
 	close(to_fd);
 	close(from_fd);
-	free(buf);
 
 	return 0;
 }
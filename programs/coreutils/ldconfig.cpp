@@ -0,0 +1,407 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/* Copyright © 2016-2024 Byteduck */
+
+// Prelinks the system libraries into the library cache used by the dynamic loader.
+
+#include <libnusa/Args.h>
+#include <libnusa/Path.h>
+#include <libexec/Object.h>
+#include <libexec/LibraryCache.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace Exec;
+
+bool g_force = false;
+bool g_verbose = false;
+
+// The same directories the loader searches by default, in the same order
+constexpr const char* LIBRARY_DIRS[] = {"/lib", "/usr/lib", "/usr/local/lib"};
+
+struct Library {
+	std::string path;
+	struct stat stat;
+	std::unique_ptr<Object> object;
+	uint8_t* image = nullptr;
+	size_t image_size = 0;
+	std::vector<size_t> needed;
+	std::vector<size_t> scope; // The library followed by its dependencies, in the order the loader would search them
+	std::vector<elf32_rela> rels;
+	bool prelinkable = false;
+
+	~Library() {
+		if(image)
+			munmap(image, image_size);
+	}
+};
+
+std::vector<std::unique_ptr<Library>> g_libraries;
+
+std::vector<std::string> find_libraries() {
+	std::vector<std::string> paths;
+	for(auto dir : LIBRARY_DIRS) {
+		auto entries_res = Duck::Path(dir).get_directory_entries();
+		if(entries_res.is_error())
+			continue;
+		for(auto& entry : entries_res.value()) {
+			auto name = std::string(entry.name());
+			if(!entry.is_regular() || name.size() < 3 || name.compare(name.size() - 3, 3, ".so") || name == "ld-nusaos.so")
+				continue;
+			paths.push_back(std::string(dir) + "/" + name);
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	return paths;
+}
+
+// Checks whether the existing cache was made from exactly these libraries
+bool cache_is_current(const std::vector<std::string>& paths) {
+	std::unique_ptr<LibraryCache> cache(LibraryCache::open());
+	if(!cache || cache->num_entries() != paths.size())
+		return false;
+	for(size_t i = 0; i < cache->num_entries(); i++) {
+		auto& entry = cache->entry(i);
+		struct stat statbuf;
+		if(stat(cache->string(entry.path), &statbuf) < 0 || !LibraryCache::is_current(entry, statbuf))
+			return false;
+		if(!std::binary_search(paths.begin(), paths.end(), std::string(cache->string(entry.path))))
+			return false;
+	}
+	return true;
+}
+
+// Reads a library and copies its segments into an image laid out like it would be in memory
+bool read_library(Library& library) {
+	int fd = open(library.path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+	auto object = std::make_unique<Object>();
+	object->fd = fd;
+	object->name = library.path;
+	library.object = std::move(object);
+	auto& obj = *library.object;
+
+	if(fstat(fd, &library.stat) < 0 || (size_t) library.stat.st_size < sizeof(elf32_ehdr))
+		return false;
+	obj.mapped_size = ((library.stat.st_size + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+	auto* mapped_file = mmap(nullptr, obj.mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+	if(mapped_file == MAP_FAILED) {
+		obj.mapped_size = 0;
+		return false;
+	}
+	obj.mapped_file = (uint8_t*) mapped_file;
+
+	if(obj.read_headers() < 0 || obj.header->e_type != ET_DYN || obj.calculate_memsz() < 0 || obj.calculated_base || obj.load_dynamic_table() < 0)
+		return false;
+
+	library.image_size = ((obj.memsz + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+	auto* image = mmap(nullptr, library.image_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS, 0, 0);
+	if(image == MAP_FAILED) {
+		library.image_size = 0;
+		return false;
+	}
+	library.image = (uint8_t*) image;
+
+	for(auto& pheader : obj.pheaders) {
+		if(pheader.p_type != PT_LOAD)
+			continue;
+		if(pheader.p_offset + pheader.p_filesz > (size_t) library.stat.st_size || pheader.p_vaddr + pheader.p_memsz > library.image_size)
+			return false;
+		memcpy(library.image + pheader.p_vaddr, obj.mapped_file + pheader.p_offset, pheader.p_filesz);
+	}
+
+	obj.read_dynamic_table([&] (size_t val) { return (size_t) library.image + val; });
+	return obj.dsym_table && obj.dstring_table && (obj.gnu_hash || obj.sysv_hash);
+}
+
+// Finds the library the loader would load for a DT_NEEDED entry
+long find_needed(const char* name) {
+	std::string path;
+	if(strchr(name, '/')) {
+		path = name;
+	} else {
+		// The first library directory with the library in it wins
+		for(auto dir : LIBRARY_DIRS) {
+			path = std::string(dir) + "/" + name;
+			if(!access(path.c_str(), F_OK))
+				break;
+		}
+	}
+
+	for(size_t i = 0; i < g_libraries.size(); i++)
+		if(g_libraries[i]->path == path)
+			return i;
+	return -1;
+}
+
+// Checks that every relocation is one we know how to prelink and targets a writable segment
+bool relocations_supported(Library& library) {
+	auto& obj = *library.object;
+	auto check = [&] (elf32_rel* table, size_t count) {
+		for(size_t i = 0; i < count; i++) {
+			auto type = ELF32_R_TYPE(table[i].r_info);
+			if(type == R_386_NONE)
+				continue;
+			if(type != R_386_32 && type != R_386_PC32 && type != R_386_GLOB_DAT && type != R_386_JMP_SLOT && type != R_386_RELATIVE)
+				return false;
+			if(ELF32_R_SYM(table[i].r_info) >= obj.dsym_table_size)
+				return false;
+			bool writable = false;
+			for(auto& pheader : obj.pheaders)
+				if(pheader.p_type == PT_LOAD && (pheader.p_flags & PF_W) && table[i].r_offset >= pheader.p_vaddr && table[i].r_offset + 4 <= pheader.p_vaddr + pheader.p_memsz)
+					writable = true;
+			if(!writable)
+				return false;
+		}
+		return true;
+	};
+	return check(obj.rel_table, obj.rel_table_size) && check(obj.plt_rel_table, obj.plt_rel_table_size);
+}
+
+void build_scope(Library& library, size_t index) {
+	// The loader loads each library's dependencies before moving on to the next one
+	std::function<void(size_t)> visit = [&] (size_t lib) {
+		if(std::find(library.scope.begin(), library.scope.end(), lib) != library.scope.end())
+			return;
+		library.scope.push_back(lib);
+		for(auto dep : g_libraries[lib]->needed)
+			visit(dep);
+	};
+	visit(index);
+}
+
+uintptr_t resolve(Library& library, const char* name) {
+	SymbolName symbol_name(name);
+	for(auto index : library.scope) {
+		auto& obj = *g_libraries[index]->object;
+		if(auto* symbol = obj.lookup_symbol(symbol_name))
+			return obj.symbol_address(*symbol);
+	}
+	return 0;
+}
+
+void prelink(Library& library) {
+	auto& obj = *library.object;
+	auto apply = [&] (elf32_rel& rel) {
+		auto type = ELF32_R_TYPE(rel.r_info);
+		auto* reloc_loc = (uintptr_t*) (library.image + rel.r_offset);
+		if(type == R_386_NONE)
+			return;
+		if(type == R_386_RELATIVE) {
+			*reloc_loc += obj.memloc;
+			return;
+		}
+
+		// Symbols that aren't local are kept with their addends, so the loader can redo them if they're interposed
+		auto& symbol = obj.dsym_table[ELF32_R_SYM(rel.r_info)];
+		elf32_rela rela = {rel.r_offset, rel.r_info, 0};
+		if(type == R_386_32 || type == R_386_PC32)
+			rela.r_addend = (int32_t) *reloc_loc;
+
+		uintptr_t symbol_loc = 0;
+		if(ELF32_R_SYM(rel.r_info) && ELF32_ST_BIND(symbol.st_info) == STB_LOCAL) {
+			symbol_loc = obj.symbol_address(symbol);
+		} else if(ELF32_R_SYM(rel.r_info)) {
+			auto* symbol_name = obj.dstring_table + symbol.st_name;
+			symbol_loc = resolve(library, symbol_name);
+			if(!symbol_loc && ELF32_ST_BIND(symbol.st_info) != STB_WEAK && g_verbose)
+				printf("ldconfig: %s: %s is undefined\n", library.path.c_str(), symbol_name);
+			library.rels.push_back(rela);
+		}
+
+		switch(type) {
+			case R_386_32:
+				*reloc_loc = symbol_loc + rela.r_addend;
+				break;
+			case R_386_PC32:
+				*reloc_loc = symbol_loc + rela.r_addend - (obj.memloc + rel.r_offset);
+				break;
+			default:
+				*reloc_loc = symbol_loc;
+				break;
+		}
+	};
+
+	for(size_t i = 0; i < obj.rel_table_size; i++)
+		apply(obj.rel_table[i]);
+	for(size_t i = 0; i < obj.plt_rel_table_size; i++)
+		apply(obj.plt_rel_table[i]);
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+	auto* bytes = (const uint8_t*) data;
+	while(size) {
+		ssize_t nwritten = write(fd, bytes, size);
+		if(nwritten <= 0)
+			return false;
+		bytes += nwritten;
+		size -= nwritten;
+	}
+	return true;
+}
+
+bool write_cache(const char* path) {
+	// Lay out the header, entries, strings, dependencies and relocations, followed by the page-aligned images
+	std::vector<ld_cache_entry> entries(g_libraries.size());
+	std::string strings;
+	std::vector<uint32_t> deps;
+	std::vector<elf32_rela> rels;
+	for(size_t i = 0; i < g_libraries.size(); i++) {
+		auto& library = *g_libraries[i];
+		auto& entry = entries[i];
+		entry.path = strings.size();
+		strings.append(library.path.c_str(), library.path.size() + 1);
+		entry.inode = library.stat.st_ino;
+		entry.size = library.stat.st_size;
+		entry.mtime = library.stat.st_mtime;
+		if(!library.prelinkable)
+			continue;
+		entry.base = library.object->memloc;
+		entry.image_size = library.image_size;
+		entry.deps_offset = deps.size();
+		entry.num_deps = library.scope.size() - 1;
+		deps.insert(deps.end(), library.scope.begin() + 1, library.scope.end());
+		entry.rels_offset = rels.size();
+		entry.num_rels = library.rels.size();
+		rels.insert(rels.end(), library.rels.begin(), library.rels.end());
+	}
+
+	ld_cache_header header = {
+		.magic = LD_CACHE_MAGIC,
+		.version = LD_CACHE_VERSION,
+		.num_entries = (uint32_t) entries.size(),
+		.entries_offset = sizeof(ld_cache_header),
+		.strings_offset = (uint32_t) (sizeof(ld_cache_header) + entries.size() * sizeof(ld_cache_entry)),
+		.strings_size = (uint32_t) strings.size()
+	};
+	uint32_t deps_offset = header.strings_offset + strings.size();
+	deps_offset = (deps_offset + 3) & ~3;
+	uint32_t rels_offset = deps_offset + deps.size() * sizeof(uint32_t);
+	size_t image_offset = ((rels_offset + rels.size() * sizeof(elf32_rela) + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+	for(size_t i = 0; i < entries.size(); i++) {
+		auto& entry = entries[i];
+		entry.deps_offset = deps_offset + entry.deps_offset * sizeof(uint32_t);
+		entry.rels_offset = rels_offset + entry.rels_offset * sizeof(elf32_rela);
+		entry.image_offset = image_offset;
+		image_offset += entry.image_size;
+	}
+
+	// Write to a temporary file first, so the loader never sees a partially written cache
+	auto tmp_path = std::string(path) + ".tmp";
+	int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		perror("ldconfig: couldn't create cache");
+		return false;
+	}
+
+	static const uint8_t padding[PAGE_SIZE] = {};
+	size_t offset = rels_offset + rels.size() * sizeof(elf32_rela);
+	bool success = write_all(fd, &header, sizeof(header))
+			&& write_all(fd, entries.data(), entries.size() * sizeof(ld_cache_entry))
+			&& write_all(fd, strings.data(), strings.size())
+			&& write_all(fd, padding, deps_offset - header.strings_offset - strings.size())
+			&& write_all(fd, deps.data(), deps.size() * sizeof(uint32_t))
+			&& write_all(fd, rels.data(), rels.size() * sizeof(elf32_rela))
+			&& write_all(fd, padding, (PAGE_SIZE - offset % PAGE_SIZE) % PAGE_SIZE);
+	for(size_t i = 0; success && i < g_libraries.size(); i++)
+		if(g_libraries[i]->prelinkable)
+			success = write_all(fd, g_libraries[i]->image, g_libraries[i]->image_size);
+	close(fd);
+
+	if(!success || rename(tmp_path.c_str(), path) < 0) {
+		perror("ldconfig: couldn't write cache");
+		unlink(tmp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	Duck::Args args;
+	args.add_flag(g_force, "f", "force", "Rebuild the cache even if it's up to date.");
+	args.add_flag(g_verbose, "v", "verbose", "Show the address each library is prelinked at.");
+	args.parse(argc, argv);
+
+	auto paths = find_libraries();
+	if(!g_force && cache_is_current(paths)) {
+		if(g_verbose)
+			printf("ldconfig: %s is up to date\n", LD_CACHE_PATH);
+		return EXIT_SUCCESS;
+	}
+
+	for(auto& path : paths) {
+		auto library = std::make_unique<Library>();
+		library->path = path;
+		g_libraries.push_back(std::move(library));
+	}
+
+	for(auto& library : g_libraries) {
+		library->prelinkable = read_library(*library) && relocations_supported(*library);
+		if(!library->prelinkable && g_verbose)
+			printf("ldconfig: %s can't be prelinked\n", library->path.c_str());
+	}
+
+	for(auto& library : g_libraries) {
+		if(!library->prelinkable)
+			continue;
+		for(auto* needed : library->object->required_libraries) {
+			auto index = find_needed(needed);
+			if(index < 0) {
+				if(g_verbose)
+					printf("ldconfig: %s: %s isn't a system library\n", library->path.c_str(), needed);
+				library->prelinkable = false;
+				break;
+			}
+			library->needed.push_back(index);
+		}
+	}
+
+	for(size_t i = 0; i < g_libraries.size(); i++)
+		if(g_libraries[i]->prelinkable)
+			build_scope(*g_libraries[i], i);
+
+	// A library can only be prelinked if everything it depends on is. Then give each one its own address.
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(auto& library : g_libraries) {
+			if(!library->prelinkable)
+				continue;
+			for(auto index : library->scope) {
+				if(!g_libraries[index]->prelinkable) {
+					library->prelinkable = false;
+					changed = true;
+					break;
+				}
+			}
+		}
+
+		uintptr_t base = LD_CACHE_BASE;
+		for(auto& library : g_libraries) {
+			if(!library->prelinkable)
+				continue;
+			if(library->image_size > LD_CACHE_LIMIT - base) {
+				library->prelinkable = false;
+				changed = true;
+				continue;
+			}
+			library->object->memloc = base;
+			base += library->image_size;
+		}
+	}
+
+	for(auto& library : g_libraries) {
+		if(!library->prelinkable)
+			continue;
+		prelink(*library);
+		if(g_verbose)
+			printf("%s => %#lx\n", library->path.c_str(), (unsigned long) library->object->memloc);
+	}
+
+	return write_cache(LD_CACHE_PATH) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
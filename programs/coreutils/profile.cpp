@@ -2,63 +2,173 @@
 /* Copyright © 2016-2023 Byteduck */
 
 #include <libdebug/LiveDebugger.h>
-#include <csignal>
+#include <sys/profile.h>
+#include <sys/mman.h>
+#include <kernel/api/page_size.h>
 #include <memory>
-#include <sys/wait.h>
+#include <algorithm>
+#include <unistd.h>
 #include <libnusa/FormatStream.h>
 #include <libnusa/Args.h>
 #include <libnusa/Socket.h>
+#include <libnusa/Time.h>
+#include <libnusa/FileStream.h>
 #include <ctime>
 
 constexpr int debugd_port = 59336;
 constexpr const char* debugd_start = "DEBUGD\nPROFILE\n";
+constexpr const char* kernel_map_path = "/boot/kernel.map";
+constexpr uintptr_t kernel_base = 0xC0000000;
+constexpr size_t buffer_size = 1024 * 1024;
+constexpr int drain_interval_ms = 20;
 
 using namespace Debug;
 using Duck::OutputStream;
 
-int pid;
-int interval = 10;
+int pid = 0;
+bool all = false;
+unsigned int frequency = 1000;
 int duration = 5000;
 bool remote = false;
 std::string filename;
 
+struct Process {
+	std::string name;
+	LiveDebugger debugger;
+	bool symbolicatable = false;
+	std::map<size_t, AddressInfo> symbols;
+};
+
 struct Thread {
+	pid_t pid;
 	tid_t tid;
-	LiveDebugger debugger;
-	std::vector<std::vector<size_t>> stacks;
+	std::map<std::vector<uintptr_t>, size_t> stacks; ///< The number of times each stack (innermost frame first) was seen.
 };
 
-Duck::Result output_profile(
-		Duck::OutputStream& stream,
-		std::map<size_t, AddressInfo>& symbols,
-		std::vector<Duck::Ptr<Thread>>& threads) {
-	for (auto& thread : threads){
-		for (auto& stk : thread->stacks) {
-			stream << "thread " << thread->tid << ";";
-			for(size_t i = stk.size(); i > 0; i--) {
-				auto pos = stk[i - 1];
-				auto info = symbols.find(pos);
-				if (info == symbols.end()) {
-					auto info_res = thread->debugger.info_at(pos);
-					if(info_res.is_error())
-						symbols[pos] = {"???", pos, nullptr};
-					else
-						symbols[pos] = info_res.value();
-					info = symbols.find(pos);
-				}
-
-				auto& symbol = info->second;
-				if (!symbol.object)
-					stream % "?? @ {#x}" % symbol.symbol_offset;
-				else if(symbol.symbol_name == "__syscall_trap__")
-					stream << "<kernel>";
-				else
-					stream % "{} @ {}" % symbol.symbol_name % symbol.object->name;
+struct KernelSymbol {
+	uintptr_t location;
+	std::string name;
+};
+
+std::map<pid_t, Process> processes;
+std::map<tid_t, Thread> threads;
+std::vector<KernelSymbol> kernel_symbols;
+size_t num_samples = 0;
+
+void load_kernel_symbols() {
+	// Lines look like "c0100000 T name(args)"
+	auto file_res = Duck::File::open(kernel_map_path, "r");
+	if (file_res.is_error()) {
+		Duck::printerrln("Warning: Couldn't open {}, kernel frames won't be symbolicated", kernel_map_path);
+		return;
+	}
+	Duck::FileInputStream stream {file_res.value()};
+	std::string line;
+	while (!stream.eof()) {
+		stream >> line;
+		if (line.size() < 12)
+			continue;
+		auto name_end = line.find('(', 11);
+		kernel_symbols.push_back({
+			(uintptr_t) strtoul(line.substr(0, 8).c_str(), nullptr, 16),
+			line.substr(11, name_end == std::string::npos ? std::string::npos : name_end - 11)
+		});
+	}
+	std::sort(kernel_symbols.begin(), kernel_symbols.end(), [](const KernelSymbol& a, const KernelSymbol& b) {
+		return a.location < b.location;
+	});
+}
+
+const KernelSymbol* kernel_symbol_at(uintptr_t addr) {
+	auto next = std::upper_bound(kernel_symbols.begin(), kernel_symbols.end(), addr, [](uintptr_t addr, const KernelSymbol& sym) {
+		return addr < sym.location;
+	});
+	if (next == kernel_symbols.begin() || next == kernel_symbols.end())
+		return nullptr;
+	return &*(next - 1);
+}
+
+Process& process_for(pid_t pid) {
+	auto proc_it = processes.find(pid);
+	if (proc_it != processes.end())
+		return proc_it->second;
+
+	// Load the memory map the first time we see a process, since it might not be around by the time we're done
+	auto& proc = processes[pid];
+	auto sys_proc_res = Sys::Process::get(pid);
+	proc.name = sys_proc_res.is_error() ? "???" : sys_proc_res.value().name();
+	auto inspect_res = proc.debugger.inspect(pid);
+	if (inspect_res.is_error())
+		Duck::printerrln("Warning: Couldn't load memory map of {}: {}", pid, inspect_res);
+	proc.symbolicatable = !inspect_res.is_error();
+	return proc;
+}
+
+bool drain(profile_buffer* buffer) {
+	auto data = (uint8_t*) buffer + buffer->data_offset;
+	auto head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+	auto tail = buffer->tail;
+	bool any = tail != head;
+	while (tail != head) {
+		auto record = (profile_record*) (data + (tail & (buffer->data_size - 1)));
+		if (!record->size)
+			break;
+		tail += record->size;
+		if (record->type != PROFILE_RECORD_SAMPLE)
+			continue;
+
+		process_for(record->pid);
+		auto& thread = threads[record->tid];
+		thread.pid = record->pid;
+		thread.tid = record->tid;
+		std::vector<uintptr_t> stack(record->frames, record->frames + record->num_kernel_frames + record->num_user_frames);
+		thread.stacks[stack]++;
+		num_samples++;
+	}
+	__atomic_store_n(&buffer->tail, tail, __ATOMIC_RELEASE);
+	return any;
+}
+
+void output_frame(Duck::OutputStream& stream, Process& proc, uintptr_t pos) {
+	if (pos >= kernel_base) {
+		auto sym = kernel_symbol_at(pos);
+		if (sym)
+			stream % "{} @ kernel" % sym->name;
+		else
+			stream % "?? @ {#x}" % pos;
+		return;
+	}
+
+	auto info = proc.symbols.find(pos);
+	if (info == proc.symbols.end()) {
+		auto info_res = proc.symbolicatable ? proc.debugger.info_at(pos) : Duck::ResultRet<AddressInfo>(Duck::Result("No memory map"));
+		if (info_res.is_error())
+			proc.symbols[pos] = {"???", pos, nullptr};
+		else
+			proc.symbols[pos] = info_res.value();
+		info = proc.symbols.find(pos);
+	}
+
+	auto& symbol = info->second;
+	if (!symbol.object)
+		stream % "?? @ {#x}" % symbol.symbol_offset;
+	else
+		stream % "{} @ {}" % symbol.symbol_name % symbol.object->name;
+}
 
+Duck::Result output_profile(Duck::OutputStream& stream) {
+	for (auto& [tid, thread] : threads) {
+		auto& proc = process_for(thread.pid);
+		for (auto& [stk, count] : thread.stacks) {
+			if (all)
+				stream % "{} ({});" % proc.name % thread.pid;
+			stream << "thread " << thread.tid << ";";
+			for (size_t i = stk.size(); i > 0; i--) {
+				output_frame(stream, proc, stk[i - 1]);
 				if (i != 1)
 					stream << ";";
 			}
-			stream << " 1\n";
+			stream << " " << count << "\n";
 		}
 	}
 
@@ -66,44 +176,45 @@ Duck::Result output_profile(
 }
 
 Duck::Result profile() {
-	auto proc = TRY(Sys::Process::get(pid));
-
-	// First, attach to all the threads
-	const int loops = duration / interval;
-	std::vector<Duck::Ptr<Thread>> threads;
-	for (auto tid : proc.threads()) {
-		auto thread = std::make_shared<Thread>();
-		thread->tid = tid;
-		thread->stacks.reserve(loops);
-		auto attach_res = thread->debugger.attach(pid, tid);
-		if (attach_res.is_error())
-			Duck::printerrln("Warning: Failed to attach to thread {}: {}", tid, attach_res);
-		else
-			threads.push_back(thread);
+	std::string name = "all";
+	if (!all) {
+		auto proc = TRY(Sys::Process::get(pid));
+		name = proc.name();
+		process_for(pid);
 	}
 
-	if (threads.empty())
-		return Duck::Result("Could not attach to any threads");
-
-	Duck::println("Sampling {} for ~{}ms...", proc.name(), duration);
-	for (size_t i = 0; i < loops; i++) {
-		waitpid(pid, nullptr, 0);
-		for (auto& thread : threads)
-			thread->stacks.push_back(TRY(thread->debugger.walk_stack_unsymbolicated()));
-		kill(pid, SIGCONT);
-		usleep(interval * 1000);
-		kill(pid, SIGSTOP);
+	int fd = profile_open(all ? PROFILE_ALL_PROCESSES : pid, frequency, buffer_size);
+	if (fd < 0)
+		return Duck::Result(errno);
+	auto buffer = (profile_buffer*) mmap(nullptr, PAGE_SIZE + buffer_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (buffer == MAP_FAILED) {
+		close(fd);
+		return Duck::Result(errno);
 	}
-	waitpid(pid, nullptr, 0);
-	kill(pid, SIGCONT);
 
-	Duck::println("Done! Symbolicating and dumping...");
-	std::map<size_t, AddressInfo> symbols;
+	Duck::println("Sampling {} at {}Hz for ~{}ms...", name, buffer->frequency, duration);
+	auto end = Duck::Time::now() + Duck::Time::millis(duration);
+	while (Duck::Time::now() < end) {
+		usleep(drain_interval_ms * 1000);
+		// If the process we're profiling exited, we're done
+		if (!drain(buffer) && !all && Sys::Process::get(pid).is_error())
+			break;
+	}
+
+	// Stop sampling and collect whatever's left
+	close(fd);
+	drain(buffer);
+	if (buffer->lost)
+		Duck::printerrln("Warning: {} samples were lost because the buffer was full", buffer->lost);
+	munmap(buffer, PAGE_SIZE + buffer_size);
+
+	Duck::println("Done! Took {} samples. Symbolicating and dumping...", num_samples);
+	load_kernel_symbols();
 
 	if (remote) {
 		// Collect into StringOutputStream
 		Duck::StringOutputStream stream;
-		TRYRES(output_profile(stream, symbols, threads));
+		TRYRES(output_profile(stream));
 
 		// Connect to socket
 		Duck::print("Connecting to debug daemon... ", debugd_port);
@@ -126,10 +237,10 @@ Duck::Result profile() {
 	} else {
 		// Write to file
 		if (filename.empty())
-			filename = "profile-" + proc.name() + "-" + std::to_string(std::time(nullptr)) + ".txt";
+			filename = "profile-" + name + "-" + std::to_string(std::time(nullptr)) + ".txt";
 		auto out = TRY(Duck::File::open(filename, "w"));
 		Duck::FileOutputStream fs {out};
-		TRYRES(output_profile(fs, symbols, threads));
+		TRYRES(output_profile(fs));
 		out.close();
 		Duck::println("Done! Saved to {}.", filename);
 	}
@@ -140,17 +251,23 @@ Duck::Result profile() {
 
 int main(int argc, char** argv) {
 	Duck::Args args;
-	args.add_positional(pid, true, "pid", "The PID of the program to profile.");
-	args.add_named(interval, "i", "interval", "The interval with which to sample, in ms. (Default: 10)");
+	args.add_positional(pid, false, "pid", "The PID of the program to profile.");
+	args.add_flag(all, "a", "all", "Profiles every process instead of one.");
+	args.add_named(frequency, "f", "frequency", "The number of samples to take per second. (Default: 1000)");
 	args.add_named(duration, "d", "duration", "The duration to sample for, in ms. (Default: 5000)");
 	args.add_named(filename, "o", "output", "The output file.");
 	args.add_flag(remote, "r", "remote", "Sends the output to a remote debug server.");
 	args.parse(argc, argv);
 
+	if (!all && !pid) {
+		Duck::printerrln("Either a pid or --all must be given.");
+		return EXIT_FAILURE;
+	}
+
 	auto res = profile();
 	if (res.is_error()) {
 		printf("Error: %s\n", res.message().c_str());
 		return res.code();
 	}
 	return 0;
-}
\ No newline at end of file
+}
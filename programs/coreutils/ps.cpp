@@ -22,11 +22,12 @@
 int main(int argc, char** argv, char** envp) {
 	auto procs = Sys::Process::get_all();
 
-	printf("PID\tPPID\tState\tName\n");
+	printf("PID\tPPID\tState\tTime\tName\n");
 
 	for(auto& proc_pair : procs) {
 		auto& proc = proc_pair.second;
-		printf("%d\t%d\t%c\t%s\n", proc.pid(), proc.ppid(), proc.state_name()[0], proc.name().c_str());
+		long cpu_secs = proc.cpu_time().millis() / 1000;
+		printf("%d\t%d\t%c\t%ld:%02ld\t%s\n", proc.pid(), proc.ppid(), proc.state_name()[0], cpu_secs / 60, cpu_secs % 60, proc.name().c_str());
 	}
 
 	return 0;
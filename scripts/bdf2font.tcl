@@ -0,0 +1,184 @@
+#!/usr/bin/env tclsh
+
+# Compiles a BDF font into the precompiled font format used by libgraphics (see Gfx::FontData in
+# libraries/libgraphics/Font.h). The output can be read straight into memory without any parsing.
+
+if {$argc < 2} {
+    puts stderr "Usage: bdf2font.tcl <input.bdf> <output.font>"
+    exit 1
+}
+
+set INPUT  [lindex $argv 0]
+set OUTPUT [lindex $argv 1]
+
+set FORMAT_VERSION 3
+set HEADER_SIZE    184
+
+proc die {message} {
+    global INPUT
+    puts stderr "bdf2font: $INPUT: $message"
+    exit 1
+}
+
+proc align8 {value} {
+    return [expr {($value + 7) & ~7}]
+}
+
+set fd [open $INPUT r]
+set lines [split [read $fd] "\n"]
+close $fd
+
+if {[string trim [lindex $lines 0]] ne "STARTFONT 2.1"} {
+    die "Invalid BDF header"
+}
+
+# --- Parse the font properties ---
+set font_id ""
+set font_size 0
+set bbx {0 0 0 0}
+set num_glyphs -1
+set lineno 1
+while {$lineno < [llength $lines]} {
+    set line [string trim [lindex $lines $lineno]]
+    incr lineno
+    set property [lindex [split $line " "] 0]
+    switch -- $property {
+        FONT            { set font_id [string range $line 5 end] }
+        SIZE            { set font_size [lindex $line 1] }
+        FONTBOUNDINGBOX { set bbx [lrange $line 1 4] }
+        CHARS           { set num_glyphs [lindex $line 1]; break }
+    }
+}
+
+if {$num_glyphs <= 0} {
+    die "Invalid CHARS count"
+}
+
+# --- Parse the glyphs ---
+set glyphs {}
+for {set i 0} {$i < $num_glyphs} {incr i} {
+    while {$lineno < [llength $lines] && [lindex [split [lindex $lines $lineno] " "] 0] ne "STARTCHAR"} {
+        incr lineno
+    }
+    if {$lineno >= [llength $lines]} {
+        die "File ended before expected"
+    }
+    incr lineno
+
+    set codepoint 0xFFFFFFFF
+    set dwidth {0 0}
+    set gbbx {0 0 0 0}
+    while {1} {
+        if {$lineno >= [llength $lines]} {
+            die "File ended before expected"
+        }
+        set line [string trim [lindex $lines $lineno]]
+        incr lineno
+        switch -- [lindex $line 0] {
+            ENCODING {
+                set codepoint [lindex $line 1]
+                if {$codepoint < 0} {
+                    die "Invalid glyph codepoint"
+                }
+            }
+            DWIDTH { set dwidth [lrange $line 1 2] }
+            BBX    { set gbbx [lrange $line 1 4] }
+            BITMAP { break }
+        }
+    }
+
+    lassign $gbbx width height
+    set bitmap ""
+    for {set y 0} {$y < $height} {incr y} {
+        set row [string trim [lindex $lines $lineno]]
+        incr lineno
+        for {set x 0} {$x < $width} {incr x} {
+            set nibble [string index $row [expr {$x / 4}]]
+            set value 0
+            if {[string is xdigit -strict $nibble]} {
+                set value [expr "0x$nibble"]
+            }
+            append bitmap [expr {($value & (0x8 >> ($x % 4))) ? "\xFF" : "\x00"}]
+        }
+    }
+
+    # The header is padded to 32 bytes (see Gfx::FontGlyph) so the bitmap after it stays 8-byte aligned
+    set glyph [binary format iiiiiiii $codepoint {*}$gbbx {*}$dwidth 0]
+    append glyph $bitmap
+    lappend glyphs [list $codepoint $glyph]
+}
+
+# Sort by codepoint. lsort is stable, so the last definition of a duplicate codepoint wins like it does in Gfx::Font
+set glyphs [lsort -integer -index 0 $glyphs]
+
+# --- Lay out the tables ---
+set offset $HEADER_SIZE
+set pages_offset $offset
+incr offset [expr {4 * 256}]
+array set pages {}
+foreach entry $glyphs {
+    set codepoint [lindex $entry 0]
+    if {$codepoint > 0xFFFF} {
+        break
+    }
+    set page [expr {$codepoint >> 8}]
+    if {![info exists pages($page)]} {
+        set pages($page) $offset
+        incr offset [expr {4 * 256}]
+    }
+}
+
+set fallback_offset $offset
+set fallback {}
+foreach entry $glyphs {
+    set codepoint [lindex $entry 0]
+    if {$codepoint > 0xFFFF && ([llength $fallback] == 0 || [lindex $fallback end 0] != $codepoint)} {
+        lappend fallback [list $codepoint 0]
+    }
+}
+incr offset [expr {8 * [llength $fallback]}]
+
+set glyphs_offset [align8 $offset]
+set offset $glyphs_offset
+set glyph_data ""
+array set entries {}
+set fallback_index -1
+foreach entry $glyphs {
+    lassign $entry codepoint glyph
+    if {$codepoint <= 0xFFFF} {
+        set entries($codepoint) $offset
+    } else {
+        if {$fallback_index < 0 || [lindex $fallback $fallback_index 0] != $codepoint} {
+            incr fallback_index
+        }
+        lset fallback $fallback_index 1 $offset
+    }
+    set size [align8 [string length $glyph]]
+    append glyph_data $glyph [string repeat "\x00" [expr {$size - [string length $glyph]}]]
+    incr offset $size
+}
+set total_size $offset
+
+# --- Write everything out ---
+set out [binary format a6sa128iiiiiiiiiiii "@FONT" $FORMAT_VERSION $font_id $font_size {*}$bbx $num_glyphs \
+    $total_size $pages_offset $fallback_offset [llength $fallback] $glyphs_offset 0]
+
+for {set page 0} {$page < 256} {incr page} {
+    append out [binary format i [expr {[info exists pages($page)] ? $pages($page) : 0}]]
+}
+foreach page [lsort -integer [array names pages]] {
+    for {set i 0} {$i < 256} {incr i} {
+        set codepoint [expr {($page << 8) | $i}]
+        append out [binary format i [expr {[info exists entries($codepoint)] ? $entries($codepoint) : 0}]]
+    }
+}
+foreach entry $fallback {
+    append out [binary format ii {*}$entry]
+}
+append out [string repeat "\x00" [expr {$glyphs_offset - [string length $out]}]]
+append out $glyph_data
+
+set fd [open $OUTPUT w]
+fconfigure $fd -translation binary
+puts -nonewline $fd $out
+close $fd
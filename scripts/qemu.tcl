@@ -43,7 +43,15 @@ switch -- $ARCH {
     i686 {
         set QEMU_SYSTEM       "i386"
         set NUSAOS_QEMU_MEM   "512M"
-        set NUSAOS_QEMU_DRIVE [list -drive "file=$NUSAOS_IMAGE,format=raw,index=0,media=disk"]
+        # Disk: default-nya IDE (PATA).
+        #   NUSAOS_QEMU_DISK=virtio - virtio-blk, untuk membandingkan `benchmark --io` dengan PATA
+        if {[info exists ::env(NUSAOS_QEMU_DISK)] && $::env(NUSAOS_QEMU_DISK) eq "virtio"} {
+            set NUSAOS_QEMU_DRIVE [list \
+                -drive "file=$NUSAOS_IMAGE,format=raw,if=none,id=disk0,discard=unmap" \
+                -device "virtio-blk-pci,drive=disk0"]
+        } else {
+            set NUSAOS_QEMU_DRIVE [list -drive "file=$NUSAOS_IMAGE,format=raw,index=0,media=disk"]
+        }
 
         # Deteksi audio backend yang tersedia di host:
         #   1. PipeWire  - distro modern (Fedora 34+, Ubuntu 22.04+, dst.)
@@ -60,6 +68,24 @@ switch -- $ARCH {
         set NUSAOS_QEMU_DEVICES [list \
             -audiodev "${audio_backend},id=audio0" \
             -device "ac97,audiodev=audio0"]
+
+        # Jaringan: default-nya e1000 dengan user networking.
+        #   NUSAOS_QEMU_NET=socket - e1000 dengan backend socket UDP lokal, sehingga frame bisa ditangkap di host
+        #   NUSAOS_QEMU_NET=virtio - virtio-net dengan user networking (host = 10.0.2.2, untuk `benchmark --net`)
+        if {[info exists ::env(NUSAOS_QEMU_NET)]} {
+            switch -- $::env(NUSAOS_QEMU_NET) {
+                socket {
+                    lappend NUSAOS_QEMU_DEVICES \
+                        -netdev "socket,id=net0,udp=127.0.0.1:5556,localaddr=127.0.0.1:5555" \
+                        -device "e1000,netdev=net0"
+                }
+                virtio {
+                    lappend NUSAOS_QEMU_DEVICES \
+                        -netdev "user,id=net0" \
+                        -device "virtio-net-pci,netdev=net0"
+                }
+            }
+        }
         set NUSAOS_QEMU_SERIAL  [list -serial stdio]
     }
     aarch64 {
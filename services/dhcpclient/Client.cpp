@@ -17,6 +17,9 @@ using namespace Duck;
 #define DHCP_HEADER_SIZE 236
 #define DHCP_MIN_PACKET_SIZE (DHCP_HEADER_SIZE + 4 + 1)
 
+#define DHCP_RECV_BATCH 4
+#define DHCP_RCVBUF_SIZE (16 * 1024)
+
 ResultRet<Ptr<Client>> Client::make() {
 	// Get interfaces
 	std::vector<Interface> interfaces;
@@ -47,6 +50,10 @@ ResultRet<Ptr<Client>> Client::make() {
 	if (fd == -1)
 		return Result(errno);
 
+	// Leave room for offers from every server on the network while we're busy answering one
+	int rcvbuf = DHCP_RCVBUF_SIZE;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
 	// Bind to port 68
 	sockaddr_in addr = IPv4Address(0).as_sockaddr(68);
 	if (bind(fd, (sockaddr*) &addr, sizeof(addr)) < 0) {
@@ -70,64 +77,82 @@ void Client::loop() {
 	for (auto& interface : m_interfaces)
 		discover(interface);
 
-	DHCPPacket buf;
+	// Several servers may answer at once, so take whatever has arrived in one go
+	DHCPPacket bufs[DHCP_RECV_BATCH];
+	iovec iovs[DHCP_RECV_BATCH];
+	mmsghdr msgs[DHCP_RECV_BATCH];
+	for (int i = 0; i < DHCP_RECV_BATCH; i++) {
+		iovs[i] = {&bufs[i].raw_packet(), sizeof(RawDHCPPacket)};
+		msgs[i] = {};
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
 	while (true) {
-		auto nread = recv(m_socket, &buf.raw_packet(), sizeof(RawDHCPPacket), 0);
-		if (nread < 0) {
+		int nmsgs = recvmmsg(m_socket, msgs, DHCP_RECV_BATCH, MSG_WAITFORONE, nullptr);
+		if (nmsgs < 0) {
 			Duck::Log::errf("Error reading packet: {}", strerror(errno));
 			break;
 		}
 
-		if (nread < (ssize_t) DHCP_MIN_PACKET_SIZE) {
-			Duck::Log::errf("Received packet too small: {} bytes (minimum {})", nread, DHCP_MIN_PACKET_SIZE);
-			continue;
-		}
-
-		if (!buf.has_valid_cookie()) {
-			Duck::Log::errf("Received packet with invalid magic cookie");
-			continue;
+		for (int i = 0; i < nmsgs; i++) {
+			if (handle_packet(bufs[i], msgs[i].msg_len))
+				return;
 		}
+	}
+}
 
-		auto type = buf.get_option<uint8_t>(MessageType);
-		if (!type.has_value()) {
-			Duck::Log::errf("Received packet without message type");
-			continue;
-		}
+bool Client::handle_packet(DHCPPacket& buf, size_t size) {
+	if (size < DHCP_MIN_PACKET_SIZE) {
+		Duck::Log::errf("Received packet too small: {} bytes (minimum {})", size, DHCP_MIN_PACKET_SIZE);
+		return false;
+	}
 
-		Result res = Result::SUCCESS;
-		switch (type.value()) {
-		case Offer:
-			// FIX: handle Offer — balas dengan Request supaya server kirim Ack
-			Duck::Log::infof("Received DHCP Offer from {}, sending Request...", buf.raw_packet().siaddr);
-			res = do_offer(buf);
-			break;
+	if (!buf.has_valid_cookie()) {
+		Duck::Log::errf("Received packet with invalid magic cookie");
+		return false;
+	}
 
-		case Ack:
-			res = do_ack(buf);
-			if (!res.is_error()) {
-				Duck::Log::success("DHCP configuration complete!");
-				return;
-			}
-			break;
+	auto type = buf.get_option<uint8_t>(MessageType);
+	if (!type.has_value()) {
+		Duck::Log::errf("Received packet without message type");
+		return false;
+	}
 
-		case Nak:
-			// Server tolak request kita, mulai ulang dari Discover
-			Duck::Log::warnf("Received NAK from {}, restarting discovery...", buf.raw_packet().siaddr);
-			for (auto& interface : m_interfaces)
-				discover(interface);
-			break;
+	Result res = Result::SUCCESS;
+	switch (type.value()) {
+	case Offer:
+		// FIX: handle Offer — balas dengan Request supaya server kirim Ack
+		Duck::Log::infof("Received DHCP Offer from {}, sending Request...", buf.raw_packet().siaddr);
+		res = do_offer(buf);
+		break;
+
+	case Ack:
+		res = do_ack(buf);
+		if (!res.is_error()) {
+			Duck::Log::success("DHCP configuration complete!");
+			return true;
+		}
+		break;
 
-		case Decline:
-			Duck::Log::warnf("Was declined DHCP request from {}", buf.raw_packet().siaddr);
-			break;
+	case Nak:
+		// Server tolak request kita, mulai ulang dari Discover
+		Duck::Log::warnf("Received NAK from {}, restarting discovery...", buf.raw_packet().siaddr);
+		for (auto& interface : m_interfaces)
+			discover(interface);
+		break;
 
-		default:
-			break;
-		}
+	case Decline:
+		Duck::Log::warnf("Was declined DHCP request from {}", buf.raw_packet().siaddr);
+		break;
 
-		if (res.is_error())
-			Duck::Log::errf("{}", res);
+	default:
+		break;
 	}
+
+	if (res.is_error())
+		Duck::Log::errf("{}", res);
+	return false;
 }
 
 Result Client::discover(const Interface& interface) {
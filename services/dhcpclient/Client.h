@@ -31,6 +31,7 @@ private:
 
 	Client(int socket, std::vector<Interface> interfaces);
 
+	bool handle_packet(DHCPPacket& packet, size_t size);
 	Duck::Result discover(const Interface& interface);
 	Duck::Result send_packet(const Interface& interface, const RawDHCPPacket& packet);
 
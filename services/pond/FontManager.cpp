@@ -18,6 +18,7 @@
 */
 
 #include "FontManager.h"
+#include <unistd.h>
 
 using namespace Gfx;
 
@@ -25,8 +26,8 @@ FontManager* instance;
 
 FontManager::FontManager() {
 	instance = this;
-	load_font("gohu-14", "/usr/share/fonts/gohufont-14.bdf");
-	load_font("gohu-11", "/usr/share/fonts/gohufont-11.bdf");
+	load_font("gohu-14", "/usr/share/fonts/gohufont-14");
+	load_font("gohu-11", "/usr/share/fonts/gohufont-11");
 }
 
 FontManager& FontManager::inst() {
@@ -37,8 +38,13 @@ Font* FontManager::get_font(const std::string& name) {
 	return fonts[name];
 }
 
-bool FontManager::load_font(const char* name, const char* path) {
-	auto* font = Font::load_bdf_shm(path);
+bool FontManager::load_font(const char* name, const std::string& path) {
+	//Prefer the precompiled font, and fall back to parsing the BDF if it isn't there
+	Font* font = nullptr;
+	if(access((path + ".font").c_str(), R_OK) == 0)
+		font = Font::load_shm((path + ".font").c_str());
+	if(!font)
+		font = Font::load_bdf_shm((path + ".bdf").c_str());
 	if(!font)
 		return false;
 	fonts[name] = font;
@@ -31,7 +31,10 @@ public:
 	Gfx::Font* get_font(const std::string& name);
 
 private:
-	bool load_font(const char* name, const char* path);
+	/**
+	 * Loads a font. Looks for a precompiled font at path.font, and falls back to path.bdf if there isn't one.
+	 */
+	bool load_font(const char* name, const std::string& path);
 
 	std::map<std::string, Gfx::Font*> fonts;
 };
@@ -121,6 +121,10 @@ int Server::fd() {
 	return _connection->file_descriptor();
 }
 
+int Server::channel_fd() {
+	return _connection->channel_file_descriptor();
+}
+
 void Server::handle_packets() {
 	_connection->read_and_handle_packets(false);
 }
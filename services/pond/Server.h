@@ -29,6 +29,7 @@ public:
 	Server();
 
 	int fd();
+	int channel_fd();
 	void handle_packets();
 	const std::shared_ptr<River::Endpoint>& endpoint();
 
@@ -24,7 +24,7 @@
 #include "FontManager.h"
 #include <libnusa/Log.h>
 #include <string.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <csignal>
@@ -89,13 +89,15 @@ int main(int argc, char** argv, char** envp) {
 	auto* mouse = new Mouse(main_window);
 	auto* font_manager = new FontManager();
 
-	struct pollfd polls[3];
-	polls[0].fd = mouse->fd();
-	polls[0].events = POLLIN;
-	polls[1].fd = server->fd();
-	polls[1].events = POLLIN;
-	polls[2].fd = display->keyboard_fd();
-	polls[2].events = POLLIN;
+	// Everything is handled after every wakeup, so which fd woke us up doesn't matter
+	int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	for(int fd : {mouse->fd(), server->fd(), display->keyboard_fd(), server->channel_fd()}) {
+		if(fd < 0)
+			continue;
+		struct epoll_event event = {.events = EPOLLIN, .data = {.fd = fd}};
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+	}
+	struct epoll_event events[4];
 
 	// Launch desktop (DESKTOP layer) dahulu, baru sandbar (PANEL layer)
 	desktop_pid = launch_app(DESKTOP_PATH, desktop_last_launch, "Desktop");
@@ -106,7 +108,7 @@ int main(int argc, char** argv, char** envp) {
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "EndlessLoop"
 	while(true) {
-		poll(polls, 3, display->buffer_is_dirty() ? display->millis_until_next_flip() : -1);
+		epoll_wait(epoll_fd, events, 4, display->buffer_is_dirty() ? display->millis_until_next_flip() : -1);
 		mouse->update();
 		display->update_keyboard();
 		server->handle_packets();